@@ -0,0 +1,72 @@
+#ifndef ADAPTIVE_RATE_H
+#define ADAPTIVE_RATE_H
+
+#include <stdint.h>
+#include "fixed_point.h"
+#include "sample_quality.h"
+
+// Fresh conversions per channel the activity is measured over
+#define ADAPTIVE_RATE_WINDOW 16
+
+// Quiet time at one interval before the next, twice as long, is tried
+#define ADAPTIVE_RATE_DEFAULT_HOLD_MS 2000
+
+// Activity of a channel: the standard deviation over the window (ripple, noise bursts,
+// ramps) or the step from its previous conversion (edges), whichever is larger
+struct ChannelActivity {
+    q31_t level;
+    q31_t threshold;  // Level that jumps to the fast interval; quiet below half of it
+};
+
+// Sampling interval that follows signal activity. Above a channel's threshold the
+// interval jumps straight to the fast end, so an event is sampled at full resolution from
+// the conversion that saw it. Only once every channel has stayed below half its threshold
+// for the hold time does the interval double, step by step, back to the slow end. Between
+// half and the full threshold the interval stays where it is; that band and the hold are
+// the hysteresis that keeps noise near a threshold from toggling the rate.
+class AdaptiveRate {
+public:
+    AdaptiveRate(uint16_t fastIntervalMs, uint16_t slowIntervalMs, q31_t currentThreshold,
+                 q31_t voltageThreshold, uint32_t holdMs = ADAPTIVE_RATE_DEFAULT_HOLD_MS);
+
+    // One stored sample: each channel's value in the sample scale and its quality. Returns
+    // true when the interval changed.
+    bool update(int64_t timeUs, q31_t current, uint8_t currentQuality, q31_t voltage, uint8_t voltageQuality);
+    void reset();  // Back to the fast interval with empty windows
+
+    // Limits apply from the next update; the interval is clamped into them
+    bool setLimits(uint16_t fastIntervalMs, uint16_t slowIntervalMs);
+    void setThresholds(q31_t currentThreshold, q31_t voltageThreshold);
+    void setHold(uint32_t holdMs) { holdUs = (int64_t)holdMs * 1000; }
+
+    uint16_t getInterval() const { return intervalMs; }
+    uint16_t getFastInterval() const { return fastMs; }
+    uint16_t getSlowInterval() const { return slowMs; }
+    const ChannelActivity& getCurrentActivity() const { return channels[0].activity; }
+    const ChannelActivity& getVoltageActivity() const { return channels[1].activity; }
+    uint32_t getSwitchCount() const { return switchCount; }
+
+private:
+    enum Level { LEVEL_QUIET, LEVEL_BAND, LEVEL_ACTIVE };
+
+    struct Channel {
+        q31_t window[ADAPTIVE_RATE_WINDOW];
+        uint8_t head;
+        uint8_t count;
+        ChannelActivity activity;
+    };
+
+    static Level measure(Channel& channel, q31_t value, uint8_t quality);
+    bool setInterval(uint16_t interval);
+
+    uint16_t fastMs;
+    uint16_t slowMs;
+    int64_t holdUs;
+    uint16_t intervalMs;
+    bool quietStarted;
+    int64_t quietSinceUs;
+    Channel channels[2];
+    uint32_t switchCount;
+};
+
+#endif // ADAPTIVE_RATE_H
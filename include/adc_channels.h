@@ -0,0 +1,30 @@
+#ifndef ADC_CHANNELS_H
+#define ADC_CHANNELS_H
+
+#include "adc_devices.h"
+#include "adc_sample.h"
+
+// Board wiring. Adding a measurement point is one row here (and, to sample it, an entry
+// in the scan list); the acquisition, recovery and reporting code is table driven.
+// Rows ADC_CURRENT_CHANNEL and ADC_VOLTAGE_CHANNEL feed the AdcSample stream and are
+// auto-ranged; the other rows are auxiliary inputs read at their configured gain.
+#define ADC_CURRENT_CHANNEL 0
+#define ADC_VOLTAGE_CHANNEL 1
+
+static const AdcChannelConfig ADC_CHANNEL_TABLE[] = {
+    // name        device  mux                    gain          rate
+    {"shunt_diff", 0,      ADS1115_MUX_DIFF_0_1,  SHUNT_GAIN,   ADS1115_RATE_860SPS},
+    {"ads2_a0",    1,      ADS1115_MUX_SINGLE_0,  ADS2_GAIN,    ADS1115_RATE_860SPS},
+};
+
+#define ADC_CHANNEL_COUNT (sizeof(ADC_CHANNEL_TABLE) / sizeof(ADC_CHANNEL_TABLE[0]))
+static_assert(ADC_CHANNEL_COUNT <= ADC_MAX_CHANNELS, "Channel table too long");
+
+// Channels sampled after boot, in scan order (changeable at run time)
+static const uint8_t ADC_DEFAULT_SCAN_LIST[] = {ADC_CURRENT_CHANNEL, ADC_VOLTAGE_CHANNEL};
+
+// ALERT/RDY pin of each device (open-drain, active low), -1 if not wired. Continuous
+// mode needs one for every device in the scan list.
+static const int ADC_ALERT_PINS[ADC_MAX_DEVICES] = {18, 19, -1, -1};
+
+#endif // ADC_CHANNELS_H
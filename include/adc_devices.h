@@ -0,0 +1,71 @@
+#ifndef ADC_DEVICES_H
+#define ADC_DEVICES_H
+
+#include <stdint.h>
+#include "ads1115_driver.h"
+
+// Up to four ADS1115s share the bus; the ADDR pin strap selects 0x48 + index
+// (GND, VDD, SDA, SCL)
+#define ADC_MAX_DEVICES 4
+#define ADC_BASE_ADDRESS 0x48
+
+// Rows in the channel table / entries in a scan list
+#define ADC_MAX_CHANNELS 8
+
+constexpr uint8_t adcDeviceAddress(uint8_t device) {
+    return ADC_BASE_ADDRESS + device;
+}
+
+// One measurement point: which chip, which input pair, and how to convert it. Gain is
+// the starting gain; channels with an auto-ranger change it at run time.
+struct AdcChannelConfig {
+    const char* name;
+    uint8_t device;  // Index into the device table
+    Ads1115Mux mux;
+    Ads1115Gain gain;
+    Ads1115DataRate rate;
+};
+
+// Mask of the devices a channel table refers to (bit n: device n)
+uint8_t adcTableDeviceMask(const AdcChannelConfig* table, uint8_t tableSize);
+
+// Channel converted by each device in one scan slot (-1: the device is idle)
+struct ScanSlot {
+    int8_t channel[ADC_MAX_DEVICES];
+};
+
+// Round-robin sequencing of a scan list over the devices. The devices convert
+// concurrently, so every slot starts one conversion per device that has channels in the
+// list; a device with several channels steps through them one per slot. Channels that
+// share a mux setting (same input, different gain or rate) are kept next to each other
+// in a device's rotation, and a device with a single mux setting never switches its mux.
+class ScanScheduler {
+public:
+    ScanScheduler();
+
+    // Fails (keeping the previous schedule) on unknown or repeated channels, or an empty list
+    bool configure(const AdcChannelConfig* table, uint8_t tableSize, const uint8_t* scanList, uint8_t scanLength);
+
+    const ScanSlot& next();  // Slot to convert now; advances every rotation
+    void restart();          // Next slot starts every rotation from its first channel
+
+    bool contains(uint8_t channel) const;
+    uint8_t getDeviceMask() const;                   // Bit n: device n has channels in the list
+    uint8_t getRotationLength(uint8_t device) const; // Slots between conversions of one of its channels
+    uint8_t getRotationLengthOf(uint8_t channel) const;
+    uint8_t getMuxSwitchesPerCycle() const;          // Summed over devices, one rotation each
+    uint8_t getScanLength() const;
+    uint8_t getScanChannel(uint8_t index) const;
+
+private:
+    uint8_t rotation[ADC_MAX_DEVICES][ADC_MAX_CHANNELS];
+    uint8_t rotationLength[ADC_MAX_DEVICES];
+    uint8_t cursor[ADC_MAX_DEVICES];
+    uint8_t muxSwitches;
+    uint8_t scanList[ADC_MAX_CHANNELS];
+    uint8_t scanLength;
+    uint8_t channelDevice[ADC_MAX_CHANNELS];
+    ScanSlot slot;
+};
+
+#endif // ADC_DEVICES_H
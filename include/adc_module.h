@@ -2,26 +2,111 @@
 #define ADC_MODULE_H
 
 #include <Arduino.h>
-#include <Adafruit_ADS1X15.h>
+#include "ads1115_driver.h"
+#include "adc_sample.h"
+#include "auto_ranger.h"
+#include "offset_calibrator.h"
+#include "burst_capture.h"
+#include "adc_scanner.h"
+#include "adc_channels.h"
 
 // Global variable declaration for sampling interval
 extern volatile uint16_t samplingIntervalMs;
 
+// Acquisition modes
+// - ACQ_MODE_SINGLE_SHOT: dataTask triggers each conversion and paces itself with the sampling interval
+// - ACQ_MODE_CONTINUOUS: both chips free-run at their data rate and the ALERT/RDY pins wake dataTask
+enum AcquisitionMode { ACQ_MODE_SINGLE_SHOT, ACQ_MODE_CONTINUOUS };
+
+// Background calibration progress
+enum CalibrationState { CALIBRATION_IDLE, CALIBRATION_RUNNING, CALIBRATION_COMPLETE };
+
+// Task notification bit set by each device's ALERT/RDY interrupt
+#define ADC_READY_BIT(device) (1UL << (device))
+#define ADC_READY_BITS ((1UL << ADC_MAX_DEVICES) - 1)
+
 // Function declarations
-void setupADC();
-void calibrateADC();
-bool initializeADS(Adafruit_ADS1115& ads, uint8_t address, const char* name);
-int16_t readShuntDifferential();
-int16_t readADS2Channel0();
-
-// Global variables
-extern Adafruit_ADS1115 ads1;
-extern Adafruit_ADS1115 ads2;
-extern bool ads1_available; // Flag for ADS1115 #1 availability
-extern bool ads2_available; // Flag for ADS1115 #2 availability
-
-// Changed to float type for Android app compatibility
-extern float shuntOffsetFloat;
-extern float ads2OffsetFloat;
+bool setI2CClock(uint32_t hz);
+uint8_t setupADC();  // Probe every device in the channel table; returns the mask of those missing
+bool initializeADS(uint8_t device, const char* name);
+
+// Device and channel table access
+Ads1115& getAdcDevice(uint8_t device);
+bool isAdcDeviceAvailable(uint8_t device);
+bool isChannelAvailable(uint8_t channel);  // Scanned and its device is up
+ChannelReading getChannelReading(uint8_t channel);
+ChannelReading takeChannelReading(uint8_t channel);  // Acquisition task: reading for the sample being stored
+String formatChannels();
+
+// Scan list: indices into ADC_CHANNEL_TABLE, which must include ADC_CURRENT_CHANNEL.
+// requestScanList() may be called from any task; the acquisition task applies it.
+bool requestScanList(const uint8_t* channels, uint8_t count);
+void applyPendingScanList();
+uint8_t getScanList(uint8_t* channels);  // Returns the length; channels holds ADC_MAX_CHANNELS
+
+// Pipelined single-shot acquisition: every device converts its channel of the next scan
+// slot concurrently. Returns true when the slot included the current channel.
+bool readScanSlot(int64_t timestampUs);
+
+// Continuous-conversion acquisition (ALERT/RDY driven)
+void setAcquisitionTask(TaskHandle_t task);
+void requestAcquisitionMode(AcquisitionMode mode);
+void applyPendingAcquisitionMode();
+AcquisitionMode getAcquisitionMode();
+uint32_t waitForConversionReady(TickType_t timeout);
+// Read every device whose ready bit is set; true (with the ALERT/RDY edge time) when the
+// device pacing the sample stream was among them
+bool readReadyConversions(uint32_t readyBits, int64_t& timestampUs);
+
+// Nominal period between stored samples in the active acquisition mode; consumers use it to
+// size their decimation
+uint32_t getInputSamplePeriodUs();
+
+// Non-blocking calibration: requestCalibration() may be called from any task, the
+// acquisition task feeds every stored sample (true while calibration owns the PGAs),
+// and a non-sampling task persists results with serviceCalibration()
+void requestCalibration();
+bool feedCalibration(const AdcSample& sample);
+CalibrationState getCalibrationState();
+uint8_t getCalibrationProgress();
+void serviceCalibration();
+bool loadCalibration();  // Restore offset tables from NVS; false if calibration is needed
+
+// Burst capture around a trigger: arm/trigger/read from any task, the acquisition task
+// feeds every stored sample (and turns relay state changes into triggers). A complete
+// capture stays frozen for download until the next arm.
+bool armCapture(const CaptureConfig& config);
+bool rearmCapture();  // Arm again with the last configuration
+void disarmCapture();
+void triggerCapture();  // Manual trigger
+void feedCapture(const AdcSample& sample);
+CaptureState getCaptureState();
+bool readCaptureRecord(uint16_t index, CaptureRecord& out);
+String formatCaptureStatus();
+// Text chunk "offset_us,ua,uv,quality;..." of up to maxLength characters from record
+// start, quality being packSampleQuality() in hex; returns the number of records in it
+uint16_t formatCaptureChunk(uint16_t start, size_t maxLength, String& out);
+
+// PGA auto-ranging, called with every stored sample; held readings are skipped
+void updateAutoRange(const AdcSample& sample);
+
+// Recovery of lost devices, kept off the sampling task: a lost device wakes the task
+// registered with setRecoveryTask(), which loops on serviceAdcRecovery() (bus clear and
+// reattach with exponential backoff) and sleeps for the ticks it returns
+void setRecoveryTask(TaskHandle_t task);
+TickType_t serviceAdcRecovery();
+String formatRecoveryStatus();  // Outages and degraded time per device and for the pipeline
+
+// Bus timing of a converter, formatted for logs and MCP
+String formatI2CTiming(const Ads1115& ads);
+
+// Timestamped samples produced by dataTask; each consumer reads through its own AdcSampleRing::Reader
+extern AdcSampleRing sampleRing;
+
+// Calibration offsets per gain and the per-channel PGA rangers
+extern GainOffsetTable shuntOffsets;
+extern GainOffsetTable ads2Offsets;
+extern AutoRanger shuntRanger;
+extern AutoRanger ads2Ranger;
 
 #endif // ADC_MODULE_H
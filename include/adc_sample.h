@@ -0,0 +1,145 @@
+#ifndef ADC_SAMPLE_H
+#define ADC_SAMPLE_H
+
+#include <stdint.h>
+#include "sample_ring.h"
+#include "decimation_filter.h"
+#include "fixed_point.h"
+#include "ads1115_driver.h"
+#include "sample_quality.h"
+
+// Consumer-side decimation: 3rd-order CIC followed by a 21-tap compensating FIR
+#define DECIMATION_CIC_ORDER 3
+#define DECIMATION_FIR_TAPS 21
+
+// Analog front end. PLACEHOLDERS: these are not measured from any board. They only fix
+// the scale of the microamp/microvolt outputs. Set them to the fitted shunt and divider,
+// here or with -DSHUNT_RESISTANCE_MICROOHMS=... / -DVOLTAGE_DIVIDER_RATIO=... in the
+// board's build_flags, before trusting current, power or energy readings.
+#ifndef SHUNT_RESISTANCE_MICROOHMS
+#define SHUNT_RESISTANCE_MICROOHMS 1000  // Current shunt across ADS1115 #1 A0-A1
+#endif
+#ifndef VOLTAGE_DIVIDER_RATIO
+#define VOLTAGE_DIVIDER_RATIO 1          // Divider in front of ADS1115 #2 A0 (1: none)
+#endif
+
+// PGA settings of the two channels. Each channel starts at its nominal gain and
+// auto-ranges between its widest and narrowest range; sample values are expressed in
+// Q31 of the widest range so filters see no steps when the gain changes.
+constexpr Ads1115Gain SHUNT_GAIN = GAIN_EIGHT;           // +/-0.512 V nominal
+constexpr Ads1115Gain SHUNT_WIDEST_GAIN = GAIN_TWO;      // +/-2.048 V for current spikes
+constexpr Ads1115Gain SHUNT_NARROWEST_GAIN = GAIN_SIXTEEN;
+constexpr Ads1115Gain ADS2_GAIN = GAIN_ONE;              // +/-4.096 V nominal, covers the supply rail
+constexpr Ads1115Gain ADS2_WIDEST_GAIN = GAIN_ONE;
+constexpr Ads1115Gain ADS2_NARROWEST_GAIN = GAIN_SIXTEEN;
+
+// Engineering units represented by a full-scale reading, for q31ToUnits()
+constexpr int64_t shuntMicroampsPerFullScale(Ads1115Gain gain) {
+    return fullScaleMicrovolts(gain) * 1000000LL / SHUNT_RESISTANCE_MICROOHMS;
+}
+
+constexpr int64_t ads2MicrovoltsPerFullScale(Ads1115Gain gain) {
+    return fullScaleMicrovolts(gain) * VOLTAGE_DIVIDER_RATIO;
+}
+
+// Gain tables for the sample scale of each channel, resolved at compile time
+constexpr int64_t SHUNT_MICROAMPS_FULL_SCALE = shuntMicroampsPerFullScale(SHUNT_WIDEST_GAIN);
+constexpr int64_t ADS2_MICROVOLTS_FULL_SCALE = ads2MicrovoltsPerFullScale(ADS2_WIDEST_GAIN);
+static_assert(SHUNT_MICROAMPS_FULL_SCALE == 2048000000, "GAIN_TWO over 1 mOhm is +/-2048 A");
+static_assert(ADS2_MICROVOLTS_FULL_SCALE == 4096000, "GAIN_ONE is +/-4.096 V");
+
+// Ring capacity; 256 samples is ~300 ms at 860 SPS, enough headroom for the slowest consumer
+#define SAMPLE_RING_CAPACITY 256
+
+// One acquisition step: a current/voltage pair with the time it was taken
+struct AdcSample {
+    int64_t timestampUs;    // esp_timer_get_time() when the pair was stored
+    int16_t shuntRaw;       // ADS1115 #1 differential 0-1, raw counts at shuntGain
+    int16_t ads2Raw;        // ADS1115 #2 single-ended A0, raw counts at ads2Gain
+    Ads1115Gain shuntGain;  // PGA setting each reading was converted with
+    Ads1115Gain ads2Gain;
+    q31_t shunt;            // Offset-corrected, Q31 of SHUNT_WIDEST_GAIN full scale
+    q31_t ads2;             // Offset-corrected, Q31 of ADS2_WIDEST_GAIN full scale
+    uint8_t shuntQuality;   // SAMPLE_QUALITY_* flags of each channel
+    uint8_t ads2Quality;
+    int64_t shuntUs;        // Middle of the conversion each value came from (kept while held);
+    int64_t ads2Us;         // the two differ by the devices' start order or free-running phase
+};
+
+typedef SampleRing<AdcSample, SAMPLE_RING_CAPACITY> AdcSampleRing;
+
+// Per-consumer decimation of both channels from the acquisition rate down to the
+// consumer's output period through the fixed-point CIC/FIR chain. Held inputs go through
+// the filters as the repeated value (a zero-order hold keeps the chain's timing); the
+// quality of each output summarises the inputs since the previous one.
+class SampleDecimator {
+public:
+    explicit SampleDecimator(uint32_t outputPeriodUs)
+        : outputPeriodUs(outputPeriodUs), inputPeriodUs(0) {}
+
+    // Derive the decimation ratio from the acquisition period; filter state is only
+    // reset when the period actually changes
+    void setInputPeriod(uint32_t periodUs) {
+        if (periodUs == inputPeriodUs) {
+            return;
+        }
+        inputPeriodUs = periodUs;
+        uint32_t ratio = periodUs ? outputPeriodUs / periodUs : 1;
+        shuntChain.setRatio(ratio);
+        ads2Chain.setRatio(ratio);
+    }
+
+    // Returns true when the sample completed a new output
+    bool add(const AdcSample& sample) {
+        shuntQualities.add(sample.shuntQuality);
+        ads2Qualities.add(sample.ads2Quality);
+        ads2Chain.push(sample.ads2);
+        if (!shuntChain.push(sample.shunt)) {
+            return false;
+        }
+        shuntQualities.complete();
+        ads2Qualities.complete();
+        return true;
+    }
+
+    // Filtered outputs in the sample scale (Q31 of the widest range)
+    q31_t shunt() const {
+        return shuntChain.output();
+    }
+
+    q31_t ads2() const {
+        return ads2Chain.output();
+    }
+
+    uint8_t shuntQuality() const {
+        return shuntQualities.output();
+    }
+
+    uint8_t ads2Quality() const {
+        return ads2Qualities.output();
+    }
+
+    int32_t shuntMicroamps() const {
+        return q31ToUnits(shunt(), SHUNT_MICROAMPS_FULL_SCALE);
+    }
+
+    int32_t ads2Microvolts() const {
+        return q31ToUnits(ads2(), ADS2_MICROVOLTS_FULL_SCALE);
+    }
+
+    uint32_t getRatio() const {
+        return shuntChain.getRatio();
+    }
+
+private:
+    typedef FixedDecimationChain<DECIMATION_CIC_ORDER, DECIMATION_FIR_TAPS> Chain;
+
+    uint32_t outputPeriodUs;
+    uint32_t inputPeriodUs;
+    Chain shuntChain;
+    Chain ads2Chain;
+    QualityAccumulator shuntQualities;
+    QualityAccumulator ads2Qualities;
+};
+
+#endif // ADC_SAMPLE_H
@@ -0,0 +1,119 @@
+#ifndef ADC_SCANNER_H
+#define ADC_SCANNER_H
+
+#include <stdint.h>
+#include "i2c_bus.h"
+#include "ads1115_driver.h"
+#include "adc_devices.h"
+#include "sample_quality.h"
+
+// Consecutive failures before a device is marked unavailable. With the I2C timeout this
+// bounds how long a dead device can stall the sampling task before it is skipped.
+#define ADC_MAX_ERRORS_BEFORE_LOST 5
+
+// Extra time allowed past the nominal conversion time (+/-10% oscillator tolerance), and
+// the pause between conversion-ready polls
+#define ADC_CONVERSION_MARGIN_US 1000
+#define ADC_READY_POLL_US 50
+
+// Last good reading of a channel, the gain it was converted at, and its SAMPLE_QUALITY_*
+// flags as of the last read or failure
+struct ChannelReading {
+    int16_t raw;
+    Ads1115Gain gain;
+    int64_t timestampUs;  // Middle of the conversion: the instant the value stands for
+    uint8_t quality;
+};
+
+// Device health changes reported to the owner (for logging); errorCount is the
+// consecutive failure count at the time of the event
+enum AdcDeviceEvent {
+    ADC_DEVICE_READ_FAILED,
+    ADC_DEVICE_LOST,
+    ADC_DEVICE_RECOVERED,
+    ADC_DEVICE_CONTINUOUS_FAILED
+};
+typedef void (*AdcDeviceEventHandler)(uint8_t device, AdcDeviceEvent event, uint8_t errorCount);
+
+// The converters of a channel table behind one I2C bus: per-device drivers and health,
+// per-channel gains and last readings, and the scan schedule. Reads scan slots in
+// single-shot mode or collects ready conversions in continuous mode, skipping lost
+// devices until the owner reattaches them. Everything runs on the caller's task, with
+// time taken from the bus, so it runs unchanged against a simulated bus on the host.
+class AdcScanner {
+public:
+    AdcScanner(const AdcChannelConfig* table, uint8_t tableSize);
+
+    void setBus(I2CBus* bus);
+    void setEventHandler(AdcDeviceEventHandler handler);
+
+    // Attach a device's driver; updates its availability
+    bool probe(uint8_t device);
+
+    // Probe a lost device again, reporting ADC_DEVICE_RECOVERED when it answers. Meant for
+    // a recovery task, with the bus locked against the sampling task.
+    bool reattach(uint8_t device);
+
+    // Fails (keeping the current schedule) like ScanScheduler::configure
+    bool configureScan(const uint8_t* scanList, uint8_t scanLength);
+    const ScanScheduler& getScheduler() const;
+
+    // A new gain takes effect with the channel's next single-shot start, or immediately by
+    // restarting continuous conversion
+    void setChannelGain(uint8_t channel, Ads1115Gain gain);
+    Ads1115Gain getChannelGain(uint8_t channel) const;
+    const ChannelReading& getReading(uint8_t channel) const;
+
+    // The reading for the sample being stored. Until the channel converts again, later
+    // calls return it flagged SAMPLE_QUALITY_HELD.
+    ChannelReading takeReading(uint8_t channel);
+
+    Ads1115& getDevice(uint8_t device);
+    bool isDeviceAvailable(uint8_t device) const;
+    bool isChannelAvailable(uint8_t channel) const;  // Scanned and its device is up
+
+    // Single-shot: start the next slot's conversion on every device back to back, then
+    // collect them in start order while the later ones are still converting. timestampUs
+    // is the slot start; each reading is stamped with its own conversion's middle.
+    // Returns true when the slot converted pacingChannel.
+    bool readSlot(int64_t timestampUs, uint8_t pacingChannel);
+
+    // Continuous: every scanned device free-runs its single channel. readReady() reads
+    // the devices whose bit is set in readyBits, stamping each with the middle of the
+    // conversion that ended at its readyTimesUs entry, and returns the mask of devices
+    // serviced.
+    void setContinuous(bool enabled);
+    bool isContinuous() const;
+    uint8_t readReady(uint32_t readyBits, const int64_t* readyTimesUs);
+
+    // Count a failed read against every scanned, available device (no ready signal arrived)
+    void recordSilence();
+
+private:
+    struct Device {
+        Ads1115 ads;
+        bool available;
+        uint8_t errorCount;
+    };
+
+    void selectChannel(uint8_t channel);
+    void startContinuous(uint8_t device);
+    bool collectConversion(Ads1115& ads, uint32_t startedUs, int16_t& reading);
+    void markDevice(uint8_t device, uint8_t quality);
+    void recordError(uint8_t device);
+    void recordReading(uint8_t channel, int16_t raw, int64_t timestampUs);
+    void notify(uint8_t device, AdcDeviceEvent event);
+
+    const AdcChannelConfig* table;
+    uint8_t tableSize;
+    I2CBus* bus;
+    AdcDeviceEventHandler eventHandler;
+    Device devices[ADC_MAX_DEVICES];
+    Ads1115Gain channelGains[ADC_MAX_CHANNELS];
+    ChannelReading readings[ADC_MAX_CHANNELS];
+    uint8_t convertedMask;  // Channels converted at least once
+    ScanScheduler scheduler;
+    bool continuous;
+};
+
+#endif // ADC_SCANNER_H
@@ -0,0 +1,143 @@
+#ifndef ADS1115_DRIVER_H
+#define ADS1115_DRIVER_H
+
+#include <stdint.h>
+#include "i2c_bus.h"
+
+// ADS1115 register pointers
+#define ADS1115_REG_CONVERSION 0x00
+#define ADS1115_REG_CONFIG     0x01
+#define ADS1115_REG_LO_THRESH  0x02
+#define ADS1115_REG_HI_THRESH  0x03
+
+// Config register fields
+#define ADS1115_CONFIG_OS_SINGLE      0x8000  // Write: start a single conversion / Read: 1 = idle
+#define ADS1115_CONFIG_MUX_MASK       0x7000
+#define ADS1115_CONFIG_PGA_MASK       0x0E00
+#define ADS1115_CONFIG_MODE_SINGLE    0x0100
+#define ADS1115_CONFIG_DR_MASK        0x00E0
+#define ADS1115_CONFIG_COMP_QUE_1CONV 0x0000  // ALERT/RDY asserts after every conversion
+#define ADS1115_CONFIG_COMP_QUE_NONE  0x0003
+#define ADS1115_CONFIG_DEFAULT        0x8583  // Power-on reset value
+
+// Input multiplexer settings
+enum Ads1115Mux : uint16_t {
+    ADS1115_MUX_DIFF_0_1 = 0x0000,
+    ADS1115_MUX_DIFF_0_3 = 0x1000,
+    ADS1115_MUX_DIFF_1_3 = 0x2000,
+    ADS1115_MUX_DIFF_2_3 = 0x3000,
+    ADS1115_MUX_SINGLE_0 = 0x4000,
+    ADS1115_MUX_SINGLE_1 = 0x5000,
+    ADS1115_MUX_SINGLE_2 = 0x6000,
+    ADS1115_MUX_SINGLE_3 = 0x7000
+};
+
+// Programmable gain amplifier settings (full-scale range in comments)
+enum Ads1115Gain : uint16_t {
+    GAIN_TWOTHIRDS = 0x0000,  // +/-6.144 V
+    GAIN_ONE       = 0x0200,  // +/-4.096 V
+    GAIN_TWO       = 0x0400,  // +/-2.048 V
+    GAIN_FOUR      = 0x0600,  // +/-1.024 V
+    GAIN_EIGHT     = 0x0800,  // +/-0.512 V
+    GAIN_SIXTEEN   = 0x0A00   // +/-0.256 V
+};
+
+#define ADS1115_GAIN_COUNT 6
+
+// Position of a gain setting in per-gain tables (0 = GAIN_TWOTHIRDS ... 5 = GAIN_SIXTEEN)
+constexpr int ads1115GainIndex(Ads1115Gain gain) {
+    return gain >> 9;
+}
+
+constexpr Ads1115Gain ads1115GainFromIndex(int index) {
+    return static_cast<Ads1115Gain>(index << 9);
+}
+
+// Full-scale input range of a PGA setting in microvolts
+constexpr int64_t fullScaleMicrovolts(Ads1115Gain gain) {
+    return gain == GAIN_TWOTHIRDS ? 6144000 :
+           gain == GAIN_ONE       ? 4096000 :
+           gain == GAIN_TWO       ? 2048000 :
+           gain == GAIN_FOUR      ? 1024000 :
+           gain == GAIN_EIGHT     ? 512000 : 256000;
+}
+
+// Data rate settings
+enum Ads1115DataRate : uint16_t {
+    ADS1115_RATE_8SPS   = 0x0000,
+    ADS1115_RATE_16SPS  = 0x0020,
+    ADS1115_RATE_32SPS  = 0x0040,
+    ADS1115_RATE_64SPS  = 0x0060,
+    ADS1115_RATE_128SPS = 0x0080,
+    ADS1115_RATE_250SPS = 0x00A0,
+    ADS1115_RATE_475SPS = 0x00C0,
+    ADS1115_RATE_860SPS = 0x00E0
+};
+
+// Per-transaction bus timing, measured around every I2C transfer
+struct Ads1115Timing {
+    uint32_t transactions;  // Completed transfers (writes and reads)
+    uint32_t failures;      // NACKs, timeouts and short reads
+    uint32_t lastUs;        // Duration of the most recent transfer
+    uint32_t maxUs;         // Longest transfer seen
+    uint64_t totalUs;       // Sum of all transfer durations
+};
+
+// Register-level ADS1115 driver.
+//
+// The config register is cached: gain/rate/mux setters only touch the cache and the
+// register is written when a conversion is started. The driver also tracks the device's
+// register pointer, so in continuous mode a sample is a single 2-byte read of the
+// conversion register with no pointer or config traffic.
+class Ads1115 {
+public:
+    Ads1115();
+
+    // Attach to a device; probes the address and reads back the config register
+    bool begin(I2CBus* bus, uint8_t address);
+
+    void setGain(Ads1115Gain gain);
+    Ads1115Gain getGain() const;
+    void setDataRate(Ads1115DataRate rate);
+    Ads1115DataRate getDataRate() const;
+    void setMux(Ads1115Mux mux);
+    Ads1115Mux getMux() const;
+
+    // Single-shot conversions
+    bool startSingleShot();
+    bool isConversionReady(bool& ready);
+    bool readSingleShot(int16_t& value);  // Start, wait and read; used off the hot path
+
+    // Continuous conversion with ALERT/RDY pulsing after every conversion
+    bool startContinuous();
+    bool isContinuous() const;
+
+    // Read the conversion register (pointer write only if the pointer moved)
+    bool readConversion(int16_t& value);
+
+    // Nominal conversion time for the configured data rate
+    uint32_t conversionTimeUs() const;
+
+    uint8_t getAddress() const;
+    const Ads1115Timing& getTiming() const;
+    void resetTiming();
+
+private:
+    bool writeRegister(uint8_t reg, uint16_t value);
+    bool readRegister(uint8_t reg, uint16_t& value);
+    bool setPointer(uint8_t reg);
+    bool timedWrite(const uint8_t* data, size_t length);
+    bool timedRead(uint8_t* data, size_t length);
+    void recordTransaction(uint32_t startUs, bool success);
+
+    I2CBus* bus;
+    uint8_t address;
+    uint16_t config;          // Cached config (without the OS bit)
+    uint8_t pointer;          // Register the device's pointer currently addresses
+    bool pointerKnown;
+    bool thresholdsArmed;     // Hi/Lo thresholds programmed for conversion-ready mode
+    bool continuous;
+    Ads1115Timing timing;
+};
+
+#endif // ADS1115_DRIVER_H
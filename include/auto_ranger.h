@@ -0,0 +1,63 @@
+#ifndef AUTO_RANGER_H
+#define AUTO_RANGER_H
+
+#include <stdint.h>
+#include "ads1115_driver.h"
+#include "fixed_point.h"
+
+// Step to a wider range as soon as a reading gets this close to clipping
+#define AUTO_RANGE_CLIP_COUNTS 30000
+// Step to a narrower range once readings stay below this for AUTO_RANGE_SETTLE_SAMPLES.
+// After the step the same signal reads at most 2x, i.e. below the clip threshold,
+// which is the hysteresis that keeps the ranger from oscillating.
+#define AUTO_RANGE_LOW_COUNTS 13000
+#define AUTO_RANGE_SETTLE_SAMPLES 16
+
+// Rescale a Q31 fraction of one gain's full scale to another gain's full scale
+constexpr q31_t rescaleQ31(q31_t value, Ads1115Gain from, Ads1115Gain to) {
+    return saturateQ31(static_cast<int64_t>(value) * fullScaleMicrovolts(from) / fullScaleMicrovolts(to));
+}
+
+// Per-channel PGA auto-ranging. Fed with every raw reading, it picks the gain for the
+// next conversion between a widest and a narrowest allowed range.
+class AutoRanger {
+public:
+    AutoRanger(Ads1115Gain widest, Ads1115Gain narrowest, Ads1115Gain initial);
+
+    // Returns true when the gain for the next conversion changed
+    bool update(int16_t raw);
+
+    Ads1115Gain getGain() const;
+    void setGain(Ads1115Gain gain);
+    uint32_t getSwitchCount() const;
+
+private:
+    int widestIndex;
+    int narrowestIndex;
+    int gainIndex;
+    uint16_t quietSamples;
+    uint32_t switchCount;
+};
+
+// Calibration offsets per gain, in Q31 of that gain's full scale. The offset is
+// input-referred, so one measured at a single gain is rescaled to all the others;
+// offsets measured at a specific gain can then replace the rescaled estimate.
+class GainOffsetTable {
+public:
+    explicit GainOffsetTable(Ads1115Gain referenceGain);
+
+    void setCalibratedOffset(Ads1115Gain gain, q31_t offset);
+    void setOffset(Ads1115Gain gain, q31_t offset);
+    q31_t getOffset(Ads1115Gain gain) const;
+
+    // Offset-corrected reading taken at gain, in Q31 of the reference range
+    q31_t correct(int16_t raw, Ads1115Gain gain) const;
+
+    Ads1115Gain getReferenceGain() const;
+
+private:
+    Ads1115Gain referenceGain;
+    q31_t offsets[ADS1115_GAIN_COUNT];
+};
+
+#endif // AUTO_RANGER_H
@@ -6,120 +6,178 @@
 #include "ble_module.h"         // For deviceConnected, BLEDevice, etc.
 #include "wifi_module.h"        // For scanWifiNetworks, connectToWifi
 #include "relay_module.h"       // For relayPins, relayStates, blinkRelayFeedback
-#include "adc_module.h"         // For calibrateADC
+#include "adc_module.h"         // For requestCalibration
+#include "energy_meter.h"       // For resetEnergyTotals
+#include "trend_monitor.h"      // For setTrendDeviation
+#include "sampling_config.h"    // For setSamplingInterval, setAdaptiveSampling
+#include "command_parser.h"     // For parseCommand and SUPPORTED_COMMANDS
 #include <ArduinoOTA.h>
 #include <Preferences.h>
 #include "config.h"             // For LOG_INFO macros and prefs
 
-// Command validation structure for documenting and validating incoming commands
-struct CommandDefinition {
-    const char* command;
-    const char* format;
-    const char* description;
-};
+// Payload characters per CAPTURE:DATA notification (stays under a 512-byte attribute)
+#define CAPTURE_CHUNK_CHARS 440
 
-// Array of supported commands with their expected formats and descriptions
-const CommandDefinition SUPPORTED_COMMANDS[] = {
-    {"CALIBRATE", "CALIBRATE", "Initiates ADC calibration procedure"},
-    {"OTA", "OTA", "Enables Over-The-Air updates"},
-    {"TOGGLE", "TOGGLE_<pin>", "Toggles the relay with the specified pin number"},
-    {"SET", "SET_<pin>_<ON|OFF>", "Sets the relay with specified pin to ON or OFF"},
-    {"SET_SAMPLING_RATE", "SET_SAMPLING_RATE_<interval>", "Sets sampling interval in ms (5-1000)"},
-    {"SCAN", "SCAN", "Scans for available WiFi networks"},
-    {"SELECT", "SELECT_<ssid>:<password>", "Connects to specified WiFi network"},
-    {"DISCONNECT", "DISCONNECT", "Disconnects from WiFi network"}
-};
+// Limits commands are validated against
+inline CommandEnvironment commandEnvironment() {
+    CommandEnvironment environment = {relayPins, 4, PROTOCOL_VERSION_MAJOR, PROTOCOL_VERSION_MINOR,
+                                      TREND_MAX_DEVIATION_UNITS, BURST_CAPTURE_CAPACITY};
+    return environment;
+}
 
-// Make function inline to avoid multiple definition errors
-inline bool validateCommand(const String& command, String& errorMessage) {
-    if (command == "CALIBRATE" || command == "OTA" || command == "SCAN" || command == "DISCONNECT") {
-        return true;
-    } 
-    else if (command.startsWith("TOGGLE_")) {
-        int pin = command.substring(7).toInt();
-        bool validPin = false;
-        for (int i = 0; i < 4; i++) {
-            if (relayPins[i] == pin) {
-                validPin = true;
-                break;
-            }
-        }
-        if (!validPin) {
-            errorMessage = "ERROR:INVALID_PIN:" + String(pin);
-            return false;
-        }
-        return true;
+inline void notifyReply(BLECharacteristic* characteristic, const char* reply) {
+    if (characteristic) {
+        characteristic->setValue(reply);
+        characteristic->notify();
     }
-    else if (command.startsWith("SET_")) {
-        int pin = command.substring(4, 6).toInt();
-        String stateStr = command.substring(7);
-        bool validPin = false;
-        
-        for (int i = 0; i < 4; i++) {
-            if (relayPins[i] == pin) {
-                validPin = true;
-                break;
+}
+
+// Drives a relay and keeps its state in NVS
+inline void applyRelayState(uint8_t relay, bool state) {
+    relayStates[relay] = state;
+    digitalWrite(relayPins[relay], state ? HIGH : LOW);
+    blinkRelayFeedback();
+
+    // Save relay state to preferences
+    char key[12];
+    snprintf(key, sizeof(key), "relay%u", relay);
+    prefs.putBool(key, state);
+}
+
+// Runs a parsed command, whichever characteristic it was written to; replies go out on the
+// relay characteristic, WiFi results on the WiFi characteristic
+inline void dispatchCommand(const ParsedCommand& command) {
+    char reply[64];
+    switch (command.id) {
+        case COMMAND_PROTOCOL:
+            if (command.format == TELEMETRY_FORMAT_STREAM) {
+                // Request a larger MTU before streaming; one sample has to fit a notification
+                size_t payload = getNotifyPayloadLimit();
+                if (payload < SAMPLE_BATCH_MIN_PAYLOAD) {
+                    snprintf(reply, sizeof(reply), "ERROR:MTU_TOO_SMALL:%u", (unsigned)(payload + 3));
+                } else {
+                    setTelemetryFormat(TELEMETRY_FORMAT_STREAM);
+                    snprintf(reply, sizeof(reply), "PROTOCOL:" PROTOCOL_VERSION ":STREAM:%d:%d", TELEMETRY_FRAME_VERSION,
+                             SAMPLE_BATCH_VERSION);
+                }
+            } else if (command.format == TELEMETRY_FORMAT_BINARY) {
+                setTelemetryFormat(TELEMETRY_FORMAT_BINARY);
+                snprintf(reply, sizeof(reply), "PROTOCOL:" PROTOCOL_VERSION ":BINARY:%d", TELEMETRY_FRAME_VERSION);
+            } else {
+                setTelemetryFormat(TELEMETRY_FORMAT_JSON);
+                snprintf(reply, sizeof(reply), "PROTOCOL:" PROTOCOL_VERSION ":JSON");
             }
+            LOG_INFO("Protocol: %s", reply);
+            notifyReply(pRelayCharacteristic, reply);
+            break;
+        case COMMAND_CALIBRATE:
+            // Runs in the background; bleTask reports progress and completion
+            LOG_INFO("Calibration requested");
+            requestCalibration();
+            notifyReply(pRelayCharacteristic, "CALIBRATE:STARTED");
+            break;
+        case COMMAND_OTA:
+            notifyReply(pRelayCharacteristic, "OTA:START");
+            // OTA is handled in loop() by ArduinoOTA.handle()
+            break;
+        case COMMAND_TOGGLE: {
+            bool state = !relayStates[command.relay];
+            applyRelayState(command.relay, state);
+            LOG_INFO("Relay %d toggled to %s", command.pin, state ? "ON" : "OFF");
+            snprintf(reply, sizeof(reply), "LOG:Relay %d toggled to %s", command.pin, state ? "ON" : "OFF");
+            notifyReply(pRelayCharacteristic, reply);
+            snprintf(reply, sizeof(reply), "RELAY_UPDATE:%d:%s", command.pin, state ? "ON" : "OFF");
+            notifyReply(pRelayCharacteristic, reply);
+            break;
         }
-        
-        if (!validPin) {
-            errorMessage = "ERROR:INVALID_PIN:" + String(pin);
-            return false;
-        }
-        
-        if (stateStr != "ON" && stateStr != "OFF") {
-            errorMessage = "ERROR:INVALID_STATE:" + stateStr;
-            return false;
+        case COMMAND_SET_RELAY:
+            applyRelayState(command.relay, command.on);
+            snprintf(reply, sizeof(reply), "RELAY_UPDATE:%d:%s", command.pin, command.on ? "ON" : "OFF");
+            notifyReply(pRelayCharacteristic, reply);
+            break;
+        case COMMAND_SET_SAMPLING_RATE:
+            setSamplingInterval(command.value);
+            prefs.putUInt("samplingIntervalMs", command.value);
+            snprintf(reply, sizeof(reply), "SAMPLING_RATE:%u", (unsigned)command.value);
+            notifyReply(pRelayCharacteristic, reply);
+            break;
+        case COMMAND_ACQ_MODE: {
+            AcquisitionMode mode = command.continuous ? ACQ_MODE_CONTINUOUS : ACQ_MODE_SINGLE_SHOT;
+            requestAcquisitionMode(mode);
+            prefs.putUChar("acqMode", mode);
+            notifyReply(pRelayCharacteristic, command.continuous ? "ACQ_MODE:CONTINUOUS" : "ACQ_MODE:SINGLE");
+            break;
         }
-        
-        return true;
-    }
-    else if (command.startsWith("SET_SAMPLING_RATE_")) {
-        int interval = command.substring(18).toInt();
-        if (interval < 5 || interval > 1000) {
-            errorMessage = "ERROR:INVALID_SAMPLING_RATE:Value must be between 5-1000";
-            return false;
-        }
-        return true;
-    }
-    else if (command.startsWith("SELECT_")) {
-        String wifiData = command.substring(7);
-        int colonIndex = wifiData.indexOf(':');
-        if (colonIndex == -1) {
-            errorMessage = "ERROR:INVALID_WIFI_FORMAT:Missing colon separator";
-            return false;
+        case COMMAND_ADAPTIVE:
+            setAdaptiveSampling(command.on);
+            if (command.on) {
+                snprintf(reply, sizeof(reply), "ADAPTIVE:ON:%u", (unsigned)getEffectiveSamplingInterval());
+                notifyReply(pRelayCharacteristic, reply);
+            } else {
+                notifyReply(pRelayCharacteristic, "ADAPTIVE:OFF");
+            }
+            break;
+        case COMMAND_TREND:
+            setTrendDeviation(command.voltage ? TREND_CHANNEL_VOLTAGE : TREND_CHANNEL_CURRENT, command.value);
+            snprintf(reply, sizeof(reply), "TREND:%s:%u", command.voltage ? "VOLTAGE" : "CURRENT", (unsigned)command.value);
+            notifyReply(pRelayCharacteristic, reply);
+            break;
+        case COMMAND_RESET_ENERGY:
+            resetEnergyTotals();
+            notifyReply(pRelayCharacteristic, "RESET_ENERGY:OK");
+            break;
+        case COMMAND_CAPTURE_ARM:
+            notifyReply(pRelayCharacteristic, rearmCapture() ? "CAPTURE:ARMED" : "ERROR:CAPTURE:ARM_FAILED");
+            break;
+        case COMMAND_CAPTURE_TRIGGER:
+            triggerCapture();
+            break;
+        case COMMAND_CAPTURE_STOP:
+            disarmCapture();
+            notifyReply(pRelayCharacteristic, "CAPTURE:STOPPED");
+            break;
+        case COMMAND_CAPTURE_READ: {
+            // One chunk per request; the client asks for index + count next until CAPTURE:END
+            uint16_t start = command.value;
+            String chunk;
+            uint16_t count = formatCaptureChunk(start, CAPTURE_CHUNK_CHARS, chunk);
+            String captureReply = count ? "CAPTURE:DATA:" + String(start) + ":" + String(count) + ":" + chunk
+                                        : "CAPTURE:END:" + String(start);
+            notifyReply(pRelayCharacteristic, captureReply.c_str());
+            break;
         }
-        String ssid = wifiData.substring(0, colonIndex);
-        if (ssid.length() == 0) {
-            errorMessage = "ERROR:INVALID_SSID:Empty SSID";
-            return false;
+        case COMMAND_SCAN:
+            scanWifiNetworks();
+            break;
+        case COMMAND_SELECT: {
+            char ssid[COMMAND_SSID_MAX_LENGTH + 1];
+            char password[COMMAND_PASSWORD_MAX_LENGTH + 1];
+            snprintf(ssid, sizeof(ssid), "%.*s", (int)command.ssidLength, command.ssid);
+            snprintf(password, sizeof(password), "%.*s", (int)command.passwordLength, command.password);
+            connectToWifi(ssid, password);
+            break;
         }
-        return true;
+        case COMMAND_DISCONNECT:
+            disconnectWifi();
+            break;
+        case COMMAND_NONE:
+            break;
     }
-    
-    errorMessage = "ERROR:UNKNOWN_COMMAND:" + command;
-    return false;
 }
 
-// Make function inline to avoid multiple definition errors
-inline bool checkProtocolVersionCompatibility(const String& clientVersion, String& errorMessage) {
-    // Extract version components
-    int clientMajor = 0, clientMinor = 0, clientPatch = 0;
-    sscanf(clientVersion.c_str(), "%d.%d.%d", &clientMajor, &clientMinor, &clientPatch);
-    
-    // Compare with our version
-    if (clientMajor != PROTOCOL_VERSION_MAJOR) {
-        errorMessage = "ERROR:INCOMPATIBLE_VERSION:Major version mismatch";
-        return false;
-    }
-    
-    // Minor version differences are okay if client is lower than server
-    if (clientMinor > PROTOCOL_VERSION_MINOR) {
-        errorMessage = "ERROR:INCOMPATIBLE_VERSION:Client using newer minor version";
-        return false;
+// Parses a command written to the relay or WiFi characteristic in place and runs it; a
+// rejected command is answered on the characteristic it came from
+inline void handleCommand(const std::string& value, BLECharacteristic* replyCharacteristic) {
+    CommandEnvironment environment = commandEnvironment();
+    ParsedCommand command;
+    if (!parseCommand(value.data(), value.size(), environment, command)) {
+        char error[COMMAND_ERROR_CAPACITY];
+        formatCommandError(command, environment, error, sizeof(error));
+        LOG_ERROR("Command validation failed: %s", error);
+        notifyReply(replyCharacteristic, error);
+        return;
     }
-    
-    return true;
+    dispatchCommand(command);
 }
 
 class MyServerCallbacks : public BLEServerCallbacks {
@@ -128,18 +186,27 @@ public:
         deviceConnected = true;
         LOG_INFO("Device connected");
         
+        // Every client starts on JSON; one that knows the binary frame asks for it with
+        // PROTOCOL_<version>_BINARY after reading this
+        setTelemetryFormat(TELEMETRY_FORMAT_JSON);
+        resetNotifyCredits();
+
         // Send protocol version information on connection
         if (pDataCharacteristic) {
-            String versionInfo = "{\"protocol_version\":\"" PROTOCOL_VERSION "\",\"device_name\":\"ESP32_ADS1115\"}";
+            String versionInfo = "{\"protocol_version\":\"" PROTOCOL_VERSION "\",\"device_name\":\"ESP32_ADS1115\","
+                                 "\"formats\":[\"json\",\"binary\",\"stream\"],\"frame_version\":" + String(TELEMETRY_FRAME_VERSION) +
+                                 ",\"batch_version\":" + String(SAMPLE_BATCH_VERSION) + ",\"flow_control\":\"credits\"}";
             pDataCharacteristic->setValue(versionInfo.c_str());
             pDataCharacteristic->notify();
             LOG_INFO("Sent protocol version: %s", PROTOCOL_VERSION);
         }
+        signalBleTask(); // First frame goes out at once
     }
     
     void onDisconnect(BLEServer* pServer) override {
         deviceConnected = false;
         LOG_INFO("Device disconnected");
+        signalBleTask(); // Advertising restarts at once
     }
 };
 
@@ -147,90 +214,8 @@ class RelayControlCallback : public BLECharacteristicCallbacks {
 public:
     void onWrite(BLECharacteristic* pCharacteristic) override {
         std::string value = pCharacteristic->getValue();
-        String command = String(value.c_str());
-        LOG_INFO("Received command: %s", command.c_str());
-        
-        // Validate command
-        String errorMessage = "";
-        if (!validateCommand(command, errorMessage)) {
-            LOG_ERROR("Command validation failed: %s", errorMessage.c_str());
-            if (pRelayCharacteristic) {
-                pRelayCharacteristic->setValue(errorMessage.c_str());
-                pRelayCharacteristic->notify();
-            }
-            return;
-        }
-        
-        // Process valid command
-        if (command == "CALIBRATE") {
-            LOG_INFO("Calibration started");
-            calibrateADC();
-            LOG_INFO("Calibration complete");
-            if (pRelayCharacteristic) {
-                pRelayCharacteristic->setValue("LOG:Calibration complete");
-                pRelayCharacteristic->notify();
-            }
-        } else if (command == "OTA") {
-            if (pRelayCharacteristic) {
-                pRelayCharacteristic->setValue("OTA:START");
-                pRelayCharacteristic->notify();
-            }
-            // OTA is handled in main loop/task by ArduinoOTA.handle()
-        } else if (command.startsWith("TOGGLE_")) {
-            int pin = command.substring(7).toInt();
-            for (int i = 0; i < 4; i++) {
-                if (relayPins[i] == pin) {
-                    relayStates[i] = !relayStates[i];
-                    digitalWrite(relayPins[i], relayStates[i] ? HIGH : LOW);
-                    blinkRelayFeedback();
-                    LOG_INFO("Relay %d toggled to %s", pin, relayStates[i] ? "ON" : "OFF");
-                    
-                    // Save relay state to preferences
-                    prefs.putBool(("relay" + String(i)).c_str(), relayStates[i]);
-                    
-                    if (pRelayCharacteristic) {
-                        pRelayCharacteristic->setValue(String("LOG:Relay " + String(pin) + " toggled to " + (relayStates[i] ? "ON" : "OFF")).c_str());
-                        pRelayCharacteristic->notify();
-                    }
-                    if (pRelayCharacteristic) {
-                        pRelayCharacteristic->setValue(String("RELAY_UPDATE:" + String(pin) + ":" + (relayStates[i] ? "ON" : "OFF")).c_str());
-                        pRelayCharacteristic->notify();
-                    }
-                    break;
-                }
-            }
-        } else if (command.startsWith("SET_")) {
-            int pin = command.substring(4, 6).toInt();
-            String stateStr = command.substring(7);
-            bool state = (stateStr == "ON");
-            for (int i = 0; i < 4; i++) {
-                if (relayPins[i] == pin) {
-                    relayStates[i] = state;
-                    digitalWrite(relayPins[i], state ? HIGH : LOW);
-                    blinkRelayFeedback();
-                    
-                    // Save relay state to preferences
-                    prefs.putBool(("relay" + String(i)).c_str(), relayStates[i]);
-                    
-                    if (pRelayCharacteristic) {
-                        pRelayCharacteristic->setValue(String("RELAY_UPDATE:" + String(pin) + ":" + (state ? "ON" : "OFF")).c_str());
-                        pRelayCharacteristic->notify();
-                    }
-                    break;
-                }
-            }
-        } else if (command.startsWith("SET_SAMPLING_RATE_")) {
-            int interval = command.substring(18).toInt();
-            if (interval >= 5 && interval <= 1000) {
-                extern volatile uint16_t samplingIntervalMs;
-                samplingIntervalMs = interval;
-                prefs.putUInt("samplingIntervalMs", interval);
-                if (pRelayCharacteristic) {
-                    pRelayCharacteristic->setValue(String("SAMPLING_RATE:" + String(interval)).c_str());
-                    pRelayCharacteristic->notify();
-                }
-            }
-        }
+        LOG_INFO("Received command: %s", value.c_str());
+        handleCommand(value, pRelayCharacteristic);
     }
 };
 
@@ -238,33 +223,42 @@ class WifiControlCallback : public BLECharacteristicCallbacks {
 public:
     void onWrite(BLECharacteristic* pCharacteristic) override {
         std::string value = pCharacteristic->getValue();
-        String command = String(value.c_str());
-        LOG_INFO("Received WiFi command: %s", command.c_str());
-        
-        // Validate command
-        String errorMessage = "";
-        if (!validateCommand(command, errorMessage)) {
-            LOG_ERROR("WiFi command validation failed: %s", errorMessage.c_str());
-            if (pWifiCharacteristic) {
-                pWifiCharacteristic->setValue(errorMessage.c_str());
-                pWifiCharacteristic->notify();
-            }
+        LOG_INFO("Received WiFi command: %s", value.c_str());
+        handleCommand(value, pWifiCharacteristic);
+    }
+};
+
+// Credits for the data characteristic: each write of a little-endian count (1-4 bytes)
+// adds that many notifications; reads return the queue counters
+class FlowControlCallback : public BLECharacteristicCallbacks {
+public:
+    void onWrite(BLECharacteristic* pCharacteristic) override {
+        std::string value = pCharacteristic->getValue();
+        if (value.empty() || value.size() > 4) {
+            LOG_WARNING("Ignoring credit grant of %u bytes", (unsigned)value.size());
             return;
         }
-        
-        // Process valid command
-        if (command == "SCAN") {
-            scanWifiNetworks();
-        } else if (command.startsWith("SELECT_")) {
-            String wifiData = command.substring(7);
-            int colonIndex = wifiData.indexOf(':');
-            if (colonIndex != -1) {
-                String ssid = wifiData.substring(0, colonIndex);
-                String password = wifiData.substring(colonIndex + 1);
-                connectToWifi(ssid, password);
-            }
-        } else if (command == "DISCONNECT") {
-            disconnectWifi();
+        uint32_t credits = 0;
+        for (size_t i = 0; i < value.size(); i++) {
+            credits |= static_cast<uint32_t>(static_cast<uint8_t>(value[i])) << (8 * i);
+        }
+        grantNotifyCredits(credits);
+    }
+
+    void onRead(BLECharacteristic* pCharacteristic) override {
+        pCharacteristic->setValue(formatNotifyStatus().c_str());
+    }
+};
+
+// Outcome of each data notification, reported from within notify(): serviceNotifyQueue()
+// only counts and charges delivered ones (refused: congestion, notifications disabled)
+class DataStatusCallback : public BLECharacteristicCallbacks {
+public:
+    void onStatus(BLECharacteristic* pCharacteristic, Status s, uint32_t code) override {
+        bool delivered = s == SUCCESS_NOTIFY || s == SUCCESS_INDICATE;
+        recordNotifyStatus(delivered);
+        if (!delivered) {
+            LOG_DEBUG("Data notification failed: status %d, code %u", (int)s, code);
         }
     }
 };
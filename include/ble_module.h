@@ -3,24 +3,63 @@
 #include <BLEDevice.h>
 #include <BLEUtils.h>
 #include <BLEServer.h>
+#include "telemetry_frame.h"
+#include "sample_batch.h"
+#include "notify_queue.h"
 
 // BLE UUIDs
 #define SERVICE_UUID        "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
 #define DATA_CHARACTERISTIC_UUID "beb5483e-36e1-4688-b7f5-ea07361b26a8"
 #define RELAY_CONTROL_UUID  "a1b2c3d4-e5f6-7890-abcd-ef1234567890"
 #define WIFI_CONTROL_UUID   "c1d2e3f4-a5b6-7890-abcd-ef1234567890"
+#define SPECTRUM_CHARACTERISTIC_UUID "d1e2f3a4-b5c6-7890-abcd-ef1234567890"
+#define FLOW_CONTROL_UUID   "e1f2a3b4-c5d6-7890-abcd-ef1234567890"
+
+// Shunt spectrum characteristic (read/notify, one update per FFT frame); build with
+// -DBLE_SPECTRUM_CHARACTERISTIC=0 to leave it out of the GATT table
+#ifndef BLE_SPECTRUM_CHARACTERISTIC
+#define BLE_SPECTRUM_CHARACTERISTIC 1
+#endif
 
 // Forward declarations for BLE callback classes
 class MyServerCallbacks;
 class RelayControlCallback;
 class WifiControlCallback;
+class FlowControlCallback;
+class DataStatusCallback;
 
 void setupBLE();
 void notifyData(const char* data);
+void notifyData(const uint8_t* data, size_t length);
+void notifySpectrum(const char* data);
+size_t getNotifyPayloadLimit(); // Negotiated ATT MTU less the 3-byte notification header
+
+// Data characteristic flow control. notifyData() only queues; bleTask sends with
+// serviceNotifyQueue(). A client that writes a little-endian credit count to the flow
+// control characteristic gets one notification per credit from then on; reading it
+// returns formatNotifyStatus().
+bool serviceNotifyQueue(); // True while entries the credits allow out are still waiting
+void grantNotifyCredits(uint32_t credits);
+void resetNotifyCredits();
+void recordNotifyStatus(bool delivered); // DataStatusCallback: outcome of the notify() in progress
+String formatNotifyStatus();
 void handleBLEConnections(); // Added function declaration
+
+// bleTask sleeps between passes and is woken through its task notification: by dataTask
+// once an output period's worth of samples (and any trend point) is in the rings, and by
+// the BLE callbacks on connection changes and credit grants
+void setBleTask(TaskHandle_t task);
+void signalBleTask();
+
+// Telemetry encoding of the current connection: JSON until the client negotiates binary
+// or streaming with PROTOCOL_<version>_<BINARY|STREAM>, and again after every new connection
+void setTelemetryFormat(TelemetryFormat format);
+TelemetryFormat getTelemetryFormat();
 extern BLECharacteristic* pDataCharacteristic;
 extern BLECharacteristic* pRelayCharacteristic;
 extern BLECharacteristic* pWifiCharacteristic;
+extern BLECharacteristic* pSpectrumCharacteristic;
+extern BLECharacteristic* pFlowControlCharacteristic;
 extern BLEServer* pServer;
 extern bool deviceConnected;
 
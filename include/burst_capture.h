@@ -0,0 +1,88 @@
+#ifndef BURST_CAPTURE_H
+#define BURST_CAPTURE_H
+
+#include <stdint.h>
+#include "adc_sample.h"
+
+// Samples held by the capture buffer (pre + post trigger); 2.4 s at 860 SPS
+#define BURST_CAPTURE_CAPACITY 2048
+
+// Defaults used when a capture is armed without explicit depths
+#define BURST_CAPTURE_DEFAULT_PRE 256
+#define BURST_CAPTURE_DEFAULT_POST 768
+
+enum CaptureState { CAPTURE_IDLE, CAPTURE_ARMED, CAPTURE_TRIGGERED, CAPTURE_COMPLETE };
+enum CaptureTriggerSource { CAPTURE_TRIGGER_NONE, CAPTURE_TRIGGER_THRESHOLD, CAPTURE_TRIGGER_RELAY, CAPTURE_TRIGGER_MANUAL };
+enum CaptureChannel { CAPTURE_CHANNEL_SHUNT, CAPTURE_CHANNEL_ADS2 };
+enum CaptureEdge { CAPTURE_EDGE_RISING, CAPTURE_EDGE_FALLING, CAPTURE_EDGE_EITHER };
+
+struct CaptureConfig {
+    uint16_t preSamples;    // Samples kept from before the trigger
+    uint16_t postSamples;   // Samples from the trigger sample on (at least 1)
+    bool thresholdEnabled;  // Fire when the channel crosses level on the given edge
+    CaptureChannel channel;
+    CaptureEdge edge;
+    q31_t level;            // In the channel's Q31 sample scale
+    bool relayEnabled;      // Fire on relay state changes (detected by the caller)
+};
+
+// One captured sample, as read back: time relative to the trigger sample
+struct CaptureRecord {
+    int32_t offsetUs;
+    q31_t shunt;
+    q31_t ads2;
+    uint8_t shuntQuality;  // SAMPLE_QUALITY_* flags
+    uint8_t ads2Quality;
+};
+
+// Pre/post-trigger recorder for raw-rate traces. While armed, samples circulate through a
+// preallocated buffer; a trigger marks the current sample and recording continues for
+// the post-trigger depth, after which the buffer is frozen until re-armed. add() is O(1)
+// and allocation-free so it can run on the acquisition task. Manual and relay triggers
+// are always accepted while armed; the threshold trigger only when enabled, and only on
+// fresh conversions of its channel.
+class BurstCapture {
+public:
+    BurstCapture();
+
+    bool arm(const CaptureConfig& config);  // False if the depths do not fit the buffer
+    void disarm();
+    void add(const AdcSample& sample);
+    void trigger(CaptureTriggerSource source);  // Takes effect with the next add()
+
+    CaptureState getState() const;
+    const CaptureConfig& getConfig() const;
+    CaptureTriggerSource getTriggerSource() const;
+    int64_t getTriggerTimestampUs() const;
+    uint16_t getLength() const;            // Samples in a complete capture
+    uint16_t getPreTriggerLength() const;  // May be below preSamples if triggered early
+
+    // Chronological readout of a complete capture
+    bool read(uint16_t index, CaptureRecord& out) const;
+
+private:
+    struct StoredSample {
+        uint32_t timeUs;  // Low 32 bits of the timestamp; offsets are taken modulo 2^32
+        q31_t shunt;
+        q31_t ads2;
+    };
+
+    bool crossed(q31_t value) const;
+
+    StoredSample buffer[BURST_CAPTURE_CAPACITY];
+    uint16_t qualities[BURST_CAPTURE_CAPACITY];  // packSampleQuality(); apart to avoid padding
+    CaptureConfig config;
+    CaptureState state;
+    CaptureTriggerSource pendingTrigger;
+    CaptureTriggerSource triggerSource;
+    uint16_t writeIndex;
+    uint16_t filled;
+    uint16_t triggerIndex;
+    uint16_t preAvailable;
+    uint16_t postRemaining;
+    int64_t triggerTimestampUs;
+    bool hasPrevious;
+    q31_t previousLevel;
+};
+
+#endif // BURST_CAPTURE_H
@@ -0,0 +1,150 @@
+#ifndef COMMAND_PARSER_H
+#define COMMAND_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_frame.h"
+
+// Sampling interval range of SET_SAMPLING_RATE_<interval>, in ms
+#define COMMAND_SAMPLING_INTERVAL_MIN_MS 5
+#define COMMAND_SAMPLING_INTERVAL_MAX_MS 1000
+
+// Longest SELECT_ credentials, the 802.11 SSID and WPA passphrase limits
+#define COMMAND_SSID_MAX_LENGTH 32
+#define COMMAND_PASSWORD_MAX_LENGTH 64
+
+// Longest reply formatCommandError() writes; a long offending token is cut short
+#define COMMAND_ERROR_CAPACITY 96
+
+enum CommandId {
+    COMMAND_NONE,
+    COMMAND_PROTOCOL,
+    COMMAND_CALIBRATE,
+    COMMAND_OTA,
+    COMMAND_TOGGLE,
+    COMMAND_SET_RELAY,
+    COMMAND_SET_SAMPLING_RATE,
+    COMMAND_ACQ_MODE,
+    COMMAND_ADAPTIVE,
+    COMMAND_TREND,
+    COMMAND_RESET_ENERGY,
+    COMMAND_CAPTURE_ARM,
+    COMMAND_CAPTURE_TRIGGER,
+    COMMAND_CAPTURE_STOP,
+    COMMAND_CAPTURE_READ,
+    COMMAND_SCAN,
+    COMMAND_SELECT,
+    COMMAND_DISCONNECT
+};
+
+// What follows the keyword and its '_'; COMMAND_ARGS_NONE commands match the keyword only
+enum CommandArgs {
+    COMMAND_ARGS_NONE,
+    COMMAND_ARGS_PROTOCOL,     // <major>[.<minor>[.<patch>]]_<JSON|BINARY|STREAM>
+    COMMAND_ARGS_PIN,          // <pin>
+    COMMAND_ARGS_PIN_STATE,    // <pin>_<ON|OFF>
+    COMMAND_ARGS_INTERVAL,     // <ms>
+    COMMAND_ARGS_ACQ_MODE,     // <SINGLE|CONTINUOUS>
+    COMMAND_ARGS_STATE,        // <ON|OFF>
+    COMMAND_ARGS_TREND,        // <CURRENT|VOLTAGE>_<deviation>
+    COMMAND_ARGS_INDEX,        // <index>
+    COMMAND_ARGS_CREDENTIALS   // <ssid>:<password>
+};
+
+// Command validation structure for documenting, parsing and validating incoming commands
+struct CommandDefinition {
+    const char* command;
+    CommandId id;
+    CommandArgs args;
+    const char* format;
+    const char* description;
+};
+
+// Array of supported commands with their expected formats and descriptions. A command
+// matches the longest keyword it starts with, so SET_SAMPLING_RATE_ is never taken for SET_.
+const CommandDefinition SUPPORTED_COMMANDS[] = {
+    {"PROTOCOL", COMMAND_PROTOCOL, COMMAND_ARGS_PROTOCOL, "PROTOCOL_<version>_<JSON|BINARY|STREAM>", "Checks the client's protocol version and selects the telemetry encoding"},
+    {"CALIBRATE", COMMAND_CALIBRATE, COMMAND_ARGS_NONE, "CALIBRATE", "Initiates ADC calibration procedure"},
+    {"OTA", COMMAND_OTA, COMMAND_ARGS_NONE, "OTA", "Enables Over-The-Air updates"},
+    {"TOGGLE", COMMAND_TOGGLE, COMMAND_ARGS_PIN, "TOGGLE_<pin>", "Toggles the relay with the specified pin number"},
+    {"SET", COMMAND_SET_RELAY, COMMAND_ARGS_PIN_STATE, "SET_<pin>_<ON|OFF>", "Sets the relay with specified pin to ON or OFF"},
+    {"SET_SAMPLING_RATE", COMMAND_SET_SAMPLING_RATE, COMMAND_ARGS_INTERVAL, "SET_SAMPLING_RATE_<interval>", "Sets sampling interval in ms (5-1000)"},
+    {"ACQ_MODE", COMMAND_ACQ_MODE, COMMAND_ARGS_ACQ_MODE, "ACQ_MODE_<SINGLE|CONTINUOUS>", "Selects single-shot or ALERT/RDY driven continuous acquisition"},
+    {"ADAPTIVE", COMMAND_ADAPTIVE, COMMAND_ARGS_STATE, "ADAPTIVE_<ON|OFF>", "Lets the sampling interval follow signal activity, or returns to the fixed interval"},
+    {"TREND", COMMAND_TREND, COMMAND_ARGS_TREND, "TREND_<CURRENT|VOLTAGE>_<deviation>", "Sets the trend compression error bound in uA or uV (0-1000000)"},
+    {"RESET_ENERGY", COMMAND_RESET_ENERGY, COMMAND_ARGS_NONE, "RESET_ENERGY", "Zeroes the accumulated charge and energy totals"},
+    {"CAPTURE_ARM", COMMAND_CAPTURE_ARM, COMMAND_ARGS_NONE, "CAPTURE_ARM", "Arms a burst capture with the last configured depths and triggers"},
+    {"CAPTURE_TRIGGER", COMMAND_CAPTURE_TRIGGER, COMMAND_ARGS_NONE, "CAPTURE_TRIGGER", "Triggers an armed burst capture manually"},
+    {"CAPTURE_STOP", COMMAND_CAPTURE_STOP, COMMAND_ARGS_NONE, "CAPTURE_STOP", "Disarms the burst capture"},
+    {"CAPTURE_READ", COMMAND_CAPTURE_READ, COMMAND_ARGS_INDEX, "CAPTURE_READ_<index>", "Reads completed capture records from index on"},
+    {"SCAN", COMMAND_SCAN, COMMAND_ARGS_NONE, "SCAN", "Scans for available WiFi networks"},
+    {"SELECT", COMMAND_SELECT, COMMAND_ARGS_CREDENTIALS, "SELECT_<ssid>:<password>", "Connects to specified WiFi network"},
+    {"DISCONNECT", COMMAND_DISCONNECT, COMMAND_ARGS_NONE, "DISCONNECT", "Disconnects from WiFi network"}
+};
+
+#define SUPPORTED_COMMAND_COUNT (sizeof(SUPPORTED_COMMANDS) / sizeof(SUPPORTED_COMMANDS[0]))
+
+enum CommandError {
+    COMMAND_OK,
+    COMMAND_ERROR_UNKNOWN,
+    COMMAND_ERROR_FORMAT,              // PROTOCOL: not JSON, BINARY or STREAM
+    COMMAND_ERROR_MAJOR_VERSION,
+    COMMAND_ERROR_MINOR_VERSION,       // Client newer than the firmware
+    COMMAND_ERROR_PIN,
+    COMMAND_ERROR_STATE,
+    COMMAND_ERROR_SAMPLING_RATE,
+    COMMAND_ERROR_ACQ_MODE,
+    COMMAND_ERROR_TREND_CHANNEL,
+    COMMAND_ERROR_TREND_DEVIATION,
+    COMMAND_ERROR_CAPTURE_INDEX,
+    COMMAND_ERROR_WIFI_FORMAT,         // SELECT: no ':'
+    COMMAND_ERROR_SSID,
+    COMMAND_ERROR_CREDENTIALS_LENGTH
+};
+
+// What the firmware accepts beyond the syntax: the relay pins, its protocol version and
+// the argument limits of the modules the commands go to
+struct CommandEnvironment {
+    const int* relayPins;
+    uint8_t relayCount;
+    uint8_t protocolMajor;
+    uint8_t protocolMinor;
+    uint32_t maxTrendDeviation;
+    uint32_t captureCapacity;
+};
+
+// One command, parsed and validated. Text fields point into the parsed input, which has
+// to outlive the command; only the fields of the command's arguments are set.
+struct ParsedCommand {
+    CommandId id;
+    CommandError error;        // COMMAND_OK when the command may be dispatched
+    const char* token;         // The offending text, for the error reply
+    uint16_t tokenLength;
+
+    TelemetryFormat format;    // PROTOCOL
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    uint16_t versionPatch;
+    uint8_t relay;             // TOGGLE, SET: index into the environment's relay pins
+    int pin;
+    bool on;                   // SET, ADAPTIVE
+    bool continuous;           // ACQ_MODE
+    bool voltage;              // TREND: the voltage channel, else the current channel
+    uint32_t value;            // SET_SAMPLING_RATE interval, TREND deviation, CAPTURE_READ index
+    const char* ssid;          // SELECT
+    uint16_t ssidLength;
+    const char* password;      // SELECT: everything after the first ':'
+    uint16_t passwordLength;
+};
+
+// Single pass over the command bytes (no terminator needed, nothing allocated): finds the
+// longest matching keyword in SUPPORTED_COMMANDS and parses and validates its arguments.
+// Returns true when command.error is COMMAND_OK.
+bool parseCommand(const char* text, size_t length, const CommandEnvironment& environment, ParsedCommand& command);
+
+// The ERROR:<reason>:<detail> reply of a failed parse; returns its length (0 for
+// COMMAND_OK), always terminated when capacity is not 0
+size_t formatCommandError(const ParsedCommand& command, const CommandEnvironment& environment, char* out,
+                          size_t capacity);
+
+#endif // COMMAND_PARSER_H
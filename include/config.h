@@ -9,9 +9,19 @@
 
 // Protocol version using semantic versioning
 #define PROTOCOL_VERSION_MAJOR 1
-#define PROTOCOL_VERSION_MINOR 2
+#define PROTOCOL_VERSION_MINOR 5
 #define PROTOCOL_VERSION_PATCH 0
-#define PROTOCOL_VERSION "1.2.0"
+#define PROTOCOL_VERSION "1.5.0"
+
+// I2C bus speed for the ADS1115s: 100000, 400000 (fast mode) or 1000000 (fast-mode plus)
+#define I2C_CLOCK_HZ 400000UL
+
+// I2C pins, and the transaction timeout: a few milliseconds is far above any ADS1115
+// transfer, and with ADC_MAX_ERRORS_BEFORE_LOST it bounds how long a dead or stuck
+// device can stall the sampling task
+#define I2C_SDA_PIN 21
+#define I2C_SCL_PIN 22
+#define I2C_TIMEOUT_MS 5
 
 // Global configuration variables
 extern volatile uint16_t samplingIntervalMs;
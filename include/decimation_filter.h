@@ -0,0 +1,408 @@
+#ifndef DECIMATION_FILTER_H
+#define DECIMATION_FILTER_H
+
+#include <stdint.h>
+#include "fixed_point.h"
+
+// Streaming decimation: an integer CIC decimator running at the ADC rate, followed by a
+// compensating FIR that flattens the CIC passband droop and decimates by a further 2.
+// Work is done per input sample (CIC) and per output sample (FIR); reading the latest
+// output never re-sums a window.
+//
+// Two FIR/chain variants share the same design: a float reference and a fixed-point one
+// (Q31 samples, Q15 coefficients) for targets without an FPU.
+
+// Largest CIC ratio; keeps register growth and the Q31 normalisation within 64 bits
+#define CIC_MAX_RATIO 4096
+
+// Q31 samples enter the fixed-point CIC with their low bits dropped, leaving room for
+// 3 * log2(CIC_MAX_RATIO) bits of register growth
+#define CIC_Q31_INPUT_SHIFT 8
+
+namespace dsp {
+
+constexpr double PI = 3.14159265358979323846;
+
+// Compile-time sine (range reduction + Taylor series); accurate to ~1e-12 on [-pi, pi]
+constexpr double constexprSin(double x) {
+    while (x > PI) {
+        x -= 2 * PI;
+    }
+    while (x < -PI) {
+        x += 2 * PI;
+    }
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 14; n++) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double constexprCos(double x) {
+    return constexprSin(x + PI / 2);
+}
+
+constexpr double constexprPow(double base, int exponent) {
+    double result = 1;
+    for (int i = 0; i < exponent; i++) {
+        result *= base;
+    }
+    return result;
+}
+
+template <int Taps>
+struct FirCoefficients {
+    float taps[Taps];
+};
+
+// Passband edge of the compensator, relative to its input rate. The FIR decimates by 2,
+// so everything above 0.25 aliases; the band between 0.2 and 0.25 is the transition.
+constexpr double COMPENSATOR_PASSBAND = 0.2;
+constexpr int COMPENSATOR_DESIGN_POINTS = 256;
+
+// Inverse of the CIC magnitude response |sin(pi f) / (pi f)|^Order for large decimation ratios
+constexpr double cicCompensation(int order, double f) {
+    if (f == 0) {
+        return 1;
+    }
+    double sinc = constexprSin(PI * f) / (PI * f);
+    return 1 / constexprPow(sinc, order);
+}
+
+// Windowed frequency-sampling design of a linear-phase CIC compensator, evaluated by the
+// compiler: h[n] = 2 * integral_0^0.5 H(f) cos(2 pi f (n - M)) df, Hamming window, unity DC gain.
+template <int Order, int Taps>
+constexpr FirCoefficients<Taps> designCicCompensator() {
+    static_assert(Taps % 2 == 1, "Compensator needs an odd tap count for linear phase");
+    FirCoefficients<Taps> result = {};
+    const int middle = Taps / 2;
+    const double step = 0.5 / COMPENSATOR_DESIGN_POINTS;
+    double dcGain = 0;
+    double h[Taps] = {};
+    for (int n = 0; n < Taps; n++) {
+        double sum = 0;
+        for (int k = 0; k < COMPENSATOR_DESIGN_POINTS; k++) {
+            double f = (k + 0.5) * step;
+            if (f <= COMPENSATOR_PASSBAND) {
+                sum += cicCompensation(Order, f) * constexprCos(2 * PI * f * (n - middle));
+            }
+        }
+        double window = 0.54 - 0.46 * constexprCos(2 * PI * n / (Taps - 1));
+        h[n] = 2 * step * sum * window;
+        dcGain += h[n];
+    }
+    for (int n = 0; n < Taps; n++) {
+        result.taps[n] = static_cast<float>(h[n] / dcGain);
+    }
+    return result;
+}
+
+template <int Taps>
+struct FixedCoefficients {
+    q15_t taps[Taps];
+};
+
+// Quantise a design to Q15, folding the rounding residue into the centre tap so the DC
+// gain stays exactly 1.0
+template <int Taps>
+constexpr FixedCoefficients<Taps> toQ15(const FirCoefficients<Taps>& coefficients) {
+    FixedCoefficients<Taps> result = {};
+    int32_t sum = 0;
+    for (int n = 0; n < Taps; n++) {
+        result.taps[n] = doubleToQ15(coefficients.taps[n]);
+        sum += result.taps[n];
+    }
+    result.taps[Taps / 2] = saturateQ15(result.taps[Taps / 2] + Q15_ONE - sum);
+    return result;
+}
+
+} // namespace dsp
+
+// Order-N cascaded integrator-comb decimator with a runtime ratio.
+// State uses wrapping unsigned arithmetic, which is exact as long as the output fits in
+// 64 bits: input bits + Order * log2(ratio).
+template <int Order>
+class CicDecimator {
+    static_assert(Order >= 1 && Order <= 3, "CIC_MAX_RATIO^Order must leave room for Q31 normalisation");
+
+public:
+    explicit CicDecimator(uint32_t ratio = 1) {
+        setRatio(ratio);
+    }
+
+    void setRatio(uint32_t newRatio) {
+        ratio = newRatio ? newRatio : 1;
+        if (ratio > CIC_MAX_RATIO) {
+            ratio = CIC_MAX_RATIO;
+        }
+        gain = 1;
+        for (int i = 0; i < Order; i++) {
+            gain *= ratio;
+        }
+        reset();
+    }
+
+    uint32_t getRatio() const {
+        return ratio;
+    }
+
+    void reset() {
+        for (int i = 0; i < Order; i++) {
+            integrators[i] = 0;
+            combDelays[i] = 0;
+        }
+        phase = 0;
+    }
+
+    // Feed one input sample; returns true and sets output (normalised to unity DC gain)
+    // on every ratio-th input
+    bool push(int32_t input, float& output) {
+        int64_t value = 0;
+        if (!step(input, value)) {
+            return false;
+        }
+        output = static_cast<float>(static_cast<double>(value) / gain);
+        return true;
+    }
+
+    // Fixed-point variant: output in input units with fractionBits extra fractional bits
+    bool push(int32_t input, int32_t& output, int fractionBits) {
+        int64_t value = 0;
+        if (!step(input, value)) {
+            return false;
+        }
+        int64_t divisor = static_cast<int64_t>(gain);
+        int64_t scale = static_cast<int64_t>(1) << fractionBits;
+        int64_t whole = value / divisor;
+        int64_t fraction = (value % divisor) * scale / divisor;
+        output = saturateQ31(whole * scale + fraction);
+        return true;
+    }
+
+private:
+    // Integrate every input; comb and return the un-normalised sum on every ratio-th one
+    bool step(int32_t input, int64_t& output) {
+        uint64_t value = static_cast<uint64_t>(static_cast<int64_t>(input));
+        for (int i = 0; i < Order; i++) {
+            integrators[i] += value;
+            value = integrators[i];
+        }
+        if (++phase < ratio) {
+            return false;
+        }
+        phase = 0;
+        for (int i = 0; i < Order; i++) {
+            uint64_t delayed = combDelays[i];
+            combDelays[i] = value;
+            value -= delayed;
+        }
+        output = static_cast<int64_t>(value);
+        return true;
+    }
+
+    uint32_t ratio;
+    uint64_t gain;
+    uint64_t integrators[Order];
+    uint64_t combDelays[Order];
+    uint32_t phase;
+};
+
+// Decimate-by-2 FIR with compile-time coefficients (float reference)
+template <int Taps>
+class FirDecimator {
+public:
+    explicit FirDecimator(const dsp::FirCoefficients<Taps>& coefficients)
+        : coefficients(coefficients) {
+        reset();
+    }
+
+    void reset() {
+        for (int i = 0; i < Taps; i++) {
+            history[i] = 0;
+        }
+        head = 0;
+        phase = 0;
+        primed = 0;
+    }
+
+    // Feed one input; every second input produces an output
+    bool push(float input, float& output) {
+        history[head] = input;
+        head = (head + 1) % Taps;
+        if (primed < Taps) {
+            primed++;
+        }
+        if (++phase < 2) {
+            return false;
+        }
+        phase = 0;
+
+        // Until the delay line is full, hold the input so start-up does not ramp from zero
+        if (primed < Taps) {
+            output = input;
+            return true;
+        }
+        float sum = 0;
+        int index = head;
+        for (int i = 0; i < Taps; i++) {
+            sum += coefficients.taps[i] * history[index];
+            index = (index + 1) % Taps;
+        }
+        output = sum;
+        return true;
+    }
+
+private:
+    const dsp::FirCoefficients<Taps>& coefficients;
+    float history[Taps];
+    int head;
+    int phase;
+    int primed;
+};
+
+// Decimate-by-2 FIR on Q31 samples with Q15 coefficients and a 64-bit accumulator
+template <int Taps>
+class FixedFirDecimator {
+public:
+    explicit FixedFirDecimator(const dsp::FixedCoefficients<Taps>& coefficients)
+        : coefficients(coefficients) {
+        reset();
+    }
+
+    void reset() {
+        for (int i = 0; i < Taps; i++) {
+            history[i] = 0;
+        }
+        head = 0;
+        phase = 0;
+        primed = 0;
+    }
+
+    bool push(q31_t input, q31_t& output) {
+        history[head] = input;
+        head = (head + 1) % Taps;
+        if (primed < Taps) {
+            primed++;
+        }
+        if (++phase < 2) {
+            return false;
+        }
+        phase = 0;
+
+        if (primed < Taps) {
+            output = input;
+            return true;
+        }
+        int64_t sum = 0;
+        int index = head;
+        for (int i = 0; i < Taps; i++) {
+            sum += static_cast<int64_t>(coefficients.taps[i]) * history[index];
+            index = (index + 1) % Taps;
+        }
+        output = saturateQ31((sum + (Q15_ONE / 2)) >> 15);
+        return true;
+    }
+
+private:
+    const dsp::FixedCoefficients<Taps>& coefficients;
+    q31_t history[Taps];
+    int head;
+    int phase;
+    int primed;
+};
+
+// CIC followed by its compensating FIR. The total decimation ratio is chosen at runtime;
+// ratios below 2 bypass the filters so slow sampling still produces every sample.
+template <int CicOrder, int FirTaps>
+class DecimationChain {
+public:
+    static constexpr dsp::FirCoefficients<FirTaps> COMPENSATOR = dsp::designCicCompensator<CicOrder, FirTaps>();
+
+    DecimationChain() : cic(1), fir(COMPENSATOR), bypass(true), latest(0) {}
+
+    void setRatio(uint32_t totalRatio) {
+        bypass = totalRatio < 2;
+        cic.setRatio(bypass ? 1 : totalRatio / 2);
+        fir.reset();
+    }
+
+    uint32_t getRatio() const {
+        return bypass ? 1 : cic.getRatio() * 2;
+    }
+
+    // Feed one sample at the input rate; returns true when a new output is available
+    bool push(int32_t input) {
+        if (bypass) {
+            latest = static_cast<float>(input);
+            return true;
+        }
+        float cicOutput = 0;
+        if (!cic.push(input, cicOutput)) {
+            return false;
+        }
+        return fir.push(cicOutput, latest);
+    }
+
+    // Most recent output, in input units
+    float output() const {
+        return latest;
+    }
+
+private:
+    CicDecimator<CicOrder> cic;
+    FirDecimator<FirTaps> fir;
+    bool bypass;
+    float latest;
+};
+
+template <int CicOrder, int FirTaps>
+constexpr dsp::FirCoefficients<FirTaps> DecimationChain<CicOrder, FirTaps>::COMPENSATOR;
+
+// Fixed-point counterpart of DecimationChain: same ratios and response, output in Q31
+template <int CicOrder, int FirTaps>
+class FixedDecimationChain {
+public:
+    static constexpr dsp::FixedCoefficients<FirTaps> COMPENSATOR =
+        dsp::toQ15(dsp::designCicCompensator<CicOrder, FirTaps>());
+
+    FixedDecimationChain() : cic(1), fir(COMPENSATOR), bypass(true), latest(0) {}
+
+    void setRatio(uint32_t totalRatio) {
+        bypass = totalRatio < 2;
+        cic.setRatio(bypass ? 1 : totalRatio / 2);
+        fir.reset();
+    }
+
+    uint32_t getRatio() const {
+        return bypass ? 1 : cic.getRatio() * 2;
+    }
+
+    bool push(q31_t input) {
+        if (bypass) {
+            latest = input;
+            return true;
+        }
+        q31_t cicOutput = 0;
+        if (!cic.push(input / (1 << CIC_Q31_INPUT_SHIFT), cicOutput, CIC_Q31_INPUT_SHIFT)) {
+            return false;
+        }
+        return fir.push(cicOutput, latest);
+    }
+
+    q31_t output() const {
+        return latest;
+    }
+
+private:
+    CicDecimator<CicOrder> cic;
+    FixedFirDecimator<FirTaps> fir;
+    bool bypass;
+    q31_t latest;
+};
+
+template <int CicOrder, int FirTaps>
+constexpr dsp::FixedCoefficients<FirTaps> FixedDecimationChain<CicOrder, FirTaps>::COMPENSATOR;
+
+#endif // DECIMATION_FILTER_H
@@ -0,0 +1,50 @@
+#ifndef DEVICE_RECOVERY_H
+#define DEVICE_RECOVERY_H
+
+#include <stdint.h>
+#include "adc_devices.h"
+
+// Reattach schedule of a lost device: the first attempt shortly after the loss (most
+// dropouts are a glitch or a stuck bus), then doubling up to the maximum interval
+#define RECOVERY_FIRST_RETRY_US 10000LL
+#define RECOVERY_MAX_RETRY_US 30000000LL
+
+// Recovery bookkeeping of one device; times are in the caller's microsecond clock
+struct DeviceRecoveryStatus {
+    bool lost;
+    uint32_t outages;       // Losses since boot
+    uint32_t attempts;      // Failed reattach attempts in the current outage
+    int64_t retryUs;        // Interval before the next attempt
+    int64_t nextAttemptUs;
+    int64_t lostSinceUs;    // Start of the current outage
+    int64_t lastOutageUs;   // Length of the last completed outage
+    int64_t degradedUs;     // Completed outages summed
+};
+
+// Exponential-backoff reattach schedule for the devices of the channel table, and the
+// time the acquisition pipeline ran degraded. It only decides when to try; the owner's
+// recovery task does the bus work and reports the outcome.
+class RecoveryScheduler {
+public:
+    RecoveryScheduler();
+
+    void markLost(uint8_t device, int64_t nowUs);  // No-op while already lost
+    void markRecovered(uint8_t device, int64_t nowUs);
+    void attemptFailed(uint8_t device, int64_t nowUs);
+
+    uint8_t getLostMask() const;
+    uint8_t getDueMask(int64_t nowUs) const;  // Lost devices whose next attempt is due
+    int64_t getNextAttemptUs() const;         // Earliest pending attempt; INT64_MAX if none
+
+    const DeviceRecoveryStatus& getStatus(uint8_t device) const;
+    int64_t getDegradedUs(uint8_t device, int64_t nowUs) const;  // Including an open outage
+    int64_t getPipelineDegradedUs(int64_t nowUs) const;          // Time any device was lost
+
+private:
+    DeviceRecoveryStatus status[ADC_MAX_DEVICES];
+    uint8_t lostMask;
+    int64_t pipelineLostSinceUs;
+    int64_t pipelineDegradedUs;
+};
+
+#endif // DEVICE_RECOVERY_H
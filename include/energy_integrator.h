@@ -0,0 +1,69 @@
+#ifndef ENERGY_INTEGRATOR_H
+#define ENERGY_INTEGRATOR_H
+
+#include <stdint.h>
+#include "pair_aligner.h"
+
+// Sample gaps longer than this (acquisition stalled, mode switch, chip recovery) are not
+// integrated across; the time is reported as uncovered instead of being guessed
+#define ENERGY_MAX_GAP_US 1000000
+
+// Stamp of persisted checkpoints; bump when EnergyTotals changes layout
+#define ENERGY_TOTALS_VERSION 2
+
+// Accumulated charge and energy, split by direction (in = positive shunt current).
+// Whole units are exact integers; sub-unit remainders are carried in the integrator.
+struct EnergyTotals {
+    uint16_t version;
+    int64_t chargeInUc;    // Microcoulombs
+    int64_t chargeOutUc;
+    int64_t energyInUj;    // Microjoules
+    int64_t energyOutUj;
+    int64_t coveredUs;     // Time integrated over
+    int64_t uncoveredUs;   // Time lost to gaps longer than ENERGY_MAX_GAP_US
+    int64_t energyUncoveredUs;  // Part of coveredUs with charge only: the voltage was
+                                // missing or lost for longer than ENERGY_MAX_GAP_US
+};
+
+// Trapezoidal integration of current and power over time-aligned current/voltage pairs
+// (PairAligner), using the pair timestamps, so the product of a pair is the instantaneous
+// power even while the load steps. Charge needs a fresh current only; energy also needs a
+// usable voltage, so a board without (or temporarily without) the voltage converter still
+// integrates charge.
+class EnergyIntegrator {
+public:
+    EnergyIntegrator();
+
+    void add(const AlignedPair& pair);
+    void reset();
+
+    // Continue from a checkpoint; the next sample starts a new segment
+    void restore(const EnergyTotals& totals);
+    const EnergyTotals& getTotals() const;
+
+    int64_t netChargeUc() const;
+    int64_t netEnergyUj() const;
+
+private:
+    static bool isVoltageUsable(const AlignedPair& pair);
+
+    // One accumulator: whole units plus a remainder in half-micro units (doubled trapezoids)
+    static void accumulate(int64_t& whole, int64_t& remainder, int64_t microProduct);
+
+    EnergyTotals totals;
+    int64_t chargeInRemainder;
+    int64_t chargeOutRemainder;
+    int64_t energyInRemainder;
+    int64_t energyOutRemainder;
+    bool hasPrevious;
+    int64_t previousUs;
+    int64_t previousMicroamps;
+
+    // Energy runs from the last pair with a usable voltage, which may be older
+    bool hasPreviousPower;
+    int64_t previousPowerUs;
+    int64_t previousMicrowatts;
+    int64_t unpoweredUs;  // Charge-covered time since then, not yet bridged or given up
+};
+
+#endif // ENERGY_INTEGRATOR_H
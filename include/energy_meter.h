@@ -0,0 +1,29 @@
+#ifndef ENERGY_METER_H
+#define ENERGY_METER_H
+
+#include <Arduino.h>
+#include "energy_integrator.h"
+#include "power_window.h"
+
+// How often the running totals are checkpointed to NVS
+#define ENERGY_CHECKPOINT_INTERVAL_MS 300000UL
+
+// Charge/energy accumulation and windowed real power at the full sample rate, on
+// time-aligned current/voltage pairs. integrateEnergy() runs on the acquisition task for
+// every stored sample; everything else may be called from any task.
+void integrateEnergy(const AdcSample& sample);
+EnergyTotals getEnergyTotals();
+void resetEnergyTotals();
+
+PowerSummary getPowerSummary();  // Latest completed POWER_WINDOW_DEFAULT_US window
+int64_t getInstantPowerUw();     // Product of the latest aligned pair
+
+// NVS checkpoints: restore once at boot, then call serviceEnergyCheckpoint() from a
+// non-sampling task; it writes when the interval has elapsed or after a reset
+bool restoreEnergyCheckpoint();
+void serviceEnergyCheckpoint();
+
+String formatEnergyTotals();
+String formatPower();
+
+#endif // ENERGY_METER_H
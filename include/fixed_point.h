@@ -0,0 +1,58 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <stdint.h>
+
+// Fixed-point formats of the signal path:
+// - Q15: a raw ADS1115 reading is already a Q15 fraction of the PGA full-scale range
+// - Q31: offset-corrected and filtered values. The 16 extra fractional bits keep the
+//   sub-count resolution of calibration averages and decimation filters, so one ADC
+//   count is Q31_ONE_COUNT.
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+constexpr int Q31_COUNT_SHIFT = 16;
+constexpr q31_t Q31_ONE_COUNT = 1L << Q31_COUNT_SHIFT;
+constexpr int32_t Q15_ONE = 32768;  // 1.0 in Q15 (not representable as q15_t itself)
+
+constexpr q31_t saturateQ31(int64_t value) {
+    return value > INT32_MAX ? INT32_MAX : (value < INT32_MIN ? INT32_MIN : static_cast<q31_t>(value));
+}
+
+constexpr q15_t saturateQ15(int32_t value) {
+    return value > INT16_MAX ? INT16_MAX : (value < INT16_MIN ? INT16_MIN : static_cast<q15_t>(value));
+}
+
+// Raw counts to Q31; exact for the whole int16_t range
+constexpr q31_t countsToQ31(int16_t counts) {
+    return static_cast<q31_t>(counts) * Q31_ONE_COUNT;
+}
+
+// Saturating a - b (raw minus a negative offset can exceed full scale)
+constexpr q31_t subQ31(q31_t a, q31_t b) {
+    return saturateQ31(static_cast<int64_t>(a) - b);
+}
+
+// Round a real coefficient in [-1, 1) to Q15
+constexpr q15_t doubleToQ15(double value) {
+    return saturateQ15(static_cast<int32_t>(value * Q15_ONE + (value >= 0 ? 0.5 : -0.5)));
+}
+
+// Scale a Q31 fraction of full scale to an integer engineering unit, given the number of
+// units a full-scale reading represents. The low 8 fractional bits are dropped first so
+// the product stays within 64 bits for any full-scale value below 2^40.
+constexpr int32_t q31ToUnits(q31_t value, int64_t unitsPerFullScale) {
+    return saturateQ31(((static_cast<int64_t>(value) >> 8) * unitsPerFullScale) >> 23);
+}
+
+// Inverse of q31ToUnits, for thresholds given in engineering units
+constexpr q31_t unitsToQ31(int32_t units, int64_t unitsPerFullScale) {
+    return saturateQ31(static_cast<int64_t>(units) * (static_cast<int64_t>(1) << 31) / unitsPerFullScale);
+}
+
+// Counts as a float, for display and JSON only; no arithmetic should follow
+inline float q31ToCounts(q31_t value) {
+    return static_cast<float>(value) / Q31_ONE_COUNT;
+}
+
+#endif // FIXED_POINT_H
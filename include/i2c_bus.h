@@ -0,0 +1,37 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Standard I2C bus speeds supported by the ADS1115 drivers
+#define I2C_STANDARD_MODE_HZ   100000UL
+#define I2C_FAST_MODE_HZ       400000UL
+#define I2C_FAST_MODE_PLUS_HZ  1000000UL
+
+// Minimal I2C transport used by the register-level device drivers.
+// Implemented on the target by WireI2CBus and on the host by simulated buses,
+// so drivers can be unit tested without hardware.
+class I2CBus {
+public:
+    virtual ~I2CBus() {}
+
+    // Write a complete transaction (START, address+W, data, STOP). Returns false on NACK/timeout.
+    virtual bool write(uint8_t address, const uint8_t* data, size_t length) = 0;
+
+    // Read from the device's current register pointer. Returns false on NACK/short read.
+    virtual bool read(uint8_t address, uint8_t* data, size_t length) = 0;
+
+    // Change the bus clock; returns false for speeds the bus cannot run
+    virtual bool setClock(uint32_t hz) = 0;
+
+    // Free a bus held low by a device stuck mid-transfer; false if SDA stays low.
+    // Transports that cannot hang have nothing to do.
+    virtual bool clearBus() { return true; }
+
+    // Time source and delay used for transaction timing and conversion waits
+    virtual uint32_t micros() = 0;
+    virtual void delayMicros(uint32_t us) = 0;
+};
+
+#endif // I2C_BUS_H
@@ -0,0 +1,71 @@
+#ifndef NOTIFY_QUEUE_H
+#define NOTIFY_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Notifications waiting for the BLE task; with a telemetry frame every 100 ms and a few
+// sample batches in between, a second's worth at the stream's rate
+#define NOTIFY_QUEUE_DEPTH 8
+
+// Largest notification payload, the attribute limit
+#define NOTIFY_QUEUE_SLOT_SIZE 512
+
+// Most credits a client can have outstanding; grants beyond it are capped
+#define NOTIFY_CREDIT_LIMIT 1024
+
+// Credits while the client has not granted any: every waiting notification may go out
+#define NOTIFY_CREDITS_UNLIMITED -1
+
+// Bounded outbound queue of the data characteristic, with client-granted credits.
+//
+// Producers push complete notification payloads; the BLE task sends front() and pop()s it.
+// A full queue drops its oldest entry to make room, so the client always gets the newest
+// data and the loss shows as a gap in the frame and batch sequence numbers. Once a client
+// grants credits, each notification sent spends one and nothing goes out at zero: entries
+// wait, and past the queue depth the oldest are dropped, so a slow client sees a steady,
+// counted loss rather than random stack-buffer drops. A client that never grants credits
+// is not flow controlled. A notification the stack refuses (notifications disabled, no
+// client, no buffer) is discarded as failed: it is not counted as sent and keeps its credit.
+//
+// push/front/pop/clear belong to one task; the credit calls and getters may come from any.
+class NotifyQueue {
+public:
+    NotifyQueue();
+
+    bool push(const uint8_t* data, size_t length);  // False for an empty or oversize payload
+    bool front(const uint8_t*& data, size_t& length) const;  // Next entry a credit allows out
+    void pop();    // The front entry was handed to the stack: frees it, spends a credit
+    void fail();   // The stack refused the front entry: frees it as failed, no credit spent
+    void clear();  // Connection closed: waiting entries discarded
+
+    // Client side. The first grant enables flow control; a grant of 0 pauses the stream.
+    void grant(uint32_t credits);
+    void resetCredits();  // New connection: not flow controlled until it grants
+
+    bool isFlowControlled() const { return credits.load(std::memory_order_relaxed) != NOTIFY_CREDITS_UNLIMITED; }
+    int32_t getCredits() const { return credits.load(std::memory_order_relaxed); }
+    uint8_t getDepth() const { return count; }
+    uint8_t getMaxDepth() const { return maxDepth; }  // High-water mark since boot
+    uint32_t getSent() const { return sent; }
+    uint32_t getDropped() const { return dropped; }  // Pushed but never handed to the stack
+    uint32_t getFailed() const { return failed; }    // Handed to the stack and refused
+
+private:
+    struct Slot {
+        uint16_t length;
+        uint8_t data[NOTIFY_QUEUE_SLOT_SIZE];
+    };
+
+    Slot slots[NOTIFY_QUEUE_DEPTH];
+    uint8_t head;   // Oldest entry
+    uint8_t count;
+    uint8_t maxDepth;
+    std::atomic<int32_t> credits;
+    uint32_t sent;
+    uint32_t dropped;
+    uint32_t failed;
+};
+
+#endif // NOTIFY_QUEUE_H
@@ -0,0 +1,57 @@
+#ifndef OFFSET_CALIBRATOR_H
+#define OFFSET_CALIBRATOR_H
+
+#include <stdint.h>
+#include "ads1115_driver.h"
+#include "auto_ranger.h"
+#include "fixed_point.h"
+
+// Readings discarded after each gain switch, then readings averaged per gain
+#define CALIBRATION_SETTLE_SAMPLES 4
+#define CALIBRATION_SAMPLES_PER_GAIN 32
+
+// Stamp of persisted records. Bump when the record layout or the acquisition setup the
+// offsets depend on changes, so stale tables trigger a fresh calibration on boot.
+#define CALIBRATION_RECORD_VERSION 1
+
+// Persisted per-channel calibration: one offset per PGA gain, Q31 of that gain's full scale
+struct CalibrationRecord {
+    uint16_t version;
+    uint16_t validMask;  // Bit n set: offsets[n] was measured (gain index n)
+    q31_t offsets[ADS1115_GAIN_COUNT];
+};
+
+// Incremental zero-input offset calibration of one channel. It walks the channel's gain
+// range, consuming readings from the normal acquisition stream; the acquisition side
+// switches the PGA to getTargetGain() and feeds every reading with the gain it was
+// converted at, so readings still in flight from before a switch are simply skipped.
+class OffsetCalibrator {
+public:
+    OffsetCalibrator();
+
+    void start(Ads1115Gain widest, Ads1115Gain narrowest);
+    void abort();
+    void feed(int16_t raw, Ads1115Gain gain);
+
+    bool isRunning() const;
+    Ads1115Gain getTargetGain() const;
+    uint8_t getProgress() const;  // 0-100
+    const CalibrationRecord& getRecord() const;
+
+private:
+    int widestIndex;
+    int narrowestIndex;
+    int gainIndex;
+    uint16_t settleRemaining;
+    uint16_t count;
+    int32_t sum;
+    bool running;
+    CalibrationRecord record;
+};
+
+// Load a record's offsets into a table. Fails (leaving the table untouched) when the
+// record is from another version or misses a gain in [widest, narrowest].
+bool applyCalibrationRecord(const CalibrationRecord& record, Ads1115Gain widest, Ads1115Gain narrowest,
+                            GainOffsetTable& table);
+
+#endif // OFFSET_CALIBRATOR_H
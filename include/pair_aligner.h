@@ -0,0 +1,80 @@
+#ifndef PAIR_ALIGNER_H
+#define PAIR_ALIGNER_H
+
+#include <stdint.h>
+#include "adc_sample.h"
+
+// Current conversions waiting for the voltage conversion after them. A voltage channel
+// rotated with others on its device converts every few slots, so this covers a rotation
+// of the longest scan list.
+#define PAIR_ALIGNER_PENDING 16
+
+// Voltage conversions further apart than this are not interpolated across; the current
+// conversions between them are dropped as unaligned
+#define PAIR_ALIGNER_MAX_SPAN_US 1000000
+
+// A current conversion and the voltage at the same instant
+struct AlignedPair {
+    int64_t timeUs;          // Middle of the current conversion
+    q31_t current;           // Sample scales as in AdcSample
+    q31_t voltage;           // Interpolated between the voltage conversions either side
+    uint8_t currentQuality;  // SAMPLE_QUALITY_* of the current conversion
+    uint8_t voltageQuality;  // Flags of both voltage conversions interpolated between
+};
+
+// Time alignment of the two channels. The current and voltage values of an AdcSample come
+// from conversions taken at different instants: the second device of a single-shot slot
+// starts a bus transaction later, free-running devices in continuous mode are out of phase
+// by up to a whole conversion, and a rotated voltage channel is held for several slots.
+// During a load step, multiplying such a pair biases the power.
+//
+// Every fresh current conversion is paired with the voltage linearly interpolated to its
+// timestamp (AdcSample::shuntUs/ads2Us, the middle of each conversion). A current
+// conversion waits until the voltage has converted after it, so pairs come out one
+// voltage conversion late, in time order. Degraded voltage conversions break the
+// interpolation: no pair is made across them. While the voltage channel is lost (or has
+// never converted) currents are not held back: they come out against the held voltage,
+// with its STALE/RECOVERING flags, so charge keeps being integrated.
+class PairAligner {
+public:
+    PairAligner();
+
+    void add(const AdcSample& sample);
+    bool read(AlignedPair& pair);  // Oldest aligned pair; false when none is ready
+    void reset();
+
+    uint32_t getAligned() const { return aligned; }
+    uint32_t getUnaligned() const { return unaligned; }  // Current conversions without a voltage bracket
+
+private:
+    struct Point {
+        int64_t timeUs;
+        q31_t value;
+        uint8_t quality;
+    };
+
+    void addVoltage(const Point& point);
+    void resolve();
+    void flushPending(q31_t voltage, uint8_t voltageQuality);
+    void push(const AlignedPair& pair);
+
+    Point pending[PAIR_ALIGNER_PENDING];
+    uint8_t pendingHead;
+    uint8_t pendingCount;
+
+    // Voltage conversions bracketing the pending currents; the previous one may be invalid
+    Point previousVoltage;
+    Point latestVoltage;
+    bool hasPrevious;
+    bool hasLatest;
+    int64_t lastCurrentUs;
+
+    AlignedPair output[PAIR_ALIGNER_PENDING];
+    uint8_t outputHead;
+    uint8_t outputCount;
+
+    uint32_t aligned;
+    uint32_t unaligned;
+};
+
+#endif // PAIR_ALIGNER_H
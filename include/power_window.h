@@ -0,0 +1,79 @@
+#ifndef POWER_WINDOW_H
+#define POWER_WINDOW_H
+
+#include <stdint.h>
+#include "pair_aligner.h"
+
+// Default averaging window for real power
+#define POWER_WINDOW_DEFAULT_US 1000000
+
+// Pairs further apart than this are not averaged across (as ENERGY_MAX_GAP_US)
+#define POWER_WINDOW_MAX_GAP_US 1000000
+
+// Longest window: keeps the integer sums of squares within 64 bits
+#define POWER_WINDOW_MAX_US 10000000
+
+// Bits dropped from the Q31 sample values before squaring, which leaves one count of the
+// narrowest gain; a doubled square times a gap of POWER_WINDOW_MAX_GAP_US is below 2^60
+#define POWER_WINDOW_SQUARE_SHIFT 12
+
+// Averages over one completed window, in floating point: formed once per window, off the
+// per-pair path
+struct PowerSummary {
+    int64_t endUs;            // Time of the pair that closed the window
+    int64_t coveredUs;        // Time averaged over (gaps excluded)
+    uint32_t pairs;           // Pair-to-pair intervals averaged
+    double realPowerUw;       // Mean of v * i
+    double voltageRmsUv;
+    double currentRmsUa;
+    double apparentPowerUva;  // Vrms * Irms
+    double powerFactor;       // Real / apparent; 0 without apparent power
+};
+
+// Real power over back-to-back windows of time-aligned pairs. Instantaneous power is
+// v * i of each pair; the window integrates it, v^2 and i^2 with the trapezoidal rule
+// over the pair timestamps, so uneven spacing (rotations, dropped pairs) is weighted
+// correctly. Only pairs with a fresh current and no stale or recovering voltage are
+// used; longer holes than POWER_WINDOW_MAX_GAP_US are left out of the averages.
+//
+// add() runs on the acquisition task for every pair and uses integer arithmetic only (the
+// ESP32 has no double-precision FPU): power is integrated in uW x us like EnergyIntegrator,
+// the squares in the sample scale. Means, RMS values and the power factor are only worked
+// out when a window closes.
+class PowerWindow {
+public:
+    explicit PowerWindow(int64_t lengthUs = POWER_WINDOW_DEFAULT_US);
+
+    // Returns true when the pair closed a window and latest() was updated
+    bool add(const AlignedPair& pair);
+    void reset();
+
+    void setLength(int64_t lengthUs);  // Takes effect from the next window, up to POWER_WINDOW_MAX_US
+    int64_t getLength() const { return lengthUs; }
+
+    const PowerSummary& latest() const { return summary; }
+    int64_t getInstantPowerUw() const { return instantUw; }
+    bool hasSummary() const { return summary.pairs > 0; }
+
+private:
+    int64_t lengthUs;
+    PowerSummary summary;
+
+    void summarize(int64_t endUs);
+
+    bool hasPrevious;
+    int64_t previousUs;
+    int64_t previousPowerUw;
+    int64_t previousVoltageSquared;  // Squared sample values after POWER_WINDOW_SQUARE_SHIFT
+    int64_t previousCurrentSquared;
+    int64_t instantUw;
+
+    int64_t windowUs;  // Elapsed in the open window, gaps included
+    int64_t coveredUs;
+    uint32_t pairs;
+    int64_t powerArea;  // Doubled trapezoid areas
+    int64_t voltageArea;
+    int64_t currentArea;
+};
+
+#endif // POWER_WINDOW_H
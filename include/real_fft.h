@@ -0,0 +1,110 @@
+#ifndef REAL_FFT_H
+#define REAL_FFT_H
+
+#include <stdint.h>
+#include "decimation_filter.h"
+
+// Fixed-size radix-2 FFT of a real frame. The frame is packed into Size/2 complex points
+// (even samples as real parts, odd samples as imaginary parts), transformed by a complex
+// radix-2 kernel and split into the Size/2 + 1 bins of the real input. Twiddles and the
+// Hann window are computed by the compiler; nothing is allocated at run time.
+//
+// The complex kernel has two variants with the same result: a portable scalar one, and
+// on the ESP32-S3 the esp-dsp kernel using the PIE vector instructions (when esp-dsp is
+// part of the build). The scalar one is what the host tests benchmark.
+
+enum FftKernel {
+    FFT_KERNEL_SCALAR,
+    FFT_KERNEL_VECTOR
+};
+
+// Complex points of the largest transform the vector kernel is prepared for
+#define FFT_VECTOR_MAX_POINTS 1024
+
+// In-place complex FFT of `points` interleaved re/im pairs (points a power of two).
+// twiddles[k] = exp(-2 pi i k / (points * stride)) as re/im pairs, k < points * stride / 2.
+void fftRadix2Scalar(float* data, int points, const float* twiddles, int stride);
+
+// True when this build has the vector kernel; fftRadix2Vector() may only be used then
+bool fftVectorKernelAvailable();
+void fftRadix2Vector(float* data, int points);
+
+// Turn the transform of the packed frame into the bins of the real frame, in place:
+// data[0] = bin 0, data[1] = bin Size/2 (both real), data[2k], data[2k + 1] = bin k.
+// twiddles as for fftRadix2Scalar() with points * stride = Size.
+void fftSplitReal(float* data, int size, const float* twiddles);
+
+namespace dsp {
+
+template <int Size>
+struct FftTables {
+    float twiddles[Size];  // exp(-2 pi i k / Size) for k < Size / 2, as re/im pairs
+    float window[Size];    // Periodic Hann window
+    float windowPower;     // Sum of the squared window
+};
+
+template <int Size>
+constexpr FftTables<Size> designFftTables() {
+    FftTables<Size> tables = {};
+    for (int k = 0; k < Size / 2; k++) {
+        tables.twiddles[2 * k] = static_cast<float>(constexprCos(2 * PI * k / Size));
+        tables.twiddles[2 * k + 1] = static_cast<float>(-constexprSin(2 * PI * k / Size));
+    }
+    double power = 0;
+    for (int n = 0; n < Size; n++) {
+        double w = 0.5 - 0.5 * constexprCos(2 * PI * n / Size);
+        tables.window[n] = static_cast<float>(w);
+        power += w * w;
+    }
+    tables.windowPower = static_cast<float>(power);
+    return tables;
+}
+
+} // namespace dsp
+
+template <int Size>
+class RealFft {
+    static_assert(Size >= 8 && (Size & (Size - 1)) == 0, "FFT size must be a power of two");
+
+public:
+    static constexpr dsp::FftTables<Size> TABLES = dsp::designFftTables<Size>();
+
+    // Uses the vector kernel wherever this build has it
+    RealFft() : kernel(FFT_KERNEL_SCALAR) {
+        setKernel(FFT_KERNEL_VECTOR);
+    }
+
+    // Falls back to the scalar kernel when the vector one is not available
+    void setKernel(FftKernel requested) {
+        kernel = requested == FFT_KERNEL_VECTOR && fftVectorKernelAvailable() && Size / 2 <= FFT_VECTOR_MAX_POINTS
+                     ? FFT_KERNEL_VECTOR
+                     : FFT_KERNEL_SCALAR;
+    }
+
+    FftKernel getKernel() const { return kernel; }
+
+    // Multiply a frame by the Hann window before transforming it
+    static void applyWindow(float* frame) {
+        for (int n = 0; n < Size; n++) {
+            frame[n] *= TABLES.window[n];
+        }
+    }
+
+    // In-place transform of Size real samples into the packed bins described at fftSplitReal()
+    void transform(float* frame) const {
+        if (kernel == FFT_KERNEL_VECTOR) {
+            fftRadix2Vector(frame, Size / 2);
+        } else {
+            fftRadix2Scalar(frame, Size / 2, TABLES.twiddles, 2);
+        }
+        fftSplitReal(frame, Size, TABLES.twiddles);
+    }
+
+private:
+    FftKernel kernel;
+};
+
+template <int Size>
+constexpr dsp::FftTables<Size> RealFft<Size>::TABLES;
+
+#endif // REAL_FFT_H
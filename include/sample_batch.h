@@ -0,0 +1,89 @@
+#ifndef SAMPLE_BATCH_H
+#define SAMPLE_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// First byte of a sample batch notification; differs from the telemetry frame's magic
+// and from the '{' of a JSON frame
+#define SAMPLE_BATCH_MAGIC 0xA8
+
+// Encoding version, sent in the onConnect version info next to the frame version
+#define SAMPLE_BATCH_VERSION 1
+
+// Magic, version, sequence (u16 little-endian), sample count
+#define SAMPLE_BATCH_HEADER_SIZE 5
+
+// Longest encoding of one sample: a 64-bit time varint, two 33-bit zigzag deltas and the
+// 16-bit quality
+#define SAMPLE_BATCH_MAX_SAMPLE_SIZE 23
+
+// Notification payload limits: any sample has to fit a batch of its own, so a stream
+// needs an ATT MTU of at least 31 (the default of 23 is too small); no attribute value
+// exceeds 512
+#define SAMPLE_BATCH_MIN_PAYLOAD (SAMPLE_BATCH_HEADER_SIZE + SAMPLE_BATCH_MAX_SAMPLE_SIZE)
+#define SAMPLE_BATCH_MAX_PAYLOAD 512
+
+// One acquired sample at the full rate, in engineering units
+struct BatchSample {
+    int64_t timeUs;
+    int32_t currentUa;
+    int32_t voltageUv;
+    uint8_t currentQuality;  // SAMPLE_QUALITY_*
+    uint8_t voltageQuality;
+};
+
+// Packs consecutive samples into one notification payload. The first sample of a batch
+// is its base, sent in full; every later one as the difference from the sample before
+// it. All values are LEB128 varints, signed ones zigzag encoded first, so a steady signal
+// sampled at a steady interval costs a few bytes per sample:
+//
+//   header   magic, version, sequence (u16), count
+//   base     varint timeUs, zigzag currentUa, zigzag voltageUv, varint quality
+//   next     varint dt, zigzag dCurrent, zigzag dVoltage, varint quality
+//
+// quality is currentQuality | voltageQuality << 8, one byte while both are fresh. A batch
+// never outgrows the payload limit; the caller sends it once add() refuses a sample,
+// clear()s it and adds the sample again to start the next batch.
+class SampleBatcher {
+public:
+    explicit SampleBatcher(size_t payloadLimit = SAMPLE_BATCH_MIN_PAYLOAD);
+
+    bool add(const BatchSample& sample);  // False when the sample does not fit
+    void clear();                         // Next batch, next sequence number
+    void reset();                         // New connection: empty, sequence back to 0
+
+    // Clamped into [SAMPLE_BATCH_MIN_PAYLOAD, SAMPLE_BATCH_MAX_PAYLOAD]; a smaller limit
+    // applies from the next batch
+    void setPayloadLimit(size_t payloadLimit);
+    size_t getPayloadLimit() const { return limit; }
+
+    const uint8_t* data() const { return buffer; }
+    size_t size() const { return length; }
+    uint8_t count() const { return buffer[4]; }
+    bool empty() const { return count() == 0; }
+    int64_t firstTimeUs() const { return baseTimeUs; }  // Of the batch being filled
+
+    uint32_t getBatches() const { return batches; }  // Batches cleared after being filled
+    uint32_t getSamples() const { return samples; }
+
+private:
+    void startBatch();
+
+    uint8_t buffer[SAMPLE_BATCH_MAX_PAYLOAD];
+    size_t length;
+    size_t limit;
+    size_t pendingLimit;
+    uint16_t sequence;
+    int64_t baseTimeUs;
+    BatchSample previous;
+    uint32_t batches;
+    uint32_t samples;
+};
+
+// Client side of the encoding. Fills up to capacity samples; false for a malformed or
+// foreign payload, or more samples than capacity.
+bool decodeSampleBatch(const uint8_t* data, size_t length, BatchSample* samples, uint8_t capacity,
+                       uint8_t& count, uint16_t& sequence);
+
+#endif // SAMPLE_BATCH_H
@@ -0,0 +1,27 @@
+#ifndef SAMPLE_CLOCK_H
+#define SAMPLE_CLOCK_H
+
+#include <Arduino.h>
+#include "timing_stats.h"
+
+// Task notification bit set on every sample clock tick (shares the word with the ALERT/RDY bits)
+#define SAMPLE_CLOCK_BIT (1UL << 4)
+
+// Periodic esp_timer that notifies the acquisition task at an exact period,
+// independent of how long each read takes and of the RTOS tick granularity.
+bool startSampleClock(TaskHandle_t task, uint32_t periodUs);
+void stopSampleClock();
+bool setSampleClockPeriod(uint32_t periodUs);
+uint32_t getSampleClockPeriod();
+
+// Block until the next tick. Returns false on timeout; otherwise tickTimeUs holds the
+// esp_timer_get_time() of the tick and missedTicks the ticks that elapsed unserviced.
+bool waitForSampleTick(TickType_t timeout, int64_t& tickTimeUs, uint32_t& missedTicks);
+
+// Jitter/overrun statistics, updated by the acquisition task
+void recordSampleTiming(int64_t timestampUs, uint32_t missedTicks);
+void resetSampleTiming(uint32_t nominalPeriodUs);
+PeriodStats getSampleTimingStats();
+String formatSampleTimingStats();
+
+#endif // SAMPLE_CLOCK_H
@@ -0,0 +1,91 @@
+#ifndef SAMPLE_QUALITY_H
+#define SAMPLE_QUALITY_H
+
+#include <stdint.h>
+
+// Per-channel quality flags carried with every sample. No flag set means a fresh
+// conversion taken for this sample.
+#define SAMPLE_QUALITY_FRESH 0x00
+#define SAMPLE_QUALITY_HELD 0x01          // No new conversion; the previous value is repeated
+#define SAMPLE_QUALITY_STALE 0x02         // Held because the conversion failed
+#define SAMPLE_QUALITY_RECOVERING 0x04    // Held because the device is lost, until it is reattached
+#define SAMPLE_QUALITY_CLIPPED 0x08       // Converted at the ADS1115 full-scale limit
+#define SAMPLE_QUALITY_GAIN_CHANGED 0x10  // First conversion at a new PGA gain
+
+// Flags that make a sample count towards degraded time. A plain hold is not one of them:
+// a scan rotation holds channels between their slots by design.
+#define SAMPLE_QUALITY_DEGRADED (SAMPLE_QUALITY_STALE | SAMPLE_QUALITY_RECOVERING | SAMPLE_QUALITY_CLIPPED)
+
+// Sample intervals longer than this (acquisition paused) are not attributed to either side
+#define SAMPLE_QUALITY_MAX_INTERVAL_US 1000000
+
+// True when the value is a conversion of its own, worth adding to averages and extremes
+inline bool isSampleFresh(uint8_t quality) {
+    return !(quality & SAMPLE_QUALITY_HELD);
+}
+
+inline bool isSampleDegraded(uint8_t quality) {
+    return (quality & SAMPLE_QUALITY_DEGRADED) != 0;
+}
+
+// Both channels' flags in one field (current in the low byte) for compact records
+inline uint16_t packSampleQuality(uint8_t shuntQuality, uint8_t ads2Quality) {
+    return static_cast<uint16_t>(shuntQuality | (ads2Quality << 8));
+}
+
+// Quality of a decimated output from the inputs it summarises: the degraded and gain
+// flags of any input carry over, and the output is only held when every input was
+class QualityAccumulator {
+public:
+    QualityAccumulator() : flags(0), fresh(false), latest(SAMPLE_QUALITY_HELD) {}
+
+    void add(uint8_t quality) {
+        flags |= quality & ~SAMPLE_QUALITY_HELD;
+        fresh |= isSampleFresh(quality);
+    }
+
+    // Close the current output and start the next one
+    void complete() {
+        latest = flags | (fresh ? 0 : SAMPLE_QUALITY_HELD);
+        flags = 0;
+        fresh = false;
+    }
+
+    uint8_t output() const { return latest; }
+
+private:
+    uint8_t flags;
+    bool fresh;
+    uint8_t latest;
+};
+
+// Sample and time counts of one channel's quality
+struct QualityCounts {
+    uint32_t samples;
+    uint32_t fresh;
+    uint32_t stale;
+    uint32_t recovering;
+    uint32_t clipped;
+    uint32_t gainChanges;
+    int64_t totalUs;     // Time covered by counted sample intervals
+    int64_t degradedUs;  // Part of it ending in a degraded sample
+};
+
+// Running quality counts of one channel's sample stream; each sample is charged with the
+// interval since the one before it
+class SampleQualityCounter {
+public:
+    SampleQualityCounter();
+
+    void add(int64_t timestampUs, uint8_t quality);
+    void reset();
+
+    const QualityCounts& getCounts() const;
+
+private:
+    QualityCounts counts;
+    bool hasPrevious;
+    int64_t previousUs;
+};
+
+#endif // SAMPLE_QUALITY_H
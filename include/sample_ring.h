@@ -0,0 +1,121 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Lock-free single-producer / multi-consumer ring buffer.
+//
+// The producer never blocks: when the ring is full the oldest slot is overwritten.
+// Every consumer owns a SampleRing::Reader with its own cursor, so consumers never
+// steal samples from each other. A reader that falls more than N samples behind (or
+// whose slot is overwritten while it copies it) skips ahead and counts the skipped
+// samples in dropped(), so loss is always visible to the consumer.
+//
+// Each slot carries a sequence stamp that works like a per-slot seqlock: it is cleared
+// while the producer writes and set to (sequence + 1) once the payload is complete.
+template <typename T, size_t N>
+class SampleRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SampleRing capacity must be a power of two");
+
+public:
+    SampleRing() : head(0) {
+        for (size_t i = 0; i < N; i++) {
+            slots[i].stamp.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Producer only
+    void push(const T& item) {
+        uint32_t seq = head.load(std::memory_order_relaxed);
+        Slot& slot = slots[seq & (N - 1)];
+        slot.stamp.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.item = item;
+        slot.stamp.store(seq + 1, std::memory_order_release);
+        head.store(seq + 1, std::memory_order_release);
+    }
+
+    // Total number of samples ever pushed (wraps at 2^32)
+    uint32_t written() const {
+        return head.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() {
+        return N;
+    }
+
+    class Reader {
+    public:
+        // A new reader starts at the current head and only sees samples pushed afterwards
+        explicit Reader(const SampleRing& ring)
+            : ring(ring), cursor(ring.written()), droppedCount(0) {}
+
+        // Returns false when no new sample is available
+        bool read(T& out) {
+            while (true) {
+                uint32_t head = ring.written();
+                uint32_t pending = head - cursor;
+                if (pending == 0) {
+                    return false;
+                }
+                if (pending > N) {
+                    // Lapped by the producer: skip to the oldest sample still in the ring
+                    droppedCount += pending - N;
+                    cursor = head - N;
+                }
+
+                const Slot& slot = ring.slots[cursor & (N - 1)];
+                uint32_t before = slot.stamp.load(std::memory_order_acquire);
+                if (before != cursor + 1) {
+                    // Slot is being rewritten for a newer lap; count it and move on
+                    droppedCount++;
+                    cursor++;
+                    continue;
+                }
+                out = slot.item;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                uint32_t after = slot.stamp.load(std::memory_order_relaxed);
+                if (after != before) {
+                    droppedCount++;
+                    cursor++;
+                    continue;
+                }
+                cursor++;
+                return true;
+            }
+        }
+
+        // Number of samples waiting for this reader (may exceed capacity if lapped)
+        uint32_t available() const {
+            return ring.written() - cursor;
+        }
+
+        // Samples this reader lost to overwrites since it was created
+        uint32_t dropped() const {
+            return droppedCount;
+        }
+
+        // Discard any backlog and continue from the newest sample
+        void skipToHead() {
+            cursor = ring.written();
+        }
+
+    private:
+        const SampleRing& ring;
+        uint32_t cursor;
+        uint32_t droppedCount;
+    };
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> stamp;
+        T item;
+    };
+
+    Slot slots[N];
+    std::atomic<uint32_t> head;
+};
+
+#endif // SAMPLE_RING_H
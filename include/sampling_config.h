@@ -2,9 +2,31 @@
 #define SAMPLING_CONFIG_H
 
 #include <Arduino.h>
+#include "adc_sample.h"
+#include "adaptive_rate.h"
+
+// Adaptive sampling: the fastest interval the single-shot scan runs at on activity, the
+// idle interval it relaxes to, and the activity that counts (see AdaptiveRate)
+#define ADAPTIVE_DEFAULT_FAST_MS 5
+#define ADAPTIVE_DEFAULT_SLOW_MS 1000
+#define ADAPTIVE_CURRENT_THRESHOLD_UA 100000
+#define ADAPTIVE_VOLTAGE_THRESHOLD_UV 5000
 
 // Functions to get/set the sampling interval
 void setSamplingInterval(uint16_t intervalMs);
 uint16_t getSamplingInterval();
 
-#endif // SAMPLING_CONFIG_H
\ No newline at end of file
+// Adaptive mode replaces the fixed interval with one that follows signal activity.
+// Settings may be changed from any task and are kept in NVS; the acquisition task feeds
+// every single-shot sample to updateAdaptiveSampling() and runs the sample clock at
+// getEffectiveSamplingInterval().
+void loadAdaptiveSampling();
+void setAdaptiveSampling(bool enabled);
+bool isAdaptiveSampling();
+bool setAdaptiveLimits(uint16_t fastMs, uint16_t slowMs);
+void updateAdaptiveSampling(const AdcSample& sample);
+uint16_t getEffectiveSamplingInterval();  // The fixed interval unless adaptive mode is on
+
+String formatSamplingStatus();
+
+#endif // SAMPLING_CONFIG_H
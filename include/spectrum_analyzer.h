@@ -0,0 +1,86 @@
+#ifndef SPECTRUM_ANALYZER_H
+#define SPECTRUM_ANALYZER_H
+
+#include <stdint.h>
+#include "fixed_point.h"
+#include "real_fft.h"
+
+// Frame length; 1024 conversions are ~1.2 s at 860 SPS, resolving 0.84 Hz
+#define SPECTRUM_FFT_SIZE 1024
+#define SPECTRUM_BIN_COUNT (SPECTRUM_FFT_SIZE / 2)
+
+#define SPECTRUM_MAX_BANDS 6
+#define SPECTRUM_PEAK_COUNT 5
+
+// Bins this close to DC hold what is left of the removed mean and are never peaks
+#define SPECTRUM_PEAK_FIRST_BIN 2
+
+// Frequency band reported as an RMS value; a bin belongs to it when its centre is in
+// [lowHz, highHz)
+struct SpectrumBand {
+    const char* name;
+    float lowHz;
+    float highHz;
+};
+
+struct SpectrumPeak {
+    float frequencyHz;  // Interpolated between bins
+    float rms;          // Fraction of full scale
+};
+
+// One analysed frame. Levels are fractions of the channel's full scale; bands that
+// together cover the spectrum add up (as squares) to acRms.
+struct SpectrumResult {
+    uint32_t frames;        // Frames analysed; 0 until the first one completes
+    uint32_t restarts;      // Frames abandoned for a rate change, a gap or a degraded sample
+    float sampleRateHz;
+    float binHz;
+    float mean;             // DC level, removed before the transform
+    float acRms;            // Everything above DC
+    uint8_t bandCount;
+    float bandRms[SPECTRUM_MAX_BANDS];
+    uint8_t peakCount;
+    SpectrumPeak peaks[SPECTRUM_PEAK_COUNT];  // Strongest first
+};
+
+// Spectrum of one channel over back-to-back frames of SPECTRUM_FFT_SIZE conversions.
+// Only fresh conversions are taken (held samples are repeats between a channel's scan
+// slots), so the frame is sampled at the channel's conversion period. The frame is
+// abandoned and restarted when that period changes, when conversions go missing, or on
+// a stale or recovering sample, so a result always comes from an unbroken stretch of
+// good data. Each frame has its mean removed, is Hann-windowed and transformed; the
+// band levels and the strongest local maxima are kept until the next frame completes.
+class SpectrumAnalyzer {
+public:
+    SpectrumAnalyzer(const SpectrumBand* bands, uint8_t bandCount);
+
+    // Conversion period of the analysed channel; a change restarts the frame
+    void setSamplePeriod(uint32_t periodUs);
+
+    // Returns true when the sample completed a frame and result() was updated
+    bool add(int64_t timestampUs, q31_t sample, uint8_t quality);
+
+    const SpectrumResult& result() const { return latest; }
+    const SpectrumBand& getBand(uint8_t band) const { return bands[band < bandCount ? band : 0]; }
+    uint8_t getBandCount() const { return bandCount; }
+    uint16_t getFill() const { return fill; }
+
+    // Exposed for benchmarking the transform on its own
+    RealFft<SPECTRUM_FFT_SIZE>& getFft() { return fft; }
+
+private:
+    void restart();
+    void analyse();
+    void findPeaks(const float* power, float scale);
+
+    RealFft<SPECTRUM_FFT_SIZE> fft;
+    const SpectrumBand* bands;
+    uint8_t bandCount;
+    uint32_t periodUs;
+    int64_t lastUs;
+    uint16_t fill;
+    float frame[SPECTRUM_FFT_SIZE];
+    SpectrumResult latest;
+};
+
+#endif // SPECTRUM_ANALYZER_H
@@ -0,0 +1,26 @@
+#ifndef SPECTRUM_MONITOR_H
+#define SPECTRUM_MONITOR_H
+
+#include <Arduino.h>
+#include "adc_sample.h"
+#include "spectrum_analyzer.h"
+
+// How often spectrumTask drains its ring reader; well inside the ring's ~300 ms at 860 SPS
+#define SPECTRUM_POLL_MS 100
+
+// Spectrum of the shunt channel: band levels and the strongest peaks of the latest
+// SPECTRUM_FFT_SIZE-conversion frame. spectrumTask feeds every sample from its ring
+// reader and publishes after each pass; the getters read that snapshot and may be
+// called from any task.
+void setSpectrumSamplePeriod(uint32_t periodUs);
+void updateSpectrum(const AdcSample& sample);
+bool publishSpectrum();  // True when a new frame was published
+
+SpectrumResult getShuntSpectrum();
+
+// Full report for the spectrum.shunt MCP resource, in microamps
+String formatSpectrum();
+// Short form for the BLE spectrum characteristic; fits one notification
+String formatSpectrumCompact();
+
+#endif // SPECTRUM_MONITOR_H
@@ -0,0 +1,33 @@
+#ifndef STATS_MONITOR_H
+#define STATS_MONITOR_H
+
+#include <Arduino.h>
+#include "adc_sample.h"
+#include "window_statistics.h"
+
+// History shared by a channel's windows; bounds every window length
+#define STATS_HISTORY_SAMPLES 1024
+
+// Window carried in the BLE telemetry (the others are on the stats.windows MCP resource)
+#define STATS_TELEMETRY_WINDOW 1
+
+// Windowed min/max/peak/mean/RMS/noise of both channels, over fresh conversions only,
+// and the sample quality counts (degraded time) of each channel. bleTask feeds every
+// sample from its ring reader and publishes a snapshot after each pass; the getters
+// read that snapshot and may be called from any task.
+void updateStatistics(const AdcSample& sample);
+void publishStatistics();
+
+WindowSummary getShuntSummary(int window);
+WindowSummary getAds2Summary(int window);
+QualityCounts getShuntQuality();
+QualityCounts getAds2Quality();
+
+// Resize a window (applied by the feeding task on its next publish)
+bool setStatisticsWindow(int window, uint32_t samples);
+uint32_t getStatisticsWindow(int window);
+
+String formatStatistics();
+String formatSampleQuality();
+
+#endif // STATS_MONITOR_H
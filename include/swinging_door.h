@@ -0,0 +1,98 @@
+#ifndef SWINGING_DOOR_H
+#define SWINGING_DOOR_H
+
+#include <stdint.h>
+#include "fixed_point.h"
+#include "sample_quality.h"
+
+// Longest time between two archived points, so a steady signal still gets a point this
+// often. The limit keeps slope products (value span x time) within 64 bits.
+#define SWINGING_DOOR_DEFAULT_MAX_INTERVAL_US 5000000
+#define SWINGING_DOOR_MAX_INTERVAL_LIMIT_US 60000000
+
+// Archived points held for the reader; one input archives at most two
+#define SWINGING_DOOR_OUTPUT_POINTS 4
+
+// A point of the compressed trend. Straight lines between consecutive points reconstruct
+// every input conversion to within the deviation, except across a break.
+struct TrendPoint {
+    int64_t timeUs;   // Timestamp of the input conversion the point was archived at
+    q31_t value;      // On the reconstruction line; within the deviation of that conversion
+    uint8_t channel;  // Channel the compressor was created for
+    uint8_t quality;  // SAMPLE_QUALITY_* flags of every conversion since the previous point
+    bool start;       // First point after a break (or ever): not joined to the previous one
+};
+
+// Swinging-door trending of one channel. Two doors hinge on the last archived point (the
+// pivot): the upper one only ever closes downwards, to the lowest slope towards any
+// conversion plus the deviation, the lower one only upwards, to the highest slope towards
+// any conversion minus it. While they have not crossed, a straight line from the pivot
+// stays within the deviation of every conversion since it. The conversion that makes
+// them cross archives the one before it on such a line, and that point becomes the next
+// pivot. Points keep the exact timestamps of the conversions; values move by at most the
+// deviation so the bound holds along the whole segment. A deviation of 0 keeps every
+// corner of the signal exactly (runs of identical or linear values still collapse).
+//
+// Slopes are kept as exact integer fractions, so the bound does not depend on float
+// rounding. Held conversions are repeats and are skipped. A stale or recovering sample
+// ends the trend at the last good conversion, as does a gap longer than
+// SWINGING_DOOR_MAX_INTERVAL_LIMIT_US (acquisition paused); the next conversion starts a
+// new one.
+class SwingingDoor {
+public:
+    explicit SwingingDoor(uint8_t channel = 0, q31_t deviation = 0,
+                          int64_t maxIntervalUs = SWINGING_DOOR_DEFAULT_MAX_INTERVAL_US);
+
+    // timeUs is the middle of the conversion (AdcSample::shuntUs/ads2Us)
+    void add(int64_t timeUs, q31_t value, uint8_t quality);
+    bool read(TrendPoint& point);  // Oldest archived point; false when none is ready
+    void flush();                  // Archive the pending conversion, ending the segment
+    void reset();
+
+    // Both apply from the next conversion; earlier ones keep the bound they were added with
+    void setDeviation(q31_t deviation);
+    void setMaxInterval(int64_t maxIntervalUs);
+    q31_t getDeviation() const { return deviation; }
+    int64_t getMaxInterval() const { return maxIntervalUs; }
+
+    uint32_t getInputs() const { return inputs; }      // Fresh conversions compressed
+    uint32_t getArchived() const { return archived; }  // Points emitted
+
+private:
+    // A slope as an exact fraction; den > 0
+    struct Slope {
+        int64_t num;
+        int64_t den;
+    };
+
+    static bool steeper(const Slope& a, const Slope& b);
+    void openDoors(int64_t timeUs, q31_t value);
+    void archiveHeld();
+    void archive(int64_t timeUs, q31_t value, uint8_t flags);
+    void endTrend();
+    void push(const TrendPoint& point);
+
+    uint8_t channel;
+    q31_t deviation;
+    int64_t maxIntervalUs;
+
+    bool hasPivot;
+    bool startNext;       // The next archived point starts a new trend
+    int64_t pivotUs;
+    q31_t pivotValue;
+    bool hasHeld;         // A conversion since the pivot, not archived yet
+    int64_t heldUs;
+    q31_t heldValue;
+    uint8_t heldFlags;    // Flags since the pivot up to and including the held conversion
+    Slope upper;          // Lowest upper door (value + deviation) seen from the pivot
+    Slope lower;          // Highest lower door (value - deviation)
+
+    TrendPoint output[SWINGING_DOOR_OUTPUT_POINTS];
+    uint8_t outputHead;
+    uint8_t outputCount;
+
+    uint32_t inputs;
+    uint32_t archived;
+};
+
+#endif // SWINGING_DOOR_H
@@ -0,0 +1,79 @@
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fixed_point.h"
+
+// First byte of a binary frame; a JSON frame starts with '{', so a client tells them apart
+#define TELEMETRY_FRAME_MAGIC 0xA7
+
+// Layout version, bumped whenever a field moves or changes meaning; sent in the
+// onConnect version info so a client can refuse layouts it does not know
+#define TELEMETRY_FRAME_VERSION 1
+
+#define TELEMETRY_FRAME_SIZE 84
+
+// Longest JSON frame: one notification at the 256-byte ATT MTU setupBLE() requests. The
+// frame is only sent when it fits the MTU the client actually negotiated.
+#define TELEMETRY_JSON_CAPACITY 253
+
+// TelemetryFrame::flags
+#define TELEMETRY_FLAG_VOLTAGE_AVAILABLE 0x01
+
+// Telemetry data characteristic encodings, negotiated per connection. STREAM sends the
+// binary frames plus every acquired sample in batches (sample_batch.h).
+enum TelemetryFormat { TELEMETRY_FORMAT_JSON, TELEMETRY_FORMAT_BINARY, TELEMETRY_FORMAT_STREAM };
+
+// Minimum/maximum/peak/RMS/standard deviation of one channel over a statistics window
+struct TelemetryStats {
+    int32_t min;
+    int32_t max;
+    int32_t peak;
+    int32_t rms;
+    int32_t stddev;
+};
+
+// Everything one telemetry update carries, in engineering units
+struct TelemetryFrame {
+    uint16_t sequence;        // Frame counter of the connection (wraps)
+    uint32_t timestampMs;     // millis() when the frame was built
+    int32_t currentUa;        // Decimated measurements
+    int32_t voltageUv;
+    int32_t powerUw;          // Real power over the last window, saturated to 32 bits
+    uint8_t currentQuality;   // SAMPLE_QUALITY_* over the decimation window
+    uint8_t voltageQuality;
+    uint8_t relays;           // Bit i: relay i + 1 on
+    uint8_t flags;            // TELEMETRY_FLAG_*
+    q31_t shuntCounts;        // Legacy counts relative to the nominal gains, Q31_ONE_COUNT per count
+    q31_t ads2Counts;
+    int32_t chargeUah;        // Net charge and energy totals, saturated to 32 bits
+    int32_t energyUwh;
+    uint32_t statsWindow;     // Samples in the statistics window
+    TelemetryStats currentStats;  // uA
+    TelemetryStats voltageStats;  // uV
+};
+
+// Fixed little-endian layout, TELEMETRY_FRAME_SIZE bytes:
+//
+//   0  u8   TELEMETRY_FRAME_MAGIC      24  i32  shuntCounts
+//   1  u8   TELEMETRY_FRAME_VERSION    28  i32  ads2Counts
+//   2  u16  sequence                   32  i32  chargeUah
+//   4  u32  timestampMs                36  i32  energyUwh
+//   8  i32  currentUa                  40  u32  statsWindow
+//  12  i32  voltageUv                  44  i32  current min, max, peak, rms, stddev
+//  16  i32  powerUw                    64  i32  voltage min, max, peak, rms, stddev
+//  20  u8   currentQuality, voltageQuality, relays, flags
+//
+// Returns the bytes written, 0 when out is too small
+size_t encodeTelemetryFrame(const TelemetryFrame& frame, uint8_t* out, size_t capacity);
+
+// False for a short buffer, a JSON frame or an unknown layout version
+bool decodeTelemetryFrame(const uint8_t* data, size_t length, TelemetryFrame& frame);
+
+// The JSON compatibility encoding of the frame: measurements and relays only (quality,
+// energy and statistics are in the binary frame). Formats into a caller-owned buffer and
+// returns the length, or 0 when it did not fit with its terminator.
+size_t formatTelemetryJson(const TelemetryFrame& frame, const char* protocolVersion, char* out, size_t capacity);
+
+#endif // TELEMETRY_FRAME_H
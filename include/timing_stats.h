@@ -0,0 +1,54 @@
+#ifndef TIMING_STATS_H
+#define TIMING_STATS_H
+
+#include <stdint.h>
+
+// Histogram buckets for |actual period - nominal period|, upper bounds in microseconds.
+// The last bucket collects everything above the final bound.
+#define JITTER_BUCKET_COUNT 8
+extern const uint32_t JITTER_BUCKET_LIMITS_US[JITTER_BUCKET_COUNT - 1];
+
+// Histogram buckets for ticks missed in a single overrun: 1, 2, 3-4, 5-8, >8
+#define OVERRUN_BUCKET_COUNT 5
+extern const uint32_t OVERRUN_BUCKET_LIMITS[OVERRUN_BUCKET_COUNT - 1];
+
+// Period jitter and overrun statistics of a periodic sample clock.
+// Fed with the timestamp of every serviced tick; keeps no per-sample history.
+class PeriodStats {
+public:
+    PeriodStats();
+
+    // Clear all counters and set the period the clock is supposed to run at
+    void reset(uint32_t nominalPeriodUs);
+
+    // Record a serviced tick. missedTicks is the number of ticks that fired while the
+    // previous one was still being serviced (0 when the consumer kept up).
+    void recordTick(int64_t timestampUs, uint32_t missedTicks);
+
+    uint32_t getNominalPeriodUs() const { return nominalPeriodUs; }
+    uint32_t getTickCount() const { return ticks; }
+    uint32_t getOverrunCount() const { return overruns; }
+    uint32_t getMissedTickCount() const { return missedTicks; }
+    int32_t getMinErrorUs() const { return minErrorUs; }
+    int32_t getMaxErrorUs() const { return maxErrorUs; }
+    uint32_t getJitterBucket(int index) const { return jitterBuckets[index]; }
+    uint32_t getOverrunBucket(int index) const { return overrunBuckets[index]; }
+
+    // Mean serviced period and the rate it corresponds to
+    uint32_t getMeanPeriodUs() const;
+    float getAchievedRateHz() const;
+
+private:
+    uint32_t nominalPeriodUs;
+    int64_t firstTickUs;
+    int64_t lastTickUs;
+    uint32_t ticks;
+    uint32_t overruns;
+    uint32_t missedTicks;
+    int32_t minErrorUs;
+    int32_t maxErrorUs;
+    uint32_t jitterBuckets[JITTER_BUCKET_COUNT];
+    uint32_t overrunBuckets[OVERRUN_BUCKET_COUNT];
+};
+
+#endif // TIMING_STATS_H
@@ -0,0 +1,49 @@
+#ifndef TREND_MONITOR_H
+#define TREND_MONITOR_H
+
+#include <Arduino.h>
+#include "adc_sample.h"
+#include "swinging_door.h"
+
+// TrendPoint::channel of each compressed channel
+#define TREND_CHANNEL_CURRENT 0
+#define TREND_CHANNEL_VOLTAGE 1
+#define TREND_CHANNEL_COUNT 2
+
+// Default error bounds: about three counts of each channel at its nominal gain
+#define TREND_DEFAULT_CURRENT_DEVIATION_UA 50000
+#define TREND_DEFAULT_VOLTAGE_DEVIATION_UV 2000
+
+// Largest settable error bound (1 A / 1 V)
+#define TREND_MAX_DEVIATION_UNITS 1000000
+
+// Archived points of both channels awaiting their consumers
+#define TREND_RING_CAPACITY 128
+
+// Latest points listed by the trend.points MCP resource
+#define TREND_HISTORY_POINTS 8
+
+typedef SampleRing<TrendPoint, TREND_RING_CAPACITY> TrendPointRing;
+extern TrendPointRing trendRing;
+
+// Swinging-door compression of both channels at the acquisition source. compressTrend()
+// runs on the acquisition task for every stored sample and publishes the archived
+// points, timestamped with their conversions, to trendRing; every consumer keeps its
+// own reader. Straight lines between a channel's points reconstruct each of its
+// conversions within the channel's deviation, so a steady load produces a point per
+// SWINGING_DOOR_DEFAULT_MAX_INTERVAL_US instead of one per conversion. Returns true when
+// the sample archived a point.
+bool compressTrend(const AdcSample& sample);
+
+// Error bounds in uA (current) or uV (voltage); 0 keeps every change. Set from any task,
+// applied by the acquisition task and kept in NVS.
+void loadTrendSettings();
+bool setTrendDeviation(uint8_t channel, uint32_t units);
+uint32_t getTrendDeviation(uint8_t channel);
+
+int32_t trendPointUnits(const TrendPoint& point);  // Value in uA or uV
+
+String formatTrendStatus();
+String formatTrendPoints(const TrendPoint* points, uint8_t count);
+
+#endif // TREND_MONITOR_H
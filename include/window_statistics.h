@@ -0,0 +1,199 @@
+#ifndef WINDOW_STATISTICS_H
+#define WINDOW_STATISTICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include "fixed_point.h"
+
+// Number of concurrent sliding windows per channel and their default lengths in samples
+#define STATS_WINDOW_COUNT 3
+#define STATS_WINDOW_SHORT 32
+#define STATS_WINDOW_MEDIUM 256
+#define STATS_WINDOW_LONG 1024
+
+// Running sums are kept at Q23 so squares of a full window stay inside 64 bits
+#define STATS_SUM_SHIFT 8
+
+// Statistics of one window, in the channel's Q31 sample scale
+struct WindowSummary {
+    uint32_t count;  // Samples currently in the window (below the length while filling)
+    q31_t min;
+    q31_t max;
+    q31_t peak;      // Largest magnitude
+    q31_t mean;
+    q31_t rms;
+    q31_t stddev;    // Population standard deviation (noise)
+};
+
+// Sliding-window statistics of one sample stream over STATS_WINDOW_COUNT windows of up
+// to Capacity samples each, updated in O(1) per sample. Min/max come from monotonic
+// deques over a shared sample history; mean, RMS and variance from exact integer
+// running sums that are added to and subtracted from as samples enter and leave, so
+// nothing drifts however long it runs. Moments are only converted to floating point
+// when a summary is taken.
+template <size_t Capacity>
+class WindowedStatistics {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(Capacity <= 32768, "Deque entries hold 16-bit sequence numbers");
+    static_assert(static_cast<uint64_t>(Capacity) << (2 * (31 - STATS_SUM_SHIFT)) <= INT64_MAX,
+                  "Sum of squares would overflow");
+
+public:
+    WindowedStatistics() : sequence(0), filled(0) {
+        static const uint32_t defaults[STATS_WINDOW_COUNT] = {STATS_WINDOW_SHORT, STATS_WINDOW_MEDIUM,
+                                                              STATS_WINDOW_LONG};
+        for (int i = 0; i < STATS_WINDOW_COUNT; i++) {
+            windows[i].length = clampLength(defaults[i]);
+            clear(windows[i]);
+        }
+    }
+
+    // Resize a window; it is refilled from the history it shares with the other windows
+    void setWindowLength(int window, uint32_t length) {
+        if (window < 0 || window >= STATS_WINDOW_COUNT) {
+            return;
+        }
+        Window& w = windows[window];
+        w.length = clampLength(length);
+        clear(w);
+        uint32_t replay = filled < w.length ? filled : w.length;
+        for (uint32_t seq = sequence - replay; seq != sequence; seq++) {
+            admit(w, seq);
+        }
+    }
+
+    uint32_t getWindowLength(int window) const {
+        return (window >= 0 && window < STATS_WINDOW_COUNT) ? windows[window].length : 0;
+    }
+
+    void add(q31_t value) {
+        // Retire the samples leaving each window before the history slot is reused
+        for (int i = 0; i < STATS_WINDOW_COUNT; i++) {
+            retire(windows[i]);
+        }
+        history[sequence & MASK] = value;
+        for (int i = 0; i < STATS_WINDOW_COUNT; i++) {
+            admit(windows[i], sequence);
+        }
+        sequence++;
+        if (filled < Capacity) {
+            filled++;
+        }
+    }
+
+    void reset() {
+        sequence = 0;
+        filled = 0;
+        for (int i = 0; i < STATS_WINDOW_COUNT; i++) {
+            clear(windows[i]);
+        }
+    }
+
+    WindowSummary summary(int window) const {
+        WindowSummary result = {0, 0, 0, 0, 0, 0, 0};
+        if (window < 0 || window >= STATS_WINDOW_COUNT || windows[window].count == 0) {
+            return result;
+        }
+        const Window& w = windows[window];
+        result.count = w.count;
+        result.min = history[w.minQueue[w.minHead] & MASK];
+        result.max = history[w.maxQueue[w.maxHead] & MASK];
+        q31_t minMagnitude = result.min == INT32_MIN ? INT32_MAX : -result.min;
+        result.peak = minMagnitude > result.max ? minMagnitude : result.max;
+
+        const double scale = static_cast<double>(1 << STATS_SUM_SHIFT);
+        double mean = static_cast<double>(w.sum) / w.count;
+        double meanSquare = static_cast<double>(w.sumSquares) / w.count;
+        double variance = meanSquare - mean * mean;
+        result.mean = toQ31(mean * scale);
+        result.rms = toQ31(sqrt(meanSquare) * scale);
+        result.stddev = toQ31(variance > 0 ? sqrt(variance) * scale : 0);
+        return result;
+    }
+
+private:
+    static const uint32_t MASK = Capacity - 1;
+
+    struct Window {
+        uint32_t length;
+        uint32_t count;
+        int64_t sum;
+        int64_t sumSquares;
+        // Sequence numbers (low 16 bits) of candidate extremes, oldest first
+        uint16_t minQueue[Capacity];
+        uint16_t maxQueue[Capacity];
+        uint16_t minHead, minSize;
+        uint16_t maxHead, maxSize;
+    };
+
+    static uint32_t clampLength(uint32_t length) {
+        if (length < 1) return 1;
+        if (length > Capacity) return Capacity;
+        return length;
+    }
+
+    static int64_t reduce(q31_t value) {
+        return (static_cast<int64_t>(value) + (1 << (STATS_SUM_SHIFT - 1))) >> STATS_SUM_SHIFT;
+    }
+
+    static q31_t toQ31(double value) {
+        return saturateQ31(static_cast<int64_t>(value < 0 ? value - 0.5 : value + 0.5));
+    }
+
+    static void clear(Window& w) {
+        w.count = 0;
+        w.sum = 0;
+        w.sumSquares = 0;
+        w.minHead = w.minSize = 0;
+        w.maxHead = w.maxSize = 0;
+    }
+
+    // Drop the sample about to fall out of a full window, ahead of the next add()
+    void retire(Window& w) {
+        if (w.count < w.length) {
+            return;
+        }
+        uint32_t leaving = sequence - w.length;
+        int64_t value = reduce(history[leaving & MASK]);
+        w.sum -= value;
+        w.sumSquares -= value * value;
+        w.count--;
+        uint16_t leavingTag = static_cast<uint16_t>(leaving);
+        if (w.minSize > 0 && w.minQueue[w.minHead] == leavingTag) {
+            w.minHead = static_cast<uint16_t>((w.minHead + 1) & MASK);
+            w.minSize--;
+        }
+        if (w.maxSize > 0 && w.maxQueue[w.maxHead] == leavingTag) {
+            w.maxHead = static_cast<uint16_t>((w.maxHead + 1) & MASK);
+            w.maxSize--;
+        }
+    }
+
+    void admit(Window& w, uint32_t seq) {
+        q31_t value = history[seq & MASK];
+        int64_t reduced = reduce(value);
+        w.sum += reduced;
+        w.sumSquares += reduced * reduced;
+        w.count++;
+
+        // Later samples dominate earlier ones that are no smaller (min) / no larger (max)
+        while (w.minSize > 0 && history[w.minQueue[(w.minHead + w.minSize - 1) & MASK] & MASK] >= value) {
+            w.minSize--;
+        }
+        w.minQueue[(w.minHead + w.minSize) & MASK] = static_cast<uint16_t>(seq);
+        w.minSize++;
+        while (w.maxSize > 0 && history[w.maxQueue[(w.maxHead + w.maxSize - 1) & MASK] & MASK] <= value) {
+            w.maxSize--;
+        }
+        w.maxQueue[(w.maxHead + w.maxSize) & MASK] = static_cast<uint16_t>(seq);
+        w.maxSize++;
+    }
+
+    q31_t history[Capacity];
+    uint32_t sequence;  // Samples added so far; wraps harmlessly
+    uint32_t filled;    // Valid history entries, up to Capacity
+    Window windows[STATS_WINDOW_COUNT];
+};
+
+#endif // WINDOW_STATISTICS_H
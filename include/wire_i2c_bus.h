@@ -0,0 +1,31 @@
+#ifndef WIRE_I2C_BUS_H
+#define WIRE_I2C_BUS_H
+
+#include <Wire.h>
+#include "i2c_bus.h"
+
+// SCL pulses of a bus clear: enough for a device to finish any byte it is sending
+#define I2C_CLEAR_PULSES 9
+#define I2C_CLEAR_HALF_PERIOD_US 5
+
+// I2CBus implementation on top of the Arduino TwoWire driver. The pins are needed to
+// bit-bang a bus clear and to hand them back to the driver afterwards.
+class WireI2CBus : public I2CBus {
+public:
+    WireI2CBus(TwoWire& wire, int sdaPin, int sclPin);
+
+    bool write(uint8_t address, const uint8_t* data, size_t length) override;
+    bool read(uint8_t address, uint8_t* data, size_t length) override;
+    bool setClock(uint32_t hz) override;
+    bool clearBus() override;
+    uint32_t micros() override;
+    void delayMicros(uint32_t us) override;
+
+private:
+    TwoWire& wire;
+    int sdaPin;
+    int sclPin;
+    uint32_t clockHz;
+};
+
+#endif // WIRE_I2C_BUS_H
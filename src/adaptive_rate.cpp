@@ -0,0 +1,114 @@
+#include "adaptive_rate.h"
+#include <math.h>
+
+AdaptiveRate::AdaptiveRate(uint16_t fastIntervalMs, uint16_t slowIntervalMs, q31_t currentThreshold,
+                           q31_t voltageThreshold, uint32_t holdMs)
+    : fastMs(1), slowMs(1), switchCount(0) {
+    setLimits(fastIntervalMs, slowIntervalMs);
+    setThresholds(currentThreshold, voltageThreshold);
+    setHold(holdMs);
+    reset();
+}
+
+void AdaptiveRate::reset() {
+    intervalMs = fastMs;
+    quietStarted = false;
+    quietSinceUs = 0;
+    for (Channel& channel : channels) {
+        channel.head = 0;
+        channel.count = 0;
+        channel.activity.level = 0;
+    }
+}
+
+bool AdaptiveRate::setLimits(uint16_t fastIntervalMs, uint16_t slowIntervalMs) {
+    if (fastIntervalMs == 0 || slowIntervalMs < fastIntervalMs) {
+        return false;
+    }
+    fastMs = fastIntervalMs;
+    slowMs = slowIntervalMs;
+    if (intervalMs < fastMs) intervalMs = fastMs;
+    if (intervalMs > slowMs) intervalMs = slowMs;
+    return true;
+}
+
+void AdaptiveRate::setThresholds(q31_t currentThreshold, q31_t voltageThreshold) {
+    channels[0].activity.threshold = currentThreshold > 0 ? currentThreshold : 0;
+    channels[1].activity.threshold = voltageThreshold > 0 ? voltageThreshold : 0;
+}
+
+// Held conversions are repeats and say nothing about activity; a clipped one means the
+// signal left the range, which always counts as activity
+AdaptiveRate::Level AdaptiveRate::measure(Channel& channel, q31_t value, uint8_t quality) {
+    if (!isSampleFresh(quality) || (quality & (SAMPLE_QUALITY_STALE | SAMPLE_QUALITY_RECOVERING))) {
+        return LEVEL_QUIET;
+    }
+    int64_t step = 0;
+    if (channel.count > 0) {
+        uint8_t last = (channel.head + ADAPTIVE_RATE_WINDOW - 1) % ADAPTIVE_RATE_WINDOW;
+        step = static_cast<int64_t>(value) - channel.window[last];
+        step = step < 0 ? -step : step;
+    }
+    channel.window[channel.head] = value;
+    channel.head = (channel.head + 1) % ADAPTIVE_RATE_WINDOW;
+    if (channel.count < ADAPTIVE_RATE_WINDOW) {
+        channel.count++;
+    }
+
+    // Two passes relative to the newest value keep float precision at the spread, not the level
+    float mean = 0;
+    for (uint8_t i = 0; i < channel.count; i++) {
+        mean += static_cast<float>(static_cast<int64_t>(channel.window[i]) - value);
+    }
+    mean /= channel.count;
+    float squares = 0;
+    for (uint8_t i = 0; i < channel.count; i++) {
+        float deviation = static_cast<float>(static_cast<int64_t>(channel.window[i]) - value) - mean;
+        squares += deviation * deviation;
+    }
+    int64_t level = static_cast<int64_t>(sqrtf(squares / channel.count));
+    if (step > level) level = step;
+    channel.activity.level = saturateQ31(level);
+
+    if ((quality & SAMPLE_QUALITY_CLIPPED) || channel.activity.level > channel.activity.threshold) {
+        return LEVEL_ACTIVE;
+    }
+    return channel.activity.level > channel.activity.threshold / 2 ? LEVEL_BAND : LEVEL_QUIET;
+}
+
+bool AdaptiveRate::update(int64_t timeUs, q31_t current, uint8_t currentQuality, q31_t voltage,
+                          uint8_t voltageQuality) {
+    Level currentLevel = measure(channels[0], current, currentQuality);
+    Level voltageLevel = measure(channels[1], voltage, voltageQuality);
+    Level level = currentLevel > voltageLevel ? currentLevel : voltageLevel;
+
+    if (level == LEVEL_ACTIVE) {
+        quietStarted = false;
+        return setInterval(fastMs);
+    }
+    if (level == LEVEL_BAND) {
+        quietStarted = false;
+        return false;
+    }
+    if (!quietStarted) {
+        quietStarted = true;
+        quietSinceUs = timeUs;
+        return false;
+    }
+    if (timeUs - quietSinceUs < holdUs) {
+        return false;
+    }
+    // Each slower step has to stay quiet for a hold of its own
+    quietSinceUs = timeUs;
+    uint32_t slower = static_cast<uint32_t>(intervalMs) * 2;
+    return setInterval(slower < slowMs ? slower : slowMs);
+}
+
+bool AdaptiveRate::setInterval(uint16_t interval) {
+    if (interval == intervalMs) {
+        return false;
+    }
+    intervalMs = interval;
+    switchCount++;
+    return true;
+}
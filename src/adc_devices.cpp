@@ -0,0 +1,125 @@
+#include "adc_devices.h"
+
+uint8_t adcTableDeviceMask(const AdcChannelConfig* table, uint8_t tableSize) {
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < tableSize; i++) {
+        if (table[i].device < ADC_MAX_DEVICES) {
+            mask |= 1 << table[i].device;
+        }
+    }
+    return mask;
+}
+
+ScanScheduler::ScanScheduler() : muxSwitches(0), scanLength(0) {
+    for (int d = 0; d < ADC_MAX_DEVICES; d++) {
+        rotationLength[d] = 0;
+        cursor[d] = 0;
+        slot.channel[d] = -1;
+    }
+    for (int i = 0; i < ADC_MAX_CHANNELS; i++) {
+        channelDevice[i] = 0;
+    }
+}
+
+bool ScanScheduler::configure(const AdcChannelConfig* table, uint8_t tableSize, const uint8_t* list, uint8_t length) {
+    if (length == 0 || length > ADC_MAX_CHANNELS || tableSize > ADC_MAX_CHANNELS) {
+        return false;
+    }
+    uint16_t seen = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        if (list[i] >= tableSize || (seen & (1 << list[i])) || table[list[i]].device >= ADC_MAX_DEVICES) {
+            return false;
+        }
+        seen |= 1 << list[i];
+    }
+
+    scanLength = length;
+    muxSwitches = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        scanList[i] = list[i];
+        channelDevice[list[i]] = table[list[i]].device;
+    }
+    for (uint8_t d = 0; d < ADC_MAX_DEVICES; d++) {
+        // Group by mux in order of first appearance, keeping scan order within a group
+        uint8_t count = 0;
+        uint16_t placed = 0;
+        for (uint8_t i = 0; i < length; i++) {
+            const AdcChannelConfig& first = table[list[i]];
+            if (first.device != d || (placed & (1 << list[i]))) {
+                continue;
+            }
+            for (uint8_t j = i; j < length; j++) {
+                const AdcChannelConfig& other = table[list[j]];
+                if (other.device == d && other.mux == first.mux && !(placed & (1 << list[j]))) {
+                    rotation[d][count++] = list[j];
+                    placed |= 1 << list[j];
+                }
+            }
+        }
+        rotationLength[d] = count;
+        for (uint8_t i = 0; count > 1 && i < count; i++) {
+            if (table[rotation[d][i]].mux != table[rotation[d][(i + 1) % count]].mux) {
+                muxSwitches++;
+            }
+        }
+    }
+    restart();
+    return true;
+}
+
+const ScanSlot& ScanScheduler::next() {
+    for (uint8_t d = 0; d < ADC_MAX_DEVICES; d++) {
+        if (rotationLength[d] == 0) {
+            slot.channel[d] = -1;
+            continue;
+        }
+        slot.channel[d] = static_cast<int8_t>(rotation[d][cursor[d]]);
+        cursor[d] = (cursor[d] + 1) % rotationLength[d];
+    }
+    return slot;
+}
+
+void ScanScheduler::restart() {
+    for (uint8_t d = 0; d < ADC_MAX_DEVICES; d++) {
+        cursor[d] = 0;
+    }
+}
+
+bool ScanScheduler::contains(uint8_t channel) const {
+    for (uint8_t i = 0; i < scanLength; i++) {
+        if (scanList[i] == channel) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t ScanScheduler::getDeviceMask() const {
+    uint8_t mask = 0;
+    for (uint8_t d = 0; d < ADC_MAX_DEVICES; d++) {
+        if (rotationLength[d]) {
+            mask |= 1 << d;
+        }
+    }
+    return mask;
+}
+
+uint8_t ScanScheduler::getRotationLength(uint8_t device) const {
+    return device < ADC_MAX_DEVICES ? rotationLength[device] : 0;
+}
+
+uint8_t ScanScheduler::getRotationLengthOf(uint8_t channel) const {
+    return contains(channel) ? rotationLength[channelDevice[channel]] : 0;
+}
+
+uint8_t ScanScheduler::getMuxSwitchesPerCycle() const {
+    return muxSwitches;
+}
+
+uint8_t ScanScheduler::getScanLength() const {
+    return scanLength;
+}
+
+uint8_t ScanScheduler::getScanChannel(uint8_t index) const {
+    return index < scanLength ? scanList[index] : 0;
+}
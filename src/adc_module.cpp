@@ -1,37 +1,139 @@
 #include "adc_module.h"
 #include "config.h"
-#include <Adafruit_ADS1X15.h>
+#include "wire_i2c_bus.h"
+#include "device_recovery.h"
+#include "sampling_config.h"
+#include "relay_module.h"
+#include <esp_timer.h>
 #include <Preferences.h>
 
-// Global ADS1115 instances
-Adafruit_ADS1115 ads1;
-Adafruit_ADS1115 ads2;
+// I2C transport shared by every converter. The acquisition task and the recovery task
+// both use it; busMutex serialises them.
+WireI2CBus adcBus(Wire, I2C_SDA_PIN, I2C_SCL_PIN);
+static SemaphoreHandle_t busMutex = NULL;
 
-// Global calibration values - ensuring float type for Android app compatibility
-float shuntOffsetFloat = 0.0f;
-float ads2OffsetFloat = 0.0f;
+// Converters of the channel table and the scan schedule; driven by the acquisition task
+static AdcScanner scanner(ADC_CHANNEL_TABLE, ADC_CHANNEL_COUNT);
 
-// Status flags
-bool ads1_available = false;
-bool ads2_available = false;
+// esp_timer_get_time() of each device's last ALERT/RDY edge
+static volatile int64_t deviceReadyUs[ADC_MAX_DEVICES];
 
-// Last good readings (for error recovery)
-int16_t lastGoodShuntReading = 0;
-int16_t lastGoodAds2Reading = 0;
+// Scan list changes requested from other tasks, applied by the acquisition task; both
+// fields are only touched under scanListLock
+static uint8_t pendingScanList[ADC_MAX_CHANNELS];
+static uint8_t pendingScanLength = 0;
+static portMUX_TYPE scanListLock = portMUX_INITIALIZER_UNLOCKED;
 
-// Error counters for I2C failures
-uint8_t ads1ErrorCount = 0;
-uint8_t ads2ErrorCount = 0;
-const uint8_t MAX_ERRORS_BEFORE_RESET = 5;
+// Lock-free sample ring shared by dataTask (producer) and the BLE/MCP consumers
+AdcSampleRing sampleRing;
 
-// Time tracking for I2C recovery
-unsigned long lastAds1RecoveryAttempt = 0;
-unsigned long lastAds2RecoveryAttempt = 0;
-const unsigned long RECOVERY_INTERVAL_MS = 5000; // Try recovery every 5 seconds
+// Calibration offsets per PGA gain (sub-count resolution from the averaging)
+GainOffsetTable shuntOffsets(SHUNT_WIDEST_GAIN);
+GainOffsetTable ads2Offsets(ADS2_WIDEST_GAIN);
+
+// PGA auto-ranging per channel; the rangers own the gain every (re)initialisation applies
+AutoRanger shuntRanger(SHUNT_WIDEST_GAIN, SHUNT_NARROWEST_GAIN, SHUNT_GAIN);
+AutoRanger ads2Ranger(ADS2_WIDEST_GAIN, ADS2_NARROWEST_GAIN, ADS2_GAIN);
+
+// Background calibration, driven from the acquisition task
+static OffsetCalibrator shuntCalibrator;
+static OffsetCalibrator ads2Calibrator;
+static volatile bool calibrationRequested = false;
+static volatile bool calibrationSavePending = false;
+static volatile CalibrationState calibrationState = CALIBRATION_IDLE;
+static volatile uint8_t calibrationProgress = 0;
+
+// Burst capture buffer (preallocated), fed from the acquisition task
+static BurstCapture burstCapture;
+static portMUX_TYPE captureLock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t lastRelayMask = 0;
+
+// Acquisition mode state; mode changes are applied by the acquisition task that owns the I2C bus
+static volatile AcquisitionMode currentAcquisitionMode = ACQ_MODE_SINGLE_SHOT;
+static volatile AcquisitionMode pendingAcquisitionMode = ACQ_MODE_SINGLE_SHOT;
+static volatile bool acquisitionModeChangePending = false;
+static TaskHandle_t acquisitionTask = NULL;
+
+// Reattach schedule of lost devices, shared by the acquisition task (which marks losses)
+// and the recovery task (which does the bus work)
+static RecoveryScheduler recovery;
+static portMUX_TYPE recoveryLock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t recoveryTask = NULL;
 
 extern Preferences prefs;
 
-bool initializeADS(Adafruit_ADS1115 &ads, uint8_t i2cAddress, const char* deviceName) {
+// Conversion-ready interrupt of one device: only notify the acquisition task, the read
+// happens in task context
+static void IRAM_ATTR adcReadyISR(void* arg) {
+    uint32_t device = (uint32_t)(uintptr_t)arg;
+    deviceReadyUs[device] = esp_timer_get_time();
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    if (acquisitionTask != NULL) {
+        xTaskNotifyFromISR(acquisitionTask, ADC_READY_BIT(device), eSetBits, &higherPriorityTaskWoken);
+    }
+    if (higherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void logDeviceEvent(uint8_t device, AdcDeviceEvent event, uint8_t errorCount) {
+    uint8_t address = adcDeviceAddress(device);
+    switch (event) {
+        case ADC_DEVICE_READ_FAILED:
+            LOG_WARNING("ADS1115 at 0x%02X read failed, error count: %d", address, errorCount);
+            break;
+        case ADC_DEVICE_LOST:
+            LOG_ERROR("ADS1115 at 0x%02X marked unavailable after %d consecutive errors", address, errorCount);
+            portENTER_CRITICAL(&recoveryLock);
+            recovery.markLost(device, esp_timer_get_time());
+            portEXIT_CRITICAL(&recoveryLock);
+            if (recoveryTask != NULL) {
+                xTaskNotifyGive(recoveryTask);
+            }
+            break;
+        case ADC_DEVICE_RECOVERED:
+            LOG_INFO("ADS1115 at 0x%02X recovered successfully", address);
+            break;
+        case ADC_DEVICE_CONTINUOUS_FAILED:
+            LOG_ERROR("ADS1115 at 0x%02X failed to enter continuous mode", address);
+            break;
+    }
+}
+
+// Hold the bus for a sequence of transactions. Before setupADC() creates the mutex only
+// the setup code runs, so there is nothing to serialise.
+static void lockBus() {
+    if (busMutex != NULL) {
+        xSemaphoreTake(busMutex, portMAX_DELAY);
+    }
+}
+
+static void unlockBus() {
+    if (busMutex != NULL) {
+        xSemaphoreGive(busMutex);
+    }
+}
+
+static void applyChannelGain(uint8_t channel, Ads1115Gain gain) {
+    lockBus();
+    scanner.setChannelGain(channel, gain);
+    unlockBus();
+}
+
+bool setI2CClock(uint32_t hz) {
+    lockBus();
+    bool applied = adcBus.setClock(hz);
+    unlockBus();
+    if (!applied) {
+        LOG_ERROR("Unsupported I2C clock %lu Hz, keeping current speed", (unsigned long)hz);
+        return false;
+    }
+    LOG_INFO("I2C clock set to %lu Hz", (unsigned long)hz);
+    return true;
+}
+
+bool initializeADS(uint8_t device, const char* deviceName) {
+    uint8_t i2cAddress = adcDeviceAddress(device);
     Wire.beginTransmission(i2cAddress);
     bool devicePresent = (Wire.endTransmission() == 0);
     
@@ -40,192 +142,605 @@ bool initializeADS(Adafruit_ADS1115 &ads, uint8_t i2cAddress, const char* device
         return false;
     }
     
-    // Set a timeout for I2C operations
-    Wire.setTimeOut(100); // 100ms timeout
-    
     // Try to initialize with error handling
     bool success = false;
     for (int attempt = 0; attempt < 3; attempt++) {
-        try {
-            success = ads.begin(i2cAddress);
-            if (success) {
-                LOG_INFO("%s initialized successfully at address 0x%02X", deviceName, i2cAddress);
-                break;
-            }
-        } catch (...) {
-            LOG_ERROR("%s initialization exception, retry %d", deviceName, attempt);
-            delay(50); // Short delay between retries
+        success = scanner.probe(device);
+        if (success) {
+            LOG_INFO("%s initialized successfully at address 0x%02X", deviceName, i2cAddress);
+            break;
         }
+        LOG_ERROR("%s initialization failed, retry %d", deviceName, attempt);
+        delay(50); // Short delay between retries
     }
     
     return success;
 }
 
-void setupADC() {
-    if (!initializeADS(ads1, 0x48, "ADS1115 #1")) {
-        // handle error or restart
-    } else {
-        ads1.setGain(GAIN_EIGHT);
-        ads1.setDataRate(RATE_ADS1115_860SPS);
-        ads1_available = true;
+uint8_t setupADC() {
+    busMutex = xSemaphoreCreateMutex();
+    Wire.setTimeOut(I2C_TIMEOUT_MS);
+    scanner.setBus(&adcBus);
+    scanner.setEventHandler(logDeviceEvent);
+    // The rangers own the gains of the auto-ranged channels
+    applyChannelGain(ADC_CURRENT_CHANNEL, shuntRanger.getGain());
+    applyChannelGain(ADC_VOLTAGE_CHANNEL, ads2Ranger.getGain());
+    scanner.configureScan(ADC_DEFAULT_SCAN_LIST, sizeof(ADC_DEFAULT_SCAN_LIST));
+
+    // Probe every device a table row refers to, so a later scan list can use it
+    uint8_t tableMask = adcTableDeviceMask(ADC_CHANNEL_TABLE, ADC_CHANNEL_COUNT);
+    uint8_t missingMask = 0;
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (!(tableMask & (1 << device))) {
+            continue;
+        }
+        char name[24];
+        snprintf(name, sizeof(name), "ADS1115 #%u", device + 1);
+        if (!initializeADS(device, name)) {
+            missingMask |= 1 << device;
+        }
     }
-    
-    if (initializeADS(ads2, 0x49, "ADS1115 #2")) {
-        ads2.setGain(GAIN_ONE);
-        ads2.setDataRate(RATE_ADS1115_860SPS);
-        ads2_available = true;
-    } else {
-        ads2_available = false;
+    return missingMask;
+}
+
+Ads1115& getAdcDevice(uint8_t device) {
+    return scanner.getDevice(device);
+}
+
+bool isAdcDeviceAvailable(uint8_t device) {
+    return scanner.isDeviceAvailable(device);
+}
+
+bool isChannelAvailable(uint8_t channel) {
+    return scanner.isChannelAvailable(channel);
+}
+
+ChannelReading getChannelReading(uint8_t channel) {
+    return scanner.getReading(channel);
+}
+
+ChannelReading takeChannelReading(uint8_t channel) {
+    return scanner.takeReading(channel);
+}
+
+bool requestScanList(const uint8_t* channels, uint8_t count) {
+    // Validate here so the caller gets an answer; the acquisition task applies it
+    ScanScheduler candidate;
+    if (!candidate.configure(ADC_CHANNEL_TABLE, ADC_CHANNEL_COUNT, channels, count) ||
+        !candidate.contains(ADC_CURRENT_CHANNEL)) {
+        return false;
     }
+    portENTER_CRITICAL(&scanListLock);
+    for (uint8_t i = 0; i < count; i++) {
+        pendingScanList[i] = channels[i];
+    }
+    pendingScanLength = count;
+    portEXIT_CRITICAL(&scanListLock);
+    return true;
 }
 
-void calibrateADC() {
-    LOG_INFO("Starting ADC calibration...");
-    
-    // Only calibrate if ADS1115 #1 is available
-    if (ads1_available) {
-        // Take multiple readings and average them for better accuracy
-        int32_t sum = 0;
-        const int samples = 16;
-        
-        for (int i = 0; i < samples; i++) {
-            try {
-                // Timeout protection for I2C operations
-                int16_t reading = ads1.readADC_Differential_0_1();
-                sum += reading;
-                delay(10);
-            } catch (...) {
-                LOG_ERROR("Exception during calibration of ADS1115 #1");
-                i--; // Retry this sample
-                delay(50);
-            }
+uint8_t getScanList(uint8_t* channels) {
+    const ScanScheduler& scheduler = scanner.getScheduler();
+    uint8_t length = scheduler.getScanLength();
+    for (uint8_t i = 0; i < length; i++) {
+        channels[i] = scheduler.getScanChannel(i);
+    }
+    return length;
+}
+
+// Zero-input offset calibration runs incrementally on the acquisition task: each chip
+// walks its gain range while the readings keep flowing into the sample ring
+void requestCalibration() {
+    calibrationRequested = true;
+}
+
+bool feedCalibration(const AdcSample& sample) {
+    if (calibrationRequested) {
+        calibrationRequested = false;
+        if (isChannelAvailable(ADC_CURRENT_CHANNEL)) {
+            shuntCalibrator.start(SHUNT_WIDEST_GAIN, SHUNT_NARROWEST_GAIN);
+        }
+        if (isChannelAvailable(ADC_VOLTAGE_CHANNEL)) {
+            ads2Calibrator.start(ADS2_WIDEST_GAIN, ADS2_NARROWEST_GAIN);
         }
-        
-        shuntOffsetFloat = static_cast<float>(sum) / samples;
-        LOG_INFO("ADS1115 #1 calibrated with offset: %f", shuntOffsetFloat);
+        calibrationProgress = 0;
+        calibrationState = CALIBRATION_RUNNING;
+        LOG_INFO("Starting background ADC calibration...");
     }
-    
-    // Only calibrate if ADS1115 #2 is available
-    if (ads2_available) {
-        int32_t sum = 0;
-        const int samples = 16;
-        
-        for (int i = 0; i < samples; i++) {
-            try {
-                // Timeout protection for I2C operations
-                int16_t reading = ads2.readADC_SingleEnded(0);
-                sum += reading;
-                delay(10);
-            } catch (...) {
-                LOG_ERROR("Exception during calibration of ADS1115 #2");
-                i--; // Retry this sample
-                delay(50);
-            }
+    if (calibrationState != CALIBRATION_RUNNING) {
+        return false;
+    }
+
+    // Only fresh conversions count towards the averages
+    if (shuntCalibrator.isRunning() && isSampleFresh(sample.shuntQuality)) {
+        shuntCalibrator.feed(sample.shuntRaw, sample.shuntGain);
+        if (shuntCalibrator.isRunning() && scanner.getChannelGain(ADC_CURRENT_CHANNEL) != shuntCalibrator.getTargetGain()) {
+            applyChannelGain(ADC_CURRENT_CHANNEL, shuntCalibrator.getTargetGain());
         }
-        
-        ads2OffsetFloat = static_cast<float>(sum) / samples;
-        LOG_INFO("ADS1115 #2 calibrated with offset: %f", ads2OffsetFloat);
-    }
-}
-
-int16_t readShuntDifferential() {
-    if (!ads1_available) {
-        // If device is marked unavailable, check if it's time to try recovery
-        unsigned long currentTime = millis();
-        if (currentTime - lastAds1RecoveryAttempt > RECOVERY_INTERVAL_MS) {
-            lastAds1RecoveryAttempt = currentTime;
-            LOG_INFO("Attempting to recover ADS1115 #1...");
-            if (ads1.begin(0x48)) {
-                ads1.setGain(GAIN_EIGHT);
-                ads1.setDataRate(RATE_ADS1115_860SPS);
-                ads1_available = true;
-                ads1ErrorCount = 0;
-                LOG_INFO("ADS1115 #1 recovered successfully");
-            }
+    }
+    if (ads2Calibrator.isRunning() && isSampleFresh(sample.ads2Quality)) {
+        ads2Calibrator.feed(sample.ads2Raw, sample.ads2Gain);
+        if (ads2Calibrator.isRunning() && scanner.getChannelGain(ADC_VOLTAGE_CHANNEL) != ads2Calibrator.getTargetGain()) {
+            applyChannelGain(ADC_VOLTAGE_CHANNEL, ads2Calibrator.getTargetGain());
         }
-        return lastGoodShuntReading;
     }
-    
-    // Try to read with error handling
-    int16_t reading = 0;
-    bool success = false;
-    
-    // Set a timeout for the I2C operation
-    Wire.setTimeOut(100);
-    
-    // Attempt to read with timeout and error handling
-    try {
-        reading = ads1.readADC_Differential_0_1();
-        success = true;
-        ads1ErrorCount = 0; // Reset error counter on success
-        lastGoodShuntReading = reading; // Update last good reading
-    } catch (...) {
-        LOG_ERROR("Exception during ADS1115 #1 read");
-        success = false;
+
+    uint8_t shuntProgress = isChannelAvailable(ADC_CURRENT_CHANNEL) ? shuntCalibrator.getProgress() : 100;
+    uint8_t ads2Progress = isChannelAvailable(ADC_VOLTAGE_CHANNEL) ? ads2Calibrator.getProgress() : 100;
+    calibrationProgress = (shuntProgress + ads2Progress) / 2;
+    if (shuntCalibrator.isRunning() || ads2Calibrator.isRunning()) {
+        return true;
     }
-    
-    if (!success) {
-        ads1ErrorCount++;
-        LOG_WARNING("ADS1115 #1 read failed, error count: %d", ads1ErrorCount);
-        
-        if (ads1ErrorCount >= MAX_ERRORS_BEFORE_RESET) {
-            LOG_ERROR("ADS1115 #1 marked unavailable after %d consecutive errors", ads1ErrorCount);
-            ads1_available = false;
+
+    // Both channels done: install the measured tables and hand the PGAs back to the rangers
+    if (shuntCalibrator.getRecord().validMask) {
+        applyCalibrationRecord(shuntCalibrator.getRecord(), SHUNT_WIDEST_GAIN, SHUNT_NARROWEST_GAIN, shuntOffsets);
+        applyChannelGain(ADC_CURRENT_CHANNEL, shuntRanger.getGain());
+    }
+    if (ads2Calibrator.getRecord().validMask) {
+        applyCalibrationRecord(ads2Calibrator.getRecord(), ADS2_WIDEST_GAIN, ADS2_NARROWEST_GAIN, ads2Offsets);
+        applyChannelGain(ADC_VOLTAGE_CHANNEL, ads2Ranger.getGain());
+    }
+    calibrationProgress = 100;
+    calibrationSavePending = true;
+    calibrationState = CALIBRATION_COMPLETE;
+    LOG_INFO("ADC calibration complete, offset at nominal gain: %f / %f",
+             q31ToCounts(shuntOffsets.getOffset(SHUNT_GAIN)), q31ToCounts(ads2Offsets.getOffset(ADS2_GAIN)));
+    return false;
+}
+
+CalibrationState getCalibrationState() {
+    return calibrationState;
+}
+
+uint8_t getCalibrationProgress() {
+    return calibrationProgress;
+}
+
+// NVS writes can stall for milliseconds, so results are persisted from a non-sampling task
+void serviceCalibration() {
+    if (!calibrationSavePending) {
+        return;
+    }
+    calibrationSavePending = false;
+    if (shuntCalibrator.getRecord().validMask) {
+        prefs.putBytes("calShunt", &shuntCalibrator.getRecord(), sizeof(CalibrationRecord));
+    }
+    if (ads2Calibrator.getRecord().validMask) {
+        prefs.putBytes("calAds2", &ads2Calibrator.getRecord(), sizeof(CalibrationRecord));
+    }
+    LOG_INFO("ADC calibration saved (version %d)", CALIBRATION_RECORD_VERSION);
+}
+
+// Restore persisted offset tables; false if an available chip has no current record
+static bool loadCalibrationRecord(const char* key, Ads1115Gain widest, Ads1115Gain narrowest, GainOffsetTable& table) {
+    CalibrationRecord record;
+    if (prefs.getBytes(key, &record, sizeof(record)) != sizeof(record)) {
+        return false;
+    }
+    return applyCalibrationRecord(record, widest, narrowest, table);
+}
+
+bool loadCalibration() {
+    bool loaded = true;
+    if (isChannelAvailable(ADC_CURRENT_CHANNEL)) {
+        loaded &= loadCalibrationRecord("calShunt", SHUNT_WIDEST_GAIN, SHUNT_NARROWEST_GAIN, shuntOffsets);
+    }
+    if (isChannelAvailable(ADC_VOLTAGE_CHANNEL)) {
+        loaded &= loadCalibrationRecord("calAds2", ADS2_WIDEST_GAIN, ADS2_NARROWEST_GAIN, ads2Offsets);
+    }
+    if (loaded) {
+        calibrationState = CALIBRATION_COMPLETE;
+        calibrationProgress = 100;
+        LOG_INFO("Loaded ADC calibration (version %d) from NVS", CALIBRATION_RECORD_VERSION);
+    }
+    return loaded;
+}
+
+// Burst capture. Every access goes through captureLock; each step is O(1), so the
+// acquisition task never waits long on a download in progress.
+bool armCapture(const CaptureConfig& config) {
+    portENTER_CRITICAL(&captureLock);
+    bool armed = burstCapture.arm(config);
+    portEXIT_CRITICAL(&captureLock);
+    if (armed) {
+        LOG_INFO("Capture armed: %u pre, %u post samples", config.preSamples, config.postSamples);
+    }
+    return armed;
+}
+
+bool rearmCapture() {
+    portENTER_CRITICAL(&captureLock);
+    CaptureConfig config = burstCapture.getConfig();
+    portEXIT_CRITICAL(&captureLock);
+    return armCapture(config);
+}
+
+void disarmCapture() {
+    portENTER_CRITICAL(&captureLock);
+    burstCapture.disarm();
+    portEXIT_CRITICAL(&captureLock);
+}
+
+void triggerCapture() {
+    portENTER_CRITICAL(&captureLock);
+    burstCapture.trigger(CAPTURE_TRIGGER_MANUAL);
+    portEXIT_CRITICAL(&captureLock);
+}
+
+void feedCapture(const AdcSample& sample) {
+    uint8_t relayMask = 0;
+    for (int i = 0; i < 4; i++) {
+        relayMask |= relayStates[i] ? (1 << i) : 0;
+    }
+    portENTER_CRITICAL(&captureLock);
+    if (relayMask != lastRelayMask && burstCapture.getConfig().relayEnabled) {
+        burstCapture.trigger(CAPTURE_TRIGGER_RELAY);
+    }
+    burstCapture.add(sample);
+    portEXIT_CRITICAL(&captureLock);
+    lastRelayMask = relayMask;
+}
+
+CaptureState getCaptureState() {
+    portENTER_CRITICAL(&captureLock);
+    CaptureState state = burstCapture.getState();
+    portEXIT_CRITICAL(&captureLock);
+    return state;
+}
+
+bool readCaptureRecord(uint16_t index, CaptureRecord& out) {
+    portENTER_CRITICAL(&captureLock);
+    bool ok = burstCapture.read(index, out);
+    portEXIT_CRITICAL(&captureLock);
+    return ok;
+}
+
+String formatCaptureStatus() {
+    static const char* stateNames[] = {"idle", "armed", "triggered", "complete"};
+    static const char* sourceNames[] = {"none", "threshold", "relay", "manual"};
+    portENTER_CRITICAL(&captureLock);
+    CaptureState state = burstCapture.getState();
+    CaptureConfig config = burstCapture.getConfig();
+    CaptureTriggerSource source = burstCapture.getTriggerSource();
+    uint16_t length = burstCapture.getLength();
+    uint16_t preLength = burstCapture.getPreTriggerLength();
+    portEXIT_CRITICAL(&captureLock);
+
+    String json = "{\"state\":\"" + String(stateNames[state]) + "\"";
+    json += ",\"pre\":" + String(config.preSamples);
+    json += ",\"post\":" + String(config.postSamples);
+    json += ",\"threshold\":" + String(config.thresholdEnabled ? "true" : "false");
+    json += ",\"relay\":" + String(config.relayEnabled ? "true" : "false");
+    json += ",\"trigger\":\"" + String(sourceNames[source]) + "\"";
+    json += ",\"length\":" + String(length);
+    json += ",\"trigger_index\":" + String(preLength);
+    json += "}";
+    return json;
+}
+
+uint16_t formatCaptureChunk(uint16_t start, size_t maxLength, String& out) {
+    out = "";
+    uint16_t count = 0;
+    CaptureRecord record;
+    while (readCaptureRecord(start + count, record)) {
+        String entry = String(record.offsetUs) + "," + String(q31ToUnits(record.shunt, SHUNT_MICROAMPS_FULL_SCALE)) +
+                       "," + String(q31ToUnits(record.ads2, ADS2_MICROVOLTS_FULL_SCALE)) + "," +
+                       String(packSampleQuality(record.shuntQuality, record.ads2Quality), HEX);
+        if (out.length() + entry.length() + (count ? 1 : 0) > maxLength) {
+            break;
         }
-        
-        return lastGoodShuntReading;
+        if (count) out += ";";
+        out += entry;
+        count++;
     }
-    
-    return reading;
-}
-
-int16_t readADS2Channel0() {
-    if (!ads2_available) {
-        // If device is marked unavailable, check if it's time to try recovery
-        unsigned long currentTime = millis();
-        if (currentTime - lastAds2RecoveryAttempt > RECOVERY_INTERVAL_MS) {
-            lastAds2RecoveryAttempt = currentTime;
-            LOG_INFO("Attempting to recover ADS1115 #2...");
-            if (ads2.begin(0x49)) {
-                ads2.setGain(GAIN_ONE);
-                ads2.setDataRate(RATE_ADS1115_860SPS);
-                ads2_available = true;
-                ads2ErrorCount = 0;
-                LOG_INFO("ADS1115 #2 recovered successfully");
-            }
+    return count;
+}
+
+// Pipelined single-shot read of the next scan slot; the current channel paces the stream
+bool readScanSlot(int64_t timestampUs) {
+    lockBus();
+    bool paced = scanner.readSlot(timestampUs, ADC_CURRENT_CHANNEL);
+    unlockBus();
+    return paced;
+}
+
+void setAcquisitionTask(TaskHandle_t task) {
+    acquisitionTask = task;
+}
+
+void requestAcquisitionMode(AcquisitionMode mode) {
+    pendingAcquisitionMode = mode;
+    acquisitionModeChangePending = true;
+}
+
+AcquisitionMode getAcquisitionMode() {
+    return currentAcquisitionMode;
+}
+
+// Device whose conversions pace the sample stream in continuous mode: the current
+// channel's, or the voltage channel's while that one is down
+static uint8_t pacingDevice() {
+    uint8_t device = ADC_CHANNEL_TABLE[ADC_CURRENT_CHANNEL].device;
+    if (!scanner.isDeviceAvailable(device) && isChannelAvailable(ADC_VOLTAGE_CHANNEL)) {
+        device = ADC_CHANNEL_TABLE[ADC_VOLTAGE_CHANNEL].device;
+    }
+    return device;
+}
+
+uint32_t getInputSamplePeriodUs() {
+    if (currentAcquisitionMode == ACQ_MODE_CONTINUOUS) {
+        return scanner.getDevice(pacingDevice()).conversionTimeUs();
+    }
+    // A current channel sharing its device with others is converted every few slots
+    uint8_t slots = scanner.getScheduler().getRotationLengthOf(ADC_CURRENT_CHANNEL);
+    return (uint32_t)getEffectiveSamplingInterval() * 1000 * (slots ? slots : 1);
+}
+
+// Continuous mode converts one channel per device, so it needs a single-channel rotation
+// and a wired ALERT/RDY pin on every device in the scan list
+static bool continuousModeSupported() {
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        uint8_t length = scanner.getScheduler().getRotationLength(device);
+        if (length > 1 || (length == 1 && ADC_ALERT_PINS[device] < 0)) {
+            return false;
         }
-        return lastGoodAds2Reading;
     }
-    
-    // Try to read with error handling
-    int16_t reading = 0;
-    bool success = false;
-    
-    // Set a timeout for the I2C operation
-    Wire.setTimeOut(100);
-    
-    // Attempt to read with timeout and error handling
-    try {
-        reading = ads2.readADC_SingleEnded(0);
-        success = true;
-        ads2ErrorCount = 0; // Reset error counter on success
-        lastGoodAds2Reading = reading; // Update last good reading
-    } catch (...) {
-        LOG_ERROR("Exception during ADS1115 #2 read");
-        success = false;
+    return true;
+}
+
+static void enterContinuousMode() {
+    currentAcquisitionMode = ACQ_MODE_CONTINUOUS;
+    lockBus();
+    scanner.setContinuous(true);
+    unlockBus();
+    uint8_t deviceMask = scanner.getScheduler().getDeviceMask();
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (!(deviceMask & (1 << device))) {
+            continue;
+        }
+        pinMode(ADC_ALERT_PINS[device], INPUT_PULLUP);
+        attachInterruptArg(digitalPinToInterrupt(ADC_ALERT_PINS[device]), adcReadyISR, (void*)(uintptr_t)device,
+                           FALLING);
     }
-    
-    if (!success) {
-        ads2ErrorCount++;
-        LOG_WARNING("ADS1115 #2 read failed, error count: %d", ads2ErrorCount);
-        
-        if (ads2ErrorCount >= MAX_ERRORS_BEFORE_RESET) {
-            LOG_ERROR("ADS1115 #2 marked unavailable after %d consecutive errors", ads2ErrorCount);
-            ads2_available = false;
+    LOG_INFO("Acquisition mode: continuous conversion (ALERT/RDY driven)");
+}
+
+static void leaveContinuousMode() {
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (ADC_ALERT_PINS[device] >= 0) {
+            detachInterrupt(digitalPinToInterrupt(ADC_ALERT_PINS[device]));
         }
-        
-        return lastGoodAds2Reading;
     }
-    
-    return reading;
+    currentAcquisitionMode = ACQ_MODE_SINGLE_SHOT;
+    scanner.setContinuous(false);
+    // The next single-shot read rewrites the config register and powers the chips down between conversions
+    LOG_INFO("Acquisition mode: single-shot");
+}
+
+// Called from the acquisition task, between reads
+void applyPendingScanList() {
+    // Copied out under the lock, so a request arriving meanwhile waits for the next pass
+    uint8_t list[ADC_MAX_CHANNELS];
+    portENTER_CRITICAL(&scanListLock);
+    uint8_t length = pendingScanLength;
+    for (uint8_t i = 0; i < length; i++) {
+        list[i] = pendingScanList[i];
+    }
+    pendingScanLength = 0;
+    portEXIT_CRITICAL(&scanListLock);
+    if (length == 0) {
+        return;
+    }
+    bool wasContinuous = currentAcquisitionMode == ACQ_MODE_CONTINUOUS;
+    if (wasContinuous) {
+        leaveContinuousMode();
+    }
+    lockBus();
+    scanner.configureScan(list, length);
+    unlockBus();
+    LOG_INFO("Scan list: %u channels, %u mux switches per cycle", length,
+             scanner.getScheduler().getMuxSwitchesPerCycle());
+    if (wasContinuous) {
+        if (continuousModeSupported()) {
+            enterContinuousMode();
+        } else {
+            LOG_WARNING("Scan list needs mux switching, staying in single-shot mode");
+        }
+    }
+}
+
+// Called from the acquisition task so that mode changes never race with an in-flight read
+void applyPendingAcquisitionMode() {
+    if (!acquisitionModeChangePending) {
+        return;
+    }
+    acquisitionModeChangePending = false;
+    AcquisitionMode mode = pendingAcquisitionMode;
+    if (mode == currentAcquisitionMode) {
+        return;
+    }
+
+    if (mode == ACQ_MODE_CONTINUOUS) {
+        if (!continuousModeSupported()) {
+            LOG_WARNING("Continuous mode needs one channel and an ALERT/RDY pin per device, staying in single-shot");
+            return;
+        }
+        enterContinuousMode();
+    } else {
+        leaveContinuousMode();
+    }
+}
+
+uint32_t waitForConversionReady(TickType_t timeout) {
+    uint32_t readyBits = 0;
+    xTaskNotifyWait(0, ADC_READY_BITS, &readyBits, timeout);
+    readyBits &= ADC_READY_BITS;
+
+    // A device that is available but stayed silent for the whole timeout is treated as a failed read
+    if (readyBits == 0) {
+        scanner.recordSilence();
+    }
+    return readyBits;
+}
+
+bool readReadyConversions(uint32_t readyBits, int64_t& timestampUs) {
+    // Snapshot the edge times so a sample and its timestamp come from the same edge
+    int64_t readyUs[ADC_MAX_DEVICES];
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        readyUs[device] = deviceReadyUs[device];
+    }
+    uint8_t pacing = pacingDevice();
+    lockBus();
+    uint8_t serviced = scanner.readReady(readyBits, readyUs);
+    unlockBus();
+    if (!(serviced & (1 << pacing))) {
+        return false;
+    }
+    timestampUs = readyUs[pacing];
+    return true;
+}
+
+// Feed the rangers with the conversions just stored; a held reading was already counted
+void updateAutoRange(const AdcSample& sample) {
+    if (isSampleFresh(sample.shuntQuality) && shuntRanger.update(sample.shuntRaw)) {
+        applyChannelGain(ADC_CURRENT_CHANNEL, shuntRanger.getGain());
+    }
+    if (isSampleFresh(sample.ads2Quality) && ads2Ranger.update(sample.ads2Raw)) {
+        applyChannelGain(ADC_VOLTAGE_CHANNEL, ads2Ranger.getGain());
+    }
+}
+
+void setRecoveryTask(TaskHandle_t task) {
+    recoveryTask = task;
+}
+
+// One pass of the recovery task: attempt every lost device that is due, clearing the bus
+// first in case a device is holding SDA. The acquisition task waits for the bus lock
+// meanwhile (one bus clear and probe, a few I2C timeouts at most) and keeps sampling the
+// healthy devices between passes.
+TickType_t serviceAdcRecovery() {
+    uint8_t scanned = scanner.getScheduler().getDeviceMask();
+    int64_t nowUs = esp_timer_get_time();
+    portENTER_CRITICAL(&recoveryLock);
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        // Devices missing at boot are not reported lost by the scanner
+        if ((scanned & (1 << device)) && !scanner.isDeviceAvailable(device)) {
+            recovery.markLost(device, nowUs);
+        }
+    }
+    uint8_t due = recovery.getDueMask(nowUs);
+    portEXIT_CRITICAL(&recoveryLock);
+
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (!(due & (1 << device))) {
+            continue;
+        }
+        lockBus();
+        bool released = adcBus.clearBus();
+        bool attached = scanner.reattach(device);
+        unlockBus();
+        if (!released) {
+            LOG_WARNING("I2C bus clear failed, SDA still held low");
+        }
+
+        nowUs = esp_timer_get_time();
+        portENTER_CRITICAL(&recoveryLock);
+        if (attached) {
+            recovery.markRecovered(device, nowUs);
+        } else {
+            recovery.attemptFailed(device, nowUs);
+        }
+        DeviceRecoveryStatus status = recovery.getStatus(device);
+        portEXIT_CRITICAL(&recoveryLock);
+        if (attached) {
+            LOG_INFO("ADS1115 at 0x%02X back after %lu ms degraded", adcDeviceAddress(device),
+                     (unsigned long)(status.lastOutageUs / 1000));
+        } else {
+            LOG_WARNING("ADS1115 at 0x%02X reattach attempt %lu failed, next in %lu ms", adcDeviceAddress(device),
+                        (unsigned long)status.attempts, (unsigned long)(status.retryUs / 1000));
+        }
+    }
+
+    portENTER_CRITICAL(&recoveryLock);
+    int64_t nextUs = recovery.getNextAttemptUs();
+    portEXIT_CRITICAL(&recoveryLock);
+    if (nextUs == INT64_MAX) {
+        return portMAX_DELAY;
+    }
+    int64_t waitUs = nextUs - esp_timer_get_time();
+    return waitUs > 0 ? pdMS_TO_TICKS(waitUs / 1000) + 1 : 1;
+}
+
+String formatRecoveryStatus() {
+    int64_t nowUs = esp_timer_get_time();
+    DeviceRecoveryStatus status[ADC_MAX_DEVICES];
+    int64_t degradedUs[ADC_MAX_DEVICES];
+    portENTER_CRITICAL(&recoveryLock);
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        status[device] = recovery.getStatus(device);
+        degradedUs[device] = recovery.getDegradedUs(device, nowUs);
+    }
+    int64_t pipelineUs = recovery.getPipelineDegradedUs(nowUs);
+    portEXIT_CRITICAL(&recoveryLock);
+
+    uint8_t tableMask = adcTableDeviceMask(ADC_CHANNEL_TABLE, ADC_CHANNEL_COUNT);
+    String json = "{\"degraded_ms\":" + String((uint32_t)(pipelineUs / 1000));
+    json += ",\"devices\":[";
+    bool first = true;
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (!(tableMask & (1 << device))) {
+            continue;
+        }
+        char address[8];
+        snprintf(address, sizeof(address), "0x%02X", adcDeviceAddress(device));
+        if (!first) json += ",";
+        first = false;
+        json += "{\"address\":\"" + String(address) + "\"";
+        json += ",\"available\":" + String(scanner.isDeviceAvailable(device) ? "true" : "false");
+        json += ",\"lost\":" + String(status[device].lost ? "true" : "false");
+        json += ",\"outages\":" + String(status[device].outages);
+        json += ",\"attempts\":" + String(status[device].attempts);
+        json += ",\"retry_ms\":" + String((uint32_t)(status[device].retryUs / 1000));
+        json += ",\"last_outage_ms\":" + String((uint32_t)(status[device].lastOutageUs / 1000));
+        json += ",\"degraded_ms\":" + String((uint32_t)(degradedUs[device] / 1000));
+        json += "}";
+    }
+    json += "]}";
+    return json;
+}
+
+String formatI2CTiming(const Ads1115& ads) {
+    const Ads1115Timing& timing = ads.getTiming();
+    uint32_t averageUs = timing.transactions ? (uint32_t)(timing.totalUs / timing.transactions) : 0;
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "{\"transactions\":%lu,\"failures\":%lu,\"last_us\":%lu,\"avg_us\":%lu,\"max_us\":%lu}",
+             (unsigned long)timing.transactions, (unsigned long)timing.failures,
+             (unsigned long)timing.lastUs, (unsigned long)averageUs, (unsigned long)timing.maxUs);
+    return String(buffer);
+}
+
+// Every table row with its last reading, as input microvolts at the gain it was taken at
+String formatChannels() {
+    const ScanScheduler& scheduler = scanner.getScheduler();
+    String json = "{\"mux_switches_per_cycle\":" + String(scheduler.getMuxSwitchesPerCycle());
+    json += ",\"channels\":[";
+    for (uint8_t channel = 0; channel < ADC_CHANNEL_COUNT; channel++) {
+        const AdcChannelConfig& config = ADC_CHANNEL_TABLE[channel];
+        const ChannelReading& reading = scanner.getReading(channel);
+        char address[8];
+        snprintf(address, sizeof(address), "0x%02X", adcDeviceAddress(config.device));
+        if (channel > 0) json += ",";
+        json += "{\"index\":" + String(channel);
+        json += ",\"name\":\"" + String(config.name) + "\"";
+        json += ",\"address\":\"" + String(address) + "\"";
+        json += ",\"scanned\":" + String(scheduler.contains(channel) ? "true" : "false");
+        json += ",\"available\":" + String(isChannelAvailable(channel) ? "true" : "false");
+        json += ",\"raw\":" + String(reading.raw);
+        json += ",\"quality\":" + String(reading.quality);
+        json += ",\"input_uv\":" + String((int32_t)((int64_t)reading.raw * fullScaleMicrovolts(reading.gain) / 32768));
+        json += "}";
+    }
+    json += "]}";
+    return json;
 }
@@ -0,0 +1,292 @@
+#include "adc_scanner.h"
+
+AdcScanner::AdcScanner(const AdcChannelConfig* table, uint8_t tableSize)
+    : table(table),
+      tableSize(tableSize < ADC_MAX_CHANNELS ? tableSize : ADC_MAX_CHANNELS),
+      bus(nullptr),
+      eventHandler(nullptr),
+      convertedMask(0),
+      continuous(false) {
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        devices[device].available = false;
+        devices[device].errorCount = 0;
+    }
+    for (uint8_t channel = 0; channel < ADC_MAX_CHANNELS; channel++) {
+        Ads1115Gain gain = channel < this->tableSize ? table[channel].gain : GAIN_TWOTHIRDS;
+        channelGains[channel] = gain;
+        readings[channel].raw = 0;
+        readings[channel].gain = gain;
+        readings[channel].timestampUs = 0;
+        readings[channel].quality = SAMPLE_QUALITY_HELD;  // Nothing converted yet
+    }
+}
+
+void AdcScanner::setBus(I2CBus* i2cBus) {
+    bus = i2cBus;
+}
+
+void AdcScanner::setEventHandler(AdcDeviceEventHandler handler) {
+    eventHandler = handler;
+}
+
+bool AdcScanner::probe(uint8_t device) {
+    if (device >= ADC_MAX_DEVICES) {
+        return false;
+    }
+    Device& dev = devices[device];
+    dev.available = dev.ads.begin(bus, adcDeviceAddress(device));
+    dev.errorCount = 0;
+    if (!dev.available) {
+        markDevice(device, SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING);
+    }
+    if (dev.available && continuous && (scheduler.getDeviceMask() & (1 << device))) {
+        startContinuous(device);
+    }
+    return dev.available;
+}
+
+bool AdcScanner::configureScan(const uint8_t* scanList, uint8_t scanLength) {
+    return scheduler.configure(table, tableSize, scanList, scanLength);
+}
+
+const ScanScheduler& AdcScanner::getScheduler() const {
+    return scheduler;
+}
+
+void AdcScanner::setChannelGain(uint8_t channel, Ads1115Gain gain) {
+    if (channel >= tableSize) {
+        return;
+    }
+    channelGains[channel] = gain;
+    uint8_t device = table[channel].device;
+    if (continuous && devices[device].available) {
+        startContinuous(device);
+    }
+}
+
+Ads1115Gain AdcScanner::getChannelGain(uint8_t channel) const {
+    return channelGains[channel < tableSize ? channel : 0];
+}
+
+const ChannelReading& AdcScanner::getReading(uint8_t channel) const {
+    return readings[channel < tableSize ? channel : 0];
+}
+
+ChannelReading AdcScanner::takeReading(uint8_t channel) {
+    if (channel >= tableSize) {
+        channel = 0;
+    }
+    ChannelReading reading = readings[channel];
+    // Clipping describes the held value too; a gain change only its first use
+    readings[channel].quality = (reading.quality | SAMPLE_QUALITY_HELD) & ~SAMPLE_QUALITY_GAIN_CHANGED;
+    return reading;
+}
+
+Ads1115& AdcScanner::getDevice(uint8_t device) {
+    return devices[device < ADC_MAX_DEVICES ? device : 0].ads;
+}
+
+bool AdcScanner::isDeviceAvailable(uint8_t device) const {
+    return device < ADC_MAX_DEVICES && devices[device].available;
+}
+
+bool AdcScanner::isChannelAvailable(uint8_t channel) const {
+    return channel < tableSize && scheduler.contains(channel) && devices[table[channel].device].available;
+}
+
+// Load a channel's mux, gain and rate into its device's cached config register
+void AdcScanner::selectChannel(uint8_t channel) {
+    Ads1115& ads = devices[table[channel].device].ads;
+    ads.setMux(table[channel].mux);
+    ads.setGain(channelGains[channel]);
+    ads.setDataRate(table[channel].rate);
+}
+
+// Put a device into continuous conversion of its (only) scanned channel, with ALERT/RDY
+// pulsing after every conversion
+void AdcScanner::startContinuous(uint8_t device) {
+    const ScanSlot& slot = scheduler.next();
+    if (slot.channel[device] < 0) {
+        return;
+    }
+    selectChannel(slot.channel[device]);
+    if (!devices[device].ads.startContinuous()) {
+        notify(device, ADC_DEVICE_CONTINUOUS_FAILED);
+    }
+}
+
+// Wait for a single-shot conversion to finish and read it. The config-register status
+// poll is a bare 2-byte read because the driver keeps the pointer on the config register.
+bool AdcScanner::collectConversion(Ads1115& ads, uint32_t startedUs, int16_t& reading) {
+    uint32_t timeoutUs = ads.conversionTimeUs() + ADC_CONVERSION_MARGIN_US;
+    bool ready = false;
+    while (!ready) {
+        if (!ads.isConversionReady(ready)) {
+            return false;
+        }
+        if (!ready) {
+            if (bus->micros() - startedUs > timeoutUs) {
+                return false;
+            }
+            bus->delayMicros(ADC_READY_POLL_US);
+        }
+    }
+    return ads.readConversion(reading);
+}
+
+bool AdcScanner::reattach(uint8_t device) {
+    if (!probe(device)) {
+        return false;
+    }
+    notify(device, ADC_DEVICE_RECOVERED);
+    return true;
+}
+
+// Flag the held readings of every channel on a device
+void AdcScanner::markDevice(uint8_t device, uint8_t quality) {
+    for (uint8_t channel = 0; channel < tableSize; channel++) {
+        if (table[channel].device == device) {
+            readings[channel].quality |= quality;
+        }
+    }
+}
+
+void AdcScanner::recordError(uint8_t device) {
+    Device& dev = devices[device];
+    dev.errorCount++;
+    markDevice(device, SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE);
+    notify(device, ADC_DEVICE_READ_FAILED);
+    if (dev.errorCount >= ADC_MAX_ERRORS_BEFORE_LOST) {
+        dev.available = false;
+        markDevice(device, SAMPLE_QUALITY_RECOVERING);
+        notify(device, ADC_DEVICE_LOST);
+    }
+}
+
+void AdcScanner::recordReading(uint8_t channel, int16_t raw, int64_t timestampUs) {
+    Device& dev = devices[table[channel].device];
+    ChannelReading& reading = readings[channel];
+    Ads1115Gain gain = dev.ads.getGain();
+    reading.quality = SAMPLE_QUALITY_FRESH;
+    if (raw == INT16_MAX || raw == INT16_MIN) {
+        reading.quality |= SAMPLE_QUALITY_CLIPPED;
+    }
+    if (gain != reading.gain && (convertedMask & (1 << channel))) {
+        reading.quality |= SAMPLE_QUALITY_GAIN_CHANGED;
+    }
+    reading.raw = raw;
+    reading.gain = gain;
+    reading.timestampUs = timestampUs;
+    convertedMask |= 1 << channel;
+    dev.errorCount = 0;
+}
+
+void AdcScanner::notify(uint8_t device, AdcDeviceEvent event) {
+    if (eventHandler != nullptr) {
+        eventHandler(device, event, devices[device].errorCount);
+    }
+}
+
+// A slot costs one conversion time plus bus traffic however many devices take part
+bool AdcScanner::readSlot(int64_t timestampUs, uint8_t pacingChannel) {
+    const ScanSlot& slot = scheduler.next();
+    bool started[ADC_MAX_DEVICES] = {false};
+    uint32_t startUs[ADC_MAX_DEVICES] = {0};
+    int64_t sampledUs[ADC_MAX_DEVICES] = {0};
+    int firstDevice = -1;
+    uint32_t slotStartUs = bus->micros();
+
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (slot.channel[device] < 0 || !devices[device].available) {
+            continue;
+        }
+        selectChannel(slot.channel[device]);
+        startUs[device] = bus->micros();
+        started[device] = devices[device].ads.startSingleShot();
+        if (!started[device]) {
+            recordError(device);
+            continue;
+        }
+        // The conversion starts as the config write ends; devices started later in the
+        // slot sample later by the bus time spent on the ones before them
+        uint32_t convertingUs = bus->micros() - slotStartUs;
+        sampledUs[device] = timestampUs + convertingUs + devices[device].ads.conversionTimeUs() / 2;
+        if (firstDevice < 0) {
+            firstDevice = device;
+        }
+    }
+
+    // Skip the status polls while the first conversion cannot possibly be done
+    if (firstDevice >= 0) {
+        uint32_t conversionUs = devices[firstDevice].ads.conversionTimeUs();
+        uint32_t elapsedUs = bus->micros() - startUs[firstDevice];
+        if (elapsedUs < conversionUs) {
+            bus->delayMicros(conversionUs - elapsedUs);
+        }
+    }
+
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (!started[device]) {
+            continue;
+        }
+        int16_t reading = 0;
+        if (collectConversion(devices[device].ads, startUs[device], reading)) {
+            recordReading(slot.channel[device], reading, sampledUs[device]);
+        } else {
+            recordError(device);
+        }
+    }
+
+    // The pacing channel holds its last good reading on errors
+    return pacingChannel < tableSize && slot.channel[table[pacingChannel].device] == pacingChannel;
+}
+
+void AdcScanner::setContinuous(bool enabled) {
+    continuous = enabled;
+    if (!enabled) {
+        // The next single-shot start rewrites the config register
+        return;
+    }
+    uint8_t deviceMask = scheduler.getDeviceMask();
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if ((deviceMask & (1 << device)) && devices[device].available) {
+            startContinuous(device);
+        }
+    }
+}
+
+bool AdcScanner::isContinuous() const {
+    return continuous;
+}
+
+// Each ready device costs only a 2-byte conversion register read
+uint8_t AdcScanner::readReady(uint32_t readyBits, const int64_t* readyTimesUs) {
+    const ScanSlot& slot = scheduler.next();  // Single-channel rotations: always the same slot
+    uint8_t serviced = 0;
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (slot.channel[device] < 0 || !devices[device].available) {
+            continue;
+        }
+        if (!(readyBits & (1UL << device))) {
+            continue;
+        }
+        int16_t reading = 0;
+        if (devices[device].ads.readConversion(reading)) {
+            int64_t sampledUs = readyTimesUs[device] - devices[device].ads.conversionTimeUs() / 2;
+            recordReading(slot.channel[device], reading, sampledUs);
+        } else {
+            recordError(device);
+        }
+        serviced |= 1 << device;
+    }
+    return serviced;
+}
+
+void AdcScanner::recordSilence() {
+    uint8_t deviceMask = scheduler.getDeviceMask();
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if ((deviceMask & (1 << device)) && devices[device].available) {
+            recordError(device);
+        }
+    }
+}
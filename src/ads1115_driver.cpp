@@ -0,0 +1,221 @@
+#include "ads1115_driver.h"
+
+// Extra time allowed on top of the nominal conversion time (internal oscillator is +/-10%)
+static const uint32_t CONVERSION_MARGIN_US = 1000;
+
+Ads1115::Ads1115()
+    : bus(nullptr),
+      address(0),
+      config(ADS1115_CONFIG_DEFAULT & ~ADS1115_CONFIG_OS_SINGLE),
+      pointer(ADS1115_REG_CONVERSION),
+      pointerKnown(false),
+      thresholdsArmed(false),
+      continuous(false) {
+    resetTiming();
+}
+
+bool Ads1115::begin(I2CBus* i2cBus, uint8_t i2cAddress) {
+    bus = i2cBus;
+    address = i2cAddress;
+    pointerKnown = false;
+    thresholdsArmed = false;
+    continuous = false;
+
+    // A readable config register proves the device is present and responding
+    uint16_t value = 0;
+    return readRegister(ADS1115_REG_CONFIG, value);
+}
+
+void Ads1115::setGain(Ads1115Gain gain) {
+    config = (config & ~ADS1115_CONFIG_PGA_MASK) | gain;
+}
+
+Ads1115Gain Ads1115::getGain() const {
+    return static_cast<Ads1115Gain>(config & ADS1115_CONFIG_PGA_MASK);
+}
+
+void Ads1115::setDataRate(Ads1115DataRate rate) {
+    config = (config & ~ADS1115_CONFIG_DR_MASK) | rate;
+}
+
+Ads1115DataRate Ads1115::getDataRate() const {
+    return static_cast<Ads1115DataRate>(config & ADS1115_CONFIG_DR_MASK);
+}
+
+void Ads1115::setMux(Ads1115Mux mux) {
+    config = (config & ~ADS1115_CONFIG_MUX_MASK) | mux;
+}
+
+Ads1115Mux Ads1115::getMux() const {
+    return static_cast<Ads1115Mux>(config & ADS1115_CONFIG_MUX_MASK);
+}
+
+bool Ads1115::startSingleShot() {
+    continuous = false;
+    uint16_t value = (config & ~0x0003) | ADS1115_CONFIG_OS_SINGLE | ADS1115_CONFIG_MODE_SINGLE | ADS1115_CONFIG_COMP_QUE_NONE;
+    return writeRegister(ADS1115_REG_CONFIG, value);
+}
+
+bool Ads1115::isConversionReady(bool& ready) {
+    uint16_t value = 0;
+    if (!readRegister(ADS1115_REG_CONFIG, value)) {
+        return false;
+    }
+    ready = (value & ADS1115_CONFIG_OS_SINGLE) != 0;
+    return true;
+}
+
+bool Ads1115::readSingleShot(int16_t& value) {
+    if (!startSingleShot()) {
+        return false;
+    }
+    uint32_t startUs = bus->micros();
+    uint32_t timeoutUs = conversionTimeUs() + CONVERSION_MARGIN_US;
+    bus->delayMicros(conversionTimeUs());
+
+    bool ready = false;
+    while (!ready) {
+        if (!isConversionReady(ready)) {
+            return false;
+        }
+        if (!ready) {
+            if (bus->micros() - startUs > timeoutUs) {
+                return false;
+            }
+            bus->delayMicros(50);
+        }
+    }
+    return readConversion(value);
+}
+
+bool Ads1115::startContinuous() {
+    // Hi_thresh MSB = 1 and Lo_thresh MSB = 0 turn ALERT/RDY into a conversion-ready pulse.
+    // The thresholds survive mode changes, so they are only written once per begin().
+    if (!thresholdsArmed) {
+        if (!writeRegister(ADS1115_REG_HI_THRESH, 0x8000) ||
+            !writeRegister(ADS1115_REG_LO_THRESH, 0x0000)) {
+            return false;
+        }
+        thresholdsArmed = true;
+    }
+
+    uint16_t value = (config & ~(ADS1115_CONFIG_MODE_SINGLE | 0x0003)) | ADS1115_CONFIG_COMP_QUE_1CONV;
+    if (!writeRegister(ADS1115_REG_CONFIG, value)) {
+        return false;
+    }
+    continuous = true;
+
+    // Park the pointer on the conversion register so every sample is a bare 2-byte read
+    return setPointer(ADS1115_REG_CONVERSION);
+}
+
+bool Ads1115::isContinuous() const {
+    return continuous;
+}
+
+bool Ads1115::readConversion(int16_t& value) {
+    uint16_t raw = 0;
+    if (!readRegister(ADS1115_REG_CONVERSION, raw)) {
+        return false;
+    }
+    value = static_cast<int16_t>(raw);
+    return true;
+}
+
+uint32_t Ads1115::conversionTimeUs() const {
+    switch (getDataRate()) {
+        case ADS1115_RATE_8SPS:   return 125000;
+        case ADS1115_RATE_16SPS:  return 62500;
+        case ADS1115_RATE_32SPS:  return 31250;
+        case ADS1115_RATE_64SPS:  return 15625;
+        case ADS1115_RATE_128SPS: return 7813;
+        case ADS1115_RATE_250SPS: return 4000;
+        case ADS1115_RATE_475SPS: return 2106;
+        case ADS1115_RATE_860SPS: return 1163;
+    }
+    return 7813;
+}
+
+uint8_t Ads1115::getAddress() const {
+    return address;
+}
+
+const Ads1115Timing& Ads1115::getTiming() const {
+    return timing;
+}
+
+void Ads1115::resetTiming() {
+    timing.transactions = 0;
+    timing.failures = 0;
+    timing.lastUs = 0;
+    timing.maxUs = 0;
+    timing.totalUs = 0;
+}
+
+bool Ads1115::writeRegister(uint8_t reg, uint16_t value) {
+    uint8_t data[3] = {reg, static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value & 0xFF)};
+    if (!timedWrite(data, sizeof(data))) {
+        pointerKnown = false;
+        return false;
+    }
+    pointer = reg;
+    pointerKnown = true;
+    return true;
+}
+
+bool Ads1115::readRegister(uint8_t reg, uint16_t& value) {
+    if (!pointerKnown || pointer != reg) {
+        if (!setPointer(reg)) {
+            return false;
+        }
+    }
+    uint8_t data[2] = {0, 0};
+    if (!timedRead(data, sizeof(data))) {
+        return false;
+    }
+    value = (static_cast<uint16_t>(data[0]) << 8) | data[1];
+    return true;
+}
+
+bool Ads1115::setPointer(uint8_t reg) {
+    if (!timedWrite(&reg, 1)) {
+        pointerKnown = false;
+        return false;
+    }
+    pointer = reg;
+    pointerKnown = true;
+    return true;
+}
+
+bool Ads1115::timedWrite(const uint8_t* data, size_t length) {
+    if (bus == nullptr) {
+        return false;
+    }
+    uint32_t startUs = bus->micros();
+    bool success = bus->write(address, data, length);
+    recordTransaction(startUs, success);
+    return success;
+}
+
+bool Ads1115::timedRead(uint8_t* data, size_t length) {
+    if (bus == nullptr) {
+        return false;
+    }
+    uint32_t startUs = bus->micros();
+    bool success = bus->read(address, data, length);
+    recordTransaction(startUs, success);
+    return success;
+}
+
+void Ads1115::recordTransaction(uint32_t startUs, bool success) {
+    uint32_t elapsedUs = bus->micros() - startUs;
+    timing.transactions++;
+    timing.lastUs = elapsedUs;
+    timing.totalUs += elapsedUs;
+    if (elapsedUs > timing.maxUs) {
+        timing.maxUs = elapsedUs;
+    }
+    if (!success) {
+        timing.failures++;
+    }
+}
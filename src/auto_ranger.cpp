@@ -0,0 +1,87 @@
+#include "auto_ranger.h"
+
+AutoRanger::AutoRanger(Ads1115Gain widest, Ads1115Gain narrowest, Ads1115Gain initial)
+    : widestIndex(ads1115GainIndex(widest)),
+      narrowestIndex(ads1115GainIndex(narrowest)),
+      gainIndex(0),
+      quietSamples(0),
+      switchCount(0) {
+    setGain(initial);
+}
+
+bool AutoRanger::update(int16_t raw) {
+    int32_t magnitude = raw < 0 ? -static_cast<int32_t>(raw) : raw;
+
+    // Near clipping: widen immediately, the reading is already suspect
+    if (magnitude >= AUTO_RANGE_CLIP_COUNTS) {
+        quietSamples = 0;
+        if (gainIndex > widestIndex) {
+            gainIndex--;
+            switchCount++;
+            return true;
+        }
+        return false;
+    }
+
+    // Small signal: narrow only after it has stayed small for a while
+    if (magnitude < AUTO_RANGE_LOW_COUNTS && gainIndex < narrowestIndex) {
+        if (++quietSamples >= AUTO_RANGE_SETTLE_SAMPLES) {
+            quietSamples = 0;
+            gainIndex++;
+            switchCount++;
+            return true;
+        }
+        return false;
+    }
+
+    quietSamples = 0;
+    return false;
+}
+
+Ads1115Gain AutoRanger::getGain() const {
+    return ads1115GainFromIndex(gainIndex);
+}
+
+void AutoRanger::setGain(Ads1115Gain gain) {
+    int index = ads1115GainIndex(gain);
+    if (index < widestIndex) {
+        index = widestIndex;
+    }
+    if (index > narrowestIndex) {
+        index = narrowestIndex;
+    }
+    gainIndex = index;
+    quietSamples = 0;
+}
+
+uint32_t AutoRanger::getSwitchCount() const {
+    return switchCount;
+}
+
+GainOffsetTable::GainOffsetTable(Ads1115Gain referenceGain) : referenceGain(referenceGain) {
+    for (int i = 0; i < ADS1115_GAIN_COUNT; i++) {
+        offsets[i] = 0;
+    }
+}
+
+void GainOffsetTable::setCalibratedOffset(Ads1115Gain gain, q31_t offset) {
+    for (int i = 0; i < ADS1115_GAIN_COUNT; i++) {
+        offsets[i] = rescaleQ31(offset, gain, ads1115GainFromIndex(i));
+    }
+}
+
+void GainOffsetTable::setOffset(Ads1115Gain gain, q31_t offset) {
+    offsets[ads1115GainIndex(gain)] = offset;
+}
+
+q31_t GainOffsetTable::getOffset(Ads1115Gain gain) const {
+    return offsets[ads1115GainIndex(gain)];
+}
+
+q31_t GainOffsetTable::correct(int16_t raw, Ads1115Gain gain) const {
+    return rescaleQ31(subQ31(countsToQ31(raw), offsets[ads1115GainIndex(gain)]), gain, referenceGain);
+}
+
+Ads1115Gain GainOffsetTable::getReferenceGain() const {
+    return referenceGain;
+}
@@ -12,6 +12,8 @@
 BLECharacteristic* pDataCharacteristic = nullptr;
 BLECharacteristic* pRelayCharacteristic = nullptr;
 BLECharacteristic* pWifiCharacteristic = nullptr;
+BLECharacteristic* pSpectrumCharacteristic = nullptr;
+BLECharacteristic* pFlowControlCharacteristic = nullptr;
 BLEServer* pServer = nullptr;
 bool deviceConnected = false;
 bool oldDeviceConnected = false;
@@ -26,9 +28,20 @@ static const char* TAG = "ESP32_ADS1115";
 #define RELAY_CONTROL_UUID  "a1b2c3d4-e5f6-7890-abcd-ef1234567890"
 #define WIFI_CONTROL_UUID   "c1d2e3f4-a5b6-7890-abcd-ef1234567890"
 
-// Notification rate limiting
-#define MIN_NOTIFICATION_INTERVAL_MS 100
-unsigned long lastNotificationTime = 0;
+// Notifications handed to the stack per serviceNotifyQueue() call
+#define BLE_NOTIFY_BURST 4
+
+// Outbound data characteristic notifications, filled and drained by bleTask
+static NotifyQueue notifyQueue;
+
+// Woken by signalBleTask()
+static TaskHandle_t bleTaskHandle = NULL;
+
+// Written by the BLE stack's callbacks, read by bleTask
+static volatile TelemetryFormat telemetryFormat = TELEMETRY_FORMAT_JSON;
+
+// Status of the last data notification, set by DataStatusCallback inside notify()
+static volatile bool lastNotifyDelivered = false;
 
 void setupBLE() {
     BLEDevice::init("ESP32_ADS1115");
@@ -39,6 +52,12 @@ void setupBLE() {
         DATA_CHARACTERISTIC_UUID,
         BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY
     );
+    pDataCharacteristic->setCallbacks(new DataStatusCallback());
+    pFlowControlCharacteristic = pService->createCharacteristic(
+        FLOW_CONTROL_UUID,
+        BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_WRITE_NR
+    );
+    pFlowControlCharacteristic->setCallbacks(new FlowControlCallback());
     pRelayCharacteristic = pService->createCharacteristic(
         RELAY_CONTROL_UUID,
         BLECharacteristic::PROPERTY_WRITE
@@ -49,6 +68,12 @@ void setupBLE() {
         BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY
     );
     pWifiCharacteristic->setCallbacks(new WifiControlCallback());
+#if BLE_SPECTRUM_CHARACTERISTIC
+    pSpectrumCharacteristic = pService->createCharacteristic(
+        SPECTRUM_CHARACTERISTIC_UUID,
+        BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY
+    );
+#endif
     pService->start();
     BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
     pAdvertising->addServiceUUID(SERVICE_UUID);
@@ -64,14 +89,94 @@ void setupBLE() {
     BLEDevice::startAdvertising();
 }
 
+// Queued for bleTask; nothing is sent from the producer's context
 void notifyData(const char* data) {
+    notifyData(reinterpret_cast<const uint8_t*>(data), strlen(data));
+}
+
+void notifyData(const uint8_t* data, size_t length) {
     if (pDataCharacteristic && deviceConnected) {
-        // Apply rate limiting for notifications
-        unsigned long currentTime = millis();
-        if (currentTime - lastNotificationTime >= MIN_NOTIFICATION_INTERVAL_MS) {
-            pDataCharacteristic->setValue(data);
-            pDataCharacteristic->notify();
-            lastNotificationTime = currentTime;
+        notifyQueue.push(data, length);
+    }
+}
+
+// Hands the queue to the stack, a few notifications per pass so a backlog does not
+// congest it, as far as the client's credits allow. The stack reports a notification's
+// status from within notify(); a refused one ends the burst without spending a credit.
+bool serviceNotifyQueue() {
+    const uint8_t* data;
+    size_t length;
+    for (int i = 0; i < BLE_NOTIFY_BURST && pDataCharacteristic && notifyQueue.front(data, length); i++) {
+        pDataCharacteristic->setValue(const_cast<uint8_t*>(data), length);
+        lastNotifyDelivered = false;
+        pDataCharacteristic->notify();
+        if (!lastNotifyDelivered) {
+            notifyQueue.fail();
+            break;
+        }
+        notifyQueue.pop();
+    }
+    return pDataCharacteristic && notifyQueue.front(data, length);
+}
+
+void setBleTask(TaskHandle_t task) {
+    bleTaskHandle = task;
+}
+
+void signalBleTask() {
+    if (bleTaskHandle != NULL) {
+        xTaskNotifyGive(bleTaskHandle);
+    }
+}
+
+void grantNotifyCredits(uint32_t credits) {
+    notifyQueue.grant(credits);
+    signalBleTask(); // Whatever waited for these can go out now
+}
+
+void resetNotifyCredits() {
+    notifyQueue.resetCredits();
+}
+
+void recordNotifyStatus(bool delivered) {
+    lastNotifyDelivered = delivered;
+}
+
+String formatNotifyStatus() {
+    String json = "{\"flow_control\":" + String(notifyQueue.isFlowControlled() ? "true" : "false");
+    json += ",\"credits\":" + String(notifyQueue.getCredits());
+    json += ",\"depth\":" + String(notifyQueue.getDepth());
+    json += ",\"max_depth\":" + String(notifyQueue.getMaxDepth());
+    json += ",\"capacity\":" + String(NOTIFY_QUEUE_DEPTH);
+    json += ",\"sent\":" + String(notifyQueue.getSent());
+    json += ",\"dropped\":" + String(notifyQueue.getDropped());
+    json += ",\"failed\":" + String(notifyQueue.getFailed()) + "}";
+    return json;
+}
+
+size_t getNotifyPayloadLimit() {
+    if (!pServer || !deviceConnected) {
+        return 0;
+    }
+    uint16_t mtu = pServer->getPeerMTU(pServer->getConnId());
+    return mtu > 3 ? mtu - 3 : 0;
+}
+
+void setTelemetryFormat(TelemetryFormat format) {
+    telemetryFormat = format;
+}
+
+TelemetryFormat getTelemetryFormat() {
+    return telemetryFormat;
+}
+
+// A frame completes at most about once a second, so no rate limiting; the value stays
+// readable between notifications
+void notifySpectrum(const char* data) {
+    if (pSpectrumCharacteristic) {
+        pSpectrumCharacteristic->setValue(data);
+        if (deviceConnected) {
+            pSpectrumCharacteristic->notify();
         }
     }
 }
@@ -84,6 +189,7 @@ void handleBLEConnections() {
         delay(500); // Give the Bluetooth stack time to get ready
         BLEDevice::startAdvertising(); // Restart advertising
         oldDeviceConnected = deviceConnected;
+        notifyQueue.clear();
         ESP_LOGI(TAG, "Device disconnected, restarting advertising");
     }
     
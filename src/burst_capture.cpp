@@ -0,0 +1,144 @@
+#include "burst_capture.h"
+
+BurstCapture::BurstCapture()
+    : state(CAPTURE_IDLE),
+      pendingTrigger(CAPTURE_TRIGGER_NONE),
+      triggerSource(CAPTURE_TRIGGER_NONE),
+      writeIndex(0),
+      filled(0),
+      triggerIndex(0),
+      preAvailable(0),
+      postRemaining(0),
+      triggerTimestampUs(0),
+      hasPrevious(false),
+      previousLevel(0) {
+    config.preSamples = BURST_CAPTURE_DEFAULT_PRE;
+    config.postSamples = BURST_CAPTURE_DEFAULT_POST;
+    config.thresholdEnabled = false;
+    config.channel = CAPTURE_CHANNEL_SHUNT;
+    config.edge = CAPTURE_EDGE_RISING;
+    config.level = 0;
+    config.relayEnabled = true;
+}
+
+bool BurstCapture::arm(const CaptureConfig& newConfig) {
+    if (newConfig.postSamples == 0 ||
+        static_cast<uint32_t>(newConfig.preSamples) + newConfig.postSamples > BURST_CAPTURE_CAPACITY) {
+        return false;
+    }
+    config = newConfig;
+    writeIndex = 0;
+    filled = 0;
+    preAvailable = 0;
+    postRemaining = 0;
+    pendingTrigger = CAPTURE_TRIGGER_NONE;
+    triggerSource = CAPTURE_TRIGGER_NONE;
+    hasPrevious = false;
+    state = CAPTURE_ARMED;
+    return true;
+}
+
+void BurstCapture::disarm() {
+    pendingTrigger = CAPTURE_TRIGGER_NONE;
+    state = CAPTURE_IDLE;
+}
+
+void BurstCapture::trigger(CaptureTriggerSource source) {
+    if (state == CAPTURE_ARMED && pendingTrigger == CAPTURE_TRIGGER_NONE) {
+        pendingTrigger = source;
+    }
+}
+
+bool BurstCapture::crossed(q31_t value) const {
+    if (!config.thresholdEnabled || !hasPrevious) {
+        return false;
+    }
+    bool rising = previousLevel < config.level && value >= config.level;
+    bool falling = previousLevel > config.level && value <= config.level;
+    switch (config.edge) {
+        case CAPTURE_EDGE_RISING: return rising;
+        case CAPTURE_EDGE_FALLING: return falling;
+        default: return rising || falling;
+    }
+}
+
+void BurstCapture::add(const AdcSample& sample) {
+    if (state != CAPTURE_ARMED && state != CAPTURE_TRIGGERED) {
+        return;
+    }
+
+    StoredSample& slot = buffer[writeIndex];
+    slot.timeUs = static_cast<uint32_t>(sample.timestampUs);
+    slot.shunt = sample.shunt;
+    slot.ads2 = sample.ads2;
+    qualities[writeIndex] = packSampleQuality(sample.shuntQuality, sample.ads2Quality);
+
+    if (state == CAPTURE_ARMED) {
+        bool shuntChannel = config.channel == CAPTURE_CHANNEL_SHUNT;
+        q31_t value = shuntChannel ? sample.shunt : sample.ads2;
+        bool fresh = isSampleFresh(shuntChannel ? sample.shuntQuality : sample.ads2Quality);
+        CaptureTriggerSource source = pendingTrigger;
+        if (source == CAPTURE_TRIGGER_NONE && fresh && crossed(value)) {
+            source = CAPTURE_TRIGGER_THRESHOLD;
+        }
+        if (fresh) {
+            hasPrevious = true;
+            previousLevel = value;
+        }
+
+        if (source != CAPTURE_TRIGGER_NONE) {
+            pendingTrigger = CAPTURE_TRIGGER_NONE;
+            triggerSource = source;
+            triggerIndex = writeIndex;
+            triggerTimestampUs = sample.timestampUs;
+            preAvailable = filled < config.preSamples ? filled : config.preSamples;
+            postRemaining = config.postSamples - 1;  // The trigger sample is the first
+            state = postRemaining ? CAPTURE_TRIGGERED : CAPTURE_COMPLETE;
+        }
+        if (filled < BURST_CAPTURE_CAPACITY) {
+            filled++;
+        }
+    } else if (--postRemaining == 0) {
+        state = CAPTURE_COMPLETE;
+    }
+
+    writeIndex = (writeIndex + 1) % BURST_CAPTURE_CAPACITY;
+}
+
+CaptureState BurstCapture::getState() const {
+    return state;
+}
+
+const CaptureConfig& BurstCapture::getConfig() const {
+    return config;
+}
+
+CaptureTriggerSource BurstCapture::getTriggerSource() const {
+    return triggerSource;
+}
+
+int64_t BurstCapture::getTriggerTimestampUs() const {
+    return triggerTimestampUs;
+}
+
+uint16_t BurstCapture::getLength() const {
+    return state == CAPTURE_COMPLETE ? preAvailable + config.postSamples : 0;
+}
+
+uint16_t BurstCapture::getPreTriggerLength() const {
+    return state == CAPTURE_COMPLETE ? preAvailable : 0;
+}
+
+bool BurstCapture::read(uint16_t index, CaptureRecord& out) const {
+    if (index >= getLength()) {
+        return false;
+    }
+    uint16_t position = (triggerIndex + BURST_CAPTURE_CAPACITY - preAvailable + index) % BURST_CAPTURE_CAPACITY;
+    const StoredSample& slot = buffer[position];
+    out.offsetUs = static_cast<int32_t>(slot.timeUs - static_cast<uint32_t>(triggerTimestampUs));
+    out.shunt = slot.shunt;
+    out.ads2 = slot.ads2;
+    out.shuntQuality = static_cast<uint8_t>(qualities[position]);
+    out.ads2Quality = static_cast<uint8_t>(qualities[position] >> 8);
+    return true;
+}
@@ -0,0 +1,277 @@
+#include "command_parser.h"
+#include <stdio.h>
+#include <string.h>
+
+// Longest decimal argument; keeps every value well inside uint32_t
+static const size_t MAX_DECIMAL_DIGITS = 9;
+
+// Reply of each CommandError: the reason, and a fixed detail or NULL to echo the token
+struct ErrorReply {
+    const char* reason;
+    const char* detail;
+};
+
+static const ErrorReply ERROR_REPLIES[] = {
+    {"", NULL},
+    {"UNKNOWN_COMMAND", NULL},
+    {"INVALID_FORMAT", NULL},
+    {"INCOMPATIBLE_VERSION", "Major version mismatch"},
+    {"INCOMPATIBLE_VERSION", "Client using newer minor version"},
+    {"INVALID_PIN", NULL},
+    {"INVALID_STATE", NULL},
+    {"INVALID_SAMPLING_RATE", "Value must be between 5-1000"},
+    {"INVALID_ACQ_MODE", NULL},
+    {"INVALID_TREND_CHANNEL", NULL},
+    {"INVALID_TREND_DEVIATION", NULL},  // Formatted with the limit
+    {"INVALID_CAPTURE_INDEX", NULL},
+    {"INVALID_WIFI_FORMAT", "Missing colon separator"},
+    {"INVALID_SSID", "Empty SSID"},
+    {"INVALID_WIFI_FORMAT", "SSID or password too long"},
+};
+
+static bool tokenIs(const char* text, size_t length, const char* word) {
+    return strlen(word) == length && memcmp(text, word, length) == 0;
+}
+
+// Position of the first separator, or length when there is none
+static size_t findChar(const char* text, size_t length, char separator) {
+    const void* found = memchr(text, separator, length);
+    return found ? static_cast<const char*>(found) - text : length;
+}
+
+// Decimal digits only, 1 to MAX_DECIMAL_DIGITS of them
+static bool parseDecimal(const char* text, size_t length, uint32_t& value) {
+    if (length == 0 || length > MAX_DECIMAL_DIGITS) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+// Leading digits of a version component, saturated; advances past them
+static uint16_t parseVersionPart(const char*& text, const char* end) {
+    uint32_t value = 0;
+    while (text < end && *text >= '0' && *text <= '9') {
+        value = value * 10 + (*text++ - '0');
+        if (value > UINT16_MAX) {
+            value = UINT16_MAX;
+        }
+    }
+    return static_cast<uint16_t>(value);
+}
+
+static bool fail(ParsedCommand& command, CommandError error, const char* token, size_t length) {
+    command.error = error;
+    command.token = token;
+    command.tokenLength = static_cast<uint16_t>(length > UINT16_MAX ? UINT16_MAX : length);
+    return false;
+}
+
+// <major>[.<minor>[.<patch>]]_<format>: the format is whatever follows the last '_'; the
+// version is read as leniently as the sscanf("%d.%d.%d") it replaces
+static bool parseProtocol(const char* args, size_t length, const CommandEnvironment& environment,
+                          ParsedCommand& command) {
+    size_t separator = length;
+    while (separator > 0 && args[separator - 1] != '_') {
+        separator--;
+    }
+    const char* format = args + separator;
+    size_t formatLength = separator == 0 ? 0 : length - separator;
+    if (tokenIs(format, formatLength, "JSON")) {
+        command.format = TELEMETRY_FORMAT_JSON;
+    } else if (tokenIs(format, formatLength, "BINARY")) {
+        command.format = TELEMETRY_FORMAT_BINARY;
+    } else if (tokenIs(format, formatLength, "STREAM")) {
+        command.format = TELEMETRY_FORMAT_STREAM;
+    } else {
+        return fail(command, COMMAND_ERROR_FORMAT, format, formatLength);
+    }
+
+    const char* version = args;
+    const char* end = separator == 0 ? args : args + separator - 1;
+    command.versionMajor = parseVersionPart(version, end);
+    command.versionMinor = 0;
+    command.versionPatch = 0;
+    if (version < end && *version == '.') {
+        version++;
+        command.versionMinor = parseVersionPart(version, end);
+        if (version < end && *version == '.') {
+            version++;
+            command.versionPatch = parseVersionPart(version, end);
+        }
+    }
+    // Minor version differences are okay if client is lower than server
+    if (command.versionMajor != environment.protocolMajor) {
+        return fail(command, COMMAND_ERROR_MAJOR_VERSION, args, end - args);
+    }
+    if (command.versionMinor > environment.protocolMinor) {
+        return fail(command, COMMAND_ERROR_MINOR_VERSION, args, end - args);
+    }
+    return true;
+}
+
+static bool parseRelayPin(const char* text, size_t length, const CommandEnvironment& environment,
+                          ParsedCommand& command) {
+    uint32_t pin = 0;
+    if (parseDecimal(text, length, pin)) {
+        for (uint8_t i = 0; i < environment.relayCount; i++) {
+            if (environment.relayPins[i] >= 0 && static_cast<uint32_t>(environment.relayPins[i]) == pin) {
+                command.relay = i;
+                command.pin = environment.relayPins[i];
+                return true;
+            }
+        }
+    }
+    return fail(command, COMMAND_ERROR_PIN, text, length);
+}
+
+static bool parseState(const char* text, size_t length, ParsedCommand& command) {
+    if (tokenIs(text, length, "ON")) {
+        command.on = true;
+    } else if (tokenIs(text, length, "OFF")) {
+        command.on = false;
+    } else {
+        return fail(command, COMMAND_ERROR_STATE, text, length);
+    }
+    return true;
+}
+
+static bool parseArgs(CommandArgs kind, const char* args, size_t length, const CommandEnvironment& environment,
+                      ParsedCommand& command) {
+    switch (kind) {
+        case COMMAND_ARGS_NONE:
+            return true;
+        case COMMAND_ARGS_PROTOCOL:
+            return parseProtocol(args, length, environment, command);
+        case COMMAND_ARGS_PIN:
+            return parseRelayPin(args, length, environment, command);
+        case COMMAND_ARGS_PIN_STATE: {
+            size_t separator = findChar(args, length, '_');
+            if (!parseRelayPin(args, separator, environment, command)) {
+                return false;
+            }
+            size_t stateStart = separator < length ? separator + 1 : length;
+            return parseState(args + stateStart, length - stateStart, command);
+        }
+        case COMMAND_ARGS_INTERVAL:
+            if (!parseDecimal(args, length, command.value) || command.value < COMMAND_SAMPLING_INTERVAL_MIN_MS ||
+                command.value > COMMAND_SAMPLING_INTERVAL_MAX_MS) {
+                return fail(command, COMMAND_ERROR_SAMPLING_RATE, args, length);
+            }
+            return true;
+        case COMMAND_ARGS_ACQ_MODE:
+            if (tokenIs(args, length, "SINGLE")) {
+                command.continuous = false;
+            } else if (tokenIs(args, length, "CONTINUOUS")) {
+                command.continuous = true;
+            } else {
+                return fail(command, COMMAND_ERROR_ACQ_MODE, args, length);
+            }
+            return true;
+        case COMMAND_ARGS_STATE:
+            return parseState(args, length, command);
+        case COMMAND_ARGS_TREND: {
+            size_t separator = findChar(args, length, '_');
+            if (tokenIs(args, separator, "CURRENT")) {
+                command.voltage = false;
+            } else if (tokenIs(args, separator, "VOLTAGE")) {
+                command.voltage = true;
+            } else {
+                return fail(command, COMMAND_ERROR_TREND_CHANNEL, args, separator);
+            }
+            size_t deviationStart = separator < length ? separator + 1 : length;
+            if (!parseDecimal(args + deviationStart, length - deviationStart, command.value) ||
+                command.value > environment.maxTrendDeviation) {
+                return fail(command, COMMAND_ERROR_TREND_DEVIATION, args + deviationStart, length - deviationStart);
+            }
+            return true;
+        }
+        case COMMAND_ARGS_INDEX:
+            if (!parseDecimal(args, length, command.value) || command.value >= environment.captureCapacity) {
+                return fail(command, COMMAND_ERROR_CAPTURE_INDEX, args, length);
+            }
+            return true;
+        case COMMAND_ARGS_CREDENTIALS: {
+            size_t colon = findChar(args, length, ':');
+            if (colon == length) {
+                return fail(command, COMMAND_ERROR_WIFI_FORMAT, args, length);
+            }
+            if (colon == 0) {
+                return fail(command, COMMAND_ERROR_SSID, args, 0);
+            }
+            if (colon > COMMAND_SSID_MAX_LENGTH || length - colon - 1 > COMMAND_PASSWORD_MAX_LENGTH) {
+                return fail(command, COMMAND_ERROR_CREDENTIALS_LENGTH, args, colon);
+            }
+            command.ssid = args;
+            command.ssidLength = static_cast<uint16_t>(colon);
+            command.password = args + colon + 1;
+            command.passwordLength = static_cast<uint16_t>(length - colon - 1);
+            return true;
+        }
+    }
+    return fail(command, COMMAND_ERROR_UNKNOWN, args, length);
+}
+
+bool parseCommand(const char* text, size_t length, const CommandEnvironment& environment, ParsedCommand& command) {
+    memset(&command, 0, sizeof(command));
+    if (length > UINT16_MAX) {
+        return fail(command, COMMAND_ERROR_UNKNOWN, text, length);
+    }
+
+    // Longest keyword the text starts with: bare for commands without arguments, followed
+    // by '_' for the others
+    const CommandDefinition* match = NULL;
+    size_t keywordLength = 0;
+    for (size_t i = 0; i < SUPPORTED_COMMAND_COUNT; i++) {
+        const CommandDefinition& definition = SUPPORTED_COMMANDS[i];
+        size_t n = strlen(definition.command);
+        if (n <= keywordLength || n > length || memcmp(text, definition.command, n) != 0) {
+            continue;
+        }
+        bool matches = definition.args == COMMAND_ARGS_NONE ? length == n : length > n && text[n] == '_';
+        if (matches) {
+            match = &definition;
+            keywordLength = n;
+        }
+    }
+    if (match == NULL) {
+        return fail(command, COMMAND_ERROR_UNKNOWN, text, length);
+    }
+
+    command.id = match->id;
+    size_t argsStart = match->args == COMMAND_ARGS_NONE ? length : keywordLength + 1;
+    return parseArgs(match->args, text + argsStart, length - argsStart, environment, command);
+}
+
+size_t formatCommandError(const ParsedCommand& command, const CommandEnvironment& environment, char* out,
+                          size_t capacity) {
+    if (capacity == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+    if (command.error == COMMAND_OK || command.error >= sizeof(ERROR_REPLIES) / sizeof(ERROR_REPLIES[0])) {
+        return 0;
+    }
+    const ErrorReply& reply = ERROR_REPLIES[command.error];
+    int written;
+    if (command.error == COMMAND_ERROR_TREND_DEVIATION) {
+        written = snprintf(out, capacity, "ERROR:%s:Value must be between 0-%u", reply.reason,
+                           (unsigned)environment.maxTrendDeviation);
+    } else if (reply.detail != NULL) {
+        written = snprintf(out, capacity, "ERROR:%s:%s", reply.reason, reply.detail);
+    } else {
+        written = snprintf(out, capacity, "ERROR:%s:%.*s", reply.reason, (int)command.tokenLength,
+                           command.token != NULL ? command.token : "");
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return static_cast<size_t>(written) < capacity ? written : capacity - 1;
+}
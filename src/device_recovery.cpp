@@ -0,0 +1,93 @@
+#include "device_recovery.h"
+
+RecoveryScheduler::RecoveryScheduler() : lostMask(0), pipelineLostSinceUs(0), pipelineDegradedUs(0) {
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        DeviceRecoveryStatus& s = status[device];
+        s.lost = false;
+        s.outages = 0;
+        s.attempts = 0;
+        s.retryUs = RECOVERY_FIRST_RETRY_US;
+        s.nextAttemptUs = 0;
+        s.lostSinceUs = 0;
+        s.lastOutageUs = 0;
+        s.degradedUs = 0;
+    }
+}
+
+void RecoveryScheduler::markLost(uint8_t device, int64_t nowUs) {
+    if (device >= ADC_MAX_DEVICES || status[device].lost) {
+        return;
+    }
+    DeviceRecoveryStatus& s = status[device];
+    s.lost = true;
+    s.outages++;
+    s.attempts = 0;
+    s.retryUs = RECOVERY_FIRST_RETRY_US;
+    s.nextAttemptUs = nowUs + s.retryUs;
+    s.lostSinceUs = nowUs;
+    if (lostMask == 0) {
+        pipelineLostSinceUs = nowUs;
+    }
+    lostMask |= 1 << device;
+}
+
+void RecoveryScheduler::markRecovered(uint8_t device, int64_t nowUs) {
+    if (device >= ADC_MAX_DEVICES || !status[device].lost) {
+        return;
+    }
+    DeviceRecoveryStatus& s = status[device];
+    s.lost = false;
+    s.lastOutageUs = nowUs - s.lostSinceUs;
+    s.degradedUs += s.lastOutageUs;
+    lostMask &= ~(1 << device);
+    if (lostMask == 0) {
+        pipelineDegradedUs += nowUs - pipelineLostSinceUs;
+    }
+}
+
+void RecoveryScheduler::attemptFailed(uint8_t device, int64_t nowUs) {
+    if (device >= ADC_MAX_DEVICES || !status[device].lost) {
+        return;
+    }
+    DeviceRecoveryStatus& s = status[device];
+    s.attempts++;
+    s.retryUs = s.retryUs * 2 > RECOVERY_MAX_RETRY_US ? RECOVERY_MAX_RETRY_US : s.retryUs * 2;
+    s.nextAttemptUs = nowUs + s.retryUs;
+}
+
+uint8_t RecoveryScheduler::getLostMask() const {
+    return lostMask;
+}
+
+uint8_t RecoveryScheduler::getDueMask(int64_t nowUs) const {
+    uint8_t due = 0;
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (status[device].lost && nowUs >= status[device].nextAttemptUs) {
+            due |= 1 << device;
+        }
+    }
+    return due;
+}
+
+int64_t RecoveryScheduler::getNextAttemptUs() const {
+    int64_t next = INT64_MAX;
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (status[device].lost && status[device].nextAttemptUs < next) {
+            next = status[device].nextAttemptUs;
+        }
+    }
+    return next;
+}
+
+const DeviceRecoveryStatus& RecoveryScheduler::getStatus(uint8_t device) const {
+    return status[device < ADC_MAX_DEVICES ? device : 0];
+}
+
+int64_t RecoveryScheduler::getDegradedUs(uint8_t device, int64_t nowUs) const {
+    const DeviceRecoveryStatus& s = getStatus(device);
+    return s.degradedUs + (s.lost ? nowUs - s.lostSinceUs : 0);
+}
+
+int64_t RecoveryScheduler::getPipelineDegradedUs(int64_t nowUs) const {
+    return pipelineDegradedUs + (lostMask ? nowUs - pipelineLostSinceUs : 0);
+}
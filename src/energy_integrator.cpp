@@ -0,0 +1,125 @@
+#include "energy_integrator.h"
+
+// Trapezoid areas are accumulated doubled ((a + b) * dt), in units x 1e-6
+static const int64_t TRAPEZOID_SCALE = 2 * 1000000LL;
+
+EnergyIntegrator::EnergyIntegrator() {
+    reset();
+}
+
+void EnergyIntegrator::reset() {
+    totals.version = ENERGY_TOTALS_VERSION;
+    totals.chargeInUc = 0;
+    totals.chargeOutUc = 0;
+    totals.energyInUj = 0;
+    totals.energyOutUj = 0;
+    totals.coveredUs = 0;
+    totals.uncoveredUs = 0;
+    totals.energyUncoveredUs = 0;
+    chargeInRemainder = 0;
+    chargeOutRemainder = 0;
+    energyInRemainder = 0;
+    energyOutRemainder = 0;
+    hasPrevious = false;
+    previousUs = 0;
+    previousMicroamps = 0;
+    hasPreviousPower = false;
+    previousPowerUs = 0;
+    previousMicrowatts = 0;
+    unpoweredUs = 0;
+}
+
+void EnergyIntegrator::restore(const EnergyTotals& checkpoint) {
+    reset();
+    totals = checkpoint;
+    totals.version = ENERGY_TOTALS_VERSION;
+}
+
+void EnergyIntegrator::add(const AlignedPair& pair) {
+    // A current that is not a conversion of its own is skipped; the trapezoid then spans
+    // from the last good pair
+    if (!isSampleFresh(pair.currentQuality)) {
+        return;
+    }
+    int64_t microamps = q31ToUnits(pair.current, SHUNT_MICROAMPS_FULL_SCALE);
+
+    if (hasPrevious) {
+        int64_t elapsedUs = pair.timeUs - previousUs;
+        if (elapsedUs <= 0) {
+            return;
+        }
+        if (elapsedUs <= ENERGY_MAX_GAP_US) {
+            int64_t charge = (previousMicroamps + microamps) * elapsedUs;
+            if (charge >= 0) {
+                accumulate(totals.chargeInUc, chargeInRemainder, charge);
+            } else {
+                accumulate(totals.chargeOutUc, chargeOutRemainder, -charge);
+            }
+            totals.coveredUs += elapsedUs;
+            unpoweredUs += elapsedUs;
+        } else {
+            totals.uncoveredUs += elapsedUs;
+        }
+    }
+    hasPrevious = true;
+    previousUs = pair.timeUs;
+    previousMicroamps = microamps;
+
+    // Energy bridges a voltage outage like charge bridges a bad current, up to
+    // ENERGY_MAX_GAP_US; the charge-covered time of a longer one is energy-uncovered
+    int64_t sincePowerUs = pair.timeUs - previousPowerUs;
+    bool bridged = hasPreviousPower && sincePowerUs <= ENERGY_MAX_GAP_US;
+    if (!isVoltageUsable(pair)) {
+        if (!bridged) {
+            totals.energyUncoveredUs += unpoweredUs;
+            unpoweredUs = 0;
+            hasPreviousPower = false;
+        }
+        return;
+    }
+    int64_t microvolts = q31ToUnits(pair.voltage, ADS2_MICROVOLTS_FULL_SCALE);
+    int64_t microwatts = microamps * microvolts / 1000000;
+    if (bridged) {
+        int64_t energy = (previousMicrowatts + microwatts) * sincePowerUs;
+        if (energy >= 0) {
+            accumulate(totals.energyInUj, energyInRemainder, energy);
+        } else {
+            accumulate(totals.energyOutUj, energyOutRemainder, -energy);
+        }
+    } else {
+        totals.energyUncoveredUs += unpoweredUs;
+    }
+    unpoweredUs = 0;
+    hasPreviousPower = true;
+    previousPowerUs = pair.timeUs;
+    previousMicrowatts = microwatts;
+}
+
+// The aligner only makes pairs from fresh currents and interpolated voltages, except
+// while the voltage channel is lost or has never converted: those pairs carry the held
+// voltage and its STALE/RECOVERING flags. The held voltage of a channel that is simply
+// not scanned (HELD alone) is used.
+bool EnergyIntegrator::isVoltageUsable(const AlignedPair& pair) {
+    return !(pair.voltageQuality & (SAMPLE_QUALITY_STALE | SAMPLE_QUALITY_RECOVERING));
+}
+
+const EnergyTotals& EnergyIntegrator::getTotals() const {
+    return totals;
+}
+
+int64_t EnergyIntegrator::netChargeUc() const {
+    return totals.chargeInUc - totals.chargeOutUc;
+}
+
+int64_t EnergyIntegrator::netEnergyUj() const {
+    return totals.energyInUj - totals.energyOutUj;
+}
+
+void EnergyIntegrator::accumulate(int64_t& whole, int64_t& remainder, int64_t microProduct) {
+    remainder += microProduct;
+    if (remainder >= TRAPEZOID_SCALE) {
+        int64_t carry = remainder / TRAPEZOID_SCALE;
+        whole += carry;
+        remainder -= carry * TRAPEZOID_SCALE;
+    }
+}
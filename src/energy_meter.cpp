@@ -0,0 +1,128 @@
+#include "energy_meter.h"
+#include "config.h"
+
+// Owned by the acquisition task
+static PairAligner pairAligner;
+static PowerWindow powerWindow;
+
+// Written by the acquisition task, copied out by BLE/MCP/monitor under this lock
+static EnergyIntegrator energyIntegrator;
+static PowerSummary powerSnapshot;
+static int64_t instantPowerSnapshot = 0;
+static uint32_t alignedSnapshot = 0;
+static uint32_t unalignedSnapshot = 0;
+static portMUX_TYPE energyLock = portMUX_INITIALIZER_UNLOCKED;
+
+static unsigned long lastCheckpointMs = 0;
+static volatile bool checkpointPending = false;
+
+void integrateEnergy(const AdcSample& sample) {
+    pairAligner.add(sample);
+    AlignedPair pair;
+    while (pairAligner.read(pair)) {
+        bool windowDone = powerWindow.add(pair);
+        portENTER_CRITICAL(&energyLock);
+        energyIntegrator.add(pair);
+        instantPowerSnapshot = powerWindow.getInstantPowerUw();
+        if (windowDone) {
+            powerSnapshot = powerWindow.latest();
+        }
+        alignedSnapshot = pairAligner.getAligned();
+        unalignedSnapshot = pairAligner.getUnaligned();
+        portEXIT_CRITICAL(&energyLock);
+    }
+}
+
+EnergyTotals getEnergyTotals() {
+    portENTER_CRITICAL(&energyLock);
+    EnergyTotals copy = energyIntegrator.getTotals();
+    portEXIT_CRITICAL(&energyLock);
+    return copy;
+}
+
+void resetEnergyTotals() {
+    portENTER_CRITICAL(&energyLock);
+    energyIntegrator.reset();
+    portEXIT_CRITICAL(&energyLock);
+    checkpointPending = true;
+    LOG_INFO("Energy totals reset");
+}
+
+bool restoreEnergyCheckpoint() {
+    EnergyTotals checkpoint;
+    if (prefs.getBytes("energy", &checkpoint, sizeof(checkpoint)) != sizeof(checkpoint) ||
+        checkpoint.version != ENERGY_TOTALS_VERSION) {
+        LOG_INFO("No energy checkpoint, starting from zero");
+        return false;
+    }
+    portENTER_CRITICAL(&energyLock);
+    energyIntegrator.restore(checkpoint);
+    portEXIT_CRITICAL(&energyLock);
+    lastCheckpointMs = millis();
+    LOG_INFO("Restored energy checkpoint: %lld uC, %lld uJ",
+             (long long)(checkpoint.chargeInUc - checkpoint.chargeOutUc),
+             (long long)(checkpoint.energyInUj - checkpoint.energyOutUj));
+    return true;
+}
+
+void serviceEnergyCheckpoint() {
+    unsigned long now = millis();
+    if (!checkpointPending && now - lastCheckpointMs < ENERGY_CHECKPOINT_INTERVAL_MS) {
+        return;
+    }
+    checkpointPending = false;
+    lastCheckpointMs = now;
+    EnergyTotals totals = getEnergyTotals();
+    if (prefs.putBytes("energy", &totals, sizeof(totals)) != sizeof(totals)) {
+        LOG_ERROR("Failed to checkpoint energy totals");
+    }
+}
+
+PowerSummary getPowerSummary() {
+    portENTER_CRITICAL(&energyLock);
+    PowerSummary copy = powerSnapshot;
+    portEXIT_CRITICAL(&energyLock);
+    return copy;
+}
+
+int64_t getInstantPowerUw() {
+    portENTER_CRITICAL(&energyLock);
+    int64_t copy = instantPowerSnapshot;
+    portEXIT_CRITICAL(&energyLock);
+    return copy;
+}
+
+String formatPower() {
+    portENTER_CRITICAL(&energyLock);
+    PowerSummary summary = powerSnapshot;
+    int64_t instantUw = instantPowerSnapshot;
+    uint32_t aligned = alignedSnapshot;
+    uint32_t unaligned = unalignedSnapshot;
+    portEXIT_CRITICAL(&energyLock);
+    char buffer[320];
+    snprintf(buffer, sizeof(buffer),
+             "{\"window_s\":%.3f,\"covered_s\":%.3f,\"pairs\":%u,\"real_power_uw\":%.0f,"
+             "\"voltage_rms_uv\":%.0f,\"current_rms_ua\":%.0f,\"apparent_power_uva\":%.0f,"
+             "\"power_factor\":%.4f,\"instant_power_uw\":%lld,\"aligned_pairs\":%u,\"unaligned\":%u}",
+             POWER_WINDOW_DEFAULT_US / 1e6, summary.coveredUs / 1e6, summary.pairs, summary.realPowerUw,
+             summary.voltageRmsUv, summary.currentRmsUa, summary.apparentPowerUva, summary.powerFactor,
+             (long long)instantUw, aligned, unaligned);
+    return String(buffer);
+}
+
+String formatEnergyTotals() {
+    EnergyTotals totals = getEnergyTotals();
+    int64_t netChargeUc = totals.chargeInUc - totals.chargeOutUc;
+    int64_t netEnergyUj = totals.energyInUj - totals.energyOutUj;
+    char buffer[320];
+    snprintf(buffer, sizeof(buffer),
+             "{\"charge_in_uc\":%lld,\"charge_out_uc\":%lld,\"energy_in_uj\":%lld,\"energy_out_uj\":%lld,"
+             "\"charge_mah\":%.3f,\"energy_mwh\":%.3f,\"covered_s\":%lld,\"uncovered_s\":%lld,"
+             "\"energy_uncovered_s\":%lld}",
+             (long long)totals.chargeInUc, (long long)totals.chargeOutUc,
+             (long long)totals.energyInUj, (long long)totals.energyOutUj,
+             netChargeUc / 3600000.0, netEnergyUj / 3600000.0,
+             (long long)(totals.coveredUs / 1000000), (long long)(totals.uncoveredUs / 1000000),
+             (long long)(totals.energyUncoveredUs / 1000000));
+    return String(buffer);
+}
@@ -1,5 +1,4 @@
 #include <Wire.h> // Provides I2C communication support for interfacing with ADS1115 ADC chips
-#include <Adafruit_ADS1X15.h> // Library for interacting with ADS1115 ADC chips for analog-to-digital conversion
 #include <BLEDevice.h> // Core library for setting up BLE functionality on the ESP32
 #include <BLEUtils.h> // Utility functions for BLE operations, such as UUID handling
 #include <BLEServer.h> // Enables the ESP32 to act as a BLE server
@@ -12,7 +11,7 @@
 #include <soc/rtc_wdt.h> // Allows control over the RTC Watchdog Timer, which can cause resets during long tasks
 #include <esp_system.h> // Provides system-level functions, such as restarting the ESP32
 #include <rom/rtc.h> // Used for retrieving crash diagnostics and reset reasons
-#include <ArduinoJson.h> // Library for creating and parsing JSON, used for BLE data serialization
+#include <esp_timer.h> // Microsecond timestamps for acquired samples
 #include "sampling_config.h" // Project-specific configuration for ADC sampling intervals and settings
 #include "config.h" // Contains system-wide constants and configuration values
 #include "ble_module.h" // Handles BLE initialization, services, and characteristics
@@ -21,20 +20,48 @@
 #include "relay_module.h" // Controls GPIO pins connected to relays and manages their states
 #include "ble_callbacks.h" // Implements BLE command processing and characteristic callbacks
 #include "mcp_server.h" // Implements the MCP server for remote management and communication
+#include "sample_clock.h" // Hardware-timer sample clock and jitter statistics
+#include "energy_meter.h" // Full-rate charge and energy integration with NVS checkpoints
+#include "stats_monitor.h" // Sliding-window min/max/RMS/noise statistics
+#include "spectrum_monitor.h" // FFT band levels and peaks of the shunt channel
+#include "trend_monitor.h" // Swinging-door compression of both channels
+#include "telemetry_frame.h" // Binary and JSON encodings of the telemetry frame
+#include "sample_batch.h" // Delta/varint batches of full-rate samples for streaming
 
 // Function prototypes for local functions only
 void monitorTask(void *pvParameters);
+void recoveryTask(void *pvParameters);
+void spectrumTask(void *pvParameters);
 
 static const char* TAG = "ESP32_ADS1115";
 
-// Local buffers and mutex for averaging and synchronization
-const int avgWindow = 10;
-float shuntBuffer[avgWindow] = {0};
-float ads2Buffer[avgWindow] = {0};
-int bufferIndex = 0;
-
 Preferences prefs;
-SemaphoreHandle_t bufferMutex;
+
+// Longest wait for ALERT/RDY in continuous mode before the silent chip is counted as failed
+const uint32_t CONVERSION_READY_TIMEOUT_MS = 20;
+
+// Output period of the decimated measurements bleTask reports
+const uint32_t BLE_OUTPUT_PERIOD_US = 100000;
+
+// Longest a streamed sample waits for its batch to fill, so slow sampling still streams
+const int64_t STREAM_BATCH_MAX_AGE_US = 200000;
+
+// Longest bleTask sleeps without a signal, for the connection and calibration housekeeping
+// while no samples arrive
+const uint32_t BLE_IDLE_WAKE_MS = 1000;
+
+// Pause between bursts while queued notifications the client has credits for remain
+const uint32_t BLE_BACKLOG_RETRY_MS = 10;
+
+// bleTask runs notify() in the BLE stack and the String-based logging and calibration
+// paths on its own stack; its large buffers are task-static instead
+const uint32_t BLE_TASK_STACK_SIZE = 6144;
+
+// Least free bleTask stack, in bytes, before its high-water mark is reported as a warning
+const uint32_t BLE_TASK_STACK_MARGIN = 1024;
+
+// Slack on top of the sampling interval before a missing sample clock tick is reported
+const uint32_t SAMPLE_TICK_TIMEOUT_MARGIN_MS = 50;
 
 // LED pin for relay feedback (used by blinkRelayFeedback in relay_module.cpp)
 const int relayFeedbackLedPin = 33;
@@ -84,74 +111,152 @@ void monitorTask(void *pvParameters) {
             }
         }
         
-        // ADS1115 #1 recovery logic
-        if (!ads1_available) {
-            LOG_INFO("Attempting to recover ADS1115 #1...");
-            
-            // Try to re-initialize with a delay
-            vTaskDelay(pdMS_TO_TICKS(100));
-            
-            if (ads1.begin(0x48)) {
-                ads1.setGain(GAIN_EIGHT);
-                ads1.setDataRate(RATE_ADS1115_860SPS);
-                ads1_available = true;
-                LOG_INFO("ADS1115 #1 reinitialized successfully.");
-            } else {
-                LOG_ERROR("ADS1115 #1 reinitialization failed!");
-            }
-        }
-        
-        // ADS1115 #2 recovery logic
-        if (!ads2_available) {
-            LOG_INFO("Attempting to recover ADS1115 #2...");
-            
-            // Try to re-initialize with a delay
-            vTaskDelay(pdMS_TO_TICKS(100));
-            
-            if (ads2.begin(0x49)) {
-                ads2.setGain(GAIN_ONE);
-                ads2.setDataRate(RATE_ADS1115_860SPS);
-                ads2_available = true;
-                LOG_INFO("ADS1115 #2 reinitialized successfully.");
-            } else {
-                LOG_ERROR("ADS1115 #2 reinitialization failed!");
-            }
-        }
-        
+        // Checkpoint the energy totals; NVS writes stay off the sampling task
+        serviceEnergyCheckpoint();
+
+        // ADS1115 recovery is handled by recoveryTask
+
         // Give other tasks time to run and avoid too frequent checks
         vTaskDelay(pdMS_TO_TICKS(30000)); // Check every 30 seconds
     }
 }
 
-// FreeRTOS task for ADC data collection with mutex protection
+// ADS1115 recovery: bus clear and reattach with exponential backoff, off the sampling
+// task. Sleeps until a device is lost or its next attempt is due.
+void recoveryTask(void *pvParameters) {
+    setRecoveryTask(xTaskGetCurrentTaskHandle());
+    while (1) {
+        TickType_t wait = serviceAdcRecovery();
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+// Owned by dataTask: when bleTask was last woken for new output
+static int64_t outputSignalUs = 0;
+static bool trendSignalled = false;
+
+// Wake bleTask once an output period's worth of samples is in the ring, and at once for
+// the first trend point of a period so a change after a quiet spell goes out without delay
+static void signalOutput(int64_t timestampUs, bool trendMoved) {
+    if (timestampUs - outputSignalUs >= BLE_OUTPUT_PERIOD_US) {
+        outputSignalUs = timestampUs;
+        trendSignalled = trendMoved;
+        signalBleTask();
+    } else if (trendMoved && !trendSignalled) {
+        trendSignalled = true;
+        signalBleTask();
+    }
+}
+
+// Publish the latest current/voltage pair, calibrated, timestamped and flagged with its
+// quality, to the lock-free ring (never blocks), then let the adaptive rate pick the next
+// interval and calibration or the rangers the gains for the next conversion
+static void storeSample(int64_t timestampUs) {
+    ChannelReading current = takeChannelReading(ADC_CURRENT_CHANNEL);
+    ChannelReading voltage = takeChannelReading(ADC_VOLTAGE_CHANNEL);
+    AdcSample sample;
+    sample.timestampUs = timestampUs;
+    sample.shuntRaw = current.raw;
+    sample.ads2Raw = voltage.raw;
+    sample.shuntGain = current.gain;
+    sample.ads2Gain = voltage.gain;
+    sample.shunt = shuntOffsets.correct(current.raw, current.gain);
+    sample.ads2 = ads2Offsets.correct(voltage.raw, voltage.gain);
+    sample.shuntQuality = current.quality;
+    sample.ads2Quality = voltage.quality;
+    sample.shuntUs = current.timestampUs;
+    sample.ads2Us = voltage.timestampUs;
+    sampleRing.push(sample);
+    integrateEnergy(sample);
+    signalOutput(timestampUs, compressTrend(sample));
+    updateAdaptiveSampling(sample);
+    feedCapture(sample);
+    if (!feedCalibration(sample)) {
+        updateAutoRange(sample);
+    }
+}
+
+// FreeRTOS task for ADC data collection (sole producer of sampleRing)
 void dataTask(void *pvParameters) {
     // Tell the watchdog that this is a monitored task
     esp_task_wdt_add(NULL);
+
+    // ALERT/RDY interrupts notify this task directly
+    setAcquisitionTask(xTaskGetCurrentTaskHandle());
+
+    uint16_t clockIntervalMs = 0; // Interval the sample clock runs at, 0 while stopped
+    uint32_t readyPeriodUs = 0;   // Expected ALERT/RDY period, 0 until continuous timing is set up
+    int64_t lastReadyUs = 0;
     
     while (1) {
         // Reset watchdog timer for this task
         esp_task_wdt_reset();
-        
-        // Use our robust reading functions that handle errors and timeouts
-        int16_t rawShuntDiff = readShuntDifferential();
-        float calibratedShuntDiff = rawShuntDiff - shuntOffsetFloat;
-        
-        if (xSemaphoreTake(bufferMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-            shuntBuffer[bufferIndex] = calibratedShuntDiff;
-            
-            // Use our robust reading function for ADS2
-            int16_t rawAds2A0 = readADS2Channel0();
-            float calibratedAds2A0 = rawAds2A0 - ads2OffsetFloat;
-            ads2Buffer[bufferIndex] = calibratedAds2A0;
-            
-            bufferIndex = (bufferIndex + 1) % avgWindow;
-            xSemaphoreGive(bufferMutex);
-        } else {
-            LOG_ERROR("Failed to acquire mutex in dataTask");
+
+        // Mode and scan list changes requested over BLE/MCP are applied here, between reads
+        applyPendingScanList();
+        applyPendingAcquisitionMode();
+
+        if (getAcquisitionMode() == ACQ_MODE_CONTINUOUS) {
+            // The chips pace themselves; jitter is measured against their conversion time
+            if (readyPeriodUs == 0) {
+                stopSampleClock();
+                clockIntervalMs = 0;
+                lastReadyUs = 0;
+                readyPeriodUs = getInputSamplePeriodUs();
+                resetSampleTiming(readyPeriodUs);
+            }
+
+            // Sleep until a chip raises ALERT/RDY; each ready chip costs one conversion register read.
+            // The current channel's device paces the ring (the voltage channel's while it is down).
+            uint32_t readyBits = waitForConversionReady(pdMS_TO_TICKS(CONVERSION_READY_TIMEOUT_MS));
+            int64_t readyUs = 0;
+            if (readReadyConversions(readyBits, readyUs)) {
+                // A gap of several conversion times means RDY pulses were missed
+                uint32_t missed = 0;
+                if (lastReadyUs != 0) {
+                    int64_t periods = (readyUs - lastReadyUs + readyPeriodUs / 2) / readyPeriodUs;
+                    missed = periods > 1 ? (uint32_t)(periods - 1) : 0;
+                }
+                lastReadyUs = readyUs;
+                recordSampleTiming(readyUs, missed);
+                storeSample(readyUs);
+            }
+            continue;
+        }
+
+        readyPeriodUs = 0;
+
+        // (Re)arm the hardware sample clock whenever the configured (or adapted) interval changes
+        uint16_t intervalMs = getEffectiveSamplingInterval();
+        if (intervalMs != clockIntervalMs) {
+            if (startSampleClock(xTaskGetCurrentTaskHandle(), intervalMs * 1000UL)) {
+                clockIntervalMs = intervalMs;
+            } else {
+                // The old period is stopped too: fall back to RTOS pacing rather than
+                // waiting on ticks that never come, and retry the clock next pass
+                clockIntervalMs = 0;
+                vTaskDelay(pdMS_TO_TICKS(intervalMs));
+            }
+        }
+
+        // Sleep until the next tick; the period no longer depends on how long the read takes
+        int64_t tickTimeUs = 0;
+        uint32_t missedTicks = 0;
+        if (clockIntervalMs != 0 &&
+            !waitForSampleTick(pdMS_TO_TICKS(intervalMs + SAMPLE_TICK_TIMEOUT_MARGIN_MS), tickTimeUs, missedTicks)) {
+            LOG_WARNING("Sample clock tick missing after %u ms", intervalMs);
+            continue;
+        }
+
+        // Timestamp the start of the conversions; that is when the pair is sampled
+        int64_t sampleUs = esp_timer_get_time();
+        recordSampleTiming(sampleUs, missedTicks);
+
+        // All devices in the scan slot convert concurrently; errors are counted per device and
+        // lost devices are skipped until recoveryTask reattaches them
+        if (readScanSlot(sampleUs)) {
+            storeSample(sampleUs);
         }
-        
-        // Make sure we yield to other tasks
-        vTaskDelay(pdMS_TO_TICKS(getSamplingInterval()));
     }
     
     // Should never reach here, but just in case
@@ -159,64 +264,273 @@ void dataTask(void *pvParameters) {
     vTaskDelete(NULL);
 }
 
-// FreeRTOS task for BLE communication with mutex protection
+// Report background calibration on the relay characteristic as it advances (10% steps)
+static void reportCalibrationProgress(CalibrationState& reportedState, uint8_t& reportedProgress) {
+    CalibrationState state = getCalibrationState();
+    uint8_t progress = getCalibrationProgress();
+    if (state == reportedState && progress / 10 == reportedProgress / 10) {
+        return;
+    }
+    reportedState = state;
+    reportedProgress = progress;
+    if (!deviceConnected || !pRelayCharacteristic) {
+        return;
+    }
+    if (state == CALIBRATION_COMPLETE) {
+        pRelayCharacteristic->setValue("LOG:Calibration complete");
+    } else if (state == CALIBRATION_RUNNING) {
+        pRelayCharacteristic->setValue(("CALIBRATE:PROGRESS:" + String(progress)).c_str());
+    } else {
+        return;
+    }
+    pRelayCharacteristic->notify();
+}
+
+// Tell the BLE client when a burst capture has been triggered and is ready to download
+static void reportCaptureState(CaptureState& reportedState) {
+    CaptureState state = getCaptureState();
+    if (state == reportedState) {
+        return;
+    }
+    reportedState = state;
+    if (!deviceConnected || !pRelayCharacteristic) {
+        return;
+    }
+    if (state == CAPTURE_TRIGGERED) {
+        pRelayCharacteristic->setValue("CAPTURE:TRIGGERED");
+    } else if (state == CAPTURE_COMPLETE) {
+        pRelayCharacteristic->setValue("CAPTURE:COMPLETE");
+    } else {
+        return;
+    }
+    pRelayCharacteristic->notify();
+}
+
+// Tell the BLE client the interval the sample clock runs at whenever adaptive sampling
+// changes it
+static void reportSamplingInterval(uint16_t& reportedInterval) {
+    uint16_t interval = getEffectiveSamplingInterval();
+    if (interval == reportedInterval) {
+        return;
+    }
+    reportedInterval = interval;
+    if (!deviceConnected || !pRelayCharacteristic || !isAdaptiveSampling()) {
+        return;
+    }
+    pRelayCharacteristic->setValue(("ADAPTIVE:INTERVAL:" + String(interval)).c_str());
+    pRelayCharacteristic->notify();
+}
+
+// Telemetry subset of a window summary, in engineering units
+static TelemetryStats toTelemetryStats(const WindowSummary& summary, int64_t unitsPerFullScale) {
+    TelemetryStats stats;
+    stats.min = q31ToUnits(summary.min, unitsPerFullScale);
+    stats.max = q31ToUnits(summary.max, unitsPerFullScale);
+    stats.peak = q31ToUnits(summary.peak, unitsPerFullScale);
+    stats.rms = q31ToUnits(summary.rms, unitsPerFullScale);
+    stats.stddev = q31ToUnits(summary.stddev, unitsPerFullScale);
+    return stats;
+}
+
+// Adds a full-rate sample to the stream, sending the batch first when it is full
+static void streamSample(SampleBatcher& batcher, const AdcSample& sample) {
+    BatchSample point;
+    point.timeUs = sample.timestampUs;
+    point.currentUa = q31ToUnits(sample.shunt, SHUNT_MICROAMPS_FULL_SCALE);
+    point.voltageUv = q31ToUnits(sample.ads2, ADS2_MICROVOLTS_FULL_SCALE);
+    point.currentQuality = sample.shuntQuality;
+    point.voltageQuality = sample.ads2Quality;
+    if (!batcher.add(point)) {
+        notifyData(batcher.data(), batcher.size());
+        batcher.clear();
+        batcher.add(point);
+    }
+}
+
+// FreeRTOS task for BLE communication. It sleeps until signalled (see signalOutput() and
+// signalBleTask()) or until something it holds falls due, rather than polling the rings.
 void bleTask(void *pvParameters) {
+    setBleTask(xTaskGetCurrentTaskHandle());
+
+    // This task's own view of the sample stream. The filters and the batch are static,
+    // off the task stack (there is only one bleTask).
+    AdcSampleRing::Reader sampleReader(sampleRing);
+    TrendPointRing::Reader trendReader(trendRing);
+    static SampleDecimator decimator(BLE_OUTPUT_PERIOD_US);
+    static SampleBatcher batcher;
+    uint32_t reportedDrops = 0;
+    UBaseType_t reportedStackFree = BLE_TASK_STACK_SIZE;
+    bool reportedConnection = false;
+    CalibrationState reportedCalibrationState = getCalibrationState();
+    uint8_t reportedCalibrationProgress = getCalibrationProgress();
+    CaptureState reportedCaptureState = getCaptureState();
+    uint16_t reportedInterval = getEffectiveSamplingInterval();
+    uint16_t frameSequence = 0;
+    bool framePending = false;
+    int64_t lastFrameUs = 0;
+
     while (1) {
         // Handle BLE connections for reconnection
         handleBLEConnections();
 
-        if (deviceConnected) {
-            float shuntDiffAvg = 0;
-            float ads2A0Avg = 0;
-            if (xSemaphoreTake(bufferMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-                for (int i = 0; i < avgWindow; i++) {
-                    shuntDiffAvg += shuntBuffer[i];
-                    if (ads2_available) {
-                        ads2A0Avg += ads2Buffer[i];
-                    }
-                }
-                shuntDiffAvg /= avgWindow;
-                if (ads2_available) {
-                    ads2A0Avg /= avgWindow;
-                }
-                xSemaphoreGive(bufferMutex);
-            } else {
-                LOG_ERROR("Failed to acquire mutex in bleTask");
+        // Drain everything produced since the last pass through the decimation filters
+        // and the windowed statistics, and into sample batches while a client streams
+        decimator.setInputPeriod(getInputSamplePeriodUs());
+        bool streaming = deviceConnected && getTelemetryFormat() == TELEMETRY_FORMAT_STREAM;
+        if (streaming) {
+            batcher.setPayloadLimit(getNotifyPayloadLimit());
+        } else {
+            batcher.reset();
+        }
+        AdcSample sample;
+        while (sampleReader.read(sample)) {
+            decimator.add(sample);
+            updateStatistics(sample);
+            if (streaming) {
+                streamSample(batcher, sample);
             }
+        }
+        if (streaming && !batcher.empty() && esp_timer_get_time() - batcher.firstTimeUs() >= STREAM_BATCH_MAX_AGE_US) {
+            notifyData(batcher.data(), batcher.size());
+            batcher.clear();
+        }
+        publishStatistics();
+        if (sampleReader.dropped() != reportedDrops) {
+            LOG_WARNING("bleTask fell behind, %u samples dropped in total", sampleReader.dropped());
+            reportedDrops = sampleReader.dropped();
+        }
 
-            // Apply deadband
-            if (abs(shuntDiffAvg) < 1.0) shuntDiffAvg = 0;
-            if (abs(ads2A0Avg) < 1.0) ads2A0Avg = 0;
-
-            // Build standardized JSON data with protocol version using ArduinoJson
-            DynamicJsonDocument doc(512);
-            doc["protocol_version"] = PROTOCOL_VERSION;
-            doc["timestamp"] = millis();
-            
-            // Organize measurements in a nested structure
-            JsonObject measurements = doc.createNestedObject("measurements");
-            measurements["shunt_diff"] = shuntDiffAvg;
-            measurements["ads2_a0"] = ads2A0Avg;
-            
-            // Organize relay states in a nested structure
-            JsonObject relays = doc.createNestedObject("relays");
+        // Calibration runs on dataTask; persisting and reporting it happens here
+        serviceCalibration();
+        reportCalibrationProgress(reportedCalibrationState, reportedCalibrationProgress);
+        reportCaptureState(reportedCaptureState);
+        reportSamplingInterval(reportedInterval);
+
+        // A frame only goes out when either channel's trend moved beyond its deviation
+        // (or the trend's interval limit passed), at most once per output period, and
+        // once on every new connection
+        TrendPoint point;
+        while (trendReader.read(point)) {
+            framePending = true;
+        }
+        bool newConnection = deviceConnected && !reportedConnection;
+        reportedConnection = deviceConnected;
+        int64_t nowUs = esp_timer_get_time();
+        int64_t frameDueUs = lastFrameUs + BLE_OUTPUT_PERIOD_US;
+
+        if (!deviceConnected) {
+            framePending = false;
+        } else if (newConnection || (framePending && nowUs >= frameDueUs)) {
+            framePending = false;
+            lastFrameUs = nowUs;
+            bool voltageAvailable = isChannelAvailable(ADC_VOLTAGE_CHANNEL);
+            q31_t shuntDiff = decimator.shunt();
+            q31_t ads2A0 = voltageAvailable ? decimator.ads2() : 0;
+
+            // One frame on the stack, encoded in whichever format the client negotiated
+            TelemetryFrame frame;
+            if (newConnection) {
+                frameSequence = 0;
+            }
+            frame.sequence = frameSequence++;
+            frame.timestampMs = millis();
+            frame.currentUa = q31ToUnits(shuntDiff, SHUNT_MICROAMPS_FULL_SCALE);
+            frame.voltageUv = q31ToUnits(ads2A0, ADS2_MICROVOLTS_FULL_SCALE);
+            // Mean of the time-aligned v * i over the last power window
+            frame.powerUw = saturateQ31((int64_t)getPowerSummary().realPowerUw);
+            // SAMPLE_QUALITY_* flags over the decimation window (0: every input fresh)
+            frame.currentQuality = decimator.shuntQuality();
+            frame.voltageQuality = decimator.ads2Quality();
+            frame.relays = 0;
             for (int i = 0; i < 4; i++) {
-                relays["relay" + String(i + 1)] = relayStates[i] ? 1 : 0;
+                frame.relays |= relayStates[i] ? (1 << i) : 0;
+            }
+            frame.flags = voltageAvailable ? TELEMETRY_FLAG_VOLTAGE_AVAILABLE : 0;
+            // Counts stay relative to the nominal gains, as the app expects
+            frame.shuntCounts = rescaleQ31(shuntDiff, SHUNT_WIDEST_GAIN, SHUNT_GAIN);
+            frame.ads2Counts = rescaleQ31(ads2A0, ADS2_WIDEST_GAIN, ADS2_GAIN);
+
+            // Net totals integrated at the full sample rate
+            EnergyTotals totals = getEnergyTotals();
+            frame.chargeUah = saturateQ31((totals.chargeInUc - totals.chargeOutUc) / 3600);
+            frame.energyUwh = saturateQ31((totals.energyInUj - totals.energyOutUj) / 3600);
+
+            // Window statistics at the full sample rate, so transients survive decimation
+            frame.statsWindow = getStatisticsWindow(STATS_TELEMETRY_WINDOW);
+            frame.currentStats = toTelemetryStats(getShuntSummary(STATS_TELEMETRY_WINDOW), SHUNT_MICROAMPS_FULL_SCALE);
+            frame.voltageStats = toTelemetryStats(getAds2Summary(STATS_TELEMETRY_WINDOW), ADS2_MICROVOLTS_FULL_SCALE);
+
+            if (getTelemetryFormat() != TELEMETRY_FORMAT_JSON) {
+                static uint8_t packet[TELEMETRY_FRAME_SIZE];
+                notifyData(packet, encodeTelemetryFrame(frame, packet, sizeof(packet)));
+            } else {
+                // Same keys as the original JSON frame, formatted into a fixed buffer; sent
+                // whole within one notification of the negotiated MTU, never truncated
+                static char json[TELEMETRY_JSON_CAPACITY + 1];
+                size_t jsonCapacity = getNotifyPayloadLimit() + 1;
+                if (jsonCapacity > sizeof(json)) {
+                    jsonCapacity = sizeof(json);
+                }
+                if (formatTelemetryJson(frame, PROTOCOL_VERSION, json, jsonCapacity) > 0) {
+                    notifyData(json);
+                    LOG_DEBUG("BLE Data Sent: %s", json);
+                } else {
+                    LOG_ERROR("Error: JSON frame does not fit the %u-byte notification payload",
+                              (unsigned)(jsonCapacity - 1));
+                }
             }
+        }
 
-            // Serialize JSON
-            String jsonData;
-            serializeJson(doc, jsonData);
+        // Queued notifications go out as far as the client's credits allow
+        bool backlog = serviceNotifyQueue();
 
-            if (jsonData.length() > 0 && jsonData.length() < 512) {
-                notifyData(jsonData.c_str());
-                LOG_INFO("BLE Data Sent: %s", jsonData.c_str());
+        // Report every new low of the free stack, as a warning once the margin is used up
+        UBaseType_t stackFree = uxTaskGetStackHighWaterMark(NULL);
+        if (stackFree < reportedStackFree) {
+            reportedStackFree = stackFree;
+            if (stackFree < BLE_TASK_STACK_MARGIN) {
+                LOG_WARNING("bleTask stack high-water mark: %u bytes free", (unsigned)stackFree);
             } else {
-                LOG_ERROR("Error: JSON data too large or invalid!");
+                LOG_DEBUG("bleTask stack high-water mark: %u bytes free", (unsigned)stackFree);
             }
         }
-        ArduinoOTA.handle(); // Handle OTA updates
-        vTaskDelay(pdMS_TO_TICKS(100)); // Notify every 100ms
+
+        // Sleep until signalled, or until the backlog, a held frame or a partial batch is due
+        int64_t waitUs = BLE_IDLE_WAKE_MS * 1000LL;
+        if (backlog) {
+            waitUs = BLE_BACKLOG_RETRY_MS * 1000LL;
+        }
+        if (framePending && frameDueUs - nowUs < waitUs) {
+            waitUs = frameDueUs - nowUs;
+        }
+        if (streaming && !batcher.empty() && batcher.firstTimeUs() + STREAM_BATCH_MAX_AGE_US - nowUs < waitUs) {
+            waitUs = batcher.firstTimeUs() + STREAM_BATCH_MAX_AGE_US - nowUs;
+        }
+        TickType_t waitTicks = waitUs > 0 ? pdMS_TO_TICKS((waitUs + 999) / 1000) : 0;
+        ulTaskNotifyTake(pdTRUE, waitTicks > 0 ? waitTicks : 1);
+    }
+}
+
+// FreeRTOS task for the shunt spectrum. It runs on core 0, away from the acquisition
+// tasks, so a transform never delays sampling or the telemetry.
+void spectrumTask(void *pvParameters) {
+    AdcSampleRing::Reader sampleReader(sampleRing);
+    uint32_t reportedDrops = 0;
+
+    while (1) {
+        setSpectrumSamplePeriod(getInputSamplePeriodUs());
+        AdcSample sample;
+        while (sampleReader.read(sample)) {
+            updateSpectrum(sample);
+        }
+        if (publishSpectrum()) {
+            notifySpectrum(formatSpectrumCompact().c_str());
+        }
+        if (sampleReader.dropped() != reportedDrops) {
+            LOG_WARNING("spectrumTask fell behind, %u samples dropped in total", sampleReader.dropped());
+            reportedDrops = sampleReader.dropped();
+        }
+        vTaskDelay(pdMS_TO_TICKS(SPECTRUM_POLL_MS));
     }
 }
 
@@ -285,9 +599,9 @@ void setup() {
     // Configure Task Watchdog Timer
     esp_task_wdt_init(30, false); // 30-second timeout, no panic
 
-    Wire.begin(21, 22); // SDA on GPIO 21, SCL on GPIO 22
-    Wire.setClock(100000); // 100 kHz I2C speed
-    Wire.setTimeout(100); // 100ms timeout for I2C
+    Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN);
+    setI2CClock(I2C_CLOCK_HZ); // Fast-mode I2C (see config.h)
+    Wire.setTimeOut(I2C_TIMEOUT_MS); // Short timeout bounds the stall on a dead device (see config.h)
 
     // Initialize Preferences
     prefs.begin("app_state", false);
@@ -304,35 +618,40 @@ void setup() {
         digitalWrite(relayPins[i], relayStates[i] ? HIGH : LOW);
     }
 
-    // Initialize ADS1 for current measurement
-    if (!initializeADS(ads1, 0x48, "ADS1115 #1")) {
-        LOG_ERROR("Critical failure: ADS1115 #1 not initialized! Restarting...");
-        if (pRelayCharacteristic) {
-            pRelayCharacteristic->setValue("ERROR:ADC:ADS1115_1_INIT_FAIL");
-            pRelayCharacteristic->notify();
+    // Probe every ADS1115 in the channel table; only the current channel's is critical
+    uint8_t devicesMissing = setupADC();
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (!(devicesMissing & (1 << device))) {
+            continue;
         }
-        ESP.restart();
-    }
-    ads1.setGain(GAIN_EIGHT); // ±0.512V range
-    ads1.setDataRate(RATE_ADS1115_860SPS); // 860 SPS
-    ads1_available = true; // Mark ADS1 as available after successful initialization
-
-    // Initialize ADS2 for voltage measurement
-    if (initializeADS(ads2, 0x49, "ADS1115 #2")) {
-        ads2.setGain(GAIN_ONE); // ±4.096V range
-        ads2.setDataRate(RATE_ADS1115_860SPS); // 860 SPS
-        ads2_available = true;
-    } else {
-        LOG_ERROR("ADS1115 #2 unavailable, proceeding without it.");
+        String error = "ERROR:ADC:ADS1115_" + String(device + 1) + "_INIT_FAIL";
         if (pRelayCharacteristic) {
-            pRelayCharacteristic->setValue("ERROR:ADC:ADS1115_2_INIT_FAIL");
+            pRelayCharacteristic->setValue(error.c_str());
             pRelayCharacteristic->notify();
         }
-        ads2_available = false;
+        if (device == ADC_CHANNEL_TABLE[ADC_CURRENT_CHANNEL].device) {
+            LOG_ERROR("Critical failure: ADS1115 #%u (current channel) not initialized! Restarting...", device + 1);
+            ESP.restart();
+        }
+        LOG_ERROR("ADS1115 #%u unavailable, proceeding without it.", device + 1);
+    }
+
+    // Continue the energy totals from the last checkpoint
+    restoreEnergyCheckpoint();
+
+    // Trend compression error bounds and adaptive sampling
+    loadTrendSettings();
+    loadAdaptiveSampling();
+
+    // Reuse the stored calibration; otherwise calibrate in the background once sampling starts
+    if (!loadCalibration()) {
+        requestCalibration();
     }
 
-    // Perform auto-calibration on every boot
-    calibrateADC();
+    // Restore the acquisition mode; it is applied by dataTask once it is running
+    if (prefs.getUChar("acqMode", ACQ_MODE_SINGLE_SHOT) == ACQ_MODE_CONTINUOUS) {
+        requestAcquisitionMode(ACQ_MODE_CONTINUOUS);
+    }
 
     // Initialize BLE with our improved setup function
     setupBLE();
@@ -355,17 +674,6 @@ void setup() {
         }
     }
 
-    // Create mutex for buffer synchronization
-    bufferMutex = xSemaphoreCreateMutex();
-    if (bufferMutex == NULL) {
-        LOG_ERROR("Failed to create mutex!");
-        if (pRelayCharacteristic) {
-            pRelayCharacteristic->setValue("ERROR:RTOS:MUTEX_CREATE_FAIL");
-            pRelayCharacteristic->notify();
-        }
-        ESP.restart();
-    }
-
     // Create mutex for MCP server state synchronization
     mcpServerMutex = xSemaphoreCreateMutex();
     if (mcpServerMutex == NULL) {
@@ -379,8 +687,10 @@ void setup() {
 
     // Create FreeRTOS tasks
     xTaskCreatePinnedToCore(dataTask, "DataTask", 4096, NULL, 3, NULL, 1);
-    xTaskCreatePinnedToCore(bleTask, "BleTask", 4096, NULL, 2, NULL, 1);
+    xTaskCreatePinnedToCore(bleTask, "BleTask", BLE_TASK_STACK_SIZE, NULL, 2, NULL, 1);
     xTaskCreatePinnedToCore(monitorTask, "MonitorTask", 4096, NULL, 1, NULL, 1);
+    xTaskCreatePinnedToCore(recoveryTask, "RecoveryTask", 3072, NULL, 1, NULL, 1);
+    xTaskCreatePinnedToCore(spectrumTask, "SpectrumTask", 4096, NULL, 1, NULL, 0);
 
     pinMode(relayFeedbackLedPin, OUTPUT); // Setup relay feedback LED
     digitalWrite(relayFeedbackLedPin, LOW);
@@ -397,6 +707,9 @@ void setup() {
 }
 
 void loop() {
+    // OTA is polled here, at the loop's own cadence, not on the sample-driven bleTask
+    ArduinoOTA.handle();
+
     // Handle MCP server if available
     handleMcpLoop();
     
@@ -404,8 +717,10 @@ void loop() {
     if (isAPModeActive()) {
         handleWiFiConfig();
     }
-    // Only enter light sleep if both BLE and MCP are inactive
-    else if (!deviceConnected && !mcpServerStarted) {
+    // Only enter light sleep if both BLE and MCP are inactive and nothing is being acquired:
+    // sleep stops the sample clock, and every gap longer than ENERGY_MAX_GAP_US would end
+    // up as uncovered time in the energy totals
+    else if (!deviceConnected && !mcpServerStarted && !isChannelAvailable(ADC_CURRENT_CHANNEL)) {
         LOG_INFO("No active connections. Entering light sleep mode.");
         esp_sleep_enable_timer_wakeup(1000000); // Wake up after 1 second
         esp_light_sleep_start();
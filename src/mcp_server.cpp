@@ -8,10 +8,14 @@
 #include "wifi_module.h"
 #include "config.h"
 #include "sampling_config.h"
-
-// Extern declarations for global buffers
-extern float shuntBuffer[];
-extern float ads2Buffer[];
+#include "sample_clock.h"
+#include "energy_meter.h"
+#include "stats_monitor.h"
+#include "spectrum_monitor.h"
+#include "trend_monitor.h"
+#include "ble_module.h"
+
+// Extern declarations for global state
 extern bool relayStates[4];
 extern SemaphoreHandle_t mcpServerMutex;
 
@@ -20,8 +24,12 @@ WebSocketsServer webSocket(9000);
 bool webSocketStarted = false;
 
 // Maximum number of resources and tools
-#define MAX_RESOURCES 10
-#define MAX_TOOLS 8
+#define MAX_RESOURCES 24
+#define MAX_TOOLS 16
+
+// Tool results carry capture.read chunks of up to MCP_CAPTURE_CHUNK_CHARS characters
+#define MCP_TOOL_RESULT_SIZE 2048
+#define MCP_CAPTURE_CHUNK_CHARS 1500
 #define MAX_SUBSCRIPTIONS 5
 
 // MCP Protocol version
@@ -76,13 +84,40 @@ void handleMcpRequest(uint8_t clientId, JsonObject& request);
 void checkSubscriptions();
 void webSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t length);
 
-// Helper function to find average of a buffer
-float getBufferAverage(float* buffer, int size) {
-    float sum = 0;
-    for (int i = 0; i < size; i++) {
-        sum += buffer[i];
+// Output period of the MCP measurement resources
+#define MCP_OUTPUT_PERIOD_US 100000
+
+// MCP's decimation filters, fed from its own reader on the sample ring. The readers are
+// created when the server starts and pumped from handleMcpLoop(), so the averages are
+// already settled when the first resource read arrives.
+static SampleDecimator mcpDecimator(MCP_OUTPUT_PERIOD_US);
+
+// Pull all new samples through the MCP decimation filters
+void updateMcpAverages() {
+    static AdcSampleRing::Reader mcpSampleReader(sampleRing);
+    mcpDecimator.setInputPeriod(getInputSamplePeriodUs());
+    AdcSample sample;
+    while (mcpSampleReader.read(sample)) {
+        mcpDecimator.add(sample);
+    }
+}
+
+// Latest compressed trend points, fed from MCP's own reader on the trend ring; the
+// trend.points value only changes when a point is archived, so subscribers are only
+// notified then
+static TrendPoint mcpTrendHistory[TREND_HISTORY_POINTS];
+static uint8_t mcpTrendCount = 0;
+
+void updateMcpTrend() {
+    static TrendPointRing::Reader mcpTrendReader(trendRing);
+    TrendPoint point;
+    while (mcpTrendReader.read(point)) {
+        if (mcpTrendCount == TREND_HISTORY_POINTS) {
+            memmove(mcpTrendHistory, mcpTrendHistory + 1, (TREND_HISTORY_POINTS - 1) * sizeof(TrendPoint));
+            mcpTrendCount--;
+        }
+        mcpTrendHistory[mcpTrendCount++] = point;
     }
-    return sum / size;
 }
 
 // Add helper function at the top with other helper functions
@@ -93,14 +128,82 @@ bool strEqual(const char* a, const char* b) {
 
 // Resource getter functions
 String getShuntDiffValue() {
-    float avg = getBufferAverage(shuntBuffer, 10);
-    return String(avg);
+    updateMcpAverages();
+    return String(q31ToCounts(rescaleQ31(mcpDecimator.shunt(), SHUNT_WIDEST_GAIN, SHUNT_GAIN)));
 }
 
 String getAds2A0Value() {
-    if (!ads2_available) return "unavailable";
-    float avg = getBufferAverage(ads2Buffer, 10);
-    return String(avg);
+    if (!isChannelAvailable(ADC_VOLTAGE_CHANNEL)) return "unavailable";
+    updateMcpAverages();
+    return String(q31ToCounts(rescaleQ31(mcpDecimator.ads2(), ADS2_WIDEST_GAIN, ADS2_GAIN)));
+}
+
+// Keyed ads1..ads4 by device index, for every device in the channel table
+String getI2cTimingValue() {
+    uint8_t tableMask = adcTableDeviceMask(ADC_CHANNEL_TABLE, ADC_CHANNEL_COUNT);
+    String json = "{";
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (!(tableMask & (1 << device))) {
+            continue;
+        }
+        if (json.length() > 1) json += ",";
+        json += "\"ads" + String(device + 1) + "\":" + formatI2CTiming(getAdcDevice(device));
+    }
+    json += "}";
+    return json;
+}
+
+String getChannelsValue() {
+    return formatChannels();
+}
+
+String getSampleQualityValue() {
+    return formatSampleQuality();
+}
+
+String getSpectrumValue() {
+    return formatSpectrum();
+}
+
+String getTrendStatusValue() {
+    return formatTrendStatus();
+}
+
+String getTrendPointsValue() {
+    updateMcpTrend();
+    return formatTrendPoints(mcpTrendHistory, mcpTrendCount);
+}
+
+String getRecoveryValue() {
+    return formatRecoveryStatus();
+}
+
+String getSampleTimingValue() {
+    return formatSampleTimingStats();
+}
+
+String getCalibrationValue() {
+    static const char* stateNames[] = {"idle", "running", "complete"};
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "{\"state\":\"%s\",\"progress\":%u}",
+             stateNames[getCalibrationState()], getCalibrationProgress());
+    return String(buffer);
+}
+
+String getEnergyTotalsValue() {
+    return formatEnergyTotals();
+}
+
+String getPowerValue() {
+    return formatPower();
+}
+
+String getStatisticsValue() {
+    return formatStatistics();
+}
+
+String getCaptureStatusValue() {
+    return formatCaptureStatus();
 }
 
 String getRelay0Value() {
@@ -133,6 +236,14 @@ String getSamplingIntervalValue() {
     return String(getSamplingInterval());
 }
 
+String getSamplingStatusValue() {
+    return formatSamplingStatus();
+}
+
+String getBleFlowValue() {
+    return formatNotifyStatus();
+}
+
 // Tool execution functions
 void setRelayTool(const JsonObject& params, JsonObject& result) {
     int index = -1;
@@ -176,10 +287,11 @@ void connectWifiTool(const JsonObject& params, JsonObject& result) {
     }
 }
 
+// Calibration runs in the background; progress is published on the adc.calibration resource
 void calibrateAdcTool(const JsonObject& params, JsonObject& result) {
-    calibrateADC();
+    requestCalibration();
     result["success"] = true;
-    result["message"] = "ADC calibration completed";
+    result["message"] = "ADC calibration started";
 }
 
 void setSamplingIntervalTool(const JsonObject& params, JsonObject& result) {
@@ -199,6 +311,134 @@ void setSamplingIntervalTool(const JsonObject& params, JsonObject& result) {
     }
 }
 
+// Adaptive sampling on/off, optionally with new fast and slow interval limits
+void setAdaptiveSamplingTool(const JsonObject& params, JsonObject& result) {
+    if (!params.containsKey("enabled")) {
+        result["success"] = false;
+        result["message"] = "Missing enabled parameter";
+        return;
+    }
+    if (params.containsKey("fast_ms") || params.containsKey("slow_ms")) {
+        uint16_t fastMs = params.containsKey("fast_ms") ? params["fast_ms"].as<uint16_t>() : ADAPTIVE_DEFAULT_FAST_MS;
+        uint16_t slowMs = params.containsKey("slow_ms") ? params["slow_ms"].as<uint16_t>() : ADAPTIVE_DEFAULT_SLOW_MS;
+        if (!setAdaptiveLimits(fastMs, slowMs)) {
+            result["success"] = false;
+            result["message"] = "Limits must satisfy 5 <= fast_ms <= slow_ms <= 1000";
+            return;
+        }
+    }
+    bool enabled = params["enabled"].as<bool>();
+    setAdaptiveSampling(enabled);
+    result["success"] = true;
+    result["message"] = enabled ? "Adaptive sampling enabled" : "Adaptive sampling disabled, interval " +
+                                                                    String(getSamplingInterval()) + "ms";
+}
+
+void setStatisticsWindowTool(const JsonObject& params, JsonObject& result) {
+    if (params.containsKey("window") && params.containsKey("samples")) {
+        int window = params["window"].as<int>();
+        uint32_t samples = params["samples"].as<uint32_t>();
+        if (setStatisticsWindow(window, samples)) {
+            result["success"] = true;
+            result["message"] = "Statistics window " + String(window) + " set to " + String(samples) + " samples";
+        } else {
+            result["success"] = false;
+            result["message"] = "Window must be 0-" + String(STATS_WINDOW_COUNT - 1) + " and samples 1-" +
+                                String(STATS_HISTORY_SAMPLES);
+        }
+    } else {
+        result["success"] = false;
+        result["message"] = "Missing window or samples parameter";
+    }
+}
+
+// Trend compression error bound of one channel, in uA (current) or uV (voltage)
+void setTrendDeviationTool(const JsonObject& params, JsonObject& result) {
+    if (params.containsKey("channel") && params.containsKey("deviation")) {
+        String channel = params["channel"].as<String>();
+        int32_t deviation = params["deviation"].as<int32_t>();
+        uint8_t index = channel == "voltage" ? TREND_CHANNEL_VOLTAGE : TREND_CHANNEL_CURRENT;
+        if ((channel == "current" || channel == "voltage") && deviation >= 0 &&
+            setTrendDeviation(index, deviation)) {
+            result["success"] = true;
+            result["message"] = "Trend deviation of " + channel + " set to " + String(deviation);
+        } else {
+            result["success"] = false;
+            result["message"] = "Channel must be current or voltage and deviation 0-" + String(TREND_MAX_DEVIATION_UNITS);
+        }
+    } else {
+        result["success"] = false;
+        result["message"] = "Missing channel or deviation parameter";
+    }
+}
+
+// Arm a burst capture; depths in samples, threshold level in uA (current) or uV (voltage)
+void armCaptureTool(const JsonObject& params, JsonObject& result) {
+    CaptureConfig config;
+    config.preSamples = params.containsKey("pre") ? params["pre"].as<uint16_t>() : BURST_CAPTURE_DEFAULT_PRE;
+    config.postSamples = params.containsKey("post") ? params["post"].as<uint16_t>() : BURST_CAPTURE_DEFAULT_POST;
+    String trigger = params.containsKey("trigger") ? params["trigger"].as<String>() : String("relay");
+    config.thresholdEnabled = trigger == "threshold";
+    config.relayEnabled = trigger == "relay";
+    String channel = params.containsKey("channel") ? params["channel"].as<String>() : String("current");
+    config.channel = channel == "voltage" ? CAPTURE_CHANNEL_ADS2 : CAPTURE_CHANNEL_SHUNT;
+    String edge = params.containsKey("edge") ? params["edge"].as<String>() : String("rising");
+    config.edge = edge == "falling" ? CAPTURE_EDGE_FALLING : (edge == "either" ? CAPTURE_EDGE_EITHER : CAPTURE_EDGE_RISING);
+    int32_t level = params.containsKey("level") ? params["level"].as<int32_t>() : 0;
+    config.level = unitsToQ31(level, config.channel == CAPTURE_CHANNEL_ADS2 ? ADS2_MICROVOLTS_FULL_SCALE
+                                                                           : SHUNT_MICROAMPS_FULL_SCALE);
+
+    if (trigger != "threshold" && trigger != "relay" && trigger != "manual") {
+        result["success"] = false;
+        result["message"] = "Trigger must be threshold, relay or manual";
+    } else if (armCapture(config)) {
+        result["success"] = true;
+        result["message"] = "Capture armed";
+    } else {
+        result["success"] = false;
+        result["message"] = "pre + post must be 1-" + String(BURST_CAPTURE_CAPACITY) + " samples with post >= 1";
+    }
+}
+
+void triggerCaptureTool(const JsonObject& params, JsonObject& result) {
+    triggerCapture();
+    result["success"] = true;
+    result["message"] = "Capture triggered";
+}
+
+// Download a complete capture in chunks of "offset_us,ua,uv,quality;..." records
+void readCaptureTool(const JsonObject& params, JsonObject& result) {
+    uint16_t start = params.containsKey("start") ? params["start"].as<uint16_t>() : 0;
+    String chunk;
+    uint16_t count = formatCaptureChunk(start, MCP_CAPTURE_CHUNK_CHARS, chunk);
+    result["success"] = count > 0;
+    result["start"] = start;
+    result["count"] = count;
+    result["data"] = chunk;
+}
+
+// Select the channels to sample, by channel table index; the current channel is required
+void setScanListTool(const JsonObject& params, JsonObject& result) {
+    if (!params.containsKey("channels") || !params["channels"].is<JsonArray>()) {
+        result["success"] = false;
+        result["message"] = "Missing channels parameter";
+        return;
+    }
+    JsonArray channelsArray = params["channels"].as<JsonArray>();
+    uint8_t channels[ADC_MAX_CHANNELS];
+    uint8_t count = channelsArray.size() <= ADC_MAX_CHANNELS ? channelsArray.size() : 0;
+    for (uint8_t i = 0; i < count; i++) {
+        channels[i] = channelsArray[i].as<uint8_t>();
+    }
+    if (count > 0 && requestScanList(channels, count)) {
+        result["success"] = true;
+        result["message"] = "Scan list set to " + String(count) + " channels";
+    } else {
+        result["success"] = false;
+        result["message"] = "Channels must be distinct table indices and include channel " + String(ADC_CURRENT_CHANNEL);
+    }
+}
+
 void printToSerial(const JsonObject& params, JsonObject& result) {
     if (params.containsKey("message")) {
         String message = params["message"].as<String>();
@@ -489,14 +729,15 @@ void handleMcpRequest(uint8_t clientId, JsonObject& request) {
         // Find the requested tool
         for (int i = 0; i < toolCount; i++) {
             if (strEqual(tools[i].uri, uri.c_str())) {
-                StaticJsonDocument<512> resultDoc;
+                // Sized for capture.read chunks; on the heap to spare the WebSocket task's stack
+                DynamicJsonDocument resultDoc(MCP_TOOL_RESULT_SIZE);
                 JsonObject result = resultDoc.to<JsonObject>();
                 
                 // Execute the tool
                 tools[i].execute(toolParams, result);
                 
                 // Create response
-                StaticJsonDocument<512> responseDoc;
+                DynamicJsonDocument responseDoc(MCP_TOOL_RESULT_SIZE);
                 JsonObject response = responseDoc.to<JsonObject>();
                 response["id"] = id;
                 response["result"] = result;
@@ -566,12 +807,27 @@ void registerResourcesAndTools() {
     // Register resources - using string literals directly
     resources[resourceCount++] = Resource("adc.shunt_diff", "number", getShuntDiffValue);
     resources[resourceCount++] = Resource("adc.ads2_a0", "number", getAds2A0Value);
+    resources[resourceCount++] = Resource("adc.i2c_timing", "object", getI2cTimingValue);
+    resources[resourceCount++] = Resource("adc.sample_timing", "object", getSampleTimingValue);
+    resources[resourceCount++] = Resource("adc.calibration", "object", getCalibrationValue);
+    resources[resourceCount++] = Resource("energy.totals", "object", getEnergyTotalsValue);
+    resources[resourceCount++] = Resource("power.real", "object", getPowerValue);
+    resources[resourceCount++] = Resource("stats.windows", "object", getStatisticsValue);
+    resources[resourceCount++] = Resource("capture.status", "object", getCaptureStatusValue);
+    resources[resourceCount++] = Resource("adc.channels", "object", getChannelsValue);
+    resources[resourceCount++] = Resource("adc.recovery", "object", getRecoveryValue);
+    resources[resourceCount++] = Resource("adc.quality", "object", getSampleQualityValue);
+    resources[resourceCount++] = Resource("spectrum.shunt", "object", getSpectrumValue);
+    resources[resourceCount++] = Resource("trend.status", "object", getTrendStatusValue);
+    resources[resourceCount++] = Resource("trend.points", "object", getTrendPointsValue);
     resources[resourceCount++] = Resource("relay.0", "boolean", getRelay0Value);
     resources[resourceCount++] = Resource("relay.1", "boolean", getRelay1Value);
     resources[resourceCount++] = Resource("relay.2", "boolean", getRelay2Value);
     resources[resourceCount++] = Resource("relay.3", "boolean", getRelay3Value);
     resources[resourceCount++] = Resource("wifi.status", "string", getWifiStatusValue);
     resources[resourceCount++] = Resource("config.sampling_interval", "number", getSamplingIntervalValue);
+    resources[resourceCount++] = Resource("adc.sampling", "object", getSamplingStatusValue);
+    resources[resourceCount++] = Resource("ble.flow", "object", getBleFlowValue);
     
     // Register tools - using string literals directly
     tools[toolCount++] = Tool("relay.set", setRelayTool);
@@ -579,6 +835,13 @@ void registerResourcesAndTools() {
     tools[toolCount++] = Tool("wifi.connect", connectWifiTool);
     tools[toolCount++] = Tool("adc.calibrate", calibrateAdcTool);
     tools[toolCount++] = Tool("config.set_sampling_interval", setSamplingIntervalTool);
+    tools[toolCount++] = Tool("config.set_adaptive_sampling", setAdaptiveSamplingTool);
+    tools[toolCount++] = Tool("stats.set_window", setStatisticsWindowTool);
+    tools[toolCount++] = Tool("trend.set_deviation", setTrendDeviationTool);
+    tools[toolCount++] = Tool("capture.arm", armCaptureTool);
+    tools[toolCount++] = Tool("capture.trigger", triggerCaptureTool);
+    tools[toolCount++] = Tool("capture.read", readCaptureTool);
+    tools[toolCount++] = Tool("adc.set_scan_list", setScanListTool);
     tools[toolCount++] = Tool("copilot.register", registerCopilotTool);
     tools[toolCount++] = Tool("stdio.print", printToSerial);
     
@@ -634,6 +897,10 @@ void setupMcpServer() {
             setupCompleted = true;  // Mark setup as completed
             Serial.println("[MCP] WebSocket server initialized");
             
+            // Start the MCP readers on the sample and trend rings
+            updateMcpAverages();
+            updateMcpTrend();
+
             // Register resources and tools
             registerResourcesAndTools();
             Serial.println("[MCP] Resources and tools registered");
@@ -677,6 +944,8 @@ void handleMcpLoop() {
         
         // Only run WebSocket loop if server is started
         if (webSocketStarted) {
+            updateMcpAverages();
+            updateMcpTrend();
             webSocket.loop();
             checkSubscriptions();
         }
@@ -0,0 +1,74 @@
+#include "notify_queue.h"
+#include <string.h>
+
+NotifyQueue::NotifyQueue()
+    : head(0), count(0), maxDepth(0), credits(NOTIFY_CREDITS_UNLIMITED), sent(0), dropped(0), failed(0) {}
+
+bool NotifyQueue::push(const uint8_t* data, size_t length) {
+    if (length == 0 || length > NOTIFY_QUEUE_SLOT_SIZE) {
+        dropped++;
+        return false;
+    }
+    if (count == NOTIFY_QUEUE_DEPTH) {
+        head = (head + 1) % NOTIFY_QUEUE_DEPTH;
+        count--;
+        dropped++;
+    }
+    Slot& slot = slots[(head + count) % NOTIFY_QUEUE_DEPTH];
+    memcpy(slot.data, data, length);
+    slot.length = static_cast<uint16_t>(length);
+    count++;
+    if (count > maxDepth) {
+        maxDepth = count;
+    }
+    return true;
+}
+
+bool NotifyQueue::front(const uint8_t*& data, size_t& length) const {
+    if (count == 0 || credits.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    data = slots[head].data;
+    length = slots[head].length;
+    return true;
+}
+
+void NotifyQueue::pop() {
+    if (count == 0) {
+        return;
+    }
+    head = (head + 1) % NOTIFY_QUEUE_DEPTH;
+    count--;
+    sent++;
+    // A grant racing this keeps its credits: only a positive balance is decremented
+    int32_t balance = credits.load(std::memory_order_relaxed);
+    while (balance > 0 && !credits.compare_exchange_weak(balance, balance - 1, std::memory_order_relaxed)) {
+    }
+}
+
+void NotifyQueue::fail() {
+    if (count == 0) {
+        return;
+    }
+    head = (head + 1) % NOTIFY_QUEUE_DEPTH;
+    count--;
+    failed++;
+}
+
+void NotifyQueue::clear() {
+    head = 0;
+    count = 0;
+}
+
+void NotifyQueue::resetCredits() {
+    credits.store(NOTIFY_CREDITS_UNLIMITED, std::memory_order_relaxed);
+}
+
+void NotifyQueue::grant(uint32_t granted) {
+    int32_t balance = credits.load(std::memory_order_relaxed);
+    int32_t next;
+    do {
+        int64_t total = (balance == NOTIFY_CREDITS_UNLIMITED ? 0 : balance) + static_cast<int64_t>(granted);
+        next = static_cast<int32_t>(total > NOTIFY_CREDIT_LIMIT ? NOTIFY_CREDIT_LIMIT : total);
+    } while (!credits.compare_exchange_weak(balance, next, std::memory_order_relaxed));
+}
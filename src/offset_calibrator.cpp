@@ -0,0 +1,96 @@
+#include "offset_calibrator.h"
+
+OffsetCalibrator::OffsetCalibrator()
+    : widestIndex(0),
+      narrowestIndex(0),
+      gainIndex(0),
+      settleRemaining(0),
+      count(0),
+      sum(0),
+      running(false) {
+    record.version = CALIBRATION_RECORD_VERSION;
+    record.validMask = 0;
+    for (int i = 0; i < ADS1115_GAIN_COUNT; i++) {
+        record.offsets[i] = 0;
+    }
+}
+
+void OffsetCalibrator::start(Ads1115Gain widest, Ads1115Gain narrowest) {
+    widestIndex = ads1115GainIndex(widest);
+    narrowestIndex = ads1115GainIndex(narrowest);
+    gainIndex = widestIndex;
+    settleRemaining = CALIBRATION_SETTLE_SAMPLES;
+    count = 0;
+    sum = 0;
+    record.version = CALIBRATION_RECORD_VERSION;
+    record.validMask = 0;
+    running = true;
+}
+
+void OffsetCalibrator::abort() {
+    running = false;
+}
+
+void OffsetCalibrator::feed(int16_t raw, Ads1115Gain gain) {
+    if (!running || ads1115GainIndex(gain) != gainIndex) {
+        return;
+    }
+    if (settleRemaining > 0) {
+        settleRemaining--;
+        return;
+    }
+
+    sum += raw;
+    if (++count < CALIBRATION_SAMPLES_PER_GAIN) {
+        return;
+    }
+
+    record.offsets[gainIndex] = saturateQ31(static_cast<int64_t>(sum) * Q31_ONE_COUNT / count);
+    record.validMask |= 1 << gainIndex;
+    sum = 0;
+    count = 0;
+    settleRemaining = CALIBRATION_SETTLE_SAMPLES;
+    if (++gainIndex > narrowestIndex) {
+        running = false;
+    }
+}
+
+bool OffsetCalibrator::isRunning() const {
+    return running;
+}
+
+Ads1115Gain OffsetCalibrator::getTargetGain() const {
+    return ads1115GainFromIndex(gainIndex > narrowestIndex ? narrowestIndex : gainIndex);
+}
+
+uint8_t OffsetCalibrator::getProgress() const {
+    const uint32_t perGain = CALIBRATION_SETTLE_SAMPLES + CALIBRATION_SAMPLES_PER_GAIN;
+    uint32_t total = (narrowestIndex - widestIndex + 1) * perGain;
+    if (!running) {
+        return record.validMask ? 100 : 0;
+    }
+    uint32_t done = (gainIndex - widestIndex) * perGain + (CALIBRATION_SETTLE_SAMPLES - settleRemaining) + count;
+    return static_cast<uint8_t>(done * 100 / total);
+}
+
+const CalibrationRecord& OffsetCalibrator::getRecord() const {
+    return record;
+}
+
+bool applyCalibrationRecord(const CalibrationRecord& record, Ads1115Gain widest, Ads1115Gain narrowest,
+                            GainOffsetTable& table) {
+    if (record.version != CALIBRATION_RECORD_VERSION) {
+        return false;
+    }
+    for (int i = ads1115GainIndex(widest); i <= ads1115GainIndex(narrowest); i++) {
+        if (!(record.validMask & (1 << i))) {
+            return false;
+        }
+    }
+    for (int i = 0; i < ADS1115_GAIN_COUNT; i++) {
+        if (record.validMask & (1 << i)) {
+            table.setOffset(ads1115GainFromIndex(i), record.offsets[i]);
+        }
+    }
+    return true;
+}
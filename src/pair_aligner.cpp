@@ -0,0 +1,125 @@
+#include "pair_aligner.h"
+
+PairAligner::PairAligner() {
+    reset();
+}
+
+void PairAligner::reset() {
+    pendingHead = 0;
+    pendingCount = 0;
+    hasPrevious = false;
+    hasLatest = false;
+    lastCurrentUs = INT64_MIN;
+    outputHead = 0;
+    outputCount = 0;
+    aligned = 0;
+    unaligned = 0;
+}
+
+void PairAligner::add(const AdcSample& sample) {
+    // A voltage channel that never converted (not scanned, or its device missing at boot)
+    // or is lost: nothing can be interpolated, so currents pass through against the held
+    // value and its flags. Charge is still integrated; power and energy skip these pairs.
+    bool voltageLost = sample.ads2Quality & (SAMPLE_QUALITY_STALE | SAMPLE_QUALITY_RECOVERING);
+    bool neverConverted = !hasLatest && sample.ads2Us == 0 && !isSampleFresh(sample.ads2Quality);
+    if (voltageLost || neverConverted) {
+        if (voltageLost) {
+            hasPrevious = false;
+            hasLatest = false;
+            flushPending(sample.ads2, sample.ads2Quality);
+        }
+        if (isSampleFresh(sample.shuntQuality) && sample.shuntUs > lastCurrentUs) {
+            lastCurrentUs = sample.shuntUs;
+            AlignedPair pair = {sample.shuntUs, sample.shunt, sample.ads2, sample.shuntQuality, sample.ads2Quality};
+            push(pair);
+        }
+        return;
+    }
+
+    if (isSampleFresh(sample.shuntQuality) && sample.shuntUs > lastCurrentUs) {
+        lastCurrentUs = sample.shuntUs;
+        if (pendingCount == PAIR_ALIGNER_PENDING) {
+            pendingHead = (pendingHead + 1) % PAIR_ALIGNER_PENDING;
+            pendingCount--;
+            unaligned++;
+        }
+        Point& point = pending[(pendingHead + pendingCount) % PAIR_ALIGNER_PENDING];
+        point.timeUs = sample.shuntUs;
+        point.value = sample.shunt;
+        point.quality = sample.shuntQuality;
+        pendingCount++;
+        // May fall inside the current voltage bracket (a late-arriving conversion)
+        resolve();
+    }
+
+    if (isSampleFresh(sample.ads2Quality) && (!hasLatest || sample.ads2Us > latestVoltage.timeUs)) {
+        Point point = {sample.ads2Us, sample.ads2, sample.ads2Quality};
+        addVoltage(point);
+        resolve();
+    }
+}
+
+void PairAligner::addVoltage(const Point& point) {
+    previousVoltage = latestVoltage;
+    hasPrevious = hasLatest;
+    latestVoltage = point;
+    hasLatest = true;
+}
+
+void PairAligner::resolve() {
+    while (pendingCount > 0 && hasLatest) {
+        const Point& current = pending[pendingHead];
+        if (current.timeUs > latestVoltage.timeUs) {
+            break;  // Wait for the voltage to convert after it
+        }
+        AlignedPair pair = {current.timeUs, current.value, latestVoltage.value, current.quality,
+                            latestVoltage.quality};
+        int64_t spanUs = hasPrevious ? latestVoltage.timeUs - previousVoltage.timeUs : 0;
+        if (current.timeUs == latestVoltage.timeUs) {
+            push(pair);
+        } else if (hasPrevious && current.timeUs >= previousVoltage.timeUs && spanUs <= PAIR_ALIGNER_MAX_SPAN_US) {
+            int64_t step = static_cast<int64_t>(latestVoltage.value) - previousVoltage.value;
+            pair.voltage = static_cast<q31_t>(previousVoltage.value +
+                                              step * (current.timeUs - previousVoltage.timeUs) / spanUs);
+            pair.voltageQuality = previousVoltage.quality | latestVoltage.quality;
+            push(pair);
+        } else {
+            unaligned++;
+        }
+        pendingHead = (pendingHead + 1) % PAIR_ALIGNER_PENDING;
+        pendingCount--;
+    }
+}
+
+// Currents still waiting for a voltage when it is lost go out in order against the held
+// voltage, flagged like it
+void PairAligner::flushPending(q31_t voltage, uint8_t voltageQuality) {
+    while (pendingCount > 0) {
+        const Point& current = pending[pendingHead];
+        AlignedPair pair = {current.timeUs, current.value, voltage, current.quality, voltageQuality};
+        push(pair);
+        pendingHead = (pendingHead + 1) % PAIR_ALIGNER_PENDING;
+        pendingCount--;
+    }
+}
+
+// Readers drain after every add, so the output only overflows if nobody reads
+void PairAligner::push(const AlignedPair& pair) {
+    if (outputCount == PAIR_ALIGNER_PENDING) {
+        outputHead = (outputHead + 1) % PAIR_ALIGNER_PENDING;
+        outputCount--;
+    }
+    output[(outputHead + outputCount) % PAIR_ALIGNER_PENDING] = pair;
+    outputCount++;
+    aligned++;
+}
+
+bool PairAligner::read(AlignedPair& pair) {
+    if (outputCount == 0) {
+        return false;
+    }
+    pair = output[outputHead];
+    outputHead = (outputHead + 1) % PAIR_ALIGNER_PENDING;
+    outputCount--;
+    return true;
+}
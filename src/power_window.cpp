@@ -0,0 +1,105 @@
+#include "power_window.h"
+#include <math.h>
+
+static int64_t clampLength(int64_t lengthUs) {
+    return lengthUs > POWER_WINDOW_MAX_US ? POWER_WINDOW_MAX_US : lengthUs;
+}
+
+// Sample scale after POWER_WINDOW_SQUARE_SHIFT, squared
+static int64_t reducedSquare(q31_t value) {
+    int64_t reduced = static_cast<int64_t>(value) >> POWER_WINDOW_SQUARE_SHIFT;
+    return reduced * reduced;
+}
+
+// RMS in engineering units of a mean reduced square
+static double reducedRms(double meanSquare, int64_t unitsPerFullScale) {
+    return sqrt(meanSquare) * unitsPerFullScale / static_cast<double>(1LL << (31 - POWER_WINDOW_SQUARE_SHIFT));
+}
+
+PowerWindow::PowerWindow(int64_t lengthUs)
+    : lengthUs(lengthUs > 0 ? clampLength(lengthUs) : POWER_WINDOW_DEFAULT_US) {
+    reset();
+}
+
+void PowerWindow::reset() {
+    summary = PowerSummary();
+    hasPrevious = false;
+    previousUs = 0;
+    previousPowerUw = 0;
+    previousVoltageSquared = 0;
+    previousCurrentSquared = 0;
+    instantUw = 0;
+    windowUs = 0;
+    coveredUs = 0;
+    pairs = 0;
+    powerArea = 0;
+    voltageArea = 0;
+    currentArea = 0;
+}
+
+void PowerWindow::setLength(int64_t length) {
+    if (length > 0) {
+        lengthUs = clampLength(length);
+    }
+}
+
+bool PowerWindow::add(const AlignedPair& pair) {
+    if (!isSampleFresh(pair.currentQuality) ||
+        (pair.voltageQuality & (SAMPLE_QUALITY_STALE | SAMPLE_QUALITY_RECOVERING))) {
+        return false;
+    }
+    int64_t microamps = q31ToUnits(pair.current, SHUNT_MICROAMPS_FULL_SCALE);
+    int64_t microvolts = q31ToUnits(pair.voltage, ADS2_MICROVOLTS_FULL_SCALE);
+    int64_t powerUw = microamps * microvolts / 1000000;
+    int64_t voltageSquared = reducedSquare(pair.voltage);
+    int64_t currentSquared = reducedSquare(pair.current);
+    instantUw = powerUw;
+
+    bool completed = false;
+    if (hasPrevious) {
+        int64_t elapsedUs = pair.timeUs - previousUs;
+        if (elapsedUs <= 0) {
+            return false;
+        }
+        if (elapsedUs <= POWER_WINDOW_MAX_GAP_US) {
+            powerArea += (previousPowerUw + powerUw) * elapsedUs;
+            voltageArea += (previousVoltageSquared + voltageSquared) * elapsedUs;
+            currentArea += (previousCurrentSquared + currentSquared) * elapsedUs;
+            coveredUs += elapsedUs;
+            pairs++;
+        }
+        windowUs += elapsedUs;
+        if (windowUs >= lengthUs) {
+            if (coveredUs > 0) {
+                summarize(pair.timeUs);
+                completed = true;
+            }
+            windowUs = 0;
+            coveredUs = 0;
+            pairs = 0;
+            powerArea = 0;
+            voltageArea = 0;
+            currentArea = 0;
+        }
+    }
+
+    hasPrevious = true;
+    previousUs = pair.timeUs;
+    previousPowerUw = powerUw;
+    previousVoltageSquared = voltageSquared;
+    previousCurrentSquared = currentSquared;
+    return completed;
+}
+
+// Once per window: the doubled areas become means, RMS values and the power factor
+void PowerWindow::summarize(int64_t endUs) {
+    double span = 2.0 * coveredUs;
+    summary.endUs = endUs;
+    summary.coveredUs = coveredUs;
+    summary.pairs = pairs;
+    summary.realPowerUw = powerArea / span;
+    summary.voltageRmsUv = reducedRms(voltageArea / span, ADS2_MICROVOLTS_FULL_SCALE);
+    summary.currentRmsUa = reducedRms(currentArea / span, SHUNT_MICROAMPS_FULL_SCALE);
+    summary.apparentPowerUva = summary.voltageRmsUv * summary.currentRmsUa / 1000000;
+    summary.powerFactor = summary.apparentPowerUva > 0 ? summary.realPowerUw / summary.apparentPowerUva : 0;
+}
@@ -0,0 +1,121 @@
+#include "real_fft.h"
+
+#if defined(ESP_PLATFORM) && !defined(NATIVE_TEST)
+#include <sdkconfig.h>
+#endif
+
+// esp-dsp selects its PIE (ESP32-S3 vector extension) FFT when built for that target
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && defined(__has_include)
+#if __has_include(<esp_dsp.h>)
+#include <esp_dsp.h>
+#define FFT_HAS_VECTOR_KERNEL 1
+#endif
+#endif
+
+// Reorder the points so the in-place butterflies produce bins in natural order
+static void bitReverse(float* data, int points) {
+    int j = 0;
+    for (int i = 1; i < points; i++) {
+        int bit = points >> 1;
+        while (j & bit) {
+            j ^= bit;
+            bit >>= 1;
+        }
+        j |= bit;
+        if (i < j) {
+            float re = data[2 * i];
+            float im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+    }
+}
+
+// Decimation in time. Each stage walks the twiddles once and applies every one to all
+// the butterflies that share it, so a twiddle is loaded once per stage.
+void fftRadix2Scalar(float* data, int points, const float* twiddles, int stride) {
+    bitReverse(data, points);
+    for (int span = 1; span < points; span <<= 1) {
+        int step = stride * points / (2 * span);
+        for (int k = 0; k < span; k++) {
+            float wr = twiddles[2 * k * step];
+            float wi = twiddles[2 * k * step + 1];
+            for (int top = k; top < points; top += 2 * span) {
+                int bottom = top + span;
+                float br = data[2 * bottom];
+                float bi = data[2 * bottom + 1];
+                float tr = br * wr - bi * wi;
+                float ti = br * wi + bi * wr;
+                float ar = data[2 * top];
+                float ai = data[2 * top + 1];
+                data[2 * top] = ar + tr;
+                data[2 * top + 1] = ai + ti;
+                data[2 * bottom] = ar - tr;
+                data[2 * bottom + 1] = ai - ti;
+            }
+        }
+    }
+}
+
+#ifdef FFT_HAS_VECTOR_KERNEL
+// esp-dsp keeps its own twiddle table, built on first use
+static bool vectorReady = false;
+static bool vectorFailed = false;
+
+bool fftVectorKernelAvailable() {
+    if (!vectorReady && !vectorFailed) {
+        vectorReady = dsps_fft2r_init_fc32(NULL, FFT_VECTOR_MAX_POINTS) == ESP_OK;
+        vectorFailed = !vectorReady;
+    }
+    return vectorReady;
+}
+
+void fftRadix2Vector(float* data, int points) {
+    dsps_fft2r_fc32(data, points);
+    dsps_bit_rev_fc32(data, points);
+}
+#else
+bool fftVectorKernelAvailable() {
+    return false;
+}
+
+void fftRadix2Vector(float* data, int points) {
+    (void)data;
+    (void)points;
+}
+#endif
+
+// With Z the transform of z[n] = x[2n] + i x[2n + 1] over M = size / 2 points:
+//   E[k] = (Z[k] + conj(Z[M - k])) / 2      (transform of the even samples)
+//   O[k] = (Z[k] - conj(Z[M - k])) / 2i     (transform of the odd samples)
+//   X[k] = E[k] + W^k O[k],  X[M - k] = conj(E[k] - W^k O[k])
+// so bins k and M - k are produced together from the same two points.
+void fftSplitReal(float* data, int size, const float* twiddles) {
+    int half = size / 2;
+    float dc = data[0] + data[1];
+    float nyquist = data[0] - data[1];
+    data[0] = dc;
+    data[1] = nyquist;
+    for (int k = 1; k <= half / 2; k++) {
+        int m = half - k;
+        float zr = data[2 * k];
+        float zi = data[2 * k + 1];
+        float cr = data[2 * m];
+        float ci = -data[2 * m + 1];
+        float evenRe = 0.5f * (zr + cr);
+        float evenIm = 0.5f * (zi + ci);
+        // (a + ib) / 2i = (b - ia) / 2
+        float oddRe = 0.5f * (zi - ci);
+        float oddIm = -0.5f * (zr - cr);
+        float wr = twiddles[2 * k];
+        float wi = twiddles[2 * k + 1];
+        float tr = oddRe * wr - oddIm * wi;
+        float ti = oddRe * wi + oddIm * wr;
+        data[2 * k] = evenRe + tr;
+        data[2 * k + 1] = evenIm + ti;
+        data[2 * m] = evenRe - tr;
+        data[2 * m + 1] = ti - evenIm;
+    }
+}
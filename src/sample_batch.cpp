@@ -0,0 +1,147 @@
+#include "sample_batch.h"
+
+static size_t putVarint(uint8_t* out, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(value);
+    return n;
+}
+
+static uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// False when the varint runs past the end or beyond 64 bits
+static bool getVarint(const uint8_t* data, size_t length, size_t& offset, uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (offset >= length) {
+            return false;
+        }
+        uint8_t byte = data[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static size_t clampPayload(size_t payloadLimit) {
+    if (payloadLimit < SAMPLE_BATCH_MIN_PAYLOAD) return SAMPLE_BATCH_MIN_PAYLOAD;
+    if (payloadLimit > SAMPLE_BATCH_MAX_PAYLOAD) return SAMPLE_BATCH_MAX_PAYLOAD;
+    return payloadLimit;
+}
+
+SampleBatcher::SampleBatcher(size_t payloadLimit)
+    : pendingLimit(clampPayload(payloadLimit)), sequence(0), batches(0), samples(0) {
+    startBatch();
+}
+
+void SampleBatcher::setPayloadLimit(size_t payloadLimit) {
+    pendingLimit = clampPayload(payloadLimit);
+    // A larger limit can take effect at once; a smaller one could cut the batch being filled
+    if (pendingLimit > limit || empty()) {
+        limit = pendingLimit;
+    }
+}
+
+void SampleBatcher::startBatch() {
+    limit = pendingLimit;
+    buffer[0] = SAMPLE_BATCH_MAGIC;
+    buffer[1] = SAMPLE_BATCH_VERSION;
+    buffer[2] = static_cast<uint8_t>(sequence);
+    buffer[3] = static_cast<uint8_t>(sequence >> 8);
+    buffer[4] = 0;
+    length = SAMPLE_BATCH_HEADER_SIZE;
+    baseTimeUs = 0;
+}
+
+bool SampleBatcher::add(const BatchSample& sample) {
+    uint8_t encoded[SAMPLE_BATCH_MAX_SAMPLE_SIZE];
+    size_t n = 0;
+    uint64_t quality = sample.currentQuality | (static_cast<uint64_t>(sample.voltageQuality) << 8);
+    if (empty()) {
+        n += putVarint(encoded + n, static_cast<uint64_t>(sample.timeUs));
+        n += putVarint(encoded + n, zigzag(sample.currentUa));
+        n += putVarint(encoded + n, zigzag(sample.voltageUv));
+    } else {
+        // Samples come in time order; a step back is sent as no time passing
+        int64_t dt = sample.timeUs - previous.timeUs;
+        n += putVarint(encoded + n, static_cast<uint64_t>(dt > 0 ? dt : 0));
+        n += putVarint(encoded + n, zigzag(static_cast<int64_t>(sample.currentUa) - previous.currentUa));
+        n += putVarint(encoded + n, zigzag(static_cast<int64_t>(sample.voltageUv) - previous.voltageUv));
+    }
+    n += putVarint(encoded + n, quality);
+
+    if (length + n > limit || count() == UINT8_MAX) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        buffer[length + i] = encoded[i];
+    }
+    length += n;
+    int64_t sentTimeUs = previous.timeUs;
+    if (empty()) {
+        baseTimeUs = sample.timeUs;
+        sentTimeUs = sample.timeUs;
+    }
+    previous = sample;
+    // After a step back, keep the time the client reconstructs so later deltas stay exact
+    if (sample.timeUs < sentTimeUs) {
+        previous.timeUs = sentTimeUs;
+    }
+    buffer[4]++;
+    samples++;
+    return true;
+}
+
+void SampleBatcher::clear() {
+    if (!empty()) {
+        batches++;
+        sequence++;
+    }
+    startBatch();
+}
+
+void SampleBatcher::reset() {
+    sequence = 0;
+    startBatch();
+}
+
+bool decodeSampleBatch(const uint8_t* data, size_t length, BatchSample* samples, uint8_t capacity,
+                       uint8_t& count, uint16_t& sequence) {
+    if (length < SAMPLE_BATCH_HEADER_SIZE || data[0] != SAMPLE_BATCH_MAGIC || data[1] != SAMPLE_BATCH_VERSION ||
+        data[4] > capacity) {
+        return false;
+    }
+    sequence = static_cast<uint16_t>(data[2] | (data[3] << 8));
+    count = data[4];
+    size_t offset = SAMPLE_BATCH_HEADER_SIZE;
+    int64_t timeUs = 0;
+    int64_t current = 0;
+    int64_t voltage = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint64_t time, dCurrent, dVoltage, quality;
+        if (!getVarint(data, length, offset, time) || !getVarint(data, length, offset, dCurrent) ||
+            !getVarint(data, length, offset, dVoltage) || !getVarint(data, length, offset, quality)) {
+            return false;
+        }
+        timeUs += static_cast<int64_t>(time);
+        current += unzigzag(dCurrent);
+        voltage += unzigzag(dVoltage);
+        samples[i].timeUs = timeUs;
+        samples[i].currentUa = static_cast<int32_t>(current);
+        samples[i].voltageUv = static_cast<int32_t>(voltage);
+        samples[i].currentQuality = static_cast<uint8_t>(quality);
+        samples[i].voltageQuality = static_cast<uint8_t>(quality >> 8);
+    }
+    return offset == length;
+}
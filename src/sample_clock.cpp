@@ -0,0 +1,131 @@
+#include "sample_clock.h"
+#include <esp_timer.h>
+#include "config.h"
+
+static esp_timer_handle_t sampleTimer = NULL;
+static TaskHandle_t sampleTask = NULL;
+static uint32_t samplePeriodUs = 0;
+
+// Written by the esp_timer callback, read by the acquisition task
+static volatile uint32_t tickCount = 0;
+static volatile int64_t lastTickTimeUs = 0;
+static uint32_t serviced = 0;
+
+// Statistics are written by the acquisition task and copied out by MCP under this lock
+static PeriodStats sampleTimingStats;
+static portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Runs in the high-priority esp_timer task; keep it to a timestamp and a notification
+static void sampleClockCallback(void* arg) {
+    lastTickTimeUs = esp_timer_get_time();
+    tickCount = tickCount + 1;
+    if (sampleTask != NULL) {
+        xTaskNotify(sampleTask, SAMPLE_CLOCK_BIT, eSetBits);
+    }
+}
+
+bool startSampleClock(TaskHandle_t task, uint32_t periodUs) {
+    sampleTask = task;
+    if (sampleTimer == NULL) {
+        esp_timer_create_args_t timerArgs = {};
+        timerArgs.callback = sampleClockCallback;
+        timerArgs.arg = NULL;
+        timerArgs.dispatch_method = ESP_TIMER_TASK;
+        timerArgs.name = "sample_clock";
+        if (esp_timer_create(&timerArgs, &sampleTimer) != ESP_OK) {
+            LOG_ERROR("Failed to create sample clock timer");
+            sampleTimer = NULL;
+            return false;
+        }
+    }
+    return setSampleClockPeriod(periodUs);
+}
+
+void stopSampleClock() {
+    if (sampleTimer != NULL) {
+        esp_timer_stop(sampleTimer);
+    }
+    samplePeriodUs = 0;
+}
+
+bool setSampleClockPeriod(uint32_t periodUs) {
+    if (sampleTimer == NULL || periodUs == 0) {
+        return false;
+    }
+    esp_timer_stop(sampleTimer); // Fails harmlessly if the timer is not running
+    serviced = tickCount;
+    samplePeriodUs = periodUs;
+    resetSampleTiming(periodUs);
+    if (esp_timer_start_periodic(sampleTimer, periodUs) != ESP_OK) {
+        LOG_ERROR("Failed to start sample clock at %lu us", (unsigned long)periodUs);
+        samplePeriodUs = 0;
+        return false;
+    }
+    LOG_INFO("Sample clock running at %lu us", (unsigned long)periodUs);
+    return true;
+}
+
+uint32_t getSampleClockPeriod() {
+    return samplePeriodUs;
+}
+
+bool waitForSampleTick(TickType_t timeout, int64_t& tickTimeUs, uint32_t& missedTicks) {
+    if (serviced == tickCount) {
+        uint32_t bits = 0;
+        if (xTaskNotifyWait(0, SAMPLE_CLOCK_BIT, &bits, timeout) != pdTRUE || !(bits & SAMPLE_CLOCK_BIT)) {
+            return false;
+        }
+    } else {
+        // Already behind: consume the pending notification without blocking
+        xTaskNotifyWait(0, SAMPLE_CLOCK_BIT, NULL, 0);
+    }
+
+    uint32_t ticks = tickCount;
+    tickTimeUs = lastTickTimeUs;
+    missedTicks = ticks - serviced - 1;
+    serviced = ticks;
+    return true;
+}
+
+void recordSampleTiming(int64_t timestampUs, uint32_t missedTicks) {
+    portENTER_CRITICAL(&statsLock);
+    sampleTimingStats.recordTick(timestampUs, missedTicks);
+    portEXIT_CRITICAL(&statsLock);
+}
+
+void resetSampleTiming(uint32_t nominalPeriodUs) {
+    portENTER_CRITICAL(&statsLock);
+    sampleTimingStats.reset(nominalPeriodUs);
+    portEXIT_CRITICAL(&statsLock);
+}
+
+PeriodStats getSampleTimingStats() {
+    portENTER_CRITICAL(&statsLock);
+    PeriodStats copy = sampleTimingStats;
+    portEXIT_CRITICAL(&statsLock);
+    return copy;
+}
+
+String formatSampleTimingStats() {
+    PeriodStats stats = getSampleTimingStats();
+    String json = "{\"nominal_us\":" + String(stats.getNominalPeriodUs());
+    json += ",\"mean_us\":" + String(stats.getMeanPeriodUs());
+    json += ",\"rate_hz\":" + String(stats.getAchievedRateHz(), 2);
+    json += ",\"ticks\":" + String(stats.getTickCount());
+    json += ",\"min_err_us\":" + String(stats.getMinErrorUs());
+    json += ",\"max_err_us\":" + String(stats.getMaxErrorUs());
+    json += ",\"overruns\":" + String(stats.getOverrunCount());
+    json += ",\"missed\":" + String(stats.getMissedTickCount());
+    json += ",\"jitter_hist\":[";
+    for (int i = 0; i < JITTER_BUCKET_COUNT; i++) {
+        if (i > 0) json += ",";
+        json += String(stats.getJitterBucket(i));
+    }
+    json += "],\"overrun_hist\":[";
+    for (int i = 0; i < OVERRUN_BUCKET_COUNT; i++) {
+        if (i > 0) json += ",";
+        json += String(stats.getOverrunBucket(i));
+    }
+    json += "]}";
+    return json;
+}
@@ -0,0 +1,43 @@
+#include "sample_quality.h"
+
+SampleQualityCounter::SampleQualityCounter() {
+    reset();
+}
+
+void SampleQualityCounter::reset() {
+    counts.samples = 0;
+    counts.fresh = 0;
+    counts.stale = 0;
+    counts.recovering = 0;
+    counts.clipped = 0;
+    counts.gainChanges = 0;
+    counts.totalUs = 0;
+    counts.degradedUs = 0;
+    hasPrevious = false;
+    previousUs = 0;
+}
+
+void SampleQualityCounter::add(int64_t timestampUs, uint8_t quality) {
+    counts.samples++;
+    counts.fresh += isSampleFresh(quality) ? 1 : 0;
+    counts.stale += (quality & SAMPLE_QUALITY_STALE) ? 1 : 0;
+    counts.recovering += (quality & SAMPLE_QUALITY_RECOVERING) ? 1 : 0;
+    counts.clipped += (quality & SAMPLE_QUALITY_CLIPPED) ? 1 : 0;
+    counts.gainChanges += (quality & SAMPLE_QUALITY_GAIN_CHANGED) ? 1 : 0;
+
+    if (hasPrevious) {
+        int64_t elapsedUs = timestampUs - previousUs;
+        if (elapsedUs > 0 && elapsedUs <= SAMPLE_QUALITY_MAX_INTERVAL_US) {
+            counts.totalUs += elapsedUs;
+            if (isSampleDegraded(quality)) {
+                counts.degradedUs += elapsedUs;
+            }
+        }
+    }
+    hasPrevious = true;
+    previousUs = timestampUs;
+}
+
+const QualityCounts& SampleQualityCounter::getCounts() const {
+    return counts;
+}
@@ -1,10 +1,31 @@
 #include "sampling_config.h"
+#include "adc_module.h"
+#include "config.h"
 
 // Define the global variable here (internal linkage)
 static volatile uint16_t _samplingIntervalMs = 17; // Default ~60Hz
 
 volatile uint16_t samplingIntervalMs = 17; // Default ~60Hz, global definition for linker
 
+// Owned by the acquisition task
+static AdaptiveRate adaptiveRate(ADAPTIVE_DEFAULT_FAST_MS, ADAPTIVE_DEFAULT_SLOW_MS,
+                                 unitsToQ31(ADAPTIVE_CURRENT_THRESHOLD_UA, SHUNT_MICROAMPS_FULL_SCALE),
+                                 unitsToQ31(ADAPTIVE_VOLTAGE_THRESHOLD_UV, ADS2_MICROVOLTS_FULL_SCALE));
+
+// Requested from any task, applied by the acquisition task
+static volatile bool adaptiveEnabled = false;
+static volatile bool adaptiveResetPending = false;
+static volatile uint16_t adaptiveFastMs = ADAPTIVE_DEFAULT_FAST_MS;
+static volatile uint16_t adaptiveSlowMs = ADAPTIVE_DEFAULT_SLOW_MS;
+static volatile bool adaptiveLimitsPending = false;
+static volatile uint16_t effectiveIntervalMs = ADAPTIVE_DEFAULT_FAST_MS;
+
+// Written by the acquisition task, copied out under this lock
+static ChannelActivity currentActivitySnapshot = adaptiveRate.getCurrentActivity();
+static ChannelActivity voltageActivitySnapshot = adaptiveRate.getVoltageActivity();
+static uint32_t adaptiveSwitchesSnapshot = 0;
+static portMUX_TYPE adaptiveLock = portMUX_INITIALIZER_UNLOCKED;
+
 void setSamplingInterval(uint16_t intervalMs) {
     if (intervalMs >= 5 && intervalMs <= 1000) {
         _samplingIntervalMs = intervalMs;
@@ -13,4 +34,96 @@ void setSamplingInterval(uint16_t intervalMs) {
 
 uint16_t getSamplingInterval() {
     return _samplingIntervalMs;
-}
\ No newline at end of file
+}
+
+void loadAdaptiveSampling() {
+    uint16_t fastMs = prefs.getUShort("adaptFast", ADAPTIVE_DEFAULT_FAST_MS);
+    uint16_t slowMs = prefs.getUShort("adaptSlow", ADAPTIVE_DEFAULT_SLOW_MS);
+    if (fastMs >= 5 && slowMs >= fastMs && slowMs <= 1000) {
+        adaptiveFastMs = fastMs;
+        adaptiveSlowMs = slowMs;
+        adaptiveLimitsPending = true;
+    }
+    if (prefs.getBool("adaptive", false)) {
+        setAdaptiveSampling(true);
+        LOG_INFO("Adaptive sampling between %u and %u ms", adaptiveFastMs, adaptiveSlowMs);
+    }
+}
+
+// Starts at the fast end, so nothing is missed while the windows fill
+void setAdaptiveSampling(bool enabled) {
+    if (enabled && !adaptiveEnabled) {
+        effectiveIntervalMs = adaptiveFastMs;
+        adaptiveResetPending = true;
+    }
+    adaptiveEnabled = enabled;
+    prefs.putBool("adaptive", enabled);
+}
+
+bool isAdaptiveSampling() {
+    return adaptiveEnabled;
+}
+
+// Same range as the fixed interval
+bool setAdaptiveLimits(uint16_t fastMs, uint16_t slowMs) {
+    if (fastMs < 5 || slowMs < fastMs || slowMs > 1000) {
+        return false;
+    }
+    adaptiveFastMs = fastMs;
+    adaptiveSlowMs = slowMs;
+    adaptiveLimitsPending = true;
+    prefs.putUShort("adaptFast", fastMs);
+    prefs.putUShort("adaptSlow", slowMs);
+    return true;
+}
+
+// Continuous mode runs at the chips' data rate; there is no interval to adapt
+void updateAdaptiveSampling(const AdcSample& sample) {
+    if (!adaptiveEnabled || getAcquisitionMode() == ACQ_MODE_CONTINUOUS) {
+        return;
+    }
+    if (adaptiveLimitsPending) {
+        adaptiveLimitsPending = false;
+        adaptiveRate.setLimits(adaptiveFastMs, adaptiveSlowMs);
+    }
+    if (adaptiveResetPending) {
+        adaptiveResetPending = false;
+        adaptiveRate.reset();
+    }
+    adaptiveRate.update(sample.timestampUs, sample.shunt, sample.shuntQuality, sample.ads2, sample.ads2Quality);
+    effectiveIntervalMs = adaptiveRate.getInterval();
+
+    portENTER_CRITICAL(&adaptiveLock);
+    currentActivitySnapshot = adaptiveRate.getCurrentActivity();
+    voltageActivitySnapshot = adaptiveRate.getVoltageActivity();
+    adaptiveSwitchesSnapshot = adaptiveRate.getSwitchCount();
+    portEXIT_CRITICAL(&adaptiveLock);
+}
+
+uint16_t getEffectiveSamplingInterval() {
+    return adaptiveEnabled ? effectiveIntervalMs : _samplingIntervalMs;
+}
+
+String formatSamplingStatus() {
+    portENTER_CRITICAL(&adaptiveLock);
+    ChannelActivity current = currentActivitySnapshot;
+    ChannelActivity voltage = voltageActivitySnapshot;
+    uint32_t switches = adaptiveSwitchesSnapshot;
+    portEXIT_CRITICAL(&adaptiveLock);
+
+    // Achieved by the current channel, rotations and continuous mode included
+    uint32_t periodUs = getInputSamplePeriodUs();
+    char buffer[360];
+    snprintf(buffer, sizeof(buffer),
+             "{\"mode\":\"%s\",\"acquisition\":\"%s\",\"interval_ms\":%u,\"effective_interval_ms\":%u,"
+             "\"effective_rate_hz\":%.2f,\"fast_ms\":%u,\"slow_ms\":%u,\"hold_ms\":%u,\"switches\":%u,"
+             "\"activity\":{\"current_ua\":%d,\"current_threshold_ua\":%d,\"voltage_uv\":%d,\"voltage_threshold_uv\":%d}}",
+             adaptiveEnabled ? "adaptive" : "fixed",
+             getAcquisitionMode() == ACQ_MODE_CONTINUOUS ? "continuous" : "single_shot", getSamplingInterval(),
+             getEffectiveSamplingInterval(), periodUs ? 1e6 / periodUs : 0.0, adaptiveFastMs, adaptiveSlowMs,
+             ADAPTIVE_RATE_DEFAULT_HOLD_MS, switches, q31ToUnits(current.level, SHUNT_MICROAMPS_FULL_SCALE),
+             q31ToUnits(current.threshold, SHUNT_MICROAMPS_FULL_SCALE),
+             q31ToUnits(voltage.level, ADS2_MICROVOLTS_FULL_SCALE),
+             q31ToUnits(voltage.threshold, ADS2_MICROVOLTS_FULL_SCALE));
+    return String(buffer);
+}
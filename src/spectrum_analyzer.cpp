@@ -0,0 +1,156 @@
+#include "spectrum_analyzer.h"
+#include <math.h>
+#include "sample_quality.h"
+
+// Q31 full scale as 1.0
+static const float Q31_TO_FLOAT = 1.0f / 2147483648.0f;
+
+// Keeps the log of an empty bin finite for the peak interpolation
+static const float PEAK_POWER_FLOOR = 1e-30f;
+
+SpectrumAnalyzer::SpectrumAnalyzer(const SpectrumBand* bands, uint8_t bandCount)
+    : bands(bands),
+      bandCount(bandCount > SPECTRUM_MAX_BANDS ? SPECTRUM_MAX_BANDS : bandCount),
+      periodUs(0),
+      lastUs(0),
+      fill(0),
+      latest() {
+    latest.bandCount = this->bandCount;
+}
+
+void SpectrumAnalyzer::setSamplePeriod(uint32_t period) {
+    if (period != periodUs) {
+        periodUs = period;
+        restart();
+    }
+}
+
+void SpectrumAnalyzer::restart() {
+    if (fill > 0) {
+        latest.restarts++;
+    }
+    fill = 0;
+}
+
+bool SpectrumAnalyzer::add(int64_t timestampUs, q31_t sample, uint8_t quality) {
+    if (periodUs == 0) {
+        return false;
+    }
+    if (isSampleDegraded(quality)) {
+        restart();
+        return false;
+    }
+    if (!isSampleFresh(quality)) {
+        return false;
+    }
+    // More than half a period late: at least one conversion is missing
+    if (fill > 0 && timestampUs - lastUs > static_cast<int64_t>(periodUs) * 3 / 2) {
+        restart();
+    }
+    lastUs = timestampUs;
+    frame[fill++] = static_cast<float>(sample) * Q31_TO_FLOAT;
+    if (fill < SPECTRUM_FFT_SIZE) {
+        return false;
+    }
+    analyse();
+    fill = 0;
+    return true;
+}
+
+// Power in bin k is |X[k]|^2 * 2 / (N * sum(w^2)) as a mean square, so a band's RMS is the
+// square root of its bins' sum and a full-scale sine reads 1/sqrt(2) whatever its phase
+void SpectrumAnalyzer::analyse() {
+    const float* window = RealFft<SPECTRUM_FFT_SIZE>::TABLES.window;
+    float sum = 0;
+    for (int n = 0; n < SPECTRUM_FFT_SIZE; n++) {
+        sum += frame[n];
+    }
+    float mean = sum / SPECTRUM_FFT_SIZE;
+    for (int n = 0; n < SPECTRUM_FFT_SIZE; n++) {
+        frame[n] = (frame[n] - mean) * window[n];
+    }
+    fft.transform(frame);
+
+    // Squared magnitudes in place: bin k only reads slots 2k and 2k + 1, ahead of slot k
+    float* power = frame;
+    power[0] = 0;
+    for (int k = 1; k < SPECTRUM_BIN_COUNT; k++) {
+        float re = frame[2 * k];
+        float im = frame[2 * k + 1];
+        power[k] = re * re + im * im;
+    }
+    float scale = 2.0f / (SPECTRUM_FFT_SIZE * RealFft<SPECTRUM_FFT_SIZE>::TABLES.windowPower);
+
+    float sampleRate = 1e6f / periodUs;
+    float binHz = sampleRate / SPECTRUM_FFT_SIZE;
+    float total = 0;
+    for (int k = 1; k < SPECTRUM_BIN_COUNT; k++) {
+        total += power[k];
+    }
+    for (uint8_t b = 0; b < bandCount; b++) {
+        int first = static_cast<int>(ceilf(bands[b].lowHz / binHz));
+        int end = static_cast<int>(ceilf(bands[b].highHz / binHz));
+        first = first < 1 ? 1 : first;
+        end = end > SPECTRUM_BIN_COUNT ? SPECTRUM_BIN_COUNT : end;
+        float bandSum = 0;
+        for (int k = first; k < end; k++) {
+            bandSum += power[k];
+        }
+        latest.bandRms[b] = sqrtf(bandSum * scale);
+    }
+
+    latest.frames++;
+    latest.sampleRateHz = sampleRate;
+    latest.binHz = binHz;
+    latest.mean = mean;
+    latest.acRms = sqrtf(total * scale);
+    findPeaks(power, scale);
+}
+
+// Strongest local maxima, placed between bins by a parabola through the log power of the
+// maximum and its neighbours (close to exact for the Gaussian-like Hann main lobe). A
+// peak's level sums its main lobe, +/-2 bins, so it does not depend on where the tone
+// falls between bins.
+void SpectrumAnalyzer::findPeaks(const float* power, float scale) {
+    latest.peakCount = 0;
+    for (int k = SPECTRUM_PEAK_FIRST_BIN; k < SPECTRUM_BIN_COUNT - 1; k++) {
+        if (power[k] <= power[k - 1] || power[k] < power[k + 1] || power[k] <= 0) {
+            continue;
+        }
+        // Insertion into the strongest-first list, dropping the weakest when full
+        int slot = latest.peakCount;
+        while (slot > 0 && power[k] > latest.peaks[slot - 1].rms) {
+            slot--;
+        }
+        if (slot >= SPECTRUM_PEAK_COUNT) {
+            continue;
+        }
+        int last = latest.peakCount < SPECTRUM_PEAK_COUNT ? latest.peakCount : SPECTRUM_PEAK_COUNT - 1;
+        for (int i = last; i > slot; i--) {
+            latest.peaks[i] = latest.peaks[i - 1];
+        }
+        // Bin index and raw power for now; converted once the list is final
+        latest.peaks[slot].frequencyHz = static_cast<float>(k);
+        latest.peaks[slot].rms = power[k];
+        if (latest.peakCount < SPECTRUM_PEAK_COUNT) {
+            latest.peakCount++;
+        }
+    }
+
+    for (uint8_t i = 0; i < latest.peakCount; i++) {
+        int k = static_cast<int>(latest.peaks[i].frequencyHz);
+        float left = logf(power[k - 1] + PEAK_POWER_FLOOR);
+        float centre = logf(power[k] + PEAK_POWER_FLOOR);
+        float right = logf(power[k + 1] + PEAK_POWER_FLOOR);
+        float curvature = left - 2 * centre + right;
+        float offset = curvature < 0 ? 0.5f * (left - right) / curvature : 0;
+        float lobe = 0;
+        for (int j = k - 2; j <= k + 2; j++) {
+            if (j >= 1 && j < SPECTRUM_BIN_COUNT) {
+                lobe += power[j];
+            }
+        }
+        latest.peaks[i].frequencyHz = (k + offset) * latest.binHz;
+        latest.peaks[i].rms = sqrtf(lobe * scale);
+    }
+}
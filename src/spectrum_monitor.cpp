@@ -0,0 +1,96 @@
+#include "spectrum_monitor.h"
+#include "config.h"
+
+// Bands of the shunt spectrum. They tile the whole range so their squares add up to the
+// AC RMS; anything from a switching supply above Nyquist (430 Hz at 860 SPS) folds into
+// the top band.
+static const SpectrumBand SHUNT_BANDS[] = {
+    {"drift", 0, 5},
+    {"low", 5, 45},
+    {"mains", 45, 65},
+    {"harmonics", 65, 100000},
+};
+
+// Owned by the feeding task (spectrumTask); other tasks only see the published snapshot
+static SpectrumAnalyzer shuntSpectrum(SHUNT_BANDS, sizeof(SHUNT_BANDS) / sizeof(SHUNT_BANDS[0]));
+static uint32_t publishedFrames = 0;
+
+static SpectrumResult shuntSnapshot;
+static portMUX_TYPE spectrumLock = portMUX_INITIALIZER_UNLOCKED;
+
+void setSpectrumSamplePeriod(uint32_t periodUs) {
+    shuntSpectrum.setSamplePeriod(periodUs);
+}
+
+void updateSpectrum(const AdcSample& sample) {
+    shuntSpectrum.add(sample.timestampUs, sample.shunt, sample.shuntQuality);
+}
+
+bool publishSpectrum() {
+    const SpectrumResult& result = shuntSpectrum.result();
+    bool fresh = result.frames != publishedFrames;
+    publishedFrames = result.frames;
+    portENTER_CRITICAL(&spectrumLock);
+    shuntSnapshot = result;
+    portEXIT_CRITICAL(&spectrumLock);
+    return fresh;
+}
+
+SpectrumResult getShuntSpectrum() {
+    portENTER_CRITICAL(&spectrumLock);
+    SpectrumResult copy = shuntSnapshot;
+    portEXIT_CRITICAL(&spectrumLock);
+    return copy;
+}
+
+static String toMicroamps(float fraction) {
+    return String(static_cast<double>(fraction) * SHUNT_MICROAMPS_FULL_SCALE, 0);
+}
+
+String formatSpectrum() {
+    SpectrumResult r = getShuntSpectrum();
+    String json = "{\"frames\":" + String(r.frames);
+    json += ",\"restarts\":" + String(r.restarts);
+    json += ",\"fft_size\":" + String(SPECTRUM_FFT_SIZE);
+    json += ",\"sample_rate_hz\":" + String(r.sampleRateHz, 1);
+    json += ",\"bin_hz\":" + String(r.binHz, 3);
+    json += ",\"mean_ua\":" + toMicroamps(r.mean);
+    json += ",\"ac_rms_ua\":" + toMicroamps(r.acRms);
+    json += ",\"bands\":[";
+    for (uint8_t b = 0; b < r.bandCount; b++) {
+        const SpectrumBand& band = shuntSpectrum.getBand(b);
+        if (b > 0) json += ",";
+        json += "{\"name\":\"" + String(band.name) + "\"";
+        json += ",\"low_hz\":" + String(band.lowHz, 1);
+        json += ",\"high_hz\":" + String(band.highHz < r.sampleRateHz / 2 ? band.highHz : r.sampleRateHz / 2, 1);
+        json += ",\"rms_ua\":" + toMicroamps(r.bandRms[b]) + "}";
+    }
+    json += "],\"peaks\":[";
+    for (uint8_t i = 0; i < r.peakCount; i++) {
+        if (i > 0) json += ",";
+        json += "{\"hz\":" + String(r.peaks[i].frequencyHz, 2);
+        json += ",\"rms_ua\":" + toMicroamps(r.peaks[i].rms) + "}";
+    }
+    json += "]}";
+    return json;
+}
+
+// Bands in SHUNT_BANDS order, peaks as [hz, rms_ua] pairs
+String formatSpectrumCompact() {
+    SpectrumResult r = getShuntSpectrum();
+    String json = "{\"n\":" + String(r.frames);
+    json += ",\"df\":" + String(r.binHz, 3);
+    json += ",\"ac\":" + toMicroamps(r.acRms);
+    json += ",\"b\":[";
+    for (uint8_t b = 0; b < r.bandCount; b++) {
+        if (b > 0) json += ",";
+        json += toMicroamps(r.bandRms[b]);
+    }
+    json += "],\"p\":[";
+    for (uint8_t i = 0; i < r.peakCount; i++) {
+        if (i > 0) json += ",";
+        json += "[" + String(r.peaks[i].frequencyHz, 1) + "," + toMicroamps(r.peaks[i].rms) + "]";
+    }
+    json += "]}";
+    return json;
+}
@@ -0,0 +1,171 @@
+#include "stats_monitor.h"
+#include "config.h"
+
+// Owned by the feeding task (bleTask); other tasks only see the published snapshot
+static WindowedStatistics<STATS_HISTORY_SAMPLES> shuntStats;
+static WindowedStatistics<STATS_HISTORY_SAMPLES> ads2Stats;
+static SampleQualityCounter shuntQuality;
+static SampleQualityCounter ads2Quality;
+
+static WindowSummary shuntSnapshot[STATS_WINDOW_COUNT];
+static WindowSummary ads2Snapshot[STATS_WINDOW_COUNT];
+static QualityCounts shuntQualitySnapshot;
+static QualityCounts ads2QualitySnapshot;
+static uint32_t windowLengths[STATS_WINDOW_COUNT] = {STATS_WINDOW_SHORT, STATS_WINDOW_MEDIUM, STATS_WINDOW_LONG};
+static volatile uint32_t requestedLengths[STATS_WINDOW_COUNT];  // 0: no change pending
+static portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Held values are repeats, not measurements: they would flatten the noise and stretch
+// the extremes, so the windows only take fresh conversions
+void updateStatistics(const AdcSample& sample) {
+    if (isSampleFresh(sample.shuntQuality)) {
+        shuntStats.add(sample.shunt);
+    }
+    if (isSampleFresh(sample.ads2Quality)) {
+        ads2Stats.add(sample.ads2);
+    }
+    shuntQuality.add(sample.timestampUs, sample.shuntQuality);
+    ads2Quality.add(sample.timestampUs, sample.ads2Quality);
+}
+
+void publishStatistics() {
+    WindowSummary shunt[STATS_WINDOW_COUNT];
+    WindowSummary ads2[STATS_WINDOW_COUNT];
+    uint32_t lengths[STATS_WINDOW_COUNT];
+    for (int i = 0; i < STATS_WINDOW_COUNT; i++) {
+        uint32_t requested = requestedLengths[i];
+        if (requested != 0) {
+            requestedLengths[i] = 0;
+            shuntStats.setWindowLength(i, requested);
+            ads2Stats.setWindowLength(i, requested);
+        }
+        shunt[i] = shuntStats.summary(i);
+        ads2[i] = ads2Stats.summary(i);
+        lengths[i] = shuntStats.getWindowLength(i);
+    }
+
+    portENTER_CRITICAL(&statsLock);
+    for (int i = 0; i < STATS_WINDOW_COUNT; i++) {
+        shuntSnapshot[i] = shunt[i];
+        ads2Snapshot[i] = ads2[i];
+        windowLengths[i] = lengths[i];
+    }
+    shuntQualitySnapshot = shuntQuality.getCounts();
+    ads2QualitySnapshot = ads2Quality.getCounts();
+    portEXIT_CRITICAL(&statsLock);
+}
+
+WindowSummary getShuntSummary(int window) {
+    WindowSummary copy = {0, 0, 0, 0, 0, 0, 0};
+    if (window < 0 || window >= STATS_WINDOW_COUNT) {
+        return copy;
+    }
+    portENTER_CRITICAL(&statsLock);
+    copy = shuntSnapshot[window];
+    portEXIT_CRITICAL(&statsLock);
+    return copy;
+}
+
+WindowSummary getAds2Summary(int window) {
+    WindowSummary copy = {0, 0, 0, 0, 0, 0, 0};
+    if (window < 0 || window >= STATS_WINDOW_COUNT) {
+        return copy;
+    }
+    portENTER_CRITICAL(&statsLock);
+    copy = ads2Snapshot[window];
+    portEXIT_CRITICAL(&statsLock);
+    return copy;
+}
+
+QualityCounts getShuntQuality() {
+    portENTER_CRITICAL(&statsLock);
+    QualityCounts copy = shuntQualitySnapshot;
+    portEXIT_CRITICAL(&statsLock);
+    return copy;
+}
+
+QualityCounts getAds2Quality() {
+    portENTER_CRITICAL(&statsLock);
+    QualityCounts copy = ads2QualitySnapshot;
+    portEXIT_CRITICAL(&statsLock);
+    return copy;
+}
+
+bool setStatisticsWindow(int window, uint32_t samples) {
+    if (window < 0 || window >= STATS_WINDOW_COUNT || samples < 1 || samples > STATS_HISTORY_SAMPLES) {
+        return false;
+    }
+    requestedLengths[window] = samples;
+    LOG_INFO("Statistics window %d set to %u samples", window, samples);
+    return true;
+}
+
+uint32_t getStatisticsWindow(int window) {
+    if (window < 0 || window >= STATS_WINDOW_COUNT) {
+        return 0;
+    }
+    portENTER_CRITICAL(&statsLock);
+    uint32_t length = windowLengths[window];
+    portEXIT_CRITICAL(&statsLock);
+    return length;
+}
+
+static String formatSummary(const WindowSummary& summary, int64_t unitsPerFullScale) {
+    int32_t stddev = q31ToUnits(summary.stddev, unitsPerFullScale);
+    String json = "{\"min\":" + String(q31ToUnits(summary.min, unitsPerFullScale));
+    json += ",\"max\":" + String(q31ToUnits(summary.max, unitsPerFullScale));
+    json += ",\"peak\":" + String(q31ToUnits(summary.peak, unitsPerFullScale));
+    json += ",\"mean\":" + String(q31ToUnits(summary.mean, unitsPerFullScale));
+    json += ",\"rms\":" + String(q31ToUnits(summary.rms, unitsPerFullScale));
+    json += ",\"std\":" + String(stddev);
+    json += ",\"variance\":" + String(static_cast<double>(stddev) * stddev, 0);
+    json += "}";
+    return json;
+}
+
+String formatStatistics() {
+    WindowSummary shunt[STATS_WINDOW_COUNT];
+    WindowSummary ads2[STATS_WINDOW_COUNT];
+    uint32_t lengths[STATS_WINDOW_COUNT];
+    portENTER_CRITICAL(&statsLock);
+    for (int i = 0; i < STATS_WINDOW_COUNT; i++) {
+        shunt[i] = shuntSnapshot[i];
+        ads2[i] = ads2Snapshot[i];
+        lengths[i] = windowLengths[i];
+    }
+    portEXIT_CRITICAL(&statsLock);
+
+    String json = "{\"windows\":[";
+    for (int i = 0; i < STATS_WINDOW_COUNT; i++) {
+        if (i > 0) json += ",";
+        json += "{\"samples\":" + String(lengths[i]);
+        json += ",\"count\":" + String(shunt[i].count);
+        json += ",\"current_ua\":" + formatSummary(shunt[i], SHUNT_MICROAMPS_FULL_SCALE);
+        json += ",\"voltage_uv\":" + formatSummary(ads2[i], ADS2_MICROVOLTS_FULL_SCALE);
+        json += "}";
+    }
+    json += "]}";
+    return json;
+}
+
+static String formatQualityCounts(const QualityCounts& counts) {
+    String json = "{\"samples\":" + String(counts.samples);
+    json += ",\"fresh\":" + String(counts.fresh);
+    json += ",\"stale\":" + String(counts.stale);
+    json += ",\"recovering\":" + String(counts.recovering);
+    json += ",\"clipped\":" + String(counts.clipped);
+    json += ",\"gain_changes\":" + String(counts.gainChanges);
+    json += ",\"total_s\":" + String(counts.totalUs / 1e6, 3);
+    json += ",\"degraded_s\":" + String(counts.degradedUs / 1e6, 3);
+    json += "}";
+    return json;
+}
+
+String formatSampleQuality() {
+    QualityCounts shunt = getShuntQuality();
+    QualityCounts ads2 = getAds2Quality();
+    String json = "{\"current\":" + formatQualityCounts(shunt);
+    json += ",\"voltage\":" + formatQualityCounts(ads2);
+    json += "}";
+    return json;
+}
@@ -0,0 +1,162 @@
+#include "swinging_door.h"
+
+// Rounded to the nearest integer, halves away from zero; den > 0
+static int64_t divideRounded(int64_t num, int64_t den) {
+    return num >= 0 ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+SwingingDoor::SwingingDoor(uint8_t channel, q31_t deviation, int64_t maxIntervalUs) : channel(channel) {
+    setDeviation(deviation);
+    this->maxIntervalUs = SWINGING_DOOR_DEFAULT_MAX_INTERVAL_US;
+    setMaxInterval(maxIntervalUs);
+    reset();
+}
+
+void SwingingDoor::reset() {
+    hasPivot = false;
+    startNext = true;
+    pivotUs = 0;
+    pivotValue = 0;
+    hasHeld = false;
+    heldUs = 0;
+    heldValue = 0;
+    heldFlags = 0;
+    upper = {0, 1};
+    lower = {0, 1};
+    outputHead = 0;
+    outputCount = 0;
+    inputs = 0;
+    archived = 0;
+}
+
+void SwingingDoor::setDeviation(q31_t value) {
+    deviation = value > 0 ? value : 0;
+}
+
+void SwingingDoor::setMaxInterval(int64_t value) {
+    if (value > 0 && value <= SWINGING_DOOR_MAX_INTERVAL_LIMIT_US) {
+        maxIntervalUs = value;
+    }
+}
+
+// Numerators span at most 2^33 and denominators SWINGING_DOOR_MAX_INTERVAL_LIMIT_US, so
+// the cross products cannot overflow
+bool SwingingDoor::steeper(const Slope& a, const Slope& b) {
+    return a.num * b.den > b.num * a.den;
+}
+
+void SwingingDoor::add(int64_t timeUs, q31_t value, uint8_t quality) {
+    if (quality & (SAMPLE_QUALITY_STALE | SAMPLE_QUALITY_RECOVERING)) {
+        endTrend();
+        return;
+    }
+    if (!isSampleFresh(quality) || (hasPivot && timeUs <= (hasHeld ? heldUs : pivotUs))) {
+        return;
+    }
+    inputs++;
+    uint8_t flags = quality & ~SAMPLE_QUALITY_HELD;
+
+    // Keep points at most maxIntervalUs apart: the pending conversion closes the segment
+    if (hasPivot && timeUs - pivotUs > maxIntervalUs) {
+        if (hasHeld) {
+            archiveHeld();
+        }
+        if (timeUs - pivotUs > SWINGING_DOOR_MAX_INTERVAL_LIMIT_US) {
+            endTrend();
+        } else if (timeUs - pivotUs > maxIntervalUs) {
+            // Sampled slower than the interval: every conversion is a point
+            archive(timeUs, value, flags);
+            return;
+        }
+    }
+    if (!hasPivot) {
+        archive(timeUs, value, flags);
+        return;
+    }
+
+    if (!hasHeld) {
+        openDoors(timeUs, value);
+    } else {
+        Slope toUpper = {static_cast<int64_t>(value) + deviation - pivotValue, timeUs - pivotUs};
+        Slope toLower = {static_cast<int64_t>(value) - deviation - pivotValue, timeUs - pivotUs};
+        Slope nextUpper = steeper(upper, toUpper) ? toUpper : upper;
+        Slope nextLower = steeper(toLower, lower) ? toLower : lower;
+        if (steeper(nextLower, nextUpper)) {
+            // No line from the pivot fits this conversion too: the held one ends the segment
+            archiveHeld();
+            openDoors(timeUs, value);
+        } else {
+            upper = nextUpper;
+            lower = nextLower;
+        }
+    }
+    hasHeld = true;
+    heldUs = timeUs;
+    heldValue = value;
+    heldFlags |= flags;
+
+    if (timeUs - pivotUs >= maxIntervalUs) {
+        archiveHeld();
+    }
+}
+
+void SwingingDoor::openDoors(int64_t timeUs, q31_t value) {
+    upper = {static_cast<int64_t>(value) + deviation - pivotValue, timeUs - pivotUs};
+    lower = {static_cast<int64_t>(value) - deviation - pivotValue, timeUs - pivotUs};
+}
+
+void SwingingDoor::flush() {
+    if (hasHeld) {
+        archiveHeld();
+    }
+}
+
+void SwingingDoor::endTrend() {
+    flush();
+    hasPivot = false;
+    startNext = true;
+}
+
+// The held conversion goes on the line from the pivot towards it, turned into the doors
+// when it lies outside them; its own doors are among them, so it moves by at most the
+// deviation
+void SwingingDoor::archiveHeld() {
+    Slope actual = {static_cast<int64_t>(heldValue) - pivotValue, heldUs - pivotUs};
+    const Slope& slope = steeper(actual, upper) ? upper : (steeper(lower, actual) ? lower : actual);
+    int64_t value = pivotValue + divideRounded(slope.num * actual.den, slope.den);
+    if (value > INT32_MAX) value = INT32_MAX;
+    if (value < INT32_MIN) value = INT32_MIN;
+    archive(heldUs, static_cast<q31_t>(value), heldFlags);
+}
+
+void SwingingDoor::archive(int64_t timeUs, q31_t value, uint8_t flags) {
+    TrendPoint point = {timeUs, value, channel, flags, startNext};
+    push(point);
+    startNext = false;
+    hasPivot = true;
+    pivotUs = timeUs;
+    pivotValue = value;
+    hasHeld = false;
+    heldFlags = 0;
+    archived++;
+}
+
+// Readers drain after every add, so the output only overflows if nobody reads
+void SwingingDoor::push(const TrendPoint& point) {
+    if (outputCount == SWINGING_DOOR_OUTPUT_POINTS) {
+        outputHead = (outputHead + 1) % SWINGING_DOOR_OUTPUT_POINTS;
+        outputCount--;
+    }
+    output[(outputHead + outputCount) % SWINGING_DOOR_OUTPUT_POINTS] = point;
+    outputCount++;
+}
+
+bool SwingingDoor::read(TrendPoint& point) {
+    if (outputCount == 0) {
+        return false;
+    }
+    point = output[outputHead];
+    outputHead = (outputHead + 1) % SWINGING_DOOR_OUTPUT_POINTS;
+    outputCount--;
+    return true;
+}
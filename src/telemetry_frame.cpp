@@ -0,0 +1,148 @@
+#include "telemetry_frame.h"
+#include <stdio.h>
+
+// Byte by byte, so the layout is the same whatever the host's endianness and padding
+
+static uint8_t* putU16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+    return out + 2;
+}
+
+static uint8_t* putU32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+    out[2] = static_cast<uint8_t>(value >> 16);
+    out[3] = static_cast<uint8_t>(value >> 24);
+    return out + 4;
+}
+
+static uint8_t* putI32(uint8_t* out, int32_t value) {
+    return putU32(out, static_cast<uint32_t>(value));
+}
+
+static uint8_t* putStats(uint8_t* out, const TelemetryStats& stats) {
+    out = putI32(out, stats.min);
+    out = putI32(out, stats.max);
+    out = putI32(out, stats.peak);
+    out = putI32(out, stats.rms);
+    return putI32(out, stats.stddev);
+}
+
+static const uint8_t* getU16(const uint8_t* in, uint16_t& value) {
+    value = static_cast<uint16_t>(in[0] | (in[1] << 8));
+    return in + 2;
+}
+
+static const uint8_t* getU32(const uint8_t* in, uint32_t& value) {
+    value = static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+            (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+    return in + 4;
+}
+
+static const uint8_t* getI32(const uint8_t* in, int32_t& value) {
+    uint32_t bits;
+    in = getU32(in, bits);
+    value = static_cast<int32_t>(bits);
+    return in;
+}
+
+static const uint8_t* getStats(const uint8_t* in, TelemetryStats& stats) {
+    in = getI32(in, stats.min);
+    in = getI32(in, stats.max);
+    in = getI32(in, stats.peak);
+    in = getI32(in, stats.rms);
+    return getI32(in, stats.stddev);
+}
+
+size_t encodeTelemetryFrame(const TelemetryFrame& frame, uint8_t* out, size_t capacity) {
+    if (capacity < TELEMETRY_FRAME_SIZE) {
+        return 0;
+    }
+    uint8_t* p = out;
+    *p++ = TELEMETRY_FRAME_MAGIC;
+    *p++ = TELEMETRY_FRAME_VERSION;
+    p = putU16(p, frame.sequence);
+    p = putU32(p, frame.timestampMs);
+    p = putI32(p, frame.currentUa);
+    p = putI32(p, frame.voltageUv);
+    p = putI32(p, frame.powerUw);
+    *p++ = frame.currentQuality;
+    *p++ = frame.voltageQuality;
+    *p++ = frame.relays;
+    *p++ = frame.flags;
+    p = putI32(p, frame.shuntCounts);
+    p = putI32(p, frame.ads2Counts);
+    p = putI32(p, frame.chargeUah);
+    p = putI32(p, frame.energyUwh);
+    p = putU32(p, frame.statsWindow);
+    p = putStats(p, frame.currentStats);
+    p = putStats(p, frame.voltageStats);
+    return static_cast<size_t>(p - out);
+}
+
+bool decodeTelemetryFrame(const uint8_t* data, size_t length, TelemetryFrame& frame) {
+    if (length < TELEMETRY_FRAME_SIZE || data[0] != TELEMETRY_FRAME_MAGIC || data[1] != TELEMETRY_FRAME_VERSION) {
+        return false;
+    }
+    const uint8_t* p = data + 2;
+    p = getU16(p, frame.sequence);
+    p = getU32(p, frame.timestampMs);
+    p = getI32(p, frame.currentUa);
+    p = getI32(p, frame.voltageUv);
+    p = getI32(p, frame.powerUw);
+    frame.currentQuality = *p++;
+    frame.voltageQuality = *p++;
+    frame.relays = *p++;
+    frame.flags = *p++;
+    p = getI32(p, frame.shuntCounts);
+    p = getI32(p, frame.ads2Counts);
+    p = getI32(p, frame.chargeUah);
+    p = getI32(p, frame.energyUwh);
+    p = getU32(p, frame.statsWindow);
+    p = getStats(p, frame.currentStats);
+    getStats(p, frame.voltageStats);
+    return true;
+}
+
+// Thousandths as a decimal number without trailing zeros, without going through float
+static void formatMilli(char* out, size_t capacity, int64_t milli) {
+    int64_t magnitude = milli < 0 ? -milli : milli;
+    int fraction = static_cast<int>(magnitude % 1000);
+    int digits = 3;
+    while (fraction != 0 && fraction % 10 == 0) {
+        fraction /= 10;
+        digits--;
+    }
+    if (fraction == 0) {
+        snprintf(out, capacity, "%lld", (long long)(milli / 1000));
+    } else {
+        snprintf(out, capacity, "%s%lld.%0*d", milli < 0 ? "-" : "", (long long)(magnitude / 1000), digits, fraction);
+    }
+}
+
+// Legacy counts keep their fraction, to three decimals
+static int64_t countsMilli(q31_t counts) {
+    return (static_cast<int64_t>(counts) * 1000) / Q31_ONE_COUNT;
+}
+
+size_t formatTelemetryJson(const TelemetryFrame& frame, const char* protocolVersion, char* out, size_t capacity) {
+    char shunt[24], ads2[24];
+    formatMilli(shunt, sizeof(shunt), countsMilli(frame.shuntCounts));
+    formatMilli(ads2, sizeof(ads2), countsMilli(frame.ads2Counts));
+
+    // Same keys and nesting as the ArduinoJson document this replaces, plus the engineering
+    // units. Quality, energy and window statistics are left to the binary frame and MCP.
+    int length = snprintf(out, capacity,
+        "{\"protocol_version\":\"%s\",\"timestamp\":%lu,"
+        "\"measurements\":{\"shunt_diff\":%s,\"ads2_a0\":%s,\"current_ua\":%ld,\"voltage_uv\":%ld,\"power_uw\":%ld},"
+        "\"relays\":{\"relay1\":%u,\"relay2\":%u,\"relay3\":%u,\"relay4\":%u}}",
+        protocolVersion, (unsigned long)frame.timestampMs,
+        shunt, ads2, (long)frame.currentUa, (long)frame.voltageUv, (long)frame.powerUw,
+        frame.relays & 0x01 ? 1 : 0, frame.relays & 0x02 ? 1 : 0, frame.relays & 0x04 ? 1 : 0,
+        frame.relays & 0x08 ? 1 : 0);
+    if (length < 0 || static_cast<size_t>(length) >= capacity) {
+        return 0;
+    }
+    return static_cast<size_t>(length);
+}
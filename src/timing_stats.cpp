@@ -0,0 +1,72 @@
+#include "timing_stats.h"
+
+const uint32_t JITTER_BUCKET_LIMITS_US[JITTER_BUCKET_COUNT - 1] = {10, 50, 100, 250, 500, 1000, 5000};
+const uint32_t OVERRUN_BUCKET_LIMITS[OVERRUN_BUCKET_COUNT - 1] = {1, 2, 4, 8};
+
+PeriodStats::PeriodStats() {
+    reset(0);
+}
+
+void PeriodStats::reset(uint32_t nominalPeriod) {
+    nominalPeriodUs = nominalPeriod;
+    firstTickUs = 0;
+    lastTickUs = 0;
+    ticks = 0;
+    overruns = 0;
+    missedTicks = 0;
+    minErrorUs = 0;
+    maxErrorUs = 0;
+    for (int i = 0; i < JITTER_BUCKET_COUNT; i++) {
+        jitterBuckets[i] = 0;
+    }
+    for (int i = 0; i < OVERRUN_BUCKET_COUNT; i++) {
+        overrunBuckets[i] = 0;
+    }
+}
+
+void PeriodStats::recordTick(int64_t timestampUs, uint32_t missed) {
+    if (missed > 0) {
+        overruns++;
+        missedTicks += missed;
+        int bucket = 0;
+        while (bucket < OVERRUN_BUCKET_COUNT - 1 && missed > OVERRUN_BUCKET_LIMITS[bucket]) {
+            bucket++;
+        }
+        overrunBuckets[bucket]++;
+    }
+
+    if (ticks == 0) {
+        firstTickUs = timestampUs;
+    } else {
+        // Compare against the expected span so a missed tick is not also counted as jitter
+        int64_t expectedUs = static_cast<int64_t>(nominalPeriodUs) * (missed + 1);
+        int32_t errorUs = static_cast<int32_t>((timestampUs - lastTickUs) - expectedUs);
+        if (ticks == 1 || errorUs < minErrorUs) {
+            minErrorUs = errorUs;
+        }
+        if (ticks == 1 || errorUs > maxErrorUs) {
+            maxErrorUs = errorUs;
+        }
+
+        uint32_t magnitude = errorUs < 0 ? static_cast<uint32_t>(-errorUs) : static_cast<uint32_t>(errorUs);
+        int bucket = 0;
+        while (bucket < JITTER_BUCKET_COUNT - 1 && magnitude > JITTER_BUCKET_LIMITS_US[bucket]) {
+            bucket++;
+        }
+        jitterBuckets[bucket]++;
+    }
+    lastTickUs = timestampUs;
+    ticks++;
+}
+
+uint32_t PeriodStats::getMeanPeriodUs() const {
+    if (ticks < 2) {
+        return 0;
+    }
+    return static_cast<uint32_t>((lastTickUs - firstTickUs) / (ticks - 1));
+}
+
+float PeriodStats::getAchievedRateHz() const {
+    uint32_t meanPeriodUs = getMeanPeriodUs();
+    return meanPeriodUs ? 1000000.0f / meanPeriodUs : 0.0f;
+}
@@ -0,0 +1,125 @@
+#include "trend_monitor.h"
+#include "config.h"
+
+TrendPointRing trendRing;
+
+static const int64_t TREND_UNITS_PER_FULL_SCALE[TREND_CHANNEL_COUNT] = {SHUNT_MICROAMPS_FULL_SCALE,
+                                                                        ADS2_MICROVOLTS_FULL_SCALE};
+static const char* TREND_PREFS_KEYS[TREND_CHANNEL_COUNT] = {"trendDevI", "trendDevV"};
+
+// Owned by the acquisition task
+static SwingingDoor currentDoor(TREND_CHANNEL_CURRENT,
+                                unitsToQ31(TREND_DEFAULT_CURRENT_DEVIATION_UA, SHUNT_MICROAMPS_FULL_SCALE));
+static SwingingDoor voltageDoor(TREND_CHANNEL_VOLTAGE,
+                                unitsToQ31(TREND_DEFAULT_VOLTAGE_DEVIATION_UV, ADS2_MICROVOLTS_FULL_SCALE));
+
+static volatile uint32_t deviations[TREND_CHANNEL_COUNT] = {TREND_DEFAULT_CURRENT_DEVIATION_UA,
+                                                            TREND_DEFAULT_VOLTAGE_DEVIATION_UV};
+static volatile bool deviationPending[TREND_CHANNEL_COUNT];
+
+// Written by the acquisition task, copied out under this lock
+static uint32_t inputsSnapshot[TREND_CHANNEL_COUNT];
+static uint32_t archivedSnapshot[TREND_CHANNEL_COUNT];
+static portMUX_TYPE trendLock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool publishPoints(SwingingDoor& door) {
+    TrendPoint point;
+    bool published = false;
+    while (door.read(point)) {
+        trendRing.push(point);
+        published = true;
+    }
+    return published;
+}
+
+bool compressTrend(const AdcSample& sample) {
+    SwingingDoor* doors[TREND_CHANNEL_COUNT] = {&currentDoor, &voltageDoor};
+    for (uint8_t channel = 0; channel < TREND_CHANNEL_COUNT; channel++) {
+        if (deviationPending[channel]) {
+            deviationPending[channel] = false;
+            doors[channel]->setDeviation(unitsToQ31(deviations[channel], TREND_UNITS_PER_FULL_SCALE[channel]));
+        }
+    }
+
+    // Each channel at the middle of its own conversion
+    currentDoor.add(sample.shuntUs, sample.shunt, sample.shuntQuality);
+    bool published = publishPoints(currentDoor);
+    voltageDoor.add(sample.ads2Us, sample.ads2, sample.ads2Quality);
+    published |= publishPoints(voltageDoor);
+
+    portENTER_CRITICAL(&trendLock);
+    for (uint8_t channel = 0; channel < TREND_CHANNEL_COUNT; channel++) {
+        inputsSnapshot[channel] = doors[channel]->getInputs();
+        archivedSnapshot[channel] = doors[channel]->getArchived();
+    }
+    portEXIT_CRITICAL(&trendLock);
+    return published;
+}
+
+void loadTrendSettings() {
+    for (uint8_t channel = 0; channel < TREND_CHANNEL_COUNT; channel++) {
+        uint32_t units = prefs.getUInt(TREND_PREFS_KEYS[channel], deviations[channel]);
+        if (units <= TREND_MAX_DEVIATION_UNITS) {
+            deviations[channel] = units;
+            deviationPending[channel] = true;
+        }
+    }
+    LOG_INFO("Trend deviations: %u uA, %u uV", deviations[TREND_CHANNEL_CURRENT],
+             deviations[TREND_CHANNEL_VOLTAGE]);
+}
+
+bool setTrendDeviation(uint8_t channel, uint32_t units) {
+    if (channel >= TREND_CHANNEL_COUNT || units > TREND_MAX_DEVIATION_UNITS) {
+        return false;
+    }
+    deviations[channel] = units;
+    deviationPending[channel] = true;
+    prefs.putUInt(TREND_PREFS_KEYS[channel], units);
+    return true;
+}
+
+uint32_t getTrendDeviation(uint8_t channel) {
+    return channel < TREND_CHANNEL_COUNT ? deviations[channel] : 0;
+}
+
+int32_t trendPointUnits(const TrendPoint& point) {
+    return q31ToUnits(point.value, TREND_UNITS_PER_FULL_SCALE[point.channel < TREND_CHANNEL_COUNT ? point.channel : 0]);
+}
+
+String formatTrendStatus() {
+    uint32_t inputs[TREND_CHANNEL_COUNT];
+    uint32_t archived[TREND_CHANNEL_COUNT];
+    portENTER_CRITICAL(&trendLock);
+    for (uint8_t channel = 0; channel < TREND_CHANNEL_COUNT; channel++) {
+        inputs[channel] = inputsSnapshot[channel];
+        archived[channel] = archivedSnapshot[channel];
+    }
+    portEXIT_CRITICAL(&trendLock);
+
+    static const char* names[TREND_CHANNEL_COUNT] = {"current", "voltage"};
+    static const char* units[TREND_CHANNEL_COUNT] = {"deviation_ua", "deviation_uv"};
+    String json = "{\"max_interval_ms\":" + String(SWINGING_DOOR_DEFAULT_MAX_INTERVAL_US / 1000);
+    for (uint8_t channel = 0; channel < TREND_CHANNEL_COUNT; channel++) {
+        // Conversions per point; 0 until the first point
+        float ratio = archived[channel] ? (float)inputs[channel] / archived[channel] : 0;
+        json += ",\"" + String(names[channel]) + "\":{\"" + units[channel] + "\":" + String(deviations[channel]);
+        json += ",\"conversions\":" + String(inputs[channel]);
+        json += ",\"points\":" + String(archived[channel]);
+        json += ",\"ratio\":" + String(ratio, 1) + "}";
+    }
+    json += "}";
+    return json;
+}
+
+// [time_us, channel, value (uA or uV), quality, start] per point, oldest first
+String formatTrendPoints(const TrendPoint* points, uint8_t count) {
+    String json = "{\"points\":[";
+    for (uint8_t i = 0; i < count; i++) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%s[%lld,%u,%d,%u,%u]", i > 0 ? "," : "", (long long)points[i].timeUs,
+                 points[i].channel, trendPointUnits(points[i]), points[i].quality, points[i].start ? 1 : 0);
+        json += buffer;
+    }
+    json += "]}";
+    return json;
+}
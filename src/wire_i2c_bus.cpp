@@ -0,0 +1,73 @@
+#include "wire_i2c_bus.h"
+#include <Arduino.h>
+
+WireI2CBus::WireI2CBus(TwoWire& wire, int sdaPin, int sclPin)
+    : wire(wire), sdaPin(sdaPin), sclPin(sclPin), clockHz(I2C_STANDARD_MODE_HZ) {}
+
+bool WireI2CBus::write(uint8_t address, const uint8_t* data, size_t length) {
+    wire.beginTransmission(address);
+    if (wire.write(data, length) != length) {
+        wire.endTransmission();
+        return false;
+    }
+    return wire.endTransmission() == 0;
+}
+
+bool WireI2CBus::read(uint8_t address, uint8_t* data, size_t length) {
+    if (wire.requestFrom(address, static_cast<uint8_t>(length)) != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        data[i] = static_cast<uint8_t>(wire.read());
+    }
+    return true;
+}
+
+bool WireI2CBus::setClock(uint32_t hz) {
+    // The ESP32 I2C peripheral supports standard, fast and fast-mode plus
+    if (hz != I2C_STANDARD_MODE_HZ && hz != I2C_FAST_MODE_HZ && hz != I2C_FAST_MODE_PLUS_HZ) {
+        return false;
+    }
+    wire.setClock(hz);
+    clockHz = hz;
+    return true;
+}
+
+// Bus clear (UM10204 3.1.16): with the controller detached, pulse SCL until the device
+// holding SDA has shifted out the rest of its byte, then generate a STOP and hand the
+// pins back to the driver
+bool WireI2CBus::clearBus() {
+    if (digitalRead(sdaPin) == HIGH) {
+        return true;  // Nothing holds the bus
+    }
+    wire.end();
+    pinMode(sdaPin, INPUT_PULLUP);
+    pinMode(sclPin, OUTPUT_OPEN_DRAIN);
+    digitalWrite(sclPin, HIGH);
+    for (int pulse = 0; pulse < I2C_CLEAR_PULSES && digitalRead(sdaPin) == LOW; pulse++) {
+        digitalWrite(sclPin, LOW);
+        ::delayMicroseconds(I2C_CLEAR_HALF_PERIOD_US);
+        digitalWrite(sclPin, HIGH);
+        ::delayMicroseconds(I2C_CLEAR_HALF_PERIOD_US);
+    }
+
+    // STOP: SDA rises while SCL is high
+    pinMode(sdaPin, OUTPUT_OPEN_DRAIN);
+    digitalWrite(sdaPin, LOW);
+    ::delayMicroseconds(I2C_CLEAR_HALF_PERIOD_US);
+    digitalWrite(sdaPin, HIGH);
+    ::delayMicroseconds(I2C_CLEAR_HALF_PERIOD_US);
+    pinMode(sdaPin, INPUT_PULLUP);
+    bool released = digitalRead(sdaPin) == HIGH;
+
+    wire.begin(sdaPin, sclPin, clockHz);
+    return released;
+}
+
+uint32_t WireI2CBus::micros() {
+    return ::micros();
+}
+
+void WireI2CBus::delayMicros(uint32_t us) {
+    ::delayMicroseconds(us);
+}
@@ -0,0 +1,48 @@
+#ifndef MOCK_ARDUINO_H
+#define MOCK_ARDUINO_H
+
+// Host stand-in for the parts of the Arduino core used by the I2C transport, running on
+// the simulated clock and GPIO pads
+#include <stddef.h>
+#include <stdint.h>
+#include "sim_clock.h"
+#include "sim_gpio.h"
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define OUTPUT_OPEN_DRAIN 0x13
+
+inline unsigned long micros() {
+    return static_cast<unsigned long>(static_cast<uint32_t>(sim::nowUs()));
+}
+
+inline unsigned long millis() {
+    return static_cast<unsigned long>(static_cast<uint32_t>(sim::nowUs() / 1000));
+}
+
+inline void delayMicroseconds(unsigned int us) {
+    sim::advanceUs(us);
+}
+
+inline void delay(unsigned long ms) {
+    sim::advanceUs(static_cast<uint64_t>(ms) * 1000);
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    if (mode == INPUT || mode == INPUT_PULLUP) {
+        sim::releasePin(pin);
+    }
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+    sim::writePin(pin, value != LOW);
+}
+
+inline int digitalRead(uint8_t pin) {
+    return sim::readPin(pin) ? HIGH : LOW;
+}
+
+#endif // MOCK_ARDUINO_H
@@ -0,0 +1,121 @@
+#ifndef MOCK_WIRE_H
+#define MOCK_WIRE_H
+
+// Host stand-in for the Arduino TwoWire driver, forwarding to a SimulatedI2CBus so the
+// firmware's WireI2CBus transport runs unchanged in native tests. Return codes follow
+// the ESP32 core: endTransmission() gives 0 on success, 2 on an address NACK and 5 on
+// a timeout.
+#include <stddef.h>
+#include <stdint.h>
+#include "simulated_i2c_bus.h"
+
+#define MOCK_WIRE_BUFFER_LENGTH 128
+
+class TwoWire {
+public:
+    TwoWire() : bus(nullptr), running(true), begins(0), txAddress(0), txLength(0), rxLength(0), rxIndex(0) {}
+
+    // Route this instance's transactions to a simulated bus
+    void attach(SimulatedI2CBus* simulatedBus) {
+        bus = simulatedBus;
+    }
+
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {
+        (void)sda;
+        (void)scl;
+        running = true;
+        begins++;
+        if (frequency) {
+            setClock(frequency);
+        }
+        return bus != nullptr;
+    }
+
+    // Releases the pins (for a bus clear); transfers fail until the next begin()
+    bool end() {
+        running = false;
+        return true;
+    }
+
+    bool isRunning() const { return running; }
+    uint32_t getBeginCount() const { return begins; }
+
+    bool setClock(uint32_t frequency) {
+        return bus != nullptr && bus->setClock(frequency);
+    }
+
+    void setTimeOut(uint16_t timeoutMs) {
+        if (bus != nullptr) {
+            bus->setTimeoutUs(static_cast<uint32_t>(timeoutMs) * 1000);
+        }
+    }
+
+    void beginTransmission(uint8_t address) {
+        txAddress = address;
+        txLength = 0;
+    }
+
+    size_t write(uint8_t data) {
+        if (txLength >= MOCK_WIRE_BUFFER_LENGTH) {
+            return 0;
+        }
+        txBuffer[txLength++] = data;
+        return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t length) {
+        size_t written = 0;
+        while (written < length && write(data[written])) {
+            written++;
+        }
+        return written;
+    }
+
+    uint8_t endTransmission(bool sendStop = true) {
+        (void)sendStop;
+        if (bus == nullptr || !running) {
+            return 4;
+        }
+        switch (bus->transferWrite(txAddress, txBuffer, txLength)) {
+            case SIM_I2C_OK: return 0;
+            case SIM_I2C_NACK: return 2;
+            default: return 5;
+        }
+    }
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity) {
+        rxIndex = 0;
+        rxLength = 0;
+        if (bus == nullptr || !running || quantity > MOCK_WIRE_BUFFER_LENGTH) {
+            return 0;
+        }
+        if (bus->transferRead(address, rxBuffer, quantity) != SIM_I2C_OK) {
+            return 0;
+        }
+        rxLength = quantity;
+        return quantity;
+    }
+
+    int available() {
+        return rxLength - rxIndex;
+    }
+
+    int read() {
+        return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1;
+    }
+
+private:
+    SimulatedI2CBus* bus;
+    bool running;
+    uint32_t begins;
+    uint8_t txAddress;
+    uint8_t txBuffer[MOCK_WIRE_BUFFER_LENGTH];
+    size_t txLength;
+    uint8_t rxBuffer[MOCK_WIRE_BUFFER_LENGTH];
+    size_t rxLength;
+    size_t rxIndex;
+};
+
+inline TwoWire Wire;
+
+#endif // MOCK_WIRE_H
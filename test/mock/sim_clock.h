@@ -0,0 +1,31 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <stdint.h>
+
+// Virtual time shared by the simulated bus, the simulated converters and the Arduino
+// time functions of the host build. Nothing sleeps: waiting advances the clock, so a
+// second of acquisition runs in however long the code under test takes to execute.
+namespace sim {
+
+inline uint64_t clockNs = 0;
+
+inline uint64_t nowUs() {
+    return clockNs / 1000;
+}
+
+inline void advanceNs(uint64_t ns) {
+    clockNs += ns;
+}
+
+inline void advanceUs(uint64_t us) {
+    clockNs += us * 1000;
+}
+
+inline void resetClock() {
+    clockNs = 0;
+}
+
+}  // namespace sim
+
+#endif // SIM_CLOCK_H
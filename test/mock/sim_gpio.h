@@ -0,0 +1,48 @@
+#ifndef SIM_GPIO_H
+#define SIM_GPIO_H
+
+#include <stdint.h>
+
+// Simulated GPIO pads of the host build. Every pad has a pull-up: it reads high unless
+// the firmware drives it low or an attached listener (a simulated bus holding SDA)
+// pulls it low.
+namespace sim {
+
+#define SIM_GPIO_PINS 64
+
+class GpioListener {
+public:
+    virtual ~GpioListener() {}
+    virtual void pinWritten(uint8_t pin, bool high) = 0;
+    virtual bool pinPulledLow(uint8_t pin) = 0;
+};
+
+inline GpioListener* gpioListener = nullptr;
+inline bool pinDrivenLow[SIM_GPIO_PINS] = {};
+
+inline void releasePin(uint8_t pin) {
+    if (pin < SIM_GPIO_PINS) {
+        pinDrivenLow[pin] = false;
+    }
+}
+
+inline void writePin(uint8_t pin, bool high) {
+    if (pin >= SIM_GPIO_PINS) {
+        return;
+    }
+    pinDrivenLow[pin] = !high;
+    if (gpioListener != nullptr) {
+        gpioListener->pinWritten(pin, high);
+    }
+}
+
+inline bool readPin(uint8_t pin) {
+    if (pin >= SIM_GPIO_PINS) {
+        return false;
+    }
+    return !pinDrivenLow[pin] && !(gpioListener != nullptr && gpioListener->pinPulledLow(pin));
+}
+
+}  // namespace sim
+
+#endif // SIM_GPIO_H
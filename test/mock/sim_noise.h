@@ -0,0 +1,24 @@
+#ifndef SIM_NOISE_H
+#define SIM_NOISE_H
+
+#include <stdint.h>
+
+// Deterministic uniform noise for host tests: a fixed LCG, so every run of a suite sees
+// the same signal. Suites call resetNoise() from setUp() to make tests order-independent.
+namespace sim {
+
+inline uint32_t noiseState = 1;
+
+inline void resetNoise() {
+    noiseState = 1;
+}
+
+// Uniform in [-amplitude, amplitude]
+inline int32_t noise(int32_t amplitude) {
+    noiseState = noiseState * 1664525u + 1013904223u;
+    return static_cast<int32_t>(static_cast<int64_t>(noiseState >> 8) % (2 * amplitude + 1)) - amplitude;
+}
+
+}  // namespace sim
+
+#endif // SIM_NOISE_H
@@ -0,0 +1,215 @@
+#ifndef SIMULATED_ADS1115_H
+#define SIMULATED_ADS1115_H
+
+#include <stdint.h>
+#include "ads1115_driver.h"
+#include "simulated_i2c_bus.h"
+
+// Register model of an ADS1115 for host tests.
+//
+// Conversions take the data sheet time for the configured rate, scaled by an oscillator
+// error, and sample the input of the configured mux at the configured PGA when they
+// complete, plus optional triangular noise from a seeded generator (runs are
+// repeatable). Single-shot and continuous modes, the config OS bit and the ALERT/RDY
+// conversion-ready pulse (Hi_thresh MSB set, Lo_thresh MSB clear) are modelled; the
+// comparator is not. Faults are injected per transaction: NACKs, timeouts, or the whole
+// device going offline (unplugged or held in reset).
+class SimulatedAds1115 : public SimulatedI2CDevice {
+public:
+    explicit SimulatedAds1115(uint8_t address)
+        : address(address), noisePeak(0), noiseState(1), oscillatorPermille(0), offline(false),
+          faultStatus(SIM_I2C_OK), faultCount(0) {
+        for (int i = 0; i < 8; i++) {
+            inputs[i] = 0;
+        }
+        powerOn();
+    }
+
+    // Power-on reset: default registers, no conversion in progress, statistics cleared
+    void powerOn() {
+        registers[ADS1115_REG_CONVERSION] = 0;
+        registers[ADS1115_REG_CONFIG] = ADS1115_CONFIG_DEFAULT & ~ADS1115_CONFIG_OS_SINGLE;
+        registers[ADS1115_REG_LO_THRESH] = 0x8000;
+        registers[ADS1115_REG_HI_THRESH] = 0x7FFF;
+        pointer = ADS1115_REG_CONVERSION;
+        converting = false;
+        continuous = false;
+        conversionDoneUs = 0;
+        readyEdges = 0;
+        conversions = 0;
+        muxChanges = 0;
+    }
+
+    // Input voltage seen through a mux setting (differential or against GND)
+    void setInputMicrovolts(Ads1115Mux mux, int32_t microvolts) {
+        inputs[mux >> 12] = microvolts;
+    }
+
+    // Noise added to every conversion, up to +/-peakCodes
+    void setNoise(uint16_t peakCodes, uint32_t seed = 1) {
+        noisePeak = peakCodes;
+        noiseState = seed ? seed : 1;
+    }
+
+    // Conversion time error of the internal oscillator (data sheet: +/-10%)
+    void setOscillatorError(int16_t permille) {
+        oscillatorPermille = permille;
+    }
+
+    void failNext(SimI2CStatus status, uint32_t count = 1) {
+        faultStatus = status;
+        faultCount = count;
+    }
+
+    void setOffline(bool isOffline) {
+        offline = isOffline;
+    }
+
+    // ALERT/RDY falling edges since the last call; only pulses in conversion-ready mode
+    uint32_t takeReadyEdges(uint64_t nowUs) {
+        update(nowUs);
+        uint32_t edges = readyEdges;
+        readyEdges = 0;
+        return alertIsReadySignal() ? edges : 0;
+    }
+
+    // Completion time of the conversion in progress (0 when idle)
+    uint64_t nextConversionUs() const {
+        return converting ? conversionDoneUs : 0;
+    }
+
+    uint32_t getConversions() const { return conversions; }
+    uint32_t getMuxChanges() const { return muxChanges; }
+    bool isContinuous() const { return continuous; }
+    uint16_t getRegister(uint8_t reg) const { return registers[reg & 0x03]; }
+
+    // Conversion time of the configured rate, including the oscillator error
+    uint32_t conversionTimeUs() const {
+        static const uint32_t nominalUs[8] = {125000, 62500, 31250, 15625, 7813, 4000, 2106, 1163};
+        uint32_t nominal = nominalUs[(registers[ADS1115_REG_CONFIG] & ADS1115_CONFIG_DR_MASK) >> 5];
+        return static_cast<uint32_t>(static_cast<int64_t>(nominal) * (1000 + oscillatorPermille) / 1000);
+    }
+
+    uint8_t getAddress() const override {
+        return address;
+    }
+
+    SimI2CStatus acknowledge() override {
+        if (offline) {
+            return SIM_I2C_NACK;
+        }
+        if (faultCount > 0) {
+            faultCount--;
+            return faultStatus;
+        }
+        return SIM_I2C_OK;
+    }
+
+    void receive(const uint8_t* data, size_t length, uint64_t nowUs) override {
+        update(nowUs);
+        if (length == 0) {
+            return;  // Address probe
+        }
+        pointer = data[0] & 0x03;
+        if (length < 3) {
+            return;
+        }
+        uint16_t value = (static_cast<uint16_t>(data[1]) << 8) | data[2];
+        if (pointer == ADS1115_REG_CONFIG) {
+            writeConfig(value, nowUs);
+        } else if (pointer != ADS1115_REG_CONVERSION) {
+            registers[pointer] = value;
+        }
+    }
+
+    void transmit(uint8_t* data, size_t length, uint64_t nowUs) override {
+        update(nowUs);
+        uint16_t value = registers[pointer];
+        if (pointer == ADS1115_REG_CONFIG && !converting) {
+            value |= ADS1115_CONFIG_OS_SINGLE;  // 1 = no conversion in progress
+        }
+        for (size_t i = 0; i < length; i++) {
+            data[i] = (i % 2 == 0) ? (value >> 8) : (value & 0xFF);
+        }
+    }
+
+private:
+    void writeConfig(uint16_t value, uint64_t nowUs) {
+        uint16_t previous = registers[ADS1115_REG_CONFIG];
+        if ((previous ^ value) & ADS1115_CONFIG_MUX_MASK) {
+            muxChanges++;
+        }
+        registers[ADS1115_REG_CONFIG] = value & ~ADS1115_CONFIG_OS_SINGLE;
+        continuous = !(value & ADS1115_CONFIG_MODE_SINGLE);
+        if (continuous || (value & ADS1115_CONFIG_OS_SINGLE)) {
+            converting = true;
+            conversionDoneUs = nowUs + conversionTimeUs();
+        }
+    }
+
+    // Complete every conversion that has finished by nowUs
+    void update(uint64_t nowUs) {
+        while (converting && nowUs >= conversionDoneUs) {
+            registers[ADS1115_REG_CONVERSION] = static_cast<uint16_t>(convert());
+            conversions++;
+            readyEdges++;
+            if (continuous) {
+                conversionDoneUs += conversionTimeUs();
+            } else {
+                converting = false;
+            }
+        }
+    }
+
+    int16_t convert() {
+        uint16_t config = registers[ADS1115_REG_CONFIG];
+        Ads1115Gain gain = static_cast<Ads1115Gain>(config & ADS1115_CONFIG_PGA_MASK);
+        int64_t code = static_cast<int64_t>(inputs[(config & ADS1115_CONFIG_MUX_MASK) >> 12]) * 32768 /
+                       fullScaleMicrovolts(gain);
+        code += noise();
+        if (code > 32767) return 32767;
+        if (code < -32768) return -32768;
+        return static_cast<int16_t>(code);
+    }
+
+    int32_t noise() {
+        if (noisePeak == 0) {
+            return 0;
+        }
+        uint32_t span = 2 * static_cast<uint32_t>(noisePeak) + 1;
+        int32_t a = static_cast<int32_t>(nextRandom() % span) - noisePeak;
+        int32_t b = static_cast<int32_t>(nextRandom() % span) - noisePeak;
+        return (a + b) / 2;
+    }
+
+    uint32_t nextRandom() {
+        noiseState ^= noiseState << 13;
+        noiseState ^= noiseState >> 17;
+        noiseState ^= noiseState << 5;
+        return noiseState;
+    }
+
+    bool alertIsReadySignal() const {
+        return (registers[ADS1115_REG_HI_THRESH] & 0x8000) && !(registers[ADS1115_REG_LO_THRESH] & 0x8000) &&
+               (registers[ADS1115_REG_CONFIG] & 0x0003) != ADS1115_CONFIG_COMP_QUE_NONE;
+    }
+
+    uint8_t address;
+    uint16_t registers[4];
+    uint8_t pointer;
+    int32_t inputs[8];  // Microvolts per mux setting
+    bool converting;
+    bool continuous;
+    uint64_t conversionDoneUs;
+    uint32_t readyEdges;
+    uint32_t conversions;
+    uint32_t muxChanges;
+    uint16_t noisePeak;
+    uint32_t noiseState;
+    int16_t oscillatorPermille;
+    bool offline;
+    SimI2CStatus faultStatus;
+    uint32_t faultCount;
+};
+
+#endif // SIMULATED_ADS1115_H
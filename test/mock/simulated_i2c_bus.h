@@ -0,0 +1,174 @@
+#ifndef SIMULATED_I2C_BUS_H
+#define SIMULATED_I2C_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "i2c_bus.h"
+#include "sim_clock.h"
+#include "sim_gpio.h"
+
+#define SIM_I2C_MAX_DEVICES 8
+
+// How long a transaction that times out holds the bus (the firmware sets I2C_TIMEOUT_MS)
+#define SIM_I2C_DEFAULT_TIMEOUT_US 5000
+
+// Outcome of the address phase of a simulated transaction
+enum SimI2CStatus { SIM_I2C_OK, SIM_I2C_NACK, SIM_I2C_TIMEOUT };
+
+// A target on the simulated bus. acknowledge() decides the address phase (and is where
+// injected faults fire); the data moves at the STOP, once the transfer time has elapsed.
+class SimulatedI2CDevice {
+public:
+    virtual ~SimulatedI2CDevice() {}
+    virtual uint8_t getAddress() const = 0;
+    virtual SimI2CStatus acknowledge() = 0;
+    virtual void receive(const uint8_t* data, size_t length, uint64_t nowUs) = 0;
+    virtual void transmit(uint8_t* data, size_t length, uint64_t nowUs) = 0;
+};
+
+// Host I2C bus: routes transactions to attached devices and charges their duration to
+// the simulated clock at the configured bus speed (9 bit times per byte plus START and
+// STOP). A NACK costs the address byte; a timeout holds the bus for the timeout.
+// With its pins attached to the simulated GPIO it can also model a target stuck holding
+// SDA low, which only SCL clocks bit-banged on the pins release.
+class SimulatedI2CBus : public I2CBus, public sim::GpioListener {
+public:
+    SimulatedI2CBus()
+        : clockHz(I2C_FAST_MODE_HZ), timeoutUs(SIM_I2C_DEFAULT_TIMEOUT_US), deviceCount(0),
+          transactions(0), failures(0), busyNs(0), sdaPin(-1), sclPin(-1), sdaHeldClocks(0),
+          sclClocks(0), sclLow(false) {}
+
+    ~SimulatedI2CBus() override {
+        if (sim::gpioListener == this) {
+            sim::gpioListener = nullptr;
+        }
+    }
+
+    void attach(SimulatedI2CDevice* device) {
+        if (deviceCount < SIM_I2C_MAX_DEVICES) {
+            devices[deviceCount++] = device;
+        }
+    }
+
+    SimI2CStatus transferWrite(uint8_t address, const uint8_t* data, size_t length) {
+        SimulatedI2CDevice* device = nullptr;
+        SimI2CStatus status = addressPhase(address, length, device);
+        if (status == SIM_I2C_OK) {
+            device->receive(data, length, sim::nowUs());
+        }
+        return status;
+    }
+
+    SimI2CStatus transferRead(uint8_t address, uint8_t* data, size_t length) {
+        SimulatedI2CDevice* device = nullptr;
+        SimI2CStatus status = addressPhase(address, length, device);
+        if (status == SIM_I2C_OK) {
+            device->transmit(data, length, sim::nowUs());
+        }
+        return status;
+    }
+
+    void attachPins(int sda, int scl) {
+        sdaPin = sda;
+        sclPin = scl;
+        sim::gpioListener = this;
+    }
+
+    // A target keeps SDA low until it has seen this many SCL clocks; every transaction
+    // times out meanwhile
+    void holdSdaLow(uint8_t clocks) { sdaHeldClocks = clocks; }
+    bool isSdaHeld() const { return sdaHeldClocks > 0; }
+    uint32_t getSclClocks() const { return sclClocks; }
+
+    void pinWritten(uint8_t pin, bool high) override {
+        if (static_cast<int>(pin) != sclPin) {
+            return;
+        }
+        bool rising = high && sclLow;
+        sclLow = !high;
+        if (!rising) {
+            return;
+        }
+        sclClocks++;
+        if (sdaHeldClocks > 0) {
+            sdaHeldClocks--;
+        }
+    }
+
+    bool pinPulledLow(uint8_t pin) override {
+        return static_cast<int>(pin) == sdaPin && sdaHeldClocks > 0;
+    }
+
+    bool write(uint8_t address, const uint8_t* data, size_t length) override {
+        return transferWrite(address, data, length) == SIM_I2C_OK;
+    }
+
+    bool read(uint8_t address, uint8_t* data, size_t length) override {
+        return transferRead(address, data, length) == SIM_I2C_OK;
+    }
+
+    bool setClock(uint32_t hz) override {
+        if (hz != I2C_STANDARD_MODE_HZ && hz != I2C_FAST_MODE_HZ && hz != I2C_FAST_MODE_PLUS_HZ) {
+            return false;
+        }
+        clockHz = hz;
+        return true;
+    }
+
+    uint32_t micros() override {
+        return static_cast<uint32_t>(sim::nowUs());
+    }
+
+    void delayMicros(uint32_t us) override {
+        sim::advanceUs(us);
+    }
+
+    uint32_t getClock() const { return clockHz; }
+    void setTimeoutUs(uint32_t us) { timeoutUs = us; }
+    uint32_t getTransactions() const { return transactions; }
+    uint32_t getFailures() const { return failures; }
+    uint64_t getBusyUs() const { return busyNs / 1000; }
+
+private:
+    SimI2CStatus addressPhase(uint8_t address, size_t dataBytes, SimulatedI2CDevice*& device) {
+        transactions++;
+        device = nullptr;
+        for (uint8_t i = 0; i < deviceCount; i++) {
+            if (devices[i]->getAddress() == address) {
+                device = devices[i];
+                break;
+            }
+        }
+        SimI2CStatus status = sdaHeldClocks > 0  ? SIM_I2C_TIMEOUT
+                              : device != nullptr ? device->acknowledge()
+                                                  : SIM_I2C_NACK;
+        uint64_t ns = status == SIM_I2C_OK      ? bitsToNs((dataBytes + 1) * 9 + 2)
+                      : status == SIM_I2C_NACK  ? bitsToNs(9 + 2)
+                                                : static_cast<uint64_t>(timeoutUs) * 1000;
+        sim::advanceNs(ns);
+        busyNs += ns;
+        if (status != SIM_I2C_OK) {
+            failures++;
+        }
+        return status;
+    }
+
+    uint64_t bitsToNs(uint64_t bits) const {
+        return bits * 1000000000ULL / clockHz;
+    }
+
+    uint32_t clockHz;
+    uint32_t timeoutUs;
+    SimulatedI2CDevice* devices[SIM_I2C_MAX_DEVICES];
+    uint8_t deviceCount;
+    uint32_t transactions;
+    uint32_t failures;
+    uint64_t busyNs;
+    int sdaPin;
+    int sclPin;
+    uint8_t sdaHeldClocks;
+    uint32_t sclClocks;
+    bool sclLow;
+};
+
+#endif // SIMULATED_I2C_BUS_H
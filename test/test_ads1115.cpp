@@ -1,24 +1,28 @@
 #include <Arduino.h>
 #include <unity.h>
-#include <Adafruit_ADS1X15.h>
+#include <Wire.h>
 #include <BLEDevice.h>
 #include <Preferences.h>
 #include <WiFi.h>
 #include "adc_module.h"
+#include "wire_i2c_bus.h"
+#include "config.h"
 #include "relay_module.h"
 #include "wifi_module.h"
 #include "ble_module.h"
 
-Adafruit_ADS1115 ads1;
-Adafruit_ADS1115 ads2;
+WireI2CBus testBus(Wire, I2C_SDA_PIN, I2C_SCL_PIN);
+Ads1115 ads1;
+Ads1115 ads2;
 Preferences prefs;
 
 void test_ads1_initialization() {
-    TEST_ASSERT_TRUE(ads1.begin(0x48));
+    Wire.begin();
+    TEST_ASSERT_TRUE(ads1.begin(&testBus, 0x48));
 }
 
 void test_ads2_initialization() {
-    TEST_ASSERT_TRUE(ads2.begin(0x49));
+    TEST_ASSERT_TRUE(ads2.begin(&testBus, 0x49));
 }
 
 void test_ble_initialization() {
@@ -44,16 +48,11 @@ void test_wifi_scan() {
 
 // --- ADC Module Tests ---
 void test_adc_calibration() {
-    // Simulate known values for calibration
-    float oldOffset = shuntOffset;
-    shuntOffset = 0.0;
-    // Simulate calibration logic
-    float testSum = 1000.0;
-    int numSamples = 10;
-    float expectedOffset = testSum / numSamples;
-    shuntOffset = expectedOffset;
-    TEST_ASSERT_EQUAL_FLOAT(expectedOffset, shuntOffset);
-    shuntOffset = oldOffset;
+    // An offset measured at the nominal gain is removed at every gain
+    GainOffsetTable offsets(SHUNT_WIDEST_GAIN);
+    offsets.setCalibratedOffset(SHUNT_GAIN, countsToQ31(100));
+    TEST_ASSERT_EQUAL_INT32(0, offsets.correct(100, SHUNT_GAIN));
+    TEST_ASSERT_EQUAL_INT32(0, offsets.correct(200, SHUNT_NARROWEST_GAIN));
 }
 
 void test_adc_averaging() {
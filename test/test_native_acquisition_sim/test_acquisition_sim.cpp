@@ -0,0 +1,502 @@
+// Host tests and throughput benchmarks of the acquisition path against simulated
+// ADS1115s, through the firmware's WireI2CBus transport on a TwoWire stand-in
+#include <unity.h>
+#include <stdio.h>
+#include <chrono>
+#include <Wire.h>
+#include "wire_i2c_bus.h"
+#include "adc_scanner.h"
+#include "device_recovery.h"
+#include "adc_sample.h"
+#include "auto_ranger.h"
+#include "energy_integrator.h"
+#include "simulated_ads1115.h"
+
+static const AdcChannelConfig TABLE[] = {
+    {"shunt", 0, ADS1115_MUX_DIFF_0_1, GAIN_EIGHT, ADS1115_RATE_860SPS},
+    {"bus", 1, ADS1115_MUX_SINGLE_0, GAIN_ONE, ADS1115_RATE_860SPS},
+    {"aux", 1, ADS1115_MUX_SINGLE_1, GAIN_ONE, ADS1115_RATE_860SPS},
+};
+static const uint8_t TABLE_SIZE = sizeof(TABLE) / sizeof(TABLE[0]);
+static const uint8_t CURRENT = 0;
+static const uint8_t VOLTAGE = 1;
+static const int SDA_PIN = 21;
+static const int SCL_PIN = 22;
+
+static SimulatedI2CBus* simBus = nullptr;
+static SimulatedAds1115* chip1 = nullptr;
+static SimulatedAds1115* chip2 = nullptr;
+static WireI2CBus* wireBus = nullptr;
+static AdcScanner* scanner = nullptr;
+static RecoveryScheduler* recovery = nullptr;
+
+// Device events seen by the scanner's owner, with the simulated time they arrived
+static int eventCount[ADC_DEVICE_CONTINUOUS_FAILED + 1];
+static uint64_t lastEventUs[ADC_DEVICE_CONTINUOUS_FAILED + 1];
+
+static void recordEvent(uint8_t device, AdcDeviceEvent event, uint8_t errorCount) {
+    (void)errorCount;
+    eventCount[event]++;
+    lastEventUs[event] = sim::nowUs();
+    if (event == ADC_DEVICE_LOST) {
+        recovery->markLost(device, static_cast<int64_t>(sim::nowUs()));
+    }
+}
+
+void setUp(void) {
+    sim::resetClock();
+    for (int i = 0; i <= ADC_DEVICE_CONTINUOUS_FAILED; i++) {
+        eventCount[i] = 0;
+        lastEventUs[i] = 0;
+    }
+    simBus = new SimulatedI2CBus();
+    chip1 = new SimulatedAds1115(0x48);
+    chip2 = new SimulatedAds1115(0x49);
+    simBus->attach(chip1);
+    simBus->attach(chip2);
+    simBus->attachPins(SDA_PIN, SCL_PIN);
+    Wire.attach(simBus);
+    Wire.setTimeOut(SIM_I2C_DEFAULT_TIMEOUT_US / 1000);
+    wireBus = new WireI2CBus(Wire, SDA_PIN, SCL_PIN);
+    wireBus->setClock(I2C_FAST_MODE_HZ);
+    recovery = new RecoveryScheduler();
+    scanner = new AdcScanner(TABLE, TABLE_SIZE);
+    scanner->setBus(wireBus);
+    scanner->setEventHandler(recordEvent);
+
+    chip1->setInputMicrovolts(ADS1115_MUX_DIFF_0_1, 100000);  // 100 A through 1 mOhm
+    chip2->setInputMicrovolts(ADS1115_MUX_SINGLE_0, 3300000);
+    chip2->setInputMicrovolts(ADS1115_MUX_SINGLE_1, 1000000);
+}
+
+void tearDown(void) {
+    delete scanner;
+    delete recovery;
+    delete wireBus;
+    delete chip2;
+    delete chip1;
+    delete simBus;
+}
+
+static void startTwoChannelScan() {
+    TEST_ASSERT_TRUE(scanner->probe(0));
+    TEST_ASSERT_TRUE(scanner->probe(1));
+    const uint8_t list[] = {CURRENT, VOLTAGE};
+    TEST_ASSERT_TRUE(scanner->configureScan(list, 2));
+}
+
+// Run single-shot slots back to back for a span of simulated time; returns paced samples
+static uint32_t runSingleShot(uint64_t spanUs) {
+    uint64_t endUs = sim::nowUs() + spanUs;
+    uint32_t samples = 0;
+    while (sim::nowUs() < endUs) {
+        if (scanner->readSlot(static_cast<int64_t>(sim::nowUs()), CURRENT)) {
+            samples++;
+        }
+    }
+    return samples;
+}
+
+// What the firmware's recovery task does when woken: bus clear and reattach of every lost
+// device that is due
+static void serviceRecovery() {
+    int64_t nowUs = static_cast<int64_t>(sim::nowUs());
+    uint8_t due = recovery->getDueMask(nowUs);
+    for (uint8_t device = 0; device < ADC_MAX_DEVICES; device++) {
+        if (!(due & (1 << device))) {
+            continue;
+        }
+        wireBus->clearBus();
+        if (scanner->reattach(device)) {
+            recovery->markRecovered(device, static_cast<int64_t>(sim::nowUs()));
+        } else {
+            recovery->attemptFailed(device, static_cast<int64_t>(sim::nowUs()));
+        }
+    }
+}
+
+// Single-shot slots with the recovery task getting the bus between them
+static uint32_t runWithRecovery(uint64_t spanUs) {
+    uint64_t endUs = sim::nowUs() + spanUs;
+    uint32_t samples = 0;
+    while (sim::nowUs() < endUs) {
+        if (scanner->readSlot(static_cast<int64_t>(sim::nowUs()), CURRENT)) {
+            samples++;
+        }
+        serviceRecovery();
+    }
+    return samples;
+}
+
+// Continuous mode: advance to the next conversion edge of either chip and service it like
+// the ALERT/RDY interrupt and dataTask would; returns paced samples
+static uint32_t runContinuous(uint64_t spanUs) {
+    SimulatedAds1115* chips[2] = {chip1, chip2};
+    uint64_t endUs = sim::nowUs() + spanUs;
+    uint32_t samples = 0;
+    while (sim::nowUs() < endUs) {
+        uint64_t nextUs = UINT64_MAX;
+        for (int i = 0; i < 2; i++) {
+            uint64_t doneUs = chips[i]->nextConversionUs();
+            if (doneUs && doneUs < nextUs) nextUs = doneUs;
+        }
+        if (nextUs > sim::nowUs()) {
+            sim::advanceUs(nextUs - sim::nowUs());
+        }
+        uint32_t readyBits = 0;
+        int64_t readyUs[ADC_MAX_DEVICES] = {0};
+        for (int i = 0; i < 2; i++) {
+            if (chips[i]->takeReadyEdges(sim::nowUs())) {
+                readyBits |= 1UL << i;
+                readyUs[i] = static_cast<int64_t>(sim::nowUs());
+            }
+        }
+        if (scanner->readReady(readyBits, readyUs) & 1) {
+            samples++;
+        }
+    }
+    return samples;
+}
+
+// The AdcSample dataTask stores after a slot: both channels' readings, offset corrected
+static AdcSample takeSample(int64_t timestampUs, GainOffsetTable& shuntOffsets, GainOffsetTable& voltageOffsets) {
+    ChannelReading current = scanner->takeReading(CURRENT);
+    ChannelReading voltage = scanner->takeReading(VOLTAGE);
+    AdcSample sample;
+    sample.timestampUs = timestampUs;
+    sample.shuntRaw = current.raw;
+    sample.ads2Raw = voltage.raw;
+    sample.shuntGain = current.gain;
+    sample.ads2Gain = voltage.gain;
+    sample.shunt = shuntOffsets.correct(current.raw, current.gain);
+    sample.ads2 = voltageOffsets.correct(voltage.raw, voltage.gain);
+    sample.shuntQuality = current.quality;
+    sample.ads2Quality = voltage.quality;
+    sample.shuntUs = current.timestampUs;
+    sample.ads2Us = voltage.timestampUs;
+    return sample;
+}
+
+void test_readings_follow_simulated_inputs() {
+    startTwoChannelScan();
+    TEST_ASSERT_TRUE(scanner->readSlot(1234, CURRENT));
+
+    // 100 mV at +/-0.512 V and 3.3 V at +/-4.096 V
+    TEST_ASSERT_EQUAL_INT16(6400, scanner->getReading(CURRENT).raw);
+    TEST_ASSERT_EQUAL_INT16(26400, scanner->getReading(VOLTAGE).raw);
+    TEST_ASSERT_EQUAL(GAIN_EIGHT, scanner->getReading(CURRENT).gain);
+    // Stamped at the middle of each conversion; the second device starts one config
+    // write later than the first
+    uint32_t halfConversionUs = scanner->getDevice(0).conversionTimeUs() / 2;
+    int64_t currentUs = scanner->getReading(CURRENT).timestampUs;
+    int64_t voltageUs = scanner->getReading(VOLTAGE).timestampUs;
+    TEST_ASSERT_GREATER_THAN_INT64(1234 + halfConversionUs, currentUs);
+    TEST_ASSERT_GREATER_THAN_INT64(currentUs, voltageUs);
+    TEST_ASSERT_LESS_THAN_INT64(currentUs + 500, voltageUs);
+}
+
+void test_single_shot_throughput() {
+    startTwoChannelScan();
+    uint32_t fastMode = runSingleShot(1000000);
+
+    TEST_ASSERT_TRUE(simBus->setClock(I2C_FAST_MODE_PLUS_HZ));
+    uint32_t fastModePlus = runSingleShot(1000000);
+
+    printf("single-shot, 2 chips at 860 SPS: %u samples/s at 400 kHz, %u samples/s at 1 MHz\n",
+           fastMode, fastModePlus);
+    // Conversions overlap, so a pair costs one conversion plus the bus traffic
+    TEST_ASSERT_GREATER_THAN_UINT32(500, fastMode);
+    TEST_ASSERT_LESS_THAN_UINT32(860, fastModePlus);
+    TEST_ASSERT_GREATER_THAN_UINT32(fastMode, fastModePlus);
+}
+
+void test_continuous_throughput_and_bus_traffic() {
+    startTwoChannelScan();
+    scanner->setContinuous(true);
+    TEST_ASSERT_TRUE(chip1->isContinuous());
+    TEST_ASSERT_TRUE(chip2->isContinuous());
+
+    uint32_t transactionsBefore = simBus->getTransactions();
+    uint32_t samples = runContinuous(1000000);
+    uint32_t transactions = simBus->getTransactions() - transactionsBefore;
+
+    printf("continuous, 2 chips at 860 SPS: %u samples/s, %.2f bus transactions per sample\n", samples,
+           static_cast<double>(transactions) / samples);
+    // The data rate itself (1163 us per conversion), one bare 2-byte read per chip
+    TEST_ASSERT_UINT32_WITHIN(2, 859, samples);
+    TEST_ASSERT_UINT32_WITHIN(2 * 2, 2 * samples, transactions);
+}
+
+void test_oscillator_error_stretches_conversions() {
+    startTwoChannelScan();
+    chip1->setOscillatorError(100);  // 10% slow
+    chip2->setOscillatorError(100);
+    scanner->setContinuous(true);
+    uint32_t samples = runContinuous(1000000);
+    TEST_ASSERT_UINT32_WITHIN(2, 781, samples);
+
+    // Single-shot reads still succeed inside the conversion margin
+    scanner->setContinuous(false);
+    runSingleShot(100000);
+    TEST_ASSERT_EQUAL_INT(0, eventCount[ADC_DEVICE_READ_FAILED]);
+}
+
+void test_cpu_per_sample_through_filters() {
+    startTwoChannelScan();
+    chip1->setNoise(40, 7);
+    chip2->setNoise(40, 11);
+    GainOffsetTable shuntOffsets(SHUNT_WIDEST_GAIN);
+    GainOffsetTable voltageOffsets(ADS2_WIDEST_GAIN);
+    SampleDecimator decimator(100000);
+    decimator.setInputPeriod(1163);
+
+    const int SAMPLES = 20000;
+    int outputs = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < SAMPLES; i++) {
+        int64_t timestampUs = static_cast<int64_t>(sim::nowUs());
+        scanner->readSlot(timestampUs, CURRENT);
+        if (decimator.add(takeSample(timestampUs, shuntOffsets, voltageOffsets))) {
+            outputs++;
+        }
+    }
+    double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+
+    printf("host CPU per sample (scan, offset correction, CIC/FIR): %.0f ns\n", elapsedNs / SAMPLES);
+    TEST_ASSERT_GREATER_THAN_INT(0, outputs);
+    // The decimated voltage settles on the simulated 3.3 V within the noise
+    TEST_ASSERT_INT32_WITHIN(2000, 3300000, decimator.ads2Microvolts());
+    TEST_ASSERT_INT32_WITHIN(200000, 100000000, decimator.shuntMicroamps());
+}
+
+void test_nack_burst_marks_device_lost_and_recovers() {
+    startTwoChannelScan();
+    runSingleShot(10000);
+
+    uint64_t outageUs = sim::nowUs();
+    chip2->setOffline(true);
+    uint32_t duringOutage = runWithRecovery(2000000);
+    TEST_ASSERT_EQUAL_INT(1, eventCount[ADC_DEVICE_LOST]);
+    TEST_ASSERT_EQUAL_INT(ADC_MAX_ERRORS_BEFORE_LOST, eventCount[ADC_DEVICE_READ_FAILED]);
+    TEST_ASSERT_FALSE(scanner->isChannelAvailable(VOLTAGE));
+    TEST_ASSERT_TRUE(scanner->isChannelAvailable(CURRENT));
+    // The current channel keeps pacing without the lost chip (faster, even)
+    TEST_ASSERT_GREATER_THAN_UINT32(1000, duringOutage);
+    // Backoff: 10 ms doubling, so about 7 attempts in 2 s rather than one per slot
+    const DeviceRecoveryStatus& status = recovery->getStatus(1);
+    TEST_ASSERT_TRUE(status.lost);
+    TEST_ASSERT_UINT32_WITHIN(1, 7, status.attempts);
+
+    chip2->setOffline(false);
+    uint64_t backUs = sim::nowUs();
+    runWithRecovery(status.retryUs + 10000);
+    TEST_ASSERT_EQUAL_INT(1, eventCount[ADC_DEVICE_RECOVERED]);
+    TEST_ASSERT_TRUE(scanner->isChannelAvailable(VOLTAGE));
+    TEST_ASSERT_FALSE(recovery->getStatus(1).lost);
+
+    uint64_t recoveryUs = lastEventUs[ADC_DEVICE_RECOVERED] - backUs;
+    int64_t degradedUs = recovery->getPipelineDegradedUs(static_cast<int64_t>(sim::nowUs()));
+    printf("reattach %.3f s after the chip returned, pipeline degraded %.3f s\n", recoveryUs / 1e6,
+           degradedUs / 1e6);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(RECOVERY_MAX_RETRY_US, recoveryUs);
+    TEST_ASSERT_INT64_WITHIN(10000, static_cast<int64_t>(lastEventUs[ADC_DEVICE_RECOVERED] - lastEventUs[ADC_DEVICE_LOST]),
+                             degradedUs);
+    TEST_ASSERT_GREATER_OR_EQUAL_INT64(static_cast<int64_t>(backUs - outageUs) - 10000, degradedUs);
+}
+
+void test_dead_device_stall_is_bounded() {
+    startTwoChannelScan();
+    runSingleShot(10000);
+
+    // A chip that stops answering altogether: every transaction runs into the timeout
+    chip2->failNext(SIM_I2C_TIMEOUT, 1000);
+    uint64_t startedUs = sim::nowUs();
+    while (scanner->isDeviceAvailable(1)) {
+        scanner->readSlot(0, CURRENT);
+    }
+    uint64_t stallUs = sim::nowUs() - startedUs;
+    printf("sampling stalled %.1f ms before the dead chip was skipped\n", stallUs / 1e3);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(ADC_MAX_ERRORS_BEFORE_LOST * (SIM_I2C_DEFAULT_TIMEOUT_US + 3000), stallUs);
+
+    startedUs = sim::nowUs();
+    scanner->readSlot(0, CURRENT);
+    TEST_ASSERT_LESS_THAN_UINT64(3000, sim::nowUs() - startedUs);
+}
+
+void test_bus_clear_releases_stuck_sda() {
+    startTwoChannelScan();
+    runSingleShot(10000);
+
+    // A target reset mid-read keeps driving SDA low; the controller sees timeouts only
+    simBus->holdSdaLow(6);
+    while (scanner->isDeviceAvailable(0) || scanner->isDeviceAvailable(1)) {
+        scanner->readSlot(0, CURRENT);
+    }
+    TEST_ASSERT_EQUAL_INT(2, eventCount[ADC_DEVICE_LOST]);
+    TEST_ASSERT_FALSE(scanner->reattach(1));
+
+    uint32_t clocksBefore = simBus->getSclClocks();
+    uint32_t beginsBefore = Wire.getBeginCount();
+    TEST_ASSERT_TRUE(wireBus->clearBus());
+    TEST_ASSERT_FALSE(simBus->isSdaHeld());
+    TEST_ASSERT_EQUAL_UINT32(6, simBus->getSclClocks() - clocksBefore);  // Stops once SDA is released
+    TEST_ASSERT_TRUE(Wire.isRunning());
+    TEST_ASSERT_EQUAL_UINT32(beginsBefore + 1, Wire.getBeginCount());
+    TEST_ASSERT_EQUAL_UINT32(I2C_FAST_MODE_HZ, simBus->getClock());
+
+    TEST_ASSERT_TRUE(scanner->reattach(0));
+    TEST_ASSERT_TRUE(scanner->reattach(1));
+    TEST_ASSERT_TRUE(scanner->readSlot(0, CURRENT));
+    TEST_ASSERT_EQUAL_INT(2, eventCount[ADC_DEVICE_RECOVERED]);
+
+    // A free bus is left alone
+    clocksBefore = simBus->getSclClocks();
+    TEST_ASSERT_TRUE(wireBus->clearBus());
+    TEST_ASSERT_EQUAL_UINT32(clocksBefore, simBus->getSclClocks());
+}
+
+void test_quality_flags_follow_device_state() {
+    startTwoChannelScan();
+    scanner->readSlot(0, CURRENT);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_FRESH, scanner->takeReading(CURRENT).quality);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_FRESH, scanner->takeReading(VOLTAGE).quality);
+    // Taken again without a new conversion: a repeat
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD, scanner->takeReading(VOLTAGE).quality);
+
+    chip2->failNext(SIM_I2C_NACK);
+    scanner->readSlot(0, CURRENT);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_FRESH, scanner->takeReading(CURRENT).quality);
+    ChannelReading stale = scanner->takeReading(VOLTAGE);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE, stale.quality);
+    TEST_ASSERT_EQUAL_INT16(26400, stale.raw);  // 3.3 V held from the slot before
+
+    // Over the range of the PGA: clipped; after a gain change: flagged once
+    chip1->setInputMicrovolts(ADS1115_MUX_DIFF_0_1, 600000);
+    scanner->readSlot(0, CURRENT);
+    ChannelReading clipped = scanner->takeReading(CURRENT);
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, clipped.raw);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_CLIPPED, clipped.quality);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_CLIPPED, scanner->takeReading(CURRENT).quality);
+    scanner->setChannelGain(CURRENT, GAIN_ONE);
+    scanner->readSlot(0, CURRENT);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_GAIN_CHANGED, scanner->takeReading(CURRENT).quality);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD, scanner->takeReading(CURRENT).quality);
+    scanner->readSlot(0, CURRENT);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_FRESH, scanner->takeReading(CURRENT).quality);
+
+    // Lost: recovering until the device converts again
+    chip2->setOffline(true);
+    while (scanner->isDeviceAvailable(1)) {
+        scanner->readSlot(0, CURRENT);
+    }
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE | SAMPLE_QUALITY_RECOVERING,
+                           scanner->takeReading(VOLTAGE).quality);
+    chip2->setOffline(false);
+    TEST_ASSERT_TRUE(scanner->reattach(1));
+    TEST_ASSERT_TRUE(scanner->takeReading(VOLTAGE).quality & SAMPLE_QUALITY_RECOVERING);
+    scanner->readSlot(0, CURRENT);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_FRESH, scanner->takeReading(VOLTAGE).quality);
+}
+
+void test_timeout_stalls_one_slot_only() {
+    startTwoChannelScan();
+    runSingleShot(10000);
+
+    chip2->failNext(SIM_I2C_TIMEOUT);
+    uint64_t startedUs = sim::nowUs();
+    scanner->readSlot(0, CURRENT);
+    uint64_t stalledSlotUs = sim::nowUs() - startedUs;
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT64(SIM_I2C_DEFAULT_TIMEOUT_US, stalledSlotUs);
+    TEST_ASSERT_EQUAL_INT(1, eventCount[ADC_DEVICE_READ_FAILED]);
+
+    startedUs = sim::nowUs();
+    scanner->readSlot(0, CURRENT);
+    TEST_ASSERT_LESS_THAN_UINT64(3000, sim::nowUs() - startedUs);
+    TEST_ASSERT_TRUE(scanner->isChannelAvailable(VOLTAGE));
+    TEST_ASSERT_EQUAL_INT(0, eventCount[ADC_DEVICE_LOST]);
+}
+
+void test_mux_switches_match_schedule() {
+    TEST_ASSERT_TRUE(scanner->probe(0));
+    TEST_ASSERT_TRUE(scanner->probe(1));
+    const uint8_t list[] = {CURRENT, VOLTAGE, 2};
+    TEST_ASSERT_TRUE(scanner->configureScan(list, 3));
+
+    const int CYCLES = 50;
+    uint32_t paced = 0;
+    for (int i = 0; i < CYCLES * 2; i++) {
+        paced += scanner->readSlot(0, CURRENT) ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL_UINT32(CYCLES * 2, paced);
+    TEST_ASSERT_EQUAL_INT16(8000, scanner->getReading(2).raw);  // 1 V at +/-4.096 V
+    TEST_ASSERT_EQUAL_UINT32(0, chip1->getMuxChanges());
+    TEST_ASSERT_UINT32_WITHIN(1, CYCLES * scanner->getScheduler().getMuxSwitchesPerCycle(), chip2->getMuxChanges());
+}
+
+void test_missing_device_at_probe() {
+    chip2->setOffline(true);
+    TEST_ASSERT_TRUE(scanner->probe(0));
+    TEST_ASSERT_FALSE(scanner->probe(1));
+    const uint8_t list[] = {CURRENT, VOLTAGE};
+    TEST_ASSERT_TRUE(scanner->configureScan(list, 2));
+    TEST_ASSERT_GREATER_THAN_UINT32(0, runSingleShot(100000));
+    TEST_ASSERT_FALSE(scanner->isChannelAvailable(VOLTAGE));
+    TEST_ASSERT_EQUAL_INT(0, eventCount[ADC_DEVICE_READ_FAILED]);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING, scanner->takeReading(VOLTAGE).quality);
+}
+
+void test_shunt_only_board_integrates_charge() {
+    // The voltage ADS1115 is missing at boot: the current channel still meters charge
+    chip2->setOffline(true);
+    TEST_ASSERT_TRUE(scanner->probe(0));
+    TEST_ASSERT_FALSE(scanner->probe(1));
+    const uint8_t list[] = {CURRENT, VOLTAGE};
+    TEST_ASSERT_TRUE(scanner->configureScan(list, 2));
+    GainOffsetTable shuntOffsets(SHUNT_WIDEST_GAIN);
+    GainOffsetTable voltageOffsets(ADS2_WIDEST_GAIN);
+    PairAligner aligner;
+    EnergyIntegrator integrator;
+
+    uint64_t endUs = sim::nowUs() + 1000000;
+    while (sim::nowUs() < endUs) {
+        int64_t timestampUs = static_cast<int64_t>(sim::nowUs());
+        if (!scanner->readSlot(timestampUs, CURRENT)) {
+            continue;
+        }
+        aligner.add(takeSample(timestampUs, shuntOffsets, voltageOffsets));
+        AlignedPair pair;
+        while (aligner.read(pair)) {
+            integrator.add(pair);
+        }
+    }
+    const EnergyTotals& totals = integrator.getTotals();
+    printf("shunt only: %.3f C over %.3f s covered\n", integrator.netChargeUc() / 1e6, totals.coveredUs / 1e6);
+    // 100 A for the covered time, which is all of the run but the first conversion
+    TEST_ASSERT_INT64_WITHIN(5000, 1000000, totals.coveredUs);
+    TEST_ASSERT_INT64_WITHIN(200000, totals.coveredUs * 100, integrator.netChargeUc());
+    TEST_ASSERT_EQUAL_INT64(0, totals.uncoveredUs);
+    TEST_ASSERT_EQUAL_INT64(totals.coveredUs, totals.energyUncoveredUs);
+    TEST_ASSERT_EQUAL_INT64(0, integrator.netEnergyUj());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_readings_follow_simulated_inputs);
+    RUN_TEST(test_single_shot_throughput);
+    RUN_TEST(test_continuous_throughput_and_bus_traffic);
+    RUN_TEST(test_oscillator_error_stretches_conversions);
+    RUN_TEST(test_cpu_per_sample_through_filters);
+    RUN_TEST(test_nack_burst_marks_device_lost_and_recovers);
+    RUN_TEST(test_dead_device_stall_is_bounded);
+    RUN_TEST(test_bus_clear_releases_stuck_sda);
+    RUN_TEST(test_quality_flags_follow_device_state);
+    RUN_TEST(test_timeout_stalls_one_slot_only);
+    RUN_TEST(test_mux_switches_match_schedule);
+    RUN_TEST(test_missing_device_at_probe);
+    RUN_TEST(test_shunt_only_board_integrates_charge);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
@@ -0,0 +1,140 @@
+// Host tests for the activity-driven sampling interval: decay while quiet, the jump on
+// activity, the hysteresis band and the conversions saved on an idle circuit
+#include <unity.h>
+#include <stdio.h>
+#include "adaptive_rate.h"
+#include "sim_noise.h"
+
+static const q31_t THRESHOLD = 100000;
+
+// Samples the signal at whatever interval the controller asks for, for durationMs
+template <typename Signal>
+static uint32_t run(AdaptiveRate& rate, int64_t& timeUs, int64_t durationMs, Signal signal) {
+    uint32_t samples = 0;
+    int64_t endUs = timeUs + durationMs * 1000;
+    while (timeUs < endUs) {
+        rate.update(timeUs, signal(timeUs), SAMPLE_QUALITY_FRESH, 0, SAMPLE_QUALITY_FRESH);
+        samples++;
+        timeUs += rate.getInterval() * 1000LL;
+    }
+    return samples;
+}
+
+void setUp(void) {
+    sim::resetNoise();
+}
+
+void tearDown(void) {
+}
+
+void test_quiet_signal_decays_to_the_slow_interval() {
+    AdaptiveRate rate(5, 1000, THRESHOLD, THRESHOLD, 2000);
+    TEST_ASSERT_EQUAL_UINT16(5, rate.getInterval());
+    int64_t timeUs = 0;
+    // 5 -> 10 -> ... -> 640 -> 1000, one step per 2 s hold
+    run(rate, timeUs, 17000, [](int64_t) { return 1000000 + sim::noise(20000); });
+    TEST_ASSERT_EQUAL_UINT16(1000, rate.getInterval());
+    TEST_ASSERT_EQUAL_UINT32(8, rate.getSwitchCount());
+    TEST_ASSERT_TRUE(rate.getCurrentActivity().level <= THRESHOLD / 2);
+}
+
+void test_activity_jumps_straight_to_the_fast_interval() {
+    AdaptiveRate rate(5, 1000, THRESHOLD, THRESHOLD, 2000);
+    int64_t timeUs = 0;
+    run(rate, timeUs, 20000, [](int64_t) { return 0; });
+    TEST_ASSERT_EQUAL_UINT16(1000, rate.getInterval());
+
+    // The first conversion after a load step is enough
+    TEST_ASSERT_TRUE(rate.update(timeUs, 5 * THRESHOLD, SAMPLE_QUALITY_FRESH, 0, SAMPLE_QUALITY_FRESH));
+    TEST_ASSERT_EQUAL_UINT16(5, rate.getInterval());
+
+    // A step on the voltage alone counts as well
+    run(rate, timeUs, 20000, [](int64_t) { return 5 * THRESHOLD; });
+    TEST_ASSERT_EQUAL_UINT16(1000, rate.getInterval());
+    rate.update(timeUs, 5 * THRESHOLD, SAMPLE_QUALITY_FRESH, 2 * THRESHOLD, SAMPLE_QUALITY_FRESH);
+    TEST_ASSERT_EQUAL_UINT16(5, rate.getInterval());
+}
+
+void test_hysteresis_band_holds_the_interval() {
+    AdaptiveRate rate(5, 1000, THRESHOLD, THRESHOLD, 2000);
+    int64_t timeUs = 0;
+    run(rate, timeUs, 4500, [](int64_t) { return 0; });
+    uint16_t interval = rate.getInterval();
+    TEST_ASSERT_EQUAL_UINT16(20, interval);
+    uint32_t switches = rate.getSwitchCount();
+
+    // Square wave of 0.7 threshold peak-to-peak, 8 conversions per half period: its edges
+    // land inside the band often enough to stop the decay, never above it
+    int n = 0;
+    run(rate, timeUs, 10000, [&n](int64_t) { return ((n++ / 8) % 2) * (THRESHOLD * 7 / 10); });
+    TEST_ASSERT_EQUAL_UINT16(interval, rate.getInterval());
+    TEST_ASSERT_EQUAL_UINT32(switches, rate.getSwitchCount());
+}
+
+void test_quality_flags() {
+    AdaptiveRate rate(5, 40, THRESHOLD, THRESHOLD, 100);
+    int64_t timeUs = 0;
+    run(rate, timeUs, 1000, [](int64_t) { return 0; });
+    TEST_ASSERT_EQUAL_UINT16(40, rate.getInterval());
+    // Repeats and failed conversions are not activity
+    rate.update(timeUs, 10 * THRESHOLD, SAMPLE_QUALITY_HELD, 0, SAMPLE_QUALITY_FRESH);
+    rate.update(timeUs + 1000, 10 * THRESHOLD, SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE, 0, SAMPLE_QUALITY_FRESH);
+    TEST_ASSERT_EQUAL_UINT16(40, rate.getInterval());
+    // A clipped conversion always is, whatever its value
+    rate.update(timeUs + 2000, 0, SAMPLE_QUALITY_FRESH, 0, SAMPLE_QUALITY_CLIPPED);
+    TEST_ASSERT_EQUAL_UINT16(5, rate.getInterval());
+}
+
+void test_limits() {
+    AdaptiveRate rate(5, 1000, THRESHOLD, THRESHOLD);
+    TEST_ASSERT_FALSE(rate.setLimits(0, 100));
+    TEST_ASSERT_FALSE(rate.setLimits(200, 100));
+    TEST_ASSERT_TRUE(rate.setLimits(50, 100));
+    // The interval is kept within the new limits
+    TEST_ASSERT_EQUAL_UINT16(50, rate.getInterval());
+    int64_t timeUs = 0;
+    run(rate, timeUs, 10000, [](int64_t) { return 0; });
+    TEST_ASSERT_EQUAL_UINT16(100, rate.getInterval());
+}
+
+// An idle circuit with one 2 s burst of ripple a minute: the burst is sampled at the fast
+// interval throughout, the minute costs a fraction of the fixed-rate conversions
+void test_idle_circuit_saves_conversions_and_catches_the_event() {
+    AdaptiveRate rate(5, 1000, THRESHOLD, THRESHOLD, 2000);
+    int64_t timeUs = 0;
+    uint32_t fastDuringBurst = 0;
+    uint32_t burstSamples = 0;
+    uint32_t samples = 0;
+    while (timeUs < 60000000) {
+        bool burst = timeUs >= 40000000 && timeUs < 42000000;
+        q31_t value = 2000000 + sim::noise(20000) + (burst ? ((timeUs / 10000) % 2 ? 400000 : -400000) : 0);
+        rate.update(timeUs, value, SAMPLE_QUALITY_FRESH, 0, SAMPLE_QUALITY_FRESH);
+        samples++;
+        if (burst) {
+            burstSamples++;
+            fastDuringBurst += rate.getInterval() == 5;
+        }
+        timeUs += rate.getInterval() * 1000LL;
+    }
+    uint32_t fixedSamples = 60000 / 5;
+    printf("idle minute with a 2 s burst: %u conversions adaptive, %u fixed at 5 ms; %u of %u burst "
+           "conversions at 5 ms\n", samples, fixedSamples, fastDuringBurst, burstSamples);
+    // From the conversion that saw the burst on, the next one is always 5 ms away
+    TEST_ASSERT_EQUAL_UINT32(burstSamples, fastDuringBurst);
+    TEST_ASSERT_TRUE(samples * 5 < fixedSamples);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_quiet_signal_decays_to_the_slow_interval);
+    RUN_TEST(test_activity_jumps_straight_to_the_fast_interval);
+    RUN_TEST(test_hysteresis_band_holds_the_interval);
+    RUN_TEST(test_quality_flags);
+    RUN_TEST(test_limits);
+    RUN_TEST(test_idle_circuit_saves_conversions_and_catches_the_event);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
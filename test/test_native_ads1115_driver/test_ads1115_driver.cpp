@@ -0,0 +1,233 @@
+// Host tests for the register-level ADS1115 driver against a simulated register map
+#include <unity.h>
+#include "ads1115_driver.h"
+
+// Simulated ADS1115 behind a fake I2C bus: four 16-bit registers, a register pointer
+// and a transaction log so tests can assert exactly what went over the wire.
+class SimulatedAds1115Bus : public I2CBus {
+public:
+    SimulatedAds1115Bus()
+        : deviceAddress(0x48), pointer(0), nowUs(0), conversionDoneUs(0),
+          nextConversion(0), writes(0), reads(0), failNext(false) {
+        registers[ADS1115_REG_CONVERSION] = 0;
+        registers[ADS1115_REG_CONFIG] = ADS1115_CONFIG_DEFAULT;
+        registers[ADS1115_REG_LO_THRESH] = 0x8000;
+        registers[ADS1115_REG_HI_THRESH] = 0x7FFF;
+    }
+
+    bool write(uint8_t address, const uint8_t* data, size_t length) override {
+        nowUs += 25 * (length + 1);  // ~25 us per byte at 400 kHz
+        if (address != deviceAddress || length == 0 || consumeFailure()) {
+            return false;
+        }
+        writes++;
+        lastWriteLength = length;
+        pointer = data[0] & 0x03;
+        if (length == 3) {
+            uint16_t value = (static_cast<uint16_t>(data[1]) << 8) | data[2];
+            if (pointer == ADS1115_REG_CONFIG) {
+                writeConfig(value);
+            } else if (pointer != ADS1115_REG_CONVERSION) {
+                registers[pointer] = value;
+            }
+        }
+        return true;
+    }
+
+    bool read(uint8_t address, uint8_t* data, size_t length) override {
+        nowUs += 25 * (length + 1);
+        if (address != deviceAddress || length != 2 || consumeFailure()) {
+            return false;
+        }
+        reads++;
+        uint16_t value = registers[pointer];
+        if (pointer == ADS1115_REG_CONFIG && nowUs >= conversionDoneUs) {
+            value |= ADS1115_CONFIG_OS_SINGLE;
+            registers[ADS1115_REG_CONVERSION] = static_cast<uint16_t>(nextConversion);
+        }
+        if (pointer == ADS1115_REG_CONVERSION && nowUs >= conversionDoneUs) {
+            value = static_cast<uint16_t>(nextConversion);
+        }
+        data[0] = value >> 8;
+        data[1] = value & 0xFF;
+        return true;
+    }
+
+    bool setClock(uint32_t hz) override {
+        return hz == I2C_FAST_MODE_HZ || hz == I2C_FAST_MODE_PLUS_HZ;
+    }
+
+    uint32_t micros() override {
+        return nowUs;
+    }
+
+    void delayMicros(uint32_t us) override {
+        nowUs += us;
+    }
+
+    uint8_t deviceAddress;
+    uint16_t registers[4];
+    uint8_t pointer;
+    uint32_t nowUs;
+    uint32_t conversionDoneUs;
+    int16_t nextConversion;
+    uint32_t writes;
+    uint32_t reads;
+    size_t lastWriteLength;
+    bool failNext;
+
+private:
+    void writeConfig(uint16_t value) {
+        registers[ADS1115_REG_CONFIG] = value & ~ADS1115_CONFIG_OS_SINGLE;
+        if (value & ADS1115_CONFIG_OS_SINGLE || !(value & ADS1115_CONFIG_MODE_SINGLE)) {
+            conversionDoneUs = nowUs + 1163;
+        }
+    }
+
+    bool consumeFailure() {
+        bool fail = failNext;
+        failNext = false;
+        return fail;
+    }
+};
+
+static SimulatedAds1115Bus* bus = nullptr;
+static Ads1115* adc = nullptr;
+
+void setUp(void) {
+    bus = new SimulatedAds1115Bus();
+    adc = new Ads1115();
+}
+
+void tearDown(void) {
+    delete adc;
+    delete bus;
+}
+
+void test_begin_probes_device() {
+    TEST_ASSERT_TRUE(adc->begin(bus, 0x48));
+    TEST_ASSERT_EQUAL_UINT8(0x48, adc->getAddress());
+
+    Ads1115 missing;
+    TEST_ASSERT_FALSE(missing.begin(bus, 0x49));
+}
+
+void test_setters_only_touch_cache() {
+    TEST_ASSERT_TRUE(adc->begin(bus, 0x48));
+    uint32_t writesBefore = bus->writes;
+
+    adc->setGain(GAIN_EIGHT);
+    adc->setDataRate(ADS1115_RATE_860SPS);
+    adc->setMux(ADS1115_MUX_SINGLE_0);
+
+    TEST_ASSERT_EQUAL_UINT32(writesBefore, bus->writes);
+    TEST_ASSERT_EQUAL(GAIN_EIGHT, adc->getGain());
+    TEST_ASSERT_EQUAL(ADS1115_RATE_860SPS, adc->getDataRate());
+    TEST_ASSERT_EQUAL(ADS1115_MUX_SINGLE_0, adc->getMux());
+    TEST_ASSERT_EQUAL_UINT32(1163, adc->conversionTimeUs());
+}
+
+void test_single_shot_writes_cached_config() {
+    TEST_ASSERT_TRUE(adc->begin(bus, 0x48));
+    adc->setGain(GAIN_EIGHT);
+    adc->setDataRate(ADS1115_RATE_860SPS);
+    adc->setMux(ADS1115_MUX_DIFF_0_1);
+    bus->nextConversion = -1234;
+
+    int16_t value = 0;
+    TEST_ASSERT_TRUE(adc->readSingleShot(value));
+    TEST_ASSERT_EQUAL_INT16(-1234, value);
+
+    uint16_t config = bus->registers[ADS1115_REG_CONFIG];
+    TEST_ASSERT_EQUAL_HEX16(GAIN_EIGHT, config & ADS1115_CONFIG_PGA_MASK);
+    TEST_ASSERT_EQUAL_HEX16(ADS1115_RATE_860SPS, config & ADS1115_CONFIG_DR_MASK);
+    TEST_ASSERT_EQUAL_HEX16(ADS1115_CONFIG_MODE_SINGLE, config & ADS1115_CONFIG_MODE_SINGLE);
+}
+
+void test_continuous_hot_path_is_read_only() {
+    TEST_ASSERT_TRUE(adc->begin(bus, 0x48));
+    adc->setDataRate(ADS1115_RATE_860SPS);
+    TEST_ASSERT_TRUE(adc->startContinuous());
+    TEST_ASSERT_TRUE(adc->isContinuous());
+
+    // Conversion-ready thresholds programmed for ALERT/RDY
+    TEST_ASSERT_EQUAL_HEX16(0x8000, bus->registers[ADS1115_REG_HI_THRESH]);
+    TEST_ASSERT_EQUAL_HEX16(0x0000, bus->registers[ADS1115_REG_LO_THRESH]);
+    TEST_ASSERT_EQUAL_HEX16(0, bus->registers[ADS1115_REG_CONFIG] & ADS1115_CONFIG_MODE_SINGLE);
+
+    bus->delayMicros(2000);
+    uint32_t writesBefore = bus->writes;
+    uint32_t readsBefore = bus->reads;
+    for (int i = 0; i < 100; i++) {
+        bus->nextConversion = static_cast<int16_t>(i * 10);
+        int16_t value = 0;
+        TEST_ASSERT_TRUE(adc->readConversion(value));
+        TEST_ASSERT_EQUAL_INT16(i * 10, value);
+    }
+    TEST_ASSERT_EQUAL_UINT32(writesBefore, bus->writes);
+    TEST_ASSERT_EQUAL_UINT32(readsBefore + 100, bus->reads);
+}
+
+void test_thresholds_written_once_per_begin() {
+    TEST_ASSERT_TRUE(adc->begin(bus, 0x48));
+    TEST_ASSERT_TRUE(adc->startContinuous());
+    uint32_t writesAfterFirst = bus->writes;
+
+    // Switching back to continuous only rewrites config and pointer
+    TEST_ASSERT_TRUE(adc->startSingleShot());
+    uint32_t writesBeforeSecond = bus->writes;
+    TEST_ASSERT_TRUE(adc->startContinuous());
+    TEST_ASSERT_EQUAL_UINT32(writesBeforeSecond + 2, bus->writes);
+    TEST_ASSERT_GREATER_THAN(writesAfterFirst, writesBeforeSecond);
+}
+
+void test_failed_transfer_invalidates_pointer() {
+    TEST_ASSERT_TRUE(adc->begin(bus, 0x48));
+    TEST_ASSERT_TRUE(adc->startContinuous());
+
+    bus->failNext = true;
+    int16_t value = 0;
+    TEST_ASSERT_FALSE(adc->readConversion(value));
+
+    // After a NACK on a write the driver re-sends the pointer before reading again
+    bus->failNext = true;
+    TEST_ASSERT_FALSE(adc->startSingleShot());
+    uint32_t writesBefore = bus->writes;
+    bus->delayMicros(2000);
+    TEST_ASSERT_TRUE(adc->readConversion(value));
+    TEST_ASSERT_EQUAL_UINT32(writesBefore + 1, bus->writes);
+    TEST_ASSERT_EQUAL(1, bus->lastWriteLength);
+}
+
+void test_transaction_timing() {
+    TEST_ASSERT_TRUE(adc->begin(bus, 0x48));
+    adc->resetTiming();
+    TEST_ASSERT_TRUE(adc->startContinuous());
+    int16_t value = 0;
+    TEST_ASSERT_TRUE(adc->readConversion(value));
+    bus->failNext = true;
+    TEST_ASSERT_FALSE(adc->readConversion(value));
+
+    const Ads1115Timing& timing = adc->getTiming();
+    // HI, LO, config, pointer writes + two reads
+    TEST_ASSERT_EQUAL_UINT32(6, timing.transactions);
+    TEST_ASSERT_EQUAL_UINT32(1, timing.failures);
+    TEST_ASSERT_EQUAL_UINT32(100, timing.maxUs);   // 3-byte register write
+    TEST_ASSERT_EQUAL_UINT32(75, timing.lastUs);   // 2-byte read
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_probes_device);
+    RUN_TEST(test_setters_only_touch_cache);
+    RUN_TEST(test_single_shot_writes_cached_config);
+    RUN_TEST(test_continuous_hot_path_is_read_only);
+    RUN_TEST(test_thresholds_written_once_per_begin);
+    RUN_TEST(test_failed_transfer_invalidates_pointer);
+    RUN_TEST(test_transaction_timing);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
@@ -0,0 +1,114 @@
+// Host tests for PGA auto-ranging and per-gain calibration offsets
+#include <unity.h>
+#include "auto_ranger.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_near_clipping_widens_immediately() {
+    AutoRanger ranger(GAIN_TWO, GAIN_SIXTEEN, GAIN_EIGHT);
+    TEST_ASSERT_TRUE(ranger.update(-31000));
+    TEST_ASSERT_EQUAL_HEX16(GAIN_FOUR, ranger.getGain());
+    TEST_ASSERT_TRUE(ranger.update(32767));
+    TEST_ASSERT_EQUAL_HEX16(GAIN_TWO, ranger.getGain());
+
+    // Already at the widest range: stays there
+    TEST_ASSERT_FALSE(ranger.update(32767));
+    TEST_ASSERT_EQUAL_HEX16(GAIN_TWO, ranger.getGain());
+    TEST_ASSERT_EQUAL_UINT32(2, ranger.getSwitchCount());
+}
+
+void test_small_signal_narrows_after_settling() {
+    AutoRanger ranger(GAIN_TWO, GAIN_SIXTEEN, GAIN_EIGHT);
+    for (int i = 0; i < AUTO_RANGE_SETTLE_SAMPLES - 1; i++) {
+        TEST_ASSERT_FALSE(ranger.update(500));
+    }
+    TEST_ASSERT_TRUE(ranger.update(500));
+    TEST_ASSERT_EQUAL_HEX16(GAIN_SIXTEEN, ranger.getGain());
+
+    // Narrowest range reached: no further steps
+    for (int i = 0; i < 2 * AUTO_RANGE_SETTLE_SAMPLES; i++) {
+        TEST_ASSERT_FALSE(ranger.update(1000));
+    }
+    TEST_ASSERT_EQUAL_HEX16(GAIN_SIXTEEN, ranger.getGain());
+}
+
+void test_mid_scale_reading_resets_settling() {
+    AutoRanger ranger(GAIN_TWO, GAIN_SIXTEEN, GAIN_EIGHT);
+    for (int i = 0; i < 3 * AUTO_RANGE_SETTLE_SAMPLES; i++) {
+        // A reading in the hysteresis band every few samples keeps the range
+        TEST_ASSERT_FALSE(ranger.update(i % 4 == 0 ? 20000 : 1000));
+    }
+    TEST_ASSERT_EQUAL_HEX16(GAIN_EIGHT, ranger.getGain());
+}
+
+void test_steady_signal_does_not_oscillate() {
+    // A signal that sits just below the narrowing threshold doubles after the step and
+    // must then stay inside the hysteresis band
+    AutoRanger ranger(GAIN_TWO, GAIN_SIXTEEN, GAIN_FOUR);
+    int16_t reading = AUTO_RANGE_LOW_COUNTS - 1;
+    uint32_t switches = 0;
+    for (int i = 0; i < 10 * AUTO_RANGE_SETTLE_SAMPLES; i++) {
+        if (ranger.update(reading)) {
+            switches++;
+            reading *= 2;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, switches);
+    TEST_ASSERT_EQUAL_HEX16(GAIN_EIGHT, ranger.getGain());
+}
+
+void test_set_gain_is_clamped_to_limits() {
+    AutoRanger ranger(GAIN_ONE, GAIN_EIGHT, GAIN_TWOTHIRDS);
+    TEST_ASSERT_EQUAL_HEX16(GAIN_ONE, ranger.getGain());
+    ranger.setGain(GAIN_SIXTEEN);
+    TEST_ASSERT_EQUAL_HEX16(GAIN_EIGHT, ranger.getGain());
+}
+
+void test_calibrated_offset_is_rescaled_per_gain() {
+    GainOffsetTable offsets(GAIN_TWO);
+    // 8 counts at GAIN_EIGHT is 125 uV
+    offsets.setCalibratedOffset(GAIN_EIGHT, countsToQ31(8));
+    TEST_ASSERT_EQUAL_INT32(countsToQ31(2), offsets.getOffset(GAIN_TWO));
+    TEST_ASSERT_EQUAL_INT32(countsToQ31(4), offsets.getOffset(GAIN_FOUR));
+    TEST_ASSERT_EQUAL_INT32(countsToQ31(16), offsets.getOffset(GAIN_SIXTEEN));
+
+    // A measured per-gain offset overrides the rescaled one
+    offsets.setOffset(GAIN_SIXTEEN, countsToQ31(17));
+    TEST_ASSERT_EQUAL_INT32(countsToQ31(17), offsets.getOffset(GAIN_SIXTEEN));
+}
+
+void test_corrected_readings_share_one_scale_across_gains() {
+    GainOffsetTable offsets(GAIN_TWO);
+    offsets.setCalibratedOffset(GAIN_EIGHT, countsToQ31(8));
+
+    // The same input voltage read at three gains lands on the same corrected value
+    q31_t atTwo = offsets.correct(1002, GAIN_TWO);
+    q31_t atEight = offsets.correct(4008, GAIN_EIGHT);
+    q31_t atSixteen = offsets.correct(8016, GAIN_SIXTEEN);
+    TEST_ASSERT_EQUAL_INT32(countsToQ31(1000), atTwo);
+    TEST_ASSERT_EQUAL_INT32(atTwo, atEight);
+    TEST_ASSERT_EQUAL_INT32(atTwo, atSixteen);
+
+    // Narrow-range readings keep their extra resolution as fractional counts
+    TEST_ASSERT_EQUAL_INT32(countsToQ31(1000) + Q31_ONE_COUNT / 8, offsets.correct(8017, GAIN_SIXTEEN));
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_near_clipping_widens_immediately);
+    RUN_TEST(test_small_signal_narrows_after_settling);
+    RUN_TEST(test_mid_scale_reading_resets_settling);
+    RUN_TEST(test_steady_signal_does_not_oscillate);
+    RUN_TEST(test_set_gain_is_clamped_to_limits);
+    RUN_TEST(test_calibrated_offset_is_rescaled_per_gain);
+    RUN_TEST(test_corrected_readings_share_one_scale_across_gains);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
@@ -0,0 +1,194 @@
+// Host tests for the pre/post-trigger burst capture engine
+#include <unity.h>
+#include <string.h>
+#include "burst_capture.h"
+
+static BurstCapture capture;  // Large buffer; keep it off the stack
+
+static AdcSample makeSample(int64_t timestampUs, q31_t shunt, q31_t ads2 = 0) {
+    AdcSample sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.timestampUs = timestampUs;
+    sample.shunt = shunt;
+    sample.ads2 = ads2;
+    return sample;
+}
+
+static CaptureConfig makeConfig(uint16_t pre, uint16_t post) {
+    CaptureConfig config;
+    config.preSamples = pre;
+    config.postSamples = post;
+    config.thresholdEnabled = false;
+    config.channel = CAPTURE_CHANNEL_SHUNT;
+    config.edge = CAPTURE_EDGE_RISING;
+    config.level = 0;
+    config.relayEnabled = false;
+    return config;
+}
+
+void setUp(void) {
+    capture.disarm();
+}
+
+void tearDown(void) {
+}
+
+void test_rejects_depths_beyond_buffer() {
+    TEST_ASSERT_FALSE(capture.arm(makeConfig(BURST_CAPTURE_CAPACITY, 1)));
+    TEST_ASSERT_FALSE(capture.arm(makeConfig(10, 0)));
+    TEST_ASSERT_EQUAL(CAPTURE_IDLE, capture.getState());
+    TEST_ASSERT_TRUE(capture.arm(makeConfig(BURST_CAPTURE_CAPACITY - 1, 1)));
+    TEST_ASSERT_EQUAL(CAPTURE_ARMED, capture.getState());
+}
+
+void test_manual_trigger_keeps_pre_and_post_samples() {
+    TEST_ASSERT_TRUE(capture.arm(makeConfig(100, 50)));
+    // Far more than the buffer holds before the trigger, so the ring wraps
+    int64_t t = 0;
+    for (int i = 0; i < 5000; i++, t += 1163) {
+        capture.add(makeSample(t, i));
+    }
+    capture.trigger(CAPTURE_TRIGGER_MANUAL);
+    for (int i = 5000; i < 5100; i++, t += 1163) {
+        capture.add(makeSample(t, i));
+    }
+
+    TEST_ASSERT_EQUAL(CAPTURE_COMPLETE, capture.getState());
+    TEST_ASSERT_EQUAL(CAPTURE_TRIGGER_MANUAL, capture.getTriggerSource());
+    TEST_ASSERT_EQUAL_UINT16(150, capture.getLength());
+    TEST_ASSERT_EQUAL_UINT16(100, capture.getPreTriggerLength());
+    TEST_ASSERT_EQUAL_INT64(5000LL * 1163, capture.getTriggerTimestampUs());
+
+    CaptureRecord record;
+    for (uint16_t i = 0; i < 150; i++) {
+        TEST_ASSERT_TRUE(capture.read(i, record));
+        TEST_ASSERT_EQUAL_INT32(4900 + i, record.shunt);
+        TEST_ASSERT_EQUAL_INT32((i - 100) * 1163, record.offsetUs);
+    }
+    TEST_ASSERT_FALSE(capture.read(150, record));
+}
+
+void test_early_trigger_shortens_pre_trigger() {
+    TEST_ASSERT_TRUE(capture.arm(makeConfig(100, 10)));
+    for (int i = 0; i < 30; i++) {
+        capture.add(makeSample(i * 1000, i));
+    }
+    capture.trigger(CAPTURE_TRIGGER_RELAY);
+    for (int i = 30; i < 40; i++) {
+        capture.add(makeSample(i * 1000, i));
+    }
+    TEST_ASSERT_EQUAL(CAPTURE_COMPLETE, capture.getState());
+    TEST_ASSERT_EQUAL_UINT16(30, capture.getPreTriggerLength());
+    TEST_ASSERT_EQUAL_UINT16(40, capture.getLength());
+    CaptureRecord record;
+    TEST_ASSERT_TRUE(capture.read(0, record));
+    TEST_ASSERT_EQUAL_INT32(0, record.shunt);
+    TEST_ASSERT_EQUAL_INT32(-30000, record.offsetUs);
+}
+
+void test_threshold_fires_on_selected_edge() {
+    CaptureConfig config = makeConfig(4, 4);
+    config.thresholdEnabled = true;
+    config.channel = CAPTURE_CHANNEL_ADS2;
+    config.edge = CAPTURE_EDGE_FALLING;
+    config.level = 1000;
+    TEST_ASSERT_TRUE(capture.arm(config));
+
+    // Starting above the level is not a crossing, nor is a rising edge
+    const q31_t levels[] = {2000, 500, 1500, 999, 0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < 10; i++) {
+        capture.add(makeSample(i * 100, 0, levels[i]));
+        if (i == 0) {
+            TEST_ASSERT_EQUAL(CAPTURE_ARMED, capture.getState());
+        }
+    }
+    TEST_ASSERT_EQUAL(CAPTURE_COMPLETE, capture.getState());
+    TEST_ASSERT_EQUAL(CAPTURE_TRIGGER_THRESHOLD, capture.getTriggerSource());
+    // The first falling crossing is 2000 -> 500 at sample 1
+    TEST_ASSERT_EQUAL_INT64(100, capture.getTriggerTimestampUs());
+    TEST_ASSERT_EQUAL_UINT16(1, capture.getPreTriggerLength());
+}
+
+void test_quality_is_kept_and_held_samples_do_not_trigger() {
+    CaptureConfig config = makeConfig(2, 2);
+    config.thresholdEnabled = true;
+    config.level = 1000;
+    TEST_ASSERT_TRUE(capture.arm(config));
+
+    capture.add(makeSample(0, 0));
+    // A held value above the level (the chip went away mid-ramp) is no crossing
+    AdcSample held = makeSample(100, 2000);
+    held.shuntQuality = SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING;
+    held.ads2Quality = SAMPLE_QUALITY_CLIPPED;
+    capture.add(held);
+    TEST_ASSERT_EQUAL(CAPTURE_ARMED, capture.getState());
+
+    capture.add(makeSample(200, 2000));
+    capture.add(makeSample(300, 2000));
+    TEST_ASSERT_EQUAL(CAPTURE_COMPLETE, capture.getState());
+    TEST_ASSERT_EQUAL_INT64(200, capture.getTriggerTimestampUs());
+
+    CaptureRecord record;
+    TEST_ASSERT_TRUE(capture.read(0, record));
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_FRESH, record.shuntQuality);
+    TEST_ASSERT_TRUE(capture.read(1, record));
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING, record.shuntQuality);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_CLIPPED, record.ads2Quality);
+}
+
+void test_capture_is_frozen_until_rearmed() {
+    TEST_ASSERT_TRUE(capture.arm(makeConfig(2, 2)));
+    capture.add(makeSample(0, 1));
+    capture.trigger(CAPTURE_TRIGGER_MANUAL);
+    capture.add(makeSample(10, 2));
+    capture.add(makeSample(20, 3));
+    TEST_ASSERT_EQUAL(CAPTURE_COMPLETE, capture.getState());
+
+    // Later samples and triggers leave the capture alone
+    capture.trigger(CAPTURE_TRIGGER_MANUAL);
+    for (int i = 0; i < 100; i++) {
+        capture.add(makeSample(30 + i, 99));
+    }
+    CaptureRecord record;
+    TEST_ASSERT_EQUAL_UINT16(3, capture.getLength());
+    TEST_ASSERT_TRUE(capture.read(2, record));
+    TEST_ASSERT_EQUAL_INT32(3, record.shunt);
+
+    // Triggers while idle are dropped, not carried into the next arm
+    capture.disarm();
+    capture.trigger(CAPTURE_TRIGGER_MANUAL);
+    TEST_ASSERT_TRUE(capture.arm(makeConfig(2, 2)));
+    capture.add(makeSample(1000, 5));
+    TEST_ASSERT_EQUAL(CAPTURE_ARMED, capture.getState());
+    TEST_ASSERT_EQUAL_UINT16(0, capture.getLength());
+}
+
+void test_offsets_survive_timestamp_wrap() {
+    TEST_ASSERT_TRUE(capture.arm(makeConfig(1, 2)));
+    int64_t base = (1LL << 32) - 500;
+    capture.add(makeSample(base, 0));
+    capture.trigger(CAPTURE_TRIGGER_MANUAL);
+    capture.add(makeSample(base + 1000, 1));
+    capture.add(makeSample(base + 2000, 2));
+    CaptureRecord record;
+    TEST_ASSERT_TRUE(capture.read(0, record));
+    TEST_ASSERT_EQUAL_INT32(-1000, record.offsetUs);
+    TEST_ASSERT_TRUE(capture.read(2, record));
+    TEST_ASSERT_EQUAL_INT32(1000, record.offsetUs);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_depths_beyond_buffer);
+    RUN_TEST(test_manual_trigger_keeps_pre_and_post_samples);
+    RUN_TEST(test_early_trigger_shortens_pre_trigger);
+    RUN_TEST(test_threshold_fires_on_selected_edge);
+    RUN_TEST(test_quality_is_kept_and_held_samples_do_not_trigger);
+    RUN_TEST(test_capture_is_frozen_until_rearmed);
+    RUN_TEST(test_offsets_survive_timestamp_wrap);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
@@ -0,0 +1,231 @@
+// Host tests for the BLE command parser: every command of the table, the error replies,
+// random and mutated input, and how fast commands are parsed
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "command_parser.h"
+
+static const int RELAY_PINS[4] = {25, 27, 32, 26};
+static const CommandEnvironment ENVIRONMENT = {RELAY_PINS, 4, 1, 5, 1000000, 2048};
+
+static ParsedCommand command;
+static char reply[COMMAND_ERROR_CAPACITY];
+
+static bool parse(const char* text) {
+    return parseCommand(text, strlen(text), ENVIRONMENT, command);
+}
+
+// The error reply of a command that fails to parse, "" when it parses
+static const char* errorOf(const char* text) {
+    parse(text);
+    formatCommandError(command, ENVIRONMENT, reply, sizeof(reply));
+    return reply;
+}
+
+static uint32_t randomState = 1;
+
+static uint32_t nextRandom() {
+    randomState = randomState * 1664525u + 1013904223u;
+    return randomState >> 8;
+}
+
+// Whether a parsed command is self-consistent: a valid one has a known id, its values in
+// range and its text inside the input; a failed one a reply that fits and is terminated
+static bool consistent(const char* input, size_t length, bool parsed) {
+    if (parsed != (command.error == COMMAND_OK)) {
+        return false;
+    }
+    if (!parsed) {
+        char out[COMMAND_ERROR_CAPACITY];
+        memset(out, 'x', sizeof(out));
+        size_t written = formatCommandError(command, ENVIRONMENT, out, sizeof(out));
+        if (written == 0 || written >= sizeof(out) || out[written] != '\0' || strncmp(out, "ERROR:", 6) != 0) {
+            return false;
+        }
+        return command.token == NULL ||
+               (command.token >= input && command.token + command.tokenLength <= input + length);
+    }
+    switch (command.id) {
+        case COMMAND_NONE:
+            return false;
+        case COMMAND_TOGGLE:
+        case COMMAND_SET_RELAY:
+            return command.relay < ENVIRONMENT.relayCount && command.pin == RELAY_PINS[command.relay];
+        case COMMAND_SET_SAMPLING_RATE:
+            return command.value >= COMMAND_SAMPLING_INTERVAL_MIN_MS && command.value <= COMMAND_SAMPLING_INTERVAL_MAX_MS;
+        case COMMAND_TREND:
+            return command.value <= ENVIRONMENT.maxTrendDeviation;
+        case COMMAND_CAPTURE_READ:
+            return command.value < ENVIRONMENT.captureCapacity;
+        case COMMAND_SELECT:
+            return command.ssidLength > 0 && command.ssidLength <= COMMAND_SSID_MAX_LENGTH &&
+                   command.passwordLength <= COMMAND_PASSWORD_MAX_LENGTH && command.ssid >= input &&
+                   command.password + command.passwordLength == input + length;
+        case COMMAND_PROTOCOL:
+            return command.versionMajor == ENVIRONMENT.protocolMajor && command.versionMinor <= ENVIRONMENT.protocolMinor;
+        default:
+            return true;
+    }
+}
+
+void setUp(void) {
+    randomState = 1;
+}
+
+void tearDown(void) {
+}
+
+void test_every_command_of_the_table() {
+    TEST_ASSERT_EQUAL_UINT32(17, SUPPORTED_COMMAND_COUNT);
+    const char* examples[] = {"PROTOCOL_1.5.0_STREAM", "CALIBRATE", "OTA", "TOGGLE_25", "SET_26_ON",
+                              "SET_SAMPLING_RATE_20", "ACQ_MODE_CONTINUOUS", "ADAPTIVE_ON", "TREND_VOLTAGE_2000",
+                              "RESET_ENERGY", "CAPTURE_ARM", "CAPTURE_TRIGGER", "CAPTURE_STOP", "CAPTURE_READ_440",
+                              "SCAN", "SELECT_home:se:cret", "DISCONNECT"};
+    for (size_t i = 0; i < SUPPORTED_COMMAND_COUNT; i++) {
+        TEST_ASSERT_TRUE_MESSAGE(parse(examples[i]), examples[i]);
+        TEST_ASSERT_EQUAL_INT(SUPPORTED_COMMANDS[i].id, command.id);
+    }
+
+    TEST_ASSERT_TRUE(parse("PROTOCOL_1.4.2_BINARY"));
+    TEST_ASSERT_EQUAL_INT(TELEMETRY_FORMAT_BINARY, command.format);
+    TEST_ASSERT_EQUAL_UINT16(4, command.versionMinor);
+    TEST_ASSERT_EQUAL_UINT16(2, command.versionPatch);
+    TEST_ASSERT_TRUE(parse("SET_26_OFF"));
+    TEST_ASSERT_EQUAL_UINT8(3, command.relay);
+    TEST_ASSERT_FALSE(command.on);
+    TEST_ASSERT_TRUE(parse("TREND_CURRENT_0"));
+    TEST_ASSERT_FALSE(command.voltage);
+    TEST_ASSERT_EQUAL_UINT32(0, command.value);
+    TEST_ASSERT_TRUE(parse("SELECT_home:se:cret"));
+    TEST_ASSERT_EQUAL_UINT16(4, command.ssidLength);
+    TEST_ASSERT_EQUAL_UINT16(7, command.passwordLength);
+    TEST_ASSERT_EQUAL_MEMORY("se:cret", command.password, 7);
+}
+
+// SET_ used to catch SET_SAMPLING_RATE_ and reject it as a pin
+void test_sampling_rate_is_not_a_relay() {
+    TEST_ASSERT_TRUE(parse("SET_SAMPLING_RATE_5"));
+    TEST_ASSERT_EQUAL_INT(COMMAND_SET_SAMPLING_RATE, command.id);
+    TEST_ASSERT_EQUAL_UINT32(5, command.value);
+    TEST_ASSERT_TRUE(parse("SET_SAMPLING_RATE_1000"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_SAMPLING_RATE:Value must be between 5-1000", errorOf("SET_SAMPLING_RATE_4"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_SAMPLING_RATE:Value must be between 5-1000", errorOf("SET_SAMPLING_RATE_1001"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_SAMPLING_RATE:Value must be between 5-1000", errorOf("SET_SAMPLING_RATE_20ms"));
+}
+
+void test_error_replies() {
+    TEST_ASSERT_EQUAL_STRING("ERROR:UNKNOWN_COMMAND:REBOOT", errorOf("REBOOT"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:UNKNOWN_COMMAND:OTA_NOW", errorOf("OTA_NOW"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:UNKNOWN_COMMAND:", errorOf(""));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_FORMAT:XML", errorOf("PROTOCOL_1.5.0_XML"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_FORMAT:", errorOf("PROTOCOL_JSON"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INCOMPATIBLE_VERSION:Major version mismatch", errorOf("PROTOCOL_2.0.0_JSON"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INCOMPATIBLE_VERSION:Client using newer minor version", errorOf("PROTOCOL_1.6.0_JSON"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_PIN:99", errorOf("TOGGLE_99"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_PIN:2x", errorOf("SET_2x_ON"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_STATE:", errorOf("SET_25"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_STATE:On", errorOf("ADAPTIVE_On"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_ACQ_MODE:BURST", errorOf("ACQ_MODE_BURST"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_TREND_CHANNEL:POWER", errorOf("TREND_POWER_5"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_TREND_DEVIATION:Value must be between 0-1000000", errorOf("TREND_CURRENT_1000001"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_TREND_DEVIATION:Value must be between 0-1000000", errorOf("TREND_VOLTAGE"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_CAPTURE_INDEX:2048", errorOf("CAPTURE_READ_2048"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_WIFI_FORMAT:Missing colon separator", errorOf("SELECT_home"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_SSID:Empty SSID", errorOf("SELECT_:secret"));
+    TEST_ASSERT_EQUAL_STRING("ERROR:INVALID_WIFI_FORMAT:SSID or password too long",
+                             errorOf("SELECT_0123456789abcdef0123456789abcdefX:secret"));
+
+    // A long token is cut to the reply's capacity
+    char longCommand[400];
+    memset(longCommand, 'A', sizeof(longCommand) - 1);
+    longCommand[sizeof(longCommand) - 1] = '\0';
+    TEST_ASSERT_EQUAL_UINT32(COMMAND_ERROR_CAPACITY - 1, strlen(errorOf(longCommand)));
+
+    // Input is taken by length: bytes past it are never looked at
+    TEST_ASSERT_TRUE(parseCommand("SCAN_", 4, ENVIRONMENT, command));
+    TEST_ASSERT_EQUAL_INT(COMMAND_SCAN, command.id);
+    TEST_ASSERT_FALSE(parseCommand("SCAN\0", 5, ENVIRONMENT, command));
+}
+
+// Random bytes, and valid commands with bytes flipped, cut short or appended: nothing
+// crashes or reads outside the input, and whatever parses is in range
+void test_fuzz() {
+    static const char* seeds[] = {"PROTOCOL_1.5.0_JSON", "TOGGLE_25", "SET_27_OFF", "SET_SAMPLING_RATE_100",
+                                  "ACQ_MODE_SINGLE", "ADAPTIVE_OFF", "TREND_CURRENT_50000", "CAPTURE_READ_0",
+                                  "SELECT_net:pw", "CAPTURE_STOP"};
+    const char alphabet[] = "_:.0123456789ONFSETCURLAVGPIJXBMDQ";
+    uint32_t parsed = 0;
+    for (int round = 0; round < 200000; round++) {
+        char input[64];
+        size_t length;
+        if (round % 4 == 0) {
+            length = nextRandom() % sizeof(input);
+            for (size_t i = 0; i < length; i++) {
+                input[i] = static_cast<char>(nextRandom());
+            }
+        } else {
+            const char* seed = seeds[nextRandom() % (sizeof(seeds) / sizeof(seeds[0]))];
+            length = strlen(seed);
+            memcpy(input, seed, length);
+            for (uint32_t edits = 1 + nextRandom() % 3; edits > 0; edits--) {
+                uint32_t kind = nextRandom() % 3;
+                if (kind == 0 && length > 0) {
+                    input[nextRandom() % length] = alphabet[nextRandom() % (sizeof(alphabet) - 1)];
+                } else if (kind == 1 && length > 0) {
+                    length = nextRandom() % length;
+                } else if (length < sizeof(input)) {
+                    input[length++] = alphabet[nextRandom() % (sizeof(alphabet) - 1)];
+                }
+            }
+        }
+        // Exactly sized, so reading past the end would touch the next allocation under a sanitizer
+        char* exact = new char[length > 0 ? length : 1];
+        memcpy(exact, input, length);
+        bool ok = parseCommand(exact, length, ENVIRONMENT, command);
+        parsed += ok;
+        bool good = consistent(exact, length, ok);
+        delete[] exact;
+        if (!good) {
+            input[length < sizeof(input) ? length : sizeof(input) - 1] = '\0';
+            TEST_FAIL_MESSAGE(input);
+        }
+    }
+    printf("fuzz: %u of 200000 inputs parsed\n", parsed);
+    TEST_ASSERT_TRUE(parsed > 0);
+}
+
+// A client's usual mix, against the table
+void test_parse_throughput() {
+    const char* mix[] = {"TOGGLE_25", "SET_26_ON", "SET_SAMPLING_RATE_20", "TREND_VOLTAGE_2000", "CAPTURE_READ_1320",
+                         "PROTOCOL_1.5.0_STREAM", "ADAPTIVE_OFF", "SCAN", "REBOOT", "SELECT_home:secret"};
+    const int count = sizeof(mix) / sizeof(mix[0]);
+    size_t lengths[count];
+    for (int i = 0; i < count; i++) {
+        lengths[i] = strlen(mix[i]);
+    }
+    uint32_t valid = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 100000; round++) {
+        for (int i = 0; i < count; i++) {
+            valid += parseCommand(mix[i], lengths[i], ENVIRONMENT, command);
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("parse: %.1f ns per command, no allocation\n", ns / (100000.0 * count));
+    TEST_ASSERT_EQUAL_UINT32(100000u * (count - 1), valid);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_command_of_the_table);
+    RUN_TEST(test_sampling_rate_is_not_a_relay);
+    RUN_TEST(test_error_replies);
+    RUN_TEST(test_fuzz);
+    RUN_TEST(test_parse_throughput);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
@@ -0,0 +1,140 @@
+// Host tests for the CIC + compensating FIR decimation chain
+#include <unity.h>
+#include <math.h>
+#include "adc_sample.h"
+
+typedef DecimationChain<DECIMATION_CIC_ORDER, DECIMATION_FIR_TAPS> Chain;
+
+// Gain of the compensator alone at normalised frequency f (relative to its input rate)
+static double compensatorGain(double f) {
+    double re = 0;
+    double im = 0;
+    for (int n = 0; n < DECIMATION_FIR_TAPS; n++) {
+        re += Chain::COMPENSATOR.taps[n] * cos(2 * M_PI * f * n);
+        im -= Chain::COMPENSATOR.taps[n] * sin(2 * M_PI * f * n);
+    }
+    return sqrt(re * re + im * im);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_coefficients_are_symmetric_with_unity_dc_gain() {
+    float sum = 0;
+    for (int n = 0; n < DECIMATION_FIR_TAPS; n++) {
+        sum += Chain::COMPENSATOR.taps[n];
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, Chain::COMPENSATOR.taps[n],
+                                 Chain::COMPENSATOR.taps[DECIMATION_FIR_TAPS - 1 - n]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 1.0f, sum);
+}
+
+void test_compensator_flattens_cic_droop() {
+    // CIC droop at 0.1 of the CIC output rate is ~5% for a 3rd-order filter
+    double f = 0.1;
+    double cic = pow(sin(M_PI * f) / (M_PI * f), DECIMATION_CIC_ORDER);
+    TEST_ASSERT_TRUE(cic < 0.96);
+    TEST_ASSERT_FLOAT_WITHIN(0.02, 1.0, cic * compensatorGain(f));
+}
+
+void test_compensator_rejects_aliasing_band() {
+    for (double f = 0.3; f <= 0.5; f += 0.05) {
+        TEST_ASSERT_TRUE(compensatorGain(f) < 0.01);
+    }
+}
+
+void test_cic_dc_gain_is_normalised() {
+    CicDecimator<3> cic(16);
+    float output = 0;
+    int outputs = 0;
+    for (int i = 0; i < 160; i++) {
+        if (cic.push(-1234, output)) {
+            outputs++;
+        }
+    }
+    TEST_ASSERT_EQUAL(10, outputs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, -1234.0f, output);
+}
+
+void test_chain_decimates_by_requested_ratio() {
+    Chain chain;
+    chain.setRatio(86);
+    TEST_ASSERT_EQUAL_UINT32(86, chain.getRatio());
+
+    int outputs = 0;
+    for (int i = 0; i < 86 * 50; i++) {
+        if (chain.push(20000)) {
+            outputs++;
+        }
+    }
+    TEST_ASSERT_EQUAL(50, outputs);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 20000.0f, chain.output());
+}
+
+void test_chain_removes_noise_above_output_band() {
+    // Alternating +/-1000 counts at the input rate is far outside the output band
+    Chain chain;
+    chain.setRatio(20);
+    for (int i = 0; i < 2000; i++) {
+        chain.push(500 + ((i & 1) ? 1000 : -1000));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 500.0f, chain.output());
+}
+
+void test_low_ratio_bypasses_filters() {
+    Chain chain;
+    chain.setRatio(1);
+    TEST_ASSERT_TRUE(chain.push(42));
+    TEST_ASSERT_EQUAL_FLOAT(42.0f, chain.output());
+    TEST_ASSERT_TRUE(chain.push(-7));
+    TEST_ASSERT_EQUAL_FLOAT(-7.0f, chain.output());
+}
+
+void test_sample_decimator_tracks_period_and_converts_units() {
+    SampleDecimator decimator(100000);
+    decimator.setInputPeriod(1163);  // 860 SPS: 85 rounds down to the even ratio 42 x 2
+    TEST_ASSERT_EQUAL_UINT32(84, decimator.getRatio());
+
+    // 1000.5 and 2000 counts in the sample scale (the widest range of each channel)
+    AdcSample sample{};
+    sample.shuntRaw = 1010;
+    sample.ads2Raw = 2020;
+    sample.shuntGain = SHUNT_WIDEST_GAIN;
+    sample.ads2Gain = ADS2_WIDEST_GAIN;
+    sample.shunt = countsToQ31(1000) + Q31_ONE_COUNT / 2;
+    sample.ads2 = countsToQ31(2000);
+    for (int i = 0; i < 84 * 30; i++) {
+        decimator.add(sample);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1000.5f, q31ToCounts(decimator.shunt()));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 2000.0f, q31ToCounts(decimator.ads2()));
+
+    // 1000.5 counts at GAIN_TWO (62.5 uV) over 1 mOhm is 62.53 A
+    TEST_ASSERT_INT32_WITHIN(100, 62531250, decimator.shuntMicroamps());
+    // 2000 counts at GAIN_ONE is 250 mV
+    TEST_ASSERT_INT32_WITHIN(5, 250000, decimator.ads2Microvolts());
+
+    decimator.setInputPeriod(200000);  // Slower than the output period
+    TEST_ASSERT_EQUAL_UINT32(1, decimator.getRatio());
+    TEST_ASSERT_TRUE(decimator.add(sample));
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_coefficients_are_symmetric_with_unity_dc_gain);
+    RUN_TEST(test_compensator_flattens_cic_droop);
+    RUN_TEST(test_compensator_rejects_aliasing_band);
+    RUN_TEST(test_cic_dc_gain_is_normalised);
+    RUN_TEST(test_chain_decimates_by_requested_ratio);
+    RUN_TEST(test_chain_removes_noise_above_output_band);
+    RUN_TEST(test_low_ratio_bypasses_filters);
+    RUN_TEST(test_sample_decimator_tracks_period_and_converts_units);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
@@ -0,0 +1,123 @@
+// Host tests for the reattach backoff schedule and degraded-time accounting
+#include <unity.h>
+#include "device_recovery.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_first_attempt_is_due_after_first_retry() {
+    RecoveryScheduler recovery;
+    TEST_ASSERT_EQUAL_HEX8(0, recovery.getLostMask());
+    TEST_ASSERT_EQUAL_INT64(INT64_MAX, recovery.getNextAttemptUs());
+
+    recovery.markLost(1, 1000);
+    TEST_ASSERT_EQUAL_HEX8(0x02, recovery.getLostMask());
+    TEST_ASSERT_EQUAL_INT64(1000 + RECOVERY_FIRST_RETRY_US, recovery.getNextAttemptUs());
+    TEST_ASSERT_EQUAL_HEX8(0, recovery.getDueMask(1000 + RECOVERY_FIRST_RETRY_US - 1));
+    TEST_ASSERT_EQUAL_HEX8(0x02, recovery.getDueMask(1000 + RECOVERY_FIRST_RETRY_US));
+    TEST_ASSERT_EQUAL_UINT32(1, recovery.getStatus(1).outages);
+}
+
+void test_failed_attempts_double_up_to_cap() {
+    RecoveryScheduler recovery;
+    recovery.markLost(0, 0);
+    int64_t nowUs = 0;
+    int64_t expectedUs = RECOVERY_FIRST_RETRY_US;
+    for (int attempt = 1; attempt <= 20; attempt++) {
+        nowUs = recovery.getNextAttemptUs();
+        TEST_ASSERT_EQUAL_HEX8(0x01, recovery.getDueMask(nowUs));
+        recovery.attemptFailed(0, nowUs);
+        expectedUs = expectedUs * 2 > RECOVERY_MAX_RETRY_US ? RECOVERY_MAX_RETRY_US : expectedUs * 2;
+        TEST_ASSERT_EQUAL_INT64(expectedUs, recovery.getStatus(0).retryUs);
+        TEST_ASSERT_EQUAL_INT64(nowUs + expectedUs, recovery.getNextAttemptUs());
+        TEST_ASSERT_EQUAL_UINT32(attempt, recovery.getStatus(0).attempts);
+    }
+    TEST_ASSERT_EQUAL_INT64(RECOVERY_MAX_RETRY_US, recovery.getStatus(0).retryUs);
+}
+
+void test_new_outage_restarts_backoff() {
+    RecoveryScheduler recovery;
+    recovery.markLost(0, 0);
+    recovery.attemptFailed(0, 10000);
+    recovery.attemptFailed(0, 30000);
+    recovery.markRecovered(0, 70000);
+    TEST_ASSERT_FALSE(recovery.getStatus(0).lost);
+    TEST_ASSERT_EQUAL_INT64(INT64_MAX, recovery.getNextAttemptUs());
+
+    recovery.markLost(0, 100000);
+    TEST_ASSERT_EQUAL_UINT32(0, recovery.getStatus(0).attempts);
+    TEST_ASSERT_EQUAL_INT64(RECOVERY_FIRST_RETRY_US, recovery.getStatus(0).retryUs);
+    TEST_ASSERT_EQUAL_UINT32(2, recovery.getStatus(0).outages);
+}
+
+void test_repeated_loss_does_not_restart_outage() {
+    RecoveryScheduler recovery;
+    recovery.markLost(2, 5000);
+    recovery.attemptFailed(2, 15000);
+    recovery.markLost(2, 20000);
+    TEST_ASSERT_EQUAL_UINT32(1, recovery.getStatus(2).outages);
+    TEST_ASSERT_EQUAL_UINT32(1, recovery.getStatus(2).attempts);
+    TEST_ASSERT_EQUAL_INT64(5000, recovery.getStatus(2).lostSinceUs);
+}
+
+void test_degraded_time_per_device() {
+    RecoveryScheduler recovery;
+    recovery.markLost(1, 1000000);
+    TEST_ASSERT_EQUAL_INT64(500000, recovery.getDegradedUs(1, 1500000));
+    recovery.markRecovered(1, 3000000);
+    TEST_ASSERT_EQUAL_INT64(2000000, recovery.getStatus(1).lastOutageUs);
+    TEST_ASSERT_EQUAL_INT64(2000000, recovery.getDegradedUs(1, 9000000));
+
+    recovery.markLost(1, 10000000);
+    recovery.markRecovered(1, 10250000);
+    TEST_ASSERT_EQUAL_INT64(250000, recovery.getStatus(1).lastOutageUs);
+    TEST_ASSERT_EQUAL_INT64(2250000, recovery.getDegradedUs(1, 20000000));
+    TEST_ASSERT_EQUAL_INT64(0, recovery.getDegradedUs(0, 20000000));
+}
+
+void test_pipeline_degraded_time_counts_overlap_once() {
+    RecoveryScheduler recovery;
+    // Device 1 lost 1..4 s, device 2 lost 3..6 s: the pipeline is degraded 1..6 s
+    recovery.markLost(1, 1000000);
+    recovery.markLost(2, 3000000);
+    recovery.markRecovered(1, 4000000);
+    TEST_ASSERT_EQUAL_INT64(4000000, recovery.getPipelineDegradedUs(5000000));
+    recovery.markRecovered(2, 6000000);
+    TEST_ASSERT_EQUAL_INT64(5000000, recovery.getPipelineDegradedUs(8000000));
+
+    // A later, separate outage adds to it
+    recovery.markLost(0, 10000000);
+    recovery.markRecovered(0, 10100000);
+    TEST_ASSERT_EQUAL_INT64(5100000, recovery.getPipelineDegradedUs(12000000));
+    TEST_ASSERT_EQUAL_INT64(6100000, recovery.getDegradedUs(0, 0) + recovery.getDegradedUs(1, 0) +
+                                         recovery.getDegradedUs(2, 0));
+}
+
+void test_due_mask_covers_each_lost_device() {
+    RecoveryScheduler recovery;
+    recovery.markLost(0, 0);
+    recovery.markLost(3, 0);
+    recovery.attemptFailed(3, RECOVERY_FIRST_RETRY_US);
+    TEST_ASSERT_EQUAL_HEX8(0x01, recovery.getDueMask(RECOVERY_FIRST_RETRY_US));
+    TEST_ASSERT_EQUAL_HEX8(0x09, recovery.getDueMask(3 * RECOVERY_FIRST_RETRY_US));
+    TEST_ASSERT_EQUAL_INT64(RECOVERY_FIRST_RETRY_US, recovery.getNextAttemptUs());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_attempt_is_due_after_first_retry);
+    RUN_TEST(test_failed_attempts_double_up_to_cap);
+    RUN_TEST(test_new_outage_restarts_backoff);
+    RUN_TEST(test_repeated_loss_does_not_restart_outage);
+    RUN_TEST(test_degraded_time_per_device);
+    RUN_TEST(test_pipeline_degraded_time_counts_overlap_once);
+    RUN_TEST(test_due_mask_covers_each_lost_device);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
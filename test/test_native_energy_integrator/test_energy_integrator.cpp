@@ -0,0 +1,202 @@
+// Host tests for the full-rate charge and energy integrator
+#include <unity.h>
+#include <string.h>
+#include "energy_integrator.h"
+
+// Q31 sample values for exact engineering units: 1 A on the shunt, 2 V on ADS #2
+static const q31_t ONE_AMP = 1 << 20;
+static const q31_t HALF_AMP = 1 << 19;
+static const q31_t TWO_VOLTS = 1048576000;
+
+static AlignedPair makePair(int64_t timeUs, q31_t current, q31_t voltage) {
+    AlignedPair pair;
+    memset(&pair, 0, sizeof(pair));
+    pair.timeUs = timeUs;
+    pair.current = current;
+    pair.voltage = voltage;
+    return pair;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_sample_scale_is_exact() {
+    TEST_ASSERT_EQUAL_INT32(1000000, q31ToUnits(ONE_AMP, SHUNT_MICROAMPS_FULL_SCALE));
+    TEST_ASSERT_EQUAL_INT32(500000, q31ToUnits(HALF_AMP, SHUNT_MICROAMPS_FULL_SCALE));
+    TEST_ASSERT_EQUAL_INT32(2000000, q31ToUnits(TWO_VOLTS, ADS2_MICROVOLTS_FULL_SCALE));
+}
+
+void test_constant_load_integrates_exactly() {
+    EnergyIntegrator integrator;
+    // One second at 1 kHz with a little timestamp jitter; only the span matters
+    for (int i = 0; i <= 1000; i++) {
+        int64_t jitter = (i > 0 && i < 1000) ? (i % 3) * 7 : 0;
+        integrator.add(makePair(5000000 + i * 1000 + jitter, ONE_AMP, TWO_VOLTS));
+    }
+    const EnergyTotals& totals = integrator.getTotals();
+    TEST_ASSERT_EQUAL_INT64(1000000, totals.chargeInUc);
+    TEST_ASSERT_EQUAL_INT64(2000000, totals.energyInUj);
+    TEST_ASSERT_EQUAL_INT64(0, totals.chargeOutUc);
+    TEST_ASSERT_EQUAL_INT64(1000000, totals.coveredUs);
+    TEST_ASSERT_EQUAL_INT64(0, totals.uncoveredUs);
+}
+
+void test_sub_unit_remainders_carry() {
+    EnergyIntegrator integrator;
+    // 0.5 uC per 1 us step: nothing is lost to truncation between steps
+    integrator.add(makePair(0, HALF_AMP, 0));
+    integrator.add(makePair(1, HALF_AMP, 0));
+    TEST_ASSERT_EQUAL_INT64(0, integrator.netChargeUc());
+    integrator.add(makePair(2, HALF_AMP, 0));
+    TEST_ASSERT_EQUAL_INT64(1, integrator.netChargeUc());
+    integrator.add(makePair(3, HALF_AMP, 0));
+    integrator.add(makePair(4, HALF_AMP, 0));
+    TEST_ASSERT_EQUAL_INT64(2, integrator.netChargeUc());
+}
+
+void test_gaps_are_not_integrated() {
+    EnergyIntegrator integrator;
+    integrator.add(makePair(0, ONE_AMP, TWO_VOLTS));
+    integrator.add(makePair(ENERGY_MAX_GAP_US + 1000, ONE_AMP, TWO_VOLTS));
+    TEST_ASSERT_EQUAL_INT64(0, integrator.netChargeUc());
+    TEST_ASSERT_EQUAL_INT64(ENERGY_MAX_GAP_US + 1000, integrator.getTotals().uncoveredUs);
+
+    // Integration resumes from the pair after the gap
+    integrator.add(makePair(ENERGY_MAX_GAP_US + 2000, ONE_AMP, TWO_VOLTS));
+    TEST_ASSERT_EQUAL_INT64(1000, integrator.netChargeUc());
+    TEST_ASSERT_EQUAL_INT64(1000, integrator.getTotals().coveredUs);
+
+    // Repeated or out-of-order timestamps add nothing
+    integrator.add(makePair(ENERGY_MAX_GAP_US + 2000, ONE_AMP, TWO_VOLTS));
+    integrator.add(makePair(ENERGY_MAX_GAP_US, ONE_AMP, TWO_VOLTS));
+    TEST_ASSERT_EQUAL_INT64(1000, integrator.netChargeUc());
+}
+
+void test_bad_pairs_are_bridged() {
+    EnergyIntegrator integrator;
+    integrator.add(makePair(0, ONE_AMP, TWO_VOLTS));
+    // A failed current read holds a wrong value; it is skipped and the trapezoid spans it
+    AlignedPair stale = makePair(1000, 10 * ONE_AMP, TWO_VOLTS);
+    stale.currentQuality = SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE;
+    integrator.add(stale);
+    AlignedPair lost = makePair(2000, ONE_AMP, 0);
+    lost.voltageQuality = SAMPLE_QUALITY_RECOVERING;
+    integrator.add(lost);
+    // The held voltage of a channel that is not converted at all is used
+    AlignedPair unscanned = makePair(3000, ONE_AMP, TWO_VOLTS);
+    unscanned.voltageQuality = SAMPLE_QUALITY_HELD;
+    integrator.add(unscanned);
+    TEST_ASSERT_EQUAL_INT64(3000, integrator.netChargeUc());
+    TEST_ASSERT_EQUAL_INT64(6000, integrator.netEnergyUj());
+    TEST_ASSERT_EQUAL_INT64(3000, integrator.getTotals().coveredUs);
+    TEST_ASSERT_EQUAL_INT64(0, integrator.getTotals().energyUncoveredUs);
+}
+
+void test_lost_voltage_still_integrates_charge() {
+    EnergyIntegrator integrator;
+    // No voltage converter at all: charge only, every covered second energy-uncovered
+    for (int64_t t = 0; t <= 1000000; t += 1000) {
+        AlignedPair pair = makePair(t, ONE_AMP, 0);
+        pair.voltageQuality = SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING;
+        integrator.add(pair);
+    }
+    TEST_ASSERT_EQUAL_INT64(1000000, integrator.netChargeUc());
+    TEST_ASSERT_EQUAL_INT64(0, integrator.netEnergyUj());
+    TEST_ASSERT_EQUAL_INT64(1000000, integrator.getTotals().coveredUs);
+    TEST_ASSERT_EQUAL_INT64(1000000, integrator.getTotals().energyUncoveredUs);
+
+    // The voltage comes back: energy resumes from its first pair
+    integrator.add(makePair(1001000, ONE_AMP, TWO_VOLTS));
+    integrator.add(makePair(1002000, ONE_AMP, TWO_VOLTS));
+    TEST_ASSERT_EQUAL_INT64(1002000, integrator.netChargeUc());
+    TEST_ASSERT_EQUAL_INT64(2000, integrator.netEnergyUj());
+    TEST_ASSERT_EQUAL_INT64(1001000, integrator.getTotals().energyUncoveredUs);
+    TEST_ASSERT_EQUAL_INT64(0, integrator.getTotals().uncoveredUs);
+}
+
+void test_long_voltage_outage_is_energy_uncovered() {
+    EnergyIntegrator integrator;
+    int64_t t = 0;
+    for (; t <= 10000; t += 1000) {
+        integrator.add(makePair(t, ONE_AMP, TWO_VOLTS));
+    }
+    // Two seconds without a voltage: charge carries on, energy is not guessed across it
+    for (; t <= 2010000; t += 1000) {
+        AlignedPair pair = makePair(t, ONE_AMP, TWO_VOLTS);
+        pair.voltageQuality = SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE | SAMPLE_QUALITY_RECOVERING;
+        integrator.add(pair);
+    }
+    for (; t <= 2020000; t += 1000) {
+        integrator.add(makePair(t, ONE_AMP, TWO_VOLTS));
+    }
+    const EnergyTotals& totals = integrator.getTotals();
+    TEST_ASSERT_EQUAL_INT64(2020000, integrator.netChargeUc());
+    TEST_ASSERT_EQUAL_INT64(2020000, totals.coveredUs);
+    TEST_ASSERT_EQUAL_INT64(2001000, totals.energyUncoveredUs);
+    // 2 W over the 19 ms either side of the outage
+    TEST_ASSERT_EQUAL_INT64(38000, integrator.netEnergyUj());
+}
+
+void test_direction_is_split() {
+    EnergyIntegrator integrator;
+    int64_t t = 0;
+    for (int i = 0; i < 500; i++, t += 1000) {
+        integrator.add(makePair(t, -ONE_AMP, TWO_VOLTS));
+    }
+    for (int i = 0; i <= 500; i++, t += 1000) {
+        integrator.add(makePair(t, ONE_AMP, TWO_VOLTS));
+    }
+    const EnergyTotals& totals = integrator.getTotals();
+    // The step between the halves averages to zero
+    TEST_ASSERT_EQUAL_INT64(499000, totals.chargeOutUc);
+    TEST_ASSERT_EQUAL_INT64(500000, totals.chargeInUc);
+    TEST_ASSERT_EQUAL_INT64(998000, totals.energyOutUj);
+    TEST_ASSERT_EQUAL_INT64(1000000, totals.energyInUj);
+    TEST_ASSERT_EQUAL_INT64(1000, integrator.netChargeUc());
+    TEST_ASSERT_EQUAL_INT64(2000, integrator.netEnergyUj());
+}
+
+void test_restore_continues_from_checkpoint() {
+    EnergyIntegrator before;
+    before.add(makePair(0, ONE_AMP, TWO_VOLTS));
+    before.add(makePair(1000, ONE_AMP, TWO_VOLTS));
+
+    // Persisted as raw bytes, as NVS stores it
+    EnergyTotals stored;
+    memcpy(&stored, &before.getTotals(), sizeof(stored));
+    TEST_ASSERT_EQUAL_UINT16(ENERGY_TOTALS_VERSION, stored.version);
+
+    // After a reboot the clock restarts; the first pair only opens a new segment
+    EnergyIntegrator after;
+    after.restore(stored);
+    after.add(makePair(100, ONE_AMP, TWO_VOLTS));
+    TEST_ASSERT_EQUAL_INT64(1000, after.netChargeUc());
+    after.add(makePair(1100, ONE_AMP, TWO_VOLTS));
+    TEST_ASSERT_EQUAL_INT64(2000, after.netChargeUc());
+    TEST_ASSERT_EQUAL_INT64(4000, after.netEnergyUj());
+
+    after.reset();
+    TEST_ASSERT_EQUAL_INT64(0, after.netChargeUc());
+    TEST_ASSERT_EQUAL_INT64(0, after.getTotals().coveredUs);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sample_scale_is_exact);
+    RUN_TEST(test_constant_load_integrates_exactly);
+    RUN_TEST(test_sub_unit_remainders_carry);
+    RUN_TEST(test_gaps_are_not_integrated);
+    RUN_TEST(test_bad_pairs_are_bridged);
+    RUN_TEST(test_lost_voltage_still_integrates_charge);
+    RUN_TEST(test_long_voltage_outage_is_energy_uncovered);
+    RUN_TEST(test_direction_is_split);
+    RUN_TEST(test_restore_continues_from_checkpoint);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
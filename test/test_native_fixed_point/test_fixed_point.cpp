@@ -0,0 +1,152 @@
+// Host tests and benchmark for the fixed-point signal path against the float reference
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include "adc_sample.h"
+
+typedef DecimationChain<DECIMATION_CIC_ORDER, DECIMATION_FIR_TAPS> FloatChain;
+typedef FixedDecimationChain<DECIMATION_CIC_ORDER, DECIMATION_FIR_TAPS> FixedChain;
+
+static const int BENCHMARK_SAMPLES = 200000;
+
+// Deterministic test signal: DC + in-band sine + out-of-band tone + LCG noise, in counts
+static int16_t testSignal(int i) {
+    static uint32_t seed = 12345;
+    seed = seed * 1664525 + 1013904223;
+    double value = 3000 + 8000 * sin(2 * M_PI * i / 5000.0) + 2000 * sin(2 * M_PI * i / 3.0) +
+                   static_cast<int>((seed >> 16) % 64) - 32;
+    return static_cast<int16_t>(value);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_counts_convert_exactly_and_saturate() {
+    TEST_ASSERT_EQUAL_INT32(32767L * 65536, countsToQ31(32767));
+    TEST_ASSERT_EQUAL_INT32(INT32_MIN, countsToQ31(-32768));
+    TEST_ASSERT_EQUAL_FLOAT(-1.5f, q31ToCounts(-3 * Q31_ONE_COUNT / 2));
+
+    // Raw full scale minus a negative offset clips instead of wrapping
+    TEST_ASSERT_EQUAL_INT32(INT32_MAX, subQ31(countsToQ31(32767), countsToQ31(-100)));
+    TEST_ASSERT_EQUAL_INT32(INT32_MIN, subQ31(countsToQ31(-32768), countsToQ31(1)));
+}
+
+void test_q15_coefficients_track_design_with_unity_dc() {
+    int32_t sum = 0;
+    for (int n = 0; n < DECIMATION_FIR_TAPS; n++) {
+        sum += FixedChain::COMPENSATOR.taps[n];
+        TEST_ASSERT_FLOAT_WITHIN(2.0 / Q15_ONE, FloatChain::COMPENSATOR.taps[n],
+                                 FixedChain::COMPENSATOR.taps[n] / static_cast<double>(Q15_ONE));
+    }
+    TEST_ASSERT_EQUAL_INT32(Q15_ONE, sum);
+}
+
+void test_fixed_cic_keeps_fractional_counts() {
+    CicDecimator<3> cic(4);
+    q31_t output = 0;
+    int16_t inputs[] = {1, 2, 1, 2};
+    for (int repeat = 0; repeat < 4; repeat++) {
+        for (int16_t input : inputs) {
+            cic.push(input, output, Q31_COUNT_SHIFT);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT32(3 * Q31_ONE_COUNT / 2, output);
+}
+
+void test_fixed_chain_matches_float_chain() {
+    FloatChain floatChain;
+    FixedChain fixedChain;
+    floatChain.setRatio(84);
+    fixedChain.setRatio(84);
+
+    double worst = 0;
+    for (int i = 0; i < 84 * 400; i++) {
+        int16_t input = testSignal(i);
+        bool floatReady = floatChain.push(input);
+        bool fixedReady = fixedChain.push(countsToQ31(input));
+        TEST_ASSERT_EQUAL(floatReady, fixedReady);
+        if (fixedReady) {
+            double error = fabs(floatChain.output() - q31ToCounts(fixedChain.output()));
+            if (error > worst) {
+                worst = error;
+            }
+        }
+    }
+    // Q15 coefficient rounding bounds the difference well below one count
+    TEST_ASSERT_TRUE(worst < 0.25);
+}
+
+void test_engineering_units_match_float_conversion() {
+    for (int32_t counts = -32768; counts <= 32767; counts += 97) {
+        q31_t value = countsToQ31(static_cast<int16_t>(counts)) + Q31_ONE_COUNT / 3;
+        double exactCounts = counts + 1.0 / 3;
+
+        double microamps = exactCounts / 32768.0 * fullScaleMicrovolts(SHUNT_WIDEST_GAIN) * 1000000.0 / SHUNT_RESISTANCE_MICROOHMS;
+        TEST_ASSERT_FLOAT_WITHIN(256.0, microamps, q31ToUnits(value, SHUNT_MICROAMPS_FULL_SCALE));
+
+        double microvolts = exactCounts / 32768.0 * fullScaleMicrovolts(ADS2_WIDEST_GAIN) * VOLTAGE_DIVIDER_RATIO;
+        TEST_ASSERT_FLOAT_WITHIN(1.0, microvolts, q31ToUnits(value, ADS2_MICROVOLTS_FULL_SCALE));
+    }
+}
+
+// Offset, filter and unit conversion per sample, float reference vs fixed point.
+// Reports ns/sample; the numbers are informational, only the results are asserted.
+void test_benchmark_fixed_vs_float_path() {
+    static int16_t inputs[BENCHMARK_SAMPLES];
+    for (int i = 0; i < BENCHMARK_SAMPLES; i++) {
+        inputs[i] = testSignal(i);
+    }
+
+    const float floatOffset = 12.3f;
+    const float floatMicroampsPerCount = SHUNT_MICROAMPS_FULL_SCALE / 32768.0f;
+    FloatChain floatChain;
+    floatChain.setRatio(84);
+    volatile float floatSink = 0;
+    auto floatStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCHMARK_SAMPLES; i++) {
+        if (floatChain.push(inputs[i])) {
+            floatSink = (floatChain.output() - floatOffset) * floatMicroampsPerCount;
+        }
+    }
+    auto floatEnd = std::chrono::steady_clock::now();
+
+    const q31_t fixedOffset = countsToQ31(12) + Q31_ONE_COUNT * 3 / 10;
+    FixedChain fixedChain;
+    fixedChain.setRatio(84);
+    volatile int32_t fixedSink = 0;
+    auto fixedStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCHMARK_SAMPLES; i++) {
+        if (fixedChain.push(countsToQ31(inputs[i]))) {
+            fixedSink = q31ToUnits(subQ31(fixedChain.output(), fixedOffset), SHUNT_MICROAMPS_FULL_SCALE);
+        }
+    }
+    auto fixedEnd = std::chrono::steady_clock::now();
+
+    double floatNs = std::chrono::duration<double, std::nano>(floatEnd - floatStart).count() / BENCHMARK_SAMPLES;
+    double fixedNs = std::chrono::duration<double, std::nano>(fixedEnd - fixedStart).count() / BENCHMARK_SAMPLES;
+    char message[128];
+    snprintf(message, sizeof(message), "signal path: float %.1f ns/sample, fixed %.1f ns/sample", floatNs, fixedNs);
+    TEST_MESSAGE(message);
+
+    // Both paths must agree to within a few milliamps (a count is 62.5 mA here)
+    TEST_ASSERT_FLOAT_WITHIN(4000.0, floatSink, fixedSink);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_counts_convert_exactly_and_saturate);
+    RUN_TEST(test_q15_coefficients_track_design_with_unity_dc);
+    RUN_TEST(test_fixed_cic_keeps_fractional_counts);
+    RUN_TEST(test_fixed_chain_matches_float_chain);
+    RUN_TEST(test_engineering_units_match_float_conversion);
+    RUN_TEST(test_benchmark_fixed_vs_float_path);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
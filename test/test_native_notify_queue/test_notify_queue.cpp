@@ -0,0 +1,189 @@
+// Host tests for the outbound notification queue: order, the bound, the credit scheme and
+// how a stream degrades when the client falls behind
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "notify_queue.h"
+#include "sample_batch.h"
+
+static uint8_t payload[NOTIFY_QUEUE_SLOT_SIZE + 1];
+
+// A payload whose first byte tells it apart
+static bool pushTagged(NotifyQueue& queue, uint8_t tag, size_t length = 10) {
+    memset(payload, tag, length);
+    return queue.push(payload, length);
+}
+
+// Tag of the entry a credit allows out, -1 when none
+static int frontTag(const NotifyQueue& queue) {
+    const uint8_t* data;
+    size_t length;
+    return queue.front(data, length) ? data[0] : -1;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_fifo_without_flow_control() {
+    NotifyQueue queue;
+    TEST_ASSERT_FALSE(queue.isFlowControlled());
+    TEST_ASSERT_EQUAL_INT(-1, frontTag(queue));
+    for (uint8_t tag = 1; tag <= 5; tag++) {
+        TEST_ASSERT_TRUE(pushTagged(queue, tag, tag * 50));
+    }
+    TEST_ASSERT_EQUAL_UINT8(5, queue.getDepth());
+    for (uint8_t tag = 1; tag <= 5; tag++) {
+        const uint8_t* data;
+        size_t length;
+        TEST_ASSERT_TRUE(queue.front(data, length));
+        TEST_ASSERT_EQUAL_UINT8(tag, data[0]);
+        TEST_ASSERT_EQUAL_UINT32(tag * 50, length);
+        queue.pop();
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, queue.getDepth());
+    TEST_ASSERT_EQUAL_UINT8(5, queue.getMaxDepth());
+    TEST_ASSERT_EQUAL_UINT32(5, queue.getSent());
+    TEST_ASSERT_EQUAL_UINT32(0, queue.getDropped());
+}
+
+void test_full_queue_drops_the_oldest() {
+    NotifyQueue queue;
+    for (uint8_t tag = 1; tag <= NOTIFY_QUEUE_DEPTH + 3; tag++) {
+        pushTagged(queue, tag);
+    }
+    TEST_ASSERT_EQUAL_UINT8(NOTIFY_QUEUE_DEPTH, queue.getDepth());
+    TEST_ASSERT_EQUAL_UINT32(3, queue.getDropped());
+    TEST_ASSERT_EQUAL_INT(4, frontTag(queue));
+
+    // Nothing empty or larger than an attribute is queued
+    TEST_ASSERT_FALSE(queue.push(payload, 0));
+    TEST_ASSERT_FALSE(queue.push(payload, NOTIFY_QUEUE_SLOT_SIZE + 1));
+    TEST_ASSERT_EQUAL_UINT32(5, queue.getDropped());
+    TEST_ASSERT_TRUE(pushTagged(queue, 99, NOTIFY_QUEUE_SLOT_SIZE));
+
+    queue.clear();
+    TEST_ASSERT_EQUAL_UINT8(0, queue.getDepth());
+    TEST_ASSERT_EQUAL_INT(-1, frontTag(queue));
+}
+
+void test_credits() {
+    NotifyQueue queue;
+    pushTagged(queue, 1);
+    pushTagged(queue, 2);
+    pushTagged(queue, 3);
+
+    // A grant of 0 turns flow control on and pauses
+    queue.grant(0);
+    TEST_ASSERT_TRUE(queue.isFlowControlled());
+    TEST_ASSERT_EQUAL_INT(-1, frontTag(queue));
+
+    queue.grant(2);
+    TEST_ASSERT_EQUAL_INT(1, frontTag(queue));
+    queue.pop();
+    TEST_ASSERT_EQUAL_INT(2, frontTag(queue));
+    queue.pop();
+    TEST_ASSERT_EQUAL_INT32(0, queue.getCredits());
+    TEST_ASSERT_EQUAL_INT(-1, frontTag(queue));
+    TEST_ASSERT_EQUAL_UINT8(1, queue.getDepth());
+
+    // Grants add up to the limit
+    queue.grant(NOTIFY_CREDIT_LIMIT - 10);
+    queue.grant(100);
+    TEST_ASSERT_EQUAL_INT32(NOTIFY_CREDIT_LIMIT, queue.getCredits());
+    queue.grant(UINT32_MAX);
+    TEST_ASSERT_EQUAL_INT32(NOTIFY_CREDIT_LIMIT, queue.getCredits());
+
+    // A new connection starts without flow control
+    queue.resetCredits();
+    TEST_ASSERT_FALSE(queue.isFlowControlled());
+    TEST_ASSERT_EQUAL_INT(3, frontTag(queue));
+}
+
+void test_refused_notification_keeps_its_credit() {
+    NotifyQueue queue;
+    pushTagged(queue, 1);
+    pushTagged(queue, 2);
+    queue.grant(1);
+
+    // Notifications disabled: the stack refuses the entry, which is neither sent nor charged
+    queue.fail();
+    TEST_ASSERT_EQUAL_UINT32(1, queue.getFailed());
+    TEST_ASSERT_EQUAL_UINT32(0, queue.getSent());
+    TEST_ASSERT_EQUAL_UINT32(0, queue.getDropped());
+    TEST_ASSERT_EQUAL_INT32(1, queue.getCredits());
+
+    // The credit still lets the next entry out
+    TEST_ASSERT_EQUAL_INT(2, frontTag(queue));
+    queue.pop();
+    TEST_ASSERT_EQUAL_UINT32(1, queue.getSent());
+    TEST_ASSERT_EQUAL_INT32(0, queue.getCredits());
+    queue.fail();
+    TEST_ASSERT_EQUAL_UINT32(1, queue.getFailed());
+}
+
+// A 200 samples/s stream of sample batches and a frame every 100 ms, about 16
+// notifications a second, against a client that can take 8 a second and grants a credit
+// every 125 ms: the loss is steady, every drop is counted and the newest data keeps flowing
+void test_slow_client_degrades_predictably() {
+    NotifyQueue queue;
+    queue.grant(4);
+    SampleBatcher batcher(244);
+    uint32_t produced = 0;
+    uint32_t received = 0;
+    uint16_t lastSequence = 0;
+    uint32_t gaps = 0;
+    for (int ms = 0; ms < 60000; ms += 5) {
+        BatchSample sample = {ms * 1000LL, 1500000 + (ms % 7) * 100, 3300000, 0, 0};
+        if (!batcher.add(sample)) {
+            queue.push(batcher.data(), batcher.size());
+            produced++;
+            batcher.clear();
+            batcher.add(sample);
+        }
+        if (ms % 100 == 0) {
+            pushTagged(queue, 0xA7, 84);
+            produced++;
+        }
+        // One pass of the BLE task every 20 ms, up to four notifications
+        if (ms % 20 == 0) {
+            const uint8_t* data;
+            size_t length;
+            for (int i = 0; i < 4 && queue.front(data, length); i++) {
+                if (data[0] == SAMPLE_BATCH_MAGIC) {
+                    uint16_t sequence = static_cast<uint16_t>(data[2] | (data[3] << 8));
+                    gaps += received > 0 && sequence != static_cast<uint16_t>(lastSequence + 1);
+                    lastSequence = sequence;
+                }
+                queue.pop();
+                received++;
+            }
+        }
+        if (ms % 125 == 0) {
+            queue.grant(1);
+        }
+    }
+    printf("slow client: %u notifications produced, %u received, %u dropped, %u batch gaps, max depth %u\n",
+           produced, received, queue.getDropped(), gaps, queue.getMaxDepth());
+    TEST_ASSERT_EQUAL_UINT32(produced, received + queue.getDropped() + queue.getDepth());
+    TEST_ASSERT_EQUAL_UINT8(NOTIFY_QUEUE_DEPTH, queue.getMaxDepth());
+    TEST_ASSERT_TRUE(gaps > 0);
+    // Exactly what the client granted gets through
+    TEST_ASSERT_EQUAL_UINT32(4 + 60000 / 125, received);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_without_flow_control);
+    RUN_TEST(test_full_queue_drops_the_oldest);
+    RUN_TEST(test_credits);
+    RUN_TEST(test_refused_notification_keeps_its_credit);
+    RUN_TEST(test_slow_client_degrades_predictably);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
@@ -0,0 +1,127 @@
+// Host tests for the incremental per-gain offset calibration
+#include <unity.h>
+#include <string.h>
+#include "offset_calibrator.h"
+
+static const int READINGS_PER_GAIN = CALIBRATION_SETTLE_SAMPLES + CALIBRATION_SAMPLES_PER_GAIN;
+
+// Drive a calibrator like the acquisition task does: convert at the target gain and feed
+// the reading back; the simulated input offset is 100 uV
+static int runToCompletion(OffsetCalibrator& calibrator) {
+    int readings = 0;
+    while (calibrator.isRunning() && readings < 10000) {
+        Ads1115Gain gain = calibrator.getTargetGain();
+        int16_t raw = static_cast<int16_t>(100 * 32768 / fullScaleMicrovolts(gain));
+        calibrator.feed(raw, gain);
+        readings++;
+    }
+    return readings;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_walks_every_gain_in_range() {
+    OffsetCalibrator calibrator;
+    calibrator.start(GAIN_TWO, GAIN_SIXTEEN);
+    TEST_ASSERT_TRUE(calibrator.isRunning());
+    TEST_ASSERT_EQUAL_HEX16(GAIN_TWO, calibrator.getTargetGain());
+
+    TEST_ASSERT_EQUAL(4 * READINGS_PER_GAIN, runToCompletion(calibrator));
+    TEST_ASSERT_FALSE(calibrator.isRunning());
+    TEST_ASSERT_EQUAL_UINT8(100, calibrator.getProgress());
+
+    const CalibrationRecord& record = calibrator.getRecord();
+    TEST_ASSERT_EQUAL_UINT16(CALIBRATION_RECORD_VERSION, record.version);
+    TEST_ASSERT_EQUAL_HEX16(0x3C, record.validMask);  // Gain indices 2-5
+    TEST_ASSERT_EQUAL_INT32(countsToQ31(1), record.offsets[ads1115GainIndex(GAIN_TWO)]);
+    TEST_ASSERT_EQUAL_INT32(countsToQ31(12), record.offsets[ads1115GainIndex(GAIN_SIXTEEN)]);
+}
+
+void test_readings_at_other_gains_are_ignored() {
+    OffsetCalibrator calibrator;
+    calibrator.start(GAIN_EIGHT, GAIN_SIXTEEN);
+
+    // Conversions still in flight at the old gain must not be counted
+    for (int i = 0; i < 100; i++) {
+        calibrator.feed(5000, GAIN_ONE);
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, calibrator.getProgress());
+
+    // Settling readings are discarded, even if they are far off
+    for (int i = 0; i < CALIBRATION_SETTLE_SAMPLES; i++) {
+        calibrator.feed(5000, GAIN_EIGHT);
+    }
+    for (int i = 0; i < CALIBRATION_SAMPLES_PER_GAIN; i++) {
+        calibrator.feed(i % 2 ? 7 : 8, GAIN_EIGHT);
+    }
+    TEST_ASSERT_EQUAL_HEX16(GAIN_SIXTEEN, calibrator.getTargetGain());
+    TEST_ASSERT_EQUAL_INT32(countsToQ31(7) + Q31_ONE_COUNT / 2, calibrator.getRecord().offsets[ads1115GainIndex(GAIN_EIGHT)]);
+}
+
+void test_progress_advances_monotonically() {
+    OffsetCalibrator calibrator;
+    calibrator.start(GAIN_ONE, GAIN_SIXTEEN);
+    uint8_t last = calibrator.getProgress();
+    TEST_ASSERT_EQUAL_UINT8(0, last);
+    while (calibrator.isRunning()) {
+        calibrator.feed(0, calibrator.getTargetGain());
+        TEST_ASSERT_TRUE(calibrator.getProgress() >= last);
+        last = calibrator.getProgress();
+    }
+    TEST_ASSERT_EQUAL_UINT8(100, last);
+}
+
+void test_abort_keeps_record_invalid() {
+    OffsetCalibrator calibrator;
+    calibrator.start(GAIN_ONE, GAIN_SIXTEEN);
+    for (int i = 0; i < READINGS_PER_GAIN; i++) {
+        calibrator.feed(3, GAIN_ONE);
+    }
+    calibrator.abort();
+    TEST_ASSERT_FALSE(calibrator.isRunning());
+
+    GainOffsetTable table(GAIN_ONE);
+    TEST_ASSERT_FALSE(applyCalibrationRecord(calibrator.getRecord(), GAIN_ONE, GAIN_SIXTEEN, table));
+    TEST_ASSERT_EQUAL_INT32(0, table.getOffset(GAIN_ONE));
+}
+
+void test_record_round_trip_into_offset_table() {
+    OffsetCalibrator calibrator;
+    calibrator.start(GAIN_TWO, GAIN_SIXTEEN);
+    runToCompletion(calibrator);
+
+    // Persisted as raw bytes, as NVS stores it
+    CalibrationRecord stored;
+    memcpy(&stored, &calibrator.getRecord(), sizeof(stored));
+
+    GainOffsetTable table(GAIN_TWO);
+    TEST_ASSERT_TRUE(applyCalibrationRecord(stored, GAIN_TWO, GAIN_SIXTEEN, table));
+    TEST_ASSERT_EQUAL_INT32(countsToQ31(6), table.getOffset(GAIN_EIGHT));
+    TEST_ASSERT_EQUAL_INT32(0, table.correct(6, GAIN_EIGHT));
+
+    // A record from an older layout forces recalibration
+    stored.version = CALIBRATION_RECORD_VERSION - 1;
+    TEST_ASSERT_FALSE(applyCalibrationRecord(stored, GAIN_TWO, GAIN_SIXTEEN, table));
+
+    // As does one that does not cover the channel's gain range
+    stored.version = CALIBRATION_RECORD_VERSION;
+    TEST_ASSERT_FALSE(applyCalibrationRecord(stored, GAIN_ONE, GAIN_SIXTEEN, table));
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_walks_every_gain_in_range);
+    RUN_TEST(test_readings_at_other_gains_are_ignored);
+    RUN_TEST(test_progress_advances_monotonically);
+    RUN_TEST(test_abort_keeps_record_invalid);
+    RUN_TEST(test_record_round_trip_into_offset_table);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
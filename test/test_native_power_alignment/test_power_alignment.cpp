@@ -0,0 +1,274 @@
+// Host tests for the current/voltage time alignment and the windowed real power built on
+// the aligned pairs
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "pair_aligner.h"
+#include "power_window.h"
+
+// Q31 sample values for exact engineering units: 1 A on the shunt, 1 V on ADS #2
+static const q31_t ONE_AMP = 1 << 20;
+static const q31_t ONE_VOLT = 524288000;
+
+// 860 SPS conversion period
+static const int64_t PERIOD_US = 1163;
+
+static AdcSample makeSample(int64_t shuntUs, q31_t shunt, int64_t ads2Us, q31_t ads2) {
+    AdcSample sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.timestampUs = shuntUs;
+    sample.shuntGain = SHUNT_WIDEST_GAIN;
+    sample.ads2Gain = ADS2_WIDEST_GAIN;
+    sample.shunt = shunt;
+    sample.ads2 = ads2;
+    sample.shuntUs = shuntUs;
+    sample.ads2Us = ads2Us;
+    return sample;
+}
+
+static q31_t amps(double value) {
+    return static_cast<q31_t>(lround(value * ONE_AMP));
+}
+
+static q31_t volts(double value) {
+    return static_cast<q31_t>(lround(value * ONE_VOLT));
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_voltage_is_interpolated_to_the_current_instant() {
+    PairAligner aligner;
+    AlignedPair pair;
+    // Voltage converts 400 us before the current; the current waits for the next voltage
+    aligner.add(makeSample(1400, ONE_AMP, 1000, volts(1)));
+    TEST_ASSERT_FALSE(aligner.read(pair));
+    aligner.add(makeSample(2400, 2 * ONE_AMP, 2000, volts(2)));
+    TEST_ASSERT_TRUE(aligner.read(pair));
+    TEST_ASSERT_EQUAL_INT64(1400, pair.timeUs);
+    TEST_ASSERT_EQUAL_INT32(ONE_AMP, pair.current);
+    TEST_ASSERT_EQUAL_INT32(volts(1.4), pair.voltage);
+    TEST_ASSERT_FALSE(aligner.read(pair));
+
+    aligner.add(makeSample(3400, ONE_AMP, 3000, volts(1)));
+    TEST_ASSERT_TRUE(aligner.read(pair));
+    TEST_ASSERT_EQUAL_INT64(2400, pair.timeUs);
+    TEST_ASSERT_EQUAL_INT32(volts(1.6), pair.voltage);
+    TEST_ASSERT_EQUAL_UINT32(2, aligner.getAligned());
+}
+
+void test_rotated_voltage_releases_every_waiting_current() {
+    PairAligner aligner;
+    AlignedPair pair;
+    // The voltage converts every third slot and is held in between
+    for (int slot = 0; slot <= 6; slot++) {
+        int converted = slot - slot % 3;
+        AdcSample sample = makeSample(slot * 1000, ONE_AMP, converted * 1000, volts(0.5 * converted));
+        if (converted != slot) {
+            sample.ads2Quality = SAMPLE_QUALITY_HELD;
+        }
+        aligner.add(sample);
+    }
+    // Slot 0 pairs at once; slots 1-3 wait for slot 3, 4-6 for slot 6
+    for (int slot = 0; slot <= 6; slot++) {
+        TEST_ASSERT_TRUE(aligner.read(pair));
+        TEST_ASSERT_EQUAL_INT64(slot * 1000, pair.timeUs);
+        TEST_ASSERT_INT32_WITHIN(1, volts(0.5 * slot), pair.voltage);
+    }
+    TEST_ASSERT_FALSE(aligner.read(pair));
+}
+
+void test_currents_pass_through_a_voltage_outage() {
+    PairAligner aligner;
+    AlignedPair pair;
+    aligner.add(makeSample(0, ONE_AMP, 0, volts(1)));
+    TEST_ASSERT_TRUE(aligner.read(pair));
+    aligner.add(makeSample(1000, ONE_AMP, 1000, volts(1)));
+    TEST_ASSERT_TRUE(aligner.read(pair));
+
+    AdcSample lost = makeSample(2000, ONE_AMP, 1000, volts(1));
+    lost.ads2Quality = SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING;
+    aligner.add(lost);
+    // 2000 fell in the outage: it comes out at once, flagged like the voltage
+    TEST_ASSERT_TRUE(aligner.read(pair));
+    TEST_ASSERT_EQUAL_INT64(2000, pair.timeUs);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING, pair.voltageQuality);
+    aligner.add(makeSample(3000, ONE_AMP, 3500, volts(1)));
+    aligner.add(makeSample(4000, ONE_AMP, 4500, volts(1)));
+    // No voltage is interpolated across the outage: 3000 has none before it; 4000 is
+    // bracketed again
+    TEST_ASSERT_TRUE(aligner.read(pair));
+    TEST_ASSERT_EQUAL_INT64(4000, pair.timeUs);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_FRESH, pair.voltageQuality);
+    TEST_ASSERT_FALSE(aligner.read(pair));
+    TEST_ASSERT_EQUAL_UINT32(1, aligner.getUnaligned());
+}
+
+void test_waiting_currents_are_released_when_the_voltage_is_lost() {
+    PairAligner aligner;
+    AlignedPair pair;
+    aligner.add(makeSample(0, ONE_AMP, 0, volts(1)));
+    TEST_ASSERT_TRUE(aligner.read(pair));
+    // A rotated voltage: 1000 waits for the next conversion, which never comes
+    AdcSample held = makeSample(1000, ONE_AMP, 0, volts(1));
+    held.ads2Quality = SAMPLE_QUALITY_HELD;
+    aligner.add(held);
+    TEST_ASSERT_FALSE(aligner.read(pair));
+    AdcSample lost = makeSample(2000, ONE_AMP, 0, volts(1));
+    lost.ads2Quality = SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE;
+    aligner.add(lost);
+    for (int64_t expectedUs = 1000; expectedUs <= 2000; expectedUs += 1000) {
+        TEST_ASSERT_TRUE(aligner.read(pair));
+        TEST_ASSERT_EQUAL_INT64(expectedUs, pair.timeUs);
+        TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE, pair.voltageQuality);
+    }
+    TEST_ASSERT_FALSE(aligner.read(pair));
+    TEST_ASSERT_EQUAL_UINT32(0, aligner.getUnaligned());
+}
+
+void test_unscanned_voltage_passes_currents_through() {
+    PairAligner aligner;
+    AlignedPair pair;
+    AdcSample sample = makeSample(1000, ONE_AMP, 0, 0);
+    sample.ads2Quality = SAMPLE_QUALITY_HELD;
+    aligner.add(sample);
+    TEST_ASSERT_TRUE(aligner.read(pair));
+    TEST_ASSERT_EQUAL_INT64(1000, pair.timeUs);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD, pair.voltageQuality);
+}
+
+void test_window_real_power_and_power_factor() {
+    PowerWindow window(100000);
+    // 2 V and 0.5 A DC: 1 W, power factor 1
+    bool completed = false;
+    for (int64_t t = 0; t <= 100000; t += 1000) {
+        AlignedPair pair = {t, amps(0.5), volts(2), SAMPLE_QUALITY_FRESH, SAMPLE_QUALITY_FRESH};
+        completed = window.add(pair);
+    }
+    TEST_ASSERT_TRUE(completed);
+    const PowerSummary& summary = window.latest();
+    TEST_ASSERT_EQUAL_UINT32(100, summary.pairs);
+    TEST_ASSERT_EQUAL_INT64(100000, summary.coveredUs);
+    TEST_ASSERT_FLOAT_WITHIN(1, 1000000, summary.realPowerUw);
+    TEST_ASSERT_FLOAT_WITHIN(1, 2000000, summary.voltageRmsUv);
+    TEST_ASSERT_FLOAT_WITHIN(1, 500000, summary.currentRmsUa);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 1.0, summary.powerFactor);
+    TEST_ASSERT_EQUAL_INT64(1000000, window.getInstantPowerUw());
+
+    // Current in quadrature with the voltage: no real power, apparent power stays
+    for (int64_t t = 101000; t <= 201000; t += 1000) {
+        double phase = 2 * 3.141592653589793 * t / 20000.0;
+        AlignedPair pair = {t, amps(sin(phase)), volts(2 * cos(phase)), SAMPLE_QUALITY_FRESH,
+                            SAMPLE_QUALITY_FRESH};
+        window.add(pair);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(20000, 0, window.latest().realPowerUw);
+    TEST_ASSERT_FLOAT_WITHIN(0.02, 0.0, window.latest().powerFactor);
+    TEST_ASSERT_FLOAT_WITHIN(20000, 1000000, window.latest().apparentPowerUva);
+}
+
+void test_full_scale_stays_within_the_integer_sums() {
+    // The longest window, at full scale on both channels, with the longest gap averaged
+    PowerWindow window(2 * POWER_WINDOW_MAX_US);
+    TEST_ASSERT_EQUAL_INT64(POWER_WINDOW_MAX_US, window.getLength());
+    bool completed = false;
+    for (int64_t t = 0; !completed; t += POWER_WINDOW_MAX_GAP_US) {
+        AlignedPair pair = {t, INT32_MAX, INT32_MAX, SAMPLE_QUALITY_FRESH, SAMPLE_QUALITY_FRESH};
+        completed = window.add(pair);
+    }
+    const PowerSummary& summary = window.latest();
+    TEST_ASSERT_EQUAL_INT64(POWER_WINDOW_MAX_US, summary.coveredUs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3 * ADS2_MICROVOLTS_FULL_SCALE, ADS2_MICROVOLTS_FULL_SCALE, summary.voltageRmsUv);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3 * SHUNT_MICROAMPS_FULL_SCALE, SHUNT_MICROAMPS_FULL_SCALE, summary.currentRmsUa);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 1.0, summary.powerFactor);
+}
+
+// A load stepping from 0.1 A to 2 A with a 200 ms slew, on a supply with 0.5 Ohm source
+// resistance, scanned in 10 ms single-shot slots with the voltage channel rotated against
+// two others on its device. The raw pairing multiplies each current with a voltage up to
+// two slots old; the aligned pairs track the true power through the step.
+static double stepCurrent(double t) {
+    if (t < 0.3) return 0.1;
+    if (t < 0.5) return 0.1 + 1.9 * (t - 0.3) / 0.2;
+    return 2.0;
+}
+
+static double stepVoltage(double t) {
+    return 4.0 - 0.5 * stepCurrent(t);
+}
+
+void test_load_steps_do_not_bias_real_power() {
+    const int64_t slotUs = 10000;
+    const int64_t spanUs = 1000000;
+    PairAligner aligner;
+    PowerWindow aligned(spanUs);
+    PowerWindow raw(spanUs);
+    double rawWorstUw = 0;
+    double alignedWorstUw = 0;
+    q31_t heldVoltage = 0;
+    // Slot 0 converts at t = 0; the window closes at the first pair 1 s later
+    for (int slot = 0; slot * slotUs <= spanUs + 3 * slotUs; slot++) {
+        int64_t t = slot * slotUs;
+        // Linear segments: a conversion's mean is the value at its middle
+        AdcSample sample = makeSample(t, amps(stepCurrent(t * 1e-6)), t, volts(stepVoltage(t * 1e-6)));
+        if (slot % 3 == 0) {
+            heldVoltage = sample.ads2;
+        } else {
+            sample.ads2 = heldVoltage;
+            sample.ads2Us = t - (slot % 3) * slotUs;
+            sample.ads2Quality = SAMPLE_QUALITY_HELD;
+        }
+        AlignedPair rawPair = {t, sample.shunt, sample.ads2, SAMPLE_QUALITY_FRESH, SAMPLE_QUALITY_FRESH};
+        if (t <= spanUs) {
+            raw.add(rawPair);
+            double trueUw = stepCurrent(t * 1e-6) * stepVoltage(t * 1e-6) * 1e6;
+            rawWorstUw = fmax(rawWorstUw, fabs(raw.getInstantPowerUw() - trueUw));
+        }
+        aligner.add(sample);
+        AlignedPair pair;
+        while (aligner.read(pair)) {
+            if (pair.timeUs <= spanUs) {
+                aligned.add(pair);
+                double trueUw = stepCurrent(pair.timeUs * 1e-6) * stepVoltage(pair.timeUs * 1e-6) * 1e6;
+                alignedWorstUw = fmax(alignedWorstUw, fabs(aligned.getInstantPowerUw() - trueUw));
+            }
+        }
+    }
+    TEST_ASSERT_TRUE(aligned.hasSummary());
+    TEST_ASSERT_TRUE(raw.hasSummary());
+
+    // Mean of v * i over the second, by the trapezoidal rule at 1 us
+    double trueSum = 0;
+    for (int64_t us = 0; us < spanUs; us++) {
+        trueSum += stepCurrent(us * 1e-6) * stepVoltage(us * 1e-6);
+    }
+    double trueUw = trueSum / spanUs * 1e6;
+    double alignedError = fabs(aligned.latest().realPowerUw - trueUw);
+    double rawError = fabs(raw.latest().realPowerUw - trueUw);
+    printf("load step: real power error %.0f uW raw, %.0f uW aligned; worst instantaneous %.0f uW raw, "
+           "%.0f uW aligned\n", rawError, alignedError, rawWorstUw, alignedWorstUw);
+    TEST_ASSERT_TRUE(rawError > 10 * alignedError);
+    // Interpolation only cuts the corners of the slew; the raw pairs lag along all of it
+    TEST_ASSERT_TRUE(rawWorstUw > 2 * alignedWorstUw);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_voltage_is_interpolated_to_the_current_instant);
+    RUN_TEST(test_rotated_voltage_releases_every_waiting_current);
+    RUN_TEST(test_currents_pass_through_a_voltage_outage);
+    RUN_TEST(test_waiting_currents_are_released_when_the_voltage_is_lost);
+    RUN_TEST(test_unscanned_voltage_passes_currents_through);
+    RUN_TEST(test_window_real_power_and_power_factor);
+    RUN_TEST(test_full_scale_stays_within_the_integer_sums);
+    RUN_TEST(test_load_steps_do_not_bias_real_power);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
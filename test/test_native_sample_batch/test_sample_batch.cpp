@@ -0,0 +1,204 @@
+// Host tests for the batched sample stream: exact round trips, the payload limit, the
+// sequence numbers and how many samples one notification carries
+#include <unity.h>
+#include <stdio.h>
+#include <chrono>
+#include "sample_batch.h"
+#include "sim_noise.h"
+
+// A 1.5 A load with 2 mA of noise on a 3.3 V rail, every 5 ms
+static BatchSample acquired(int index) {
+    BatchSample sample;
+    sample.timeUs = 1000000000LL + index * 5000LL + sim::noise(20);
+    sample.currentUa = 1500000 + sim::noise(2000);
+    sample.voltageUv = 3300000 + sim::noise(500);
+    sample.currentQuality = 0;
+    sample.voltageQuality = 0;
+    return sample;
+}
+
+static bool sameSample(const BatchSample& a, const BatchSample& b) {
+    return a.timeUs == b.timeUs && a.currentUa == b.currentUa && a.voltageUv == b.voltageUv &&
+           a.currentQuality == b.currentQuality && a.voltageQuality == b.voltageQuality;
+}
+
+// Streams the samples through a batcher and checks every decoded batch against them;
+// returns the number of batches, 0 on any mismatch
+static uint32_t roundTrip(const BatchSample* input, int count, size_t payloadLimit) {
+    SampleBatcher batcher(payloadLimit);
+    BatchSample decoded[UINT8_MAX];
+    int checked = 0;
+    uint32_t batches = 0;
+    for (int i = 0; i <= count; i++) {
+        if (i < count && batcher.add(input[i])) {
+            continue;
+        }
+        uint8_t decodedCount = 0;
+        uint16_t sequence = 0;
+        if (batcher.size() > payloadLimit ||
+            !decodeSampleBatch(batcher.data(), batcher.size(), decoded, UINT8_MAX, decodedCount, sequence) ||
+            sequence != batches || decodedCount == 0) {
+            return 0;
+        }
+        for (uint8_t j = 0; j < decodedCount; j++) {
+            if (!sameSample(decoded[j], input[checked++])) {
+                return 0;
+            }
+        }
+        batches++;
+        batcher.clear();
+        if (i < count && !batcher.add(input[i])) {
+            return 0;
+        }
+    }
+    return checked == count ? batches : 0;
+}
+
+void setUp(void) {
+    sim::resetNoise();
+}
+
+void tearDown(void) {
+}
+
+void test_round_trip_is_exact() {
+    static BatchSample input[2000];
+    for (int i = 0; i < 2000; i++) {
+        input[i] = acquired(i);
+        // Flags now and then
+        if (i % 97 == 0) input[i].currentQuality = 0x01;
+        if (i % 131 == 0) input[i].voltageQuality = 0x12;
+    }
+    const size_t limits[] = {SAMPLE_BATCH_MIN_PAYLOAD, 64, 244, SAMPLE_BATCH_MAX_PAYLOAD};
+    for (size_t limit : limits) {
+        TEST_ASSERT_TRUE(roundTrip(input, 2000, limit) > 0);
+    }
+}
+
+void test_extreme_values_and_steps() {
+    BatchSample input[6] = {
+        {0, INT32_MIN, INT32_MAX, 0xFF, 0xFF},
+        {INT64_MAX / 2, INT32_MAX, INT32_MIN, 0, 0},
+        {INT64_MAX / 2, INT32_MIN, INT32_MIN, 0x01, 0},
+        {INT64_MAX / 2 + 1, 0, 0, 0, 0x10},
+        {INT64_MAX / 2 + 2, -1, 1, 0, 0},
+        {INT64_MAX / 2 + 3, 1, -1, 0, 0},
+    };
+    TEST_ASSERT_TRUE(roundTrip(input, 6, SAMPLE_BATCH_MIN_PAYLOAD) > 0);
+    TEST_ASSERT_TRUE(roundTrip(input, 6, SAMPLE_BATCH_MAX_PAYLOAD) == 1);
+}
+
+void test_step_back_in_time_is_sent_as_no_time() {
+    SampleBatcher batcher(SAMPLE_BATCH_MAX_PAYLOAD);
+    BatchSample first = {1000, 5, 6, 0, 0};
+    BatchSample back = {900, 7, 8, 0, 0};
+    BatchSample next = {1100, 9, 10, 0, 0};
+    TEST_ASSERT_TRUE(batcher.add(first));
+    TEST_ASSERT_TRUE(batcher.add(back));
+    TEST_ASSERT_TRUE(batcher.add(next));
+    BatchSample decoded[3];
+    uint8_t count = 0;
+    uint16_t sequence = 0;
+    TEST_ASSERT_TRUE(decodeSampleBatch(batcher.data(), batcher.size(), decoded, 3, count, sequence));
+    TEST_ASSERT_EQUAL_UINT8(3, count);
+    TEST_ASSERT_EQUAL_INT64(1000, decoded[1].timeUs);
+    TEST_ASSERT_EQUAL_INT32(7, decoded[1].currentUa);
+    TEST_ASSERT_EQUAL_INT64(1100, decoded[2].timeUs);
+}
+
+void test_sequence_and_limits() {
+    SampleBatcher batcher(100);
+    TEST_ASSERT_TRUE(batcher.empty());
+    TEST_ASSERT_EQUAL_UINT32(SAMPLE_BATCH_HEADER_SIZE, batcher.size());
+    // Clearing an empty batch does not use up a sequence number
+    batcher.clear();
+    BatchSample first = acquired(0);
+    TEST_ASSERT_TRUE(batcher.add(first));
+    TEST_ASSERT_EQUAL_INT64(first.timeUs, batcher.firstTimeUs());
+    batcher.clear();
+    TEST_ASSERT_TRUE(batcher.add(acquired(1)));
+    TEST_ASSERT_EQUAL_UINT8(1, batcher.data()[2]);
+    TEST_ASSERT_EQUAL_UINT32(1, batcher.getBatches());
+    batcher.reset();
+    TEST_ASSERT_TRUE(batcher.add(acquired(2)));
+    TEST_ASSERT_EQUAL_UINT8(0, batcher.data()[2]);
+
+    // A smaller limit waits for the next batch, a larger one applies at once
+    batcher.setPayloadLimit(10);
+    TEST_ASSERT_EQUAL_UINT32(100, batcher.getPayloadLimit());
+    batcher.clear();
+    TEST_ASSERT_EQUAL_UINT32(SAMPLE_BATCH_MIN_PAYLOAD, batcher.getPayloadLimit());
+    TEST_ASSERT_TRUE(batcher.add(acquired(3)));
+    batcher.setPayloadLimit(1000);
+    TEST_ASSERT_EQUAL_UINT32(SAMPLE_BATCH_MAX_PAYLOAD, batcher.getPayloadLimit());
+}
+
+void test_rejects_malformed_batches() {
+    SampleBatcher batcher(SAMPLE_BATCH_MAX_PAYLOAD);
+    for (int i = 0; i < 10; i++) {
+        batcher.add(acquired(i));
+    }
+    uint8_t payload[SAMPLE_BATCH_MAX_PAYLOAD];
+    size_t length = batcher.size();
+    for (size_t i = 0; i < length; i++) payload[i] = batcher.data()[i];
+    BatchSample decoded[10];
+    uint8_t count = 0;
+    uint16_t sequence = 0;
+    TEST_ASSERT_TRUE(decodeSampleBatch(payload, length, decoded, 10, count, sequence));
+    TEST_ASSERT_FALSE(decodeSampleBatch(payload, length, decoded, 9, count, sequence));
+    TEST_ASSERT_FALSE(decodeSampleBatch(payload, length - 1, decoded, 10, count, sequence));
+    payload[length] = 0;
+    TEST_ASSERT_FALSE(decodeSampleBatch(payload, length + 1, decoded, 10, count, sequence));
+    payload[0] = '{';
+    TEST_ASSERT_FALSE(decodeSampleBatch(payload, length, decoded, 10, count, sequence));
+}
+
+// At the smallest payload a stream runs on and the 244 bytes of the 247-byte MTU most
+// phones negotiate, versus one averaged reading per 100 ms: samples per notification and
+// the cost of packing them
+void test_samples_per_notification() {
+    static BatchSample input[4000];
+    for (int i = 0; i < 4000; i++) {
+        input[i] = acquired(i);
+    }
+    const size_t limits[] = {SAMPLE_BATCH_MIN_PAYLOAD, 244};
+    for (size_t limit : limits) {
+        uint32_t batches = roundTrip(input, 4000, limit);
+        TEST_ASSERT_TRUE(batches > 0);
+        printf("payload %3u bytes: %.1f samples per notification, %.1f notifications/s at 200 samples/s\n",
+               (unsigned)limit, 4000.0 / batches, 200.0 * batches / 4000);
+    }
+    // The full 5 ms rate fits in well under ten notifications a second
+    TEST_ASSERT_TRUE(roundTrip(input, 4000, 244) * 200 / 4000 < 10);
+
+    SampleBatcher batcher(244);
+    uint32_t sent = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 50; round++) {
+        for (int i = 0; i < 4000; i++) {
+            if (!batcher.add(input[i])) {
+                sent += batcher.size();
+                batcher.clear();
+                batcher.add(input[i]);
+            }
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("packing: %.1f ns per sample, %.2f bytes per sample\n", ns / (50 * 4000), (double)sent / batcher.getSamples());
+    TEST_ASSERT_TRUE(sent > 0);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_is_exact);
+    RUN_TEST(test_extreme_values_and_steps);
+    RUN_TEST(test_step_back_in_time_is_sent_as_no_time);
+    RUN_TEST(test_sequence_and_limits);
+    RUN_TEST(test_rejects_malformed_batches);
+    RUN_TEST(test_samples_per_notification);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
@@ -0,0 +1,125 @@
+// Host tests for sample quality flags, their accumulation through decimation and the
+// degraded-time counts
+#include <unity.h>
+#include "sample_quality.h"
+#include "adc_sample.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_flag_predicates() {
+    TEST_ASSERT_TRUE(isSampleFresh(SAMPLE_QUALITY_FRESH));
+    TEST_ASSERT_TRUE(isSampleFresh(SAMPLE_QUALITY_CLIPPED | SAMPLE_QUALITY_GAIN_CHANGED));
+    TEST_ASSERT_FALSE(isSampleFresh(SAMPLE_QUALITY_HELD));
+    TEST_ASSERT_FALSE(isSampleDegraded(SAMPLE_QUALITY_HELD));
+    TEST_ASSERT_FALSE(isSampleDegraded(SAMPLE_QUALITY_GAIN_CHANGED));
+    TEST_ASSERT_TRUE(isSampleDegraded(SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE));
+    TEST_ASSERT_TRUE(isSampleDegraded(SAMPLE_QUALITY_CLIPPED));
+    TEST_ASSERT_EQUAL_HEX16(0x0508, packSampleQuality(SAMPLE_QUALITY_CLIPPED,
+                                                      SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING));
+}
+
+void test_accumulator_holds_only_when_every_input_held() {
+    QualityAccumulator quality;
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD, quality.output());  // Nothing produced yet
+
+    quality.add(SAMPLE_QUALITY_FRESH);
+    quality.add(SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE);
+    quality.add(SAMPLE_QUALITY_FRESH);
+    quality.complete();
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_STALE, quality.output());
+
+    quality.add(SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING);
+    quality.add(SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING);
+    quality.complete();
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING, quality.output());
+
+    quality.add(SAMPLE_QUALITY_GAIN_CHANGED);
+    quality.add(SAMPLE_QUALITY_FRESH);
+    quality.complete();
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_GAIN_CHANGED, quality.output());
+
+    quality.add(SAMPLE_QUALITY_FRESH);
+    quality.complete();
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_FRESH, quality.output());
+}
+
+void test_decimator_output_quality_covers_its_window() {
+    SampleDecimator decimator(10000);
+    decimator.setInputPeriod(1000);  // Ratio 10
+    AdcSample sample{};
+    sample.shuntGain = SHUNT_WIDEST_GAIN;
+    sample.ads2Gain = ADS2_WIDEST_GAIN;
+    int outputs = 0;
+    for (int i = 0; i < 100; i++) {
+        sample.shuntQuality = (i == 45) ? SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE : SAMPLE_QUALITY_FRESH;
+        sample.ads2Quality = SAMPLE_QUALITY_HELD;  // Channel not scanned
+        if (decimator.add(sample)) {
+            outputs++;
+            bool windowHasFailure = i >= 45 && i < 50;
+            TEST_ASSERT_EQUAL_HEX8(windowHasFailure ? SAMPLE_QUALITY_STALE : SAMPLE_QUALITY_FRESH,
+                                   decimator.shuntQuality());
+            TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_HELD, decimator.ads2Quality());
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(10, outputs);
+}
+
+void test_counter_charges_intervals_to_degraded_samples() {
+    SampleQualityCounter counter;
+    int64_t t = 0;
+    for (int i = 0; i < 10; i++, t += 1000) {
+        counter.add(t, SAMPLE_QUALITY_FRESH);
+    }
+    for (int i = 0; i < 5; i++, t += 1000) {
+        counter.add(t, SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE);
+    }
+    for (int i = 0; i < 3; i++, t += 1000) {
+        counter.add(t, SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING);
+    }
+    counter.add(t, SAMPLE_QUALITY_CLIPPED);
+    t += 1000;
+    counter.add(t, SAMPLE_QUALITY_GAIN_CHANGED);
+    t += 1000;
+    counter.add(t, SAMPLE_QUALITY_HELD);  // Scan rotation: held but not degraded
+
+    const QualityCounts& counts = counter.getCounts();
+    TEST_ASSERT_EQUAL_UINT32(21, counts.samples);
+    TEST_ASSERT_EQUAL_UINT32(12, counts.fresh);
+    TEST_ASSERT_EQUAL_UINT32(5, counts.stale);
+    TEST_ASSERT_EQUAL_UINT32(3, counts.recovering);
+    TEST_ASSERT_EQUAL_UINT32(1, counts.clipped);
+    TEST_ASSERT_EQUAL_UINT32(1, counts.gainChanges);
+    TEST_ASSERT_EQUAL_INT64(20000, counts.totalUs);
+    TEST_ASSERT_EQUAL_INT64(9000, counts.degradedUs);
+}
+
+void test_counter_skips_pauses() {
+    SampleQualityCounter counter;
+    counter.add(0, SAMPLE_QUALITY_FRESH);
+    counter.add(SAMPLE_QUALITY_MAX_INTERVAL_US + 1, SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE);
+    counter.add(SAMPLE_QUALITY_MAX_INTERVAL_US + 1001, SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE);
+    TEST_ASSERT_EQUAL_INT64(1000, counter.getCounts().totalUs);
+    TEST_ASSERT_EQUAL_INT64(1000, counter.getCounts().degradedUs);
+
+    counter.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, counter.getCounts().samples);
+    TEST_ASSERT_EQUAL_INT64(0, counter.getCounts().totalUs);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_flag_predicates);
+    RUN_TEST(test_accumulator_holds_only_when_every_input_held);
+    RUN_TEST(test_decimator_output_quality_covers_its_window);
+    RUN_TEST(test_counter_charges_intervals_to_degraded_samples);
+    RUN_TEST(test_counter_skips_pauses);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
@@ -0,0 +1,124 @@
+// Host tests for the device/channel table scan scheduler
+#include <unity.h>
+#include "adc_devices.h"
+
+// Four chips: a shunt, a voltage input, a chip with three inputs on two mux settings,
+// and a chip with one input read at two gains
+static const AdcChannelConfig TABLE[] = {
+    {"shunt", 0, ADS1115_MUX_DIFF_0_1, GAIN_EIGHT, ADS1115_RATE_860SPS},
+    {"bus", 1, ADS1115_MUX_SINGLE_0, GAIN_ONE, ADS1115_RATE_860SPS},
+    {"aux_a0", 2, ADS1115_MUX_SINGLE_0, GAIN_ONE, ADS1115_RATE_860SPS},
+    {"aux_a1", 2, ADS1115_MUX_SINGLE_1, GAIN_ONE, ADS1115_RATE_860SPS},
+    {"aux_a0_fine", 2, ADS1115_MUX_SINGLE_0, GAIN_EIGHT, ADS1115_RATE_860SPS},
+    {"temp_lo", 3, ADS1115_MUX_DIFF_2_3, GAIN_SIXTEEN, ADS1115_RATE_128SPS},
+    {"temp_hi", 3, ADS1115_MUX_DIFF_2_3, GAIN_FOUR, ADS1115_RATE_128SPS},
+};
+static const uint8_t TABLE_SIZE = sizeof(TABLE) / sizeof(TABLE[0]);
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_two_single_channel_devices_convert_every_slot() {
+    ScanScheduler scheduler;
+    const uint8_t list[] = {0, 1};
+    TEST_ASSERT_TRUE(scheduler.configure(TABLE, TABLE_SIZE, list, 2));
+    TEST_ASSERT_EQUAL_HEX8(0x03, scheduler.getDeviceMask());
+    TEST_ASSERT_EQUAL_UINT8(0, scheduler.getMuxSwitchesPerCycle());
+    for (int i = 0; i < 5; i++) {
+        const ScanSlot& slot = scheduler.next();
+        TEST_ASSERT_EQUAL_INT8(0, slot.channel[0]);
+        TEST_ASSERT_EQUAL_INT8(1, slot.channel[1]);
+        TEST_ASSERT_EQUAL_INT8(-1, slot.channel[2]);
+        TEST_ASSERT_EQUAL_INT8(-1, slot.channel[3]);
+    }
+}
+
+void test_shared_device_rotates_grouped_by_mux() {
+    ScanScheduler scheduler;
+    // Listed with the mux settings interleaved; the rotation keeps equal muxes together
+    const uint8_t list[] = {2, 3, 4, 0};
+    TEST_ASSERT_TRUE(scheduler.configure(TABLE, TABLE_SIZE, list, 4));
+    TEST_ASSERT_EQUAL_UINT8(3, scheduler.getRotationLength(2));
+    TEST_ASSERT_EQUAL_UINT8(3, scheduler.getRotationLengthOf(4));
+    TEST_ASSERT_EQUAL_UINT8(1, scheduler.getRotationLengthOf(0));
+
+    const int8_t expected[] = {2, 4, 3, 2, 4, 3};
+    for (int i = 0; i < 6; i++) {
+        const ScanSlot& slot = scheduler.next();
+        TEST_ASSERT_EQUAL_INT8(0, slot.channel[0]);
+        TEST_ASSERT_EQUAL_INT8(expected[i], slot.channel[2]);
+    }
+    // SINGLE_0 -> SINGLE_1 -> back: two switches instead of three
+    TEST_ASSERT_EQUAL_UINT8(2, scheduler.getMuxSwitchesPerCycle());
+}
+
+void test_same_mux_channels_never_switch() {
+    ScanScheduler scheduler;
+    const uint8_t list[] = {0, 5, 6};
+    TEST_ASSERT_TRUE(scheduler.configure(TABLE, TABLE_SIZE, list, 3));
+    TEST_ASSERT_EQUAL_UINT8(2, scheduler.getRotationLength(3));
+    TEST_ASSERT_EQUAL_UINT8(0, scheduler.getMuxSwitchesPerCycle());
+    TEST_ASSERT_EQUAL_INT8(5, scheduler.next().channel[3]);
+    TEST_ASSERT_EQUAL_INT8(6, scheduler.next().channel[3]);
+    TEST_ASSERT_EQUAL_INT8(5, scheduler.next().channel[3]);
+}
+
+void test_all_four_devices() {
+    ScanScheduler scheduler;
+    const uint8_t list[] = {0, 1, 2, 3, 5};
+    TEST_ASSERT_TRUE(scheduler.configure(TABLE, TABLE_SIZE, list, 5));
+    TEST_ASSERT_EQUAL_HEX8(0x0F, scheduler.getDeviceMask());
+    const ScanSlot& slot = scheduler.next();
+    TEST_ASSERT_EQUAL_INT8(0, slot.channel[0]);
+    TEST_ASSERT_EQUAL_INT8(1, slot.channel[1]);
+    TEST_ASSERT_EQUAL_INT8(2, slot.channel[2]);
+    TEST_ASSERT_EQUAL_INT8(5, slot.channel[3]);
+    TEST_ASSERT_EQUAL_INT8(3, scheduler.next().channel[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x0F, adcTableDeviceMask(TABLE, TABLE_SIZE));
+    TEST_ASSERT_EQUAL_HEX8(0x4B, adcDeviceAddress(3));
+}
+
+void test_invalid_lists_keep_previous_schedule() {
+    ScanScheduler scheduler;
+    const uint8_t good[] = {0, 1};
+    TEST_ASSERT_TRUE(scheduler.configure(TABLE, TABLE_SIZE, good, 2));
+
+    const uint8_t unknown[] = {0, TABLE_SIZE};
+    const uint8_t repeated[] = {0, 1, 0};
+    TEST_ASSERT_FALSE(scheduler.configure(TABLE, TABLE_SIZE, unknown, 2));
+    TEST_ASSERT_FALSE(scheduler.configure(TABLE, TABLE_SIZE, repeated, 3));
+    TEST_ASSERT_FALSE(scheduler.configure(TABLE, TABLE_SIZE, good, 0));
+
+    TEST_ASSERT_EQUAL_UINT8(2, scheduler.getScanLength());
+    TEST_ASSERT_TRUE(scheduler.contains(1));
+    TEST_ASSERT_FALSE(scheduler.contains(2));
+    TEST_ASSERT_EQUAL_INT8(1, scheduler.next().channel[1]);
+}
+
+void test_restart_rewinds_rotations() {
+    ScanScheduler scheduler;
+    const uint8_t list[] = {2, 3};
+    TEST_ASSERT_TRUE(scheduler.configure(TABLE, TABLE_SIZE, list, 2));
+    TEST_ASSERT_EQUAL_INT8(2, scheduler.next().channel[2]);
+    scheduler.restart();
+    TEST_ASSERT_EQUAL_INT8(2, scheduler.next().channel[2]);
+    TEST_ASSERT_EQUAL_INT8(3, scheduler.next().channel[2]);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_two_single_channel_devices_convert_every_slot);
+    RUN_TEST(test_shared_device_rotates_grouped_by_mux);
+    RUN_TEST(test_same_mux_channels_never_switch);
+    RUN_TEST(test_all_four_devices);
+    RUN_TEST(test_invalid_lists_keep_previous_schedule);
+    RUN_TEST(test_restart_rewinds_rotations);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
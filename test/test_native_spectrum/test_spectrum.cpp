@@ -0,0 +1,188 @@
+// Host tests for the real FFT against a direct DFT, the spectrum analyser's band levels,
+// peaks and frame handling, and a benchmark of the transform kernel
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include "real_fft.h"
+#include "spectrum_analyzer.h"
+#include "sample_quality.h"
+
+static const double TWO_PI = 6.283185307179586;
+
+// 860 SPS continuous conversion period, rounded as the driver reports it
+static const uint32_t PERIOD_US = 1163;
+
+static const SpectrumBand BANDS[] = {
+    {"low", 0, 45},
+    {"mains", 45, 65},
+    {"high", 65, 1000},
+};
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static q31_t toQ31(double value) {
+    return static_cast<q31_t>(lround(value * 2147483647.0));
+}
+
+// Feed whole frames of offset + sum of sines (amplitudes as fractions of full scale)
+static void feed(SpectrumAnalyzer& analyzer, int frames, double offset, const double* hz, const double* amplitude,
+                 int tones) {
+    for (int n = 0; n < frames * SPECTRUM_FFT_SIZE; n++) {
+        double t = n * PERIOD_US * 1e-6;
+        double value = offset;
+        for (int i = 0; i < tones; i++) {
+            value += amplitude[i] * sin(TWO_PI * hz[i] * t + i);
+        }
+        analyzer.add(static_cast<int64_t>(n) * PERIOD_US, toQ31(value), SAMPLE_QUALITY_FRESH);
+    }
+}
+
+void test_real_fft_matches_dft() {
+    const int size = 64;
+    RealFft<size> fft;
+    fft.setKernel(FFT_KERNEL_SCALAR);
+    float frame[size];
+    double input[size];
+    for (int n = 0; n < size; n++) {
+        input[n] = 0.3 * sin(TWO_PI * 5 * n / size) - 0.2 * cos(TWO_PI * 11.3 * n / size) + 0.1 * ((n * 7) % 5) - 0.05;
+        frame[n] = static_cast<float>(input[n]);
+    }
+    fft.transform(frame);
+    for (int k = 0; k <= size / 2; k++) {
+        double re = 0, im = 0;
+        for (int n = 0; n < size; n++) {
+            re += input[n] * cos(TWO_PI * k * n / size);
+            im -= input[n] * sin(TWO_PI * k * n / size);
+        }
+        if (k == 0) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f, re, frame[0]);
+        } else if (k == size / 2) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f, re, frame[1]);
+        } else {
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f, re, frame[2 * k]);
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f, im, frame[2 * k + 1]);
+        }
+    }
+}
+
+void test_window_tables_are_exact() {
+    const dsp::FftTables<16>& tables = RealFft<16>::TABLES;
+    TEST_ASSERT_FLOAT_WITHIN(1e-7f, 0.0f, tables.window[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-7f, 1.0f, tables.window[8]);
+    // Periodic Hann: sum of squares is 3N/8
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 6.0f, tables.windowPower);
+    TEST_ASSERT_FLOAT_WITHIN(1e-7f, 0.0f, tables.twiddles[2 * 4]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-7f, -1.0f, tables.twiddles[2 * 4 + 1]);
+}
+
+void test_tone_peak_and_band_levels() {
+    SpectrumAnalyzer analyzer(BANDS, 3);
+    analyzer.setSamplePeriod(PERIOD_US);
+    const double hz[] = {50.0, 150.0};
+    const double amplitude[] = {0.2, 0.05};
+    feed(analyzer, 1, 0.1, hz, amplitude, 2);
+
+    const SpectrumResult& r = analyzer.result();
+    TEST_ASSERT_EQUAL_UINT32(1, r.frames);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1e6f / PERIOD_US / SPECTRUM_FFT_SIZE, r.binHz);
+    // The frame is not a whole number of cycles, so a little of the tones is in the mean
+    TEST_ASSERT_FLOAT_WITHIN(2e-3f, 0.1f, r.mean);
+    // Sine RMS is amplitude / sqrt(2); Hann leakage stays within a few percent
+    double expectedAc = sqrt(0.2 * 0.2 / 2 + 0.05 * 0.05 / 2);
+    TEST_ASSERT_FLOAT_WITHIN(0.003f, expectedAc, r.acRms);
+    TEST_ASSERT_FLOAT_WITHIN(0.003f, 0.2 / sqrt(2.0), r.bandRms[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.003f, 0.05 / sqrt(2.0), r.bandRms[2]);
+    TEST_ASSERT_TRUE(r.bandRms[0] < 0.002f);
+
+    TEST_ASSERT_TRUE(r.peakCount >= 2);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 50.0f, r.peaks[0].frequencyHz);
+    TEST_ASSERT_FLOAT_WITHIN(0.003f, 0.2 / sqrt(2.0), r.peaks[0].rms);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 150.0f, r.peaks[1].frequencyHz);
+    TEST_ASSERT_FLOAT_WITHIN(0.002f, 0.05 / sqrt(2.0), r.peaks[1].rms);
+}
+
+void test_peaks_are_sorted_and_capped() {
+    SpectrumAnalyzer analyzer(BANDS, 3);
+    analyzer.setSamplePeriod(PERIOD_US);
+    const double hz[] = {20, 60, 100, 140, 180, 220, 260};
+    const double amplitude[] = {0.01, 0.07, 0.02, 0.06, 0.03, 0.05, 0.04};
+    feed(analyzer, 1, 0, hz, amplitude, 7);
+
+    const SpectrumResult& r = analyzer.result();
+    TEST_ASSERT_EQUAL_UINT8(SPECTRUM_PEAK_COUNT, r.peakCount);
+    const float expected[] = {60, 140, 220, 260, 180};
+    for (int i = 0; i < SPECTRUM_PEAK_COUNT; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.2f, expected[i], r.peaks[i].frequencyHz);
+    }
+}
+
+void test_frame_restarts_on_gaps_and_degraded_samples() {
+    SpectrumAnalyzer analyzer(BANDS, 3);
+    analyzer.setSamplePeriod(PERIOD_US);
+    int64_t t = 0;
+    for (int n = 0; n < 100; n++, t += PERIOD_US) {
+        analyzer.add(t, 0, SAMPLE_QUALITY_FRESH);
+    }
+    // Held samples between scan slots are skipped without breaking the frame
+    analyzer.add(t, 0, SAMPLE_QUALITY_HELD);
+    TEST_ASSERT_EQUAL_UINT16(100, analyzer.getFill());
+
+    // A missing conversion
+    t += PERIOD_US;
+    analyzer.add(t, 0, SAMPLE_QUALITY_FRESH);
+    TEST_ASSERT_EQUAL_UINT16(1, analyzer.getFill());
+    TEST_ASSERT_EQUAL_UINT32(1, analyzer.result().restarts);
+
+    t += PERIOD_US;
+    analyzer.add(t, 0, SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_STALE);
+    TEST_ASSERT_EQUAL_UINT16(0, analyzer.getFill());
+    TEST_ASSERT_EQUAL_UINT32(2, analyzer.result().restarts);
+
+    analyzer.add(t, 0, SAMPLE_QUALITY_FRESH);
+    analyzer.setSamplePeriod(PERIOD_US * 2);
+    TEST_ASSERT_EQUAL_UINT16(0, analyzer.getFill());
+    TEST_ASSERT_EQUAL_UINT32(3, analyzer.result().restarts);
+    TEST_ASSERT_EQUAL_UINT32(0, analyzer.result().frames);
+}
+
+void test_benchmark_transform() {
+    static const int FRAMES = 2000;
+    SpectrumAnalyzer analyzer(BANDS, 3);
+    RealFft<SPECTRUM_FFT_SIZE>& fft = analyzer.getFft();
+    TEST_ASSERT_EQUAL_INT(FFT_KERNEL_SCALAR, fft.getKernel());
+    static float frame[SPECTRUM_FFT_SIZE];
+    float checksum = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; i++) {
+        for (int n = 0; n < SPECTRUM_FFT_SIZE; n++) {
+            frame[n] = static_cast<float>((n * 37 + i) % 101) * 0.01f;
+        }
+        RealFft<SPECTRUM_FFT_SIZE>::applyWindow(frame);
+        fft.transform(frame);
+        checksum += frame[2];
+    }
+    double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+    printf("scalar %d-point real FFT with window: %.1f us per frame (checksum %.1f)\n", SPECTRUM_FFT_SIZE,
+           elapsedNs / FRAMES / 1000, checksum);
+    TEST_ASSERT_TRUE(elapsedNs > 0);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_real_fft_matches_dft);
+    RUN_TEST(test_window_tables_are_exact);
+    RUN_TEST(test_tone_peak_and_band_levels);
+    RUN_TEST(test_peaks_are_sorted_and_capped);
+    RUN_TEST(test_frame_restarts_on_gaps_and_degraded_samples);
+    RUN_TEST(test_benchmark_transform);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
@@ -0,0 +1,208 @@
+// Host tests for the telemetry frame: the fixed binary layout, round trips, versioning,
+// the JSON compatibility encoding and the cost of each
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "telemetry_frame.h"
+
+static TelemetryFrame sampleFrame() {
+    TelemetryFrame frame;
+    frame.sequence = 0x1234;
+    frame.timestampMs = 0x89ABCDEF;
+    frame.currentUa = -1500000;
+    frame.voltageUv = 3300123;
+    frame.powerUw = -4950184;
+    frame.currentQuality = 0x01;
+    frame.voltageQuality = 0x10;
+    frame.relays = 0x05;
+    frame.flags = TELEMETRY_FLAG_VOLTAGE_AVAILABLE;
+    frame.shuntCounts = -3 * Q31_ONE_COUNT / 2;
+    frame.ads2Counts = 26400 * Q31_ONE_COUNT;
+    frame.chargeUah = -125500;
+    frame.energyUwh = 412250;
+    frame.statsWindow = 100;
+    frame.currentStats = {-1600000, -1400000, 1600000, 1501000, 40000};
+    frame.voltageStats = {3290000, 3310000, 3310000, 3300100, 5000};
+    return frame;
+}
+
+// Every field at the end of its range, for the longest JSON
+static TelemetryFrame widestFrame() {
+    TelemetryFrame frame;
+    frame.sequence = UINT16_MAX;
+    frame.timestampMs = UINT32_MAX;
+    frame.currentUa = INT32_MIN;
+    frame.voltageUv = INT32_MIN;
+    frame.powerUw = INT32_MIN;
+    frame.currentQuality = UINT8_MAX;
+    frame.voltageQuality = UINT8_MAX;
+    frame.relays = 0x0F;
+    frame.flags = TELEMETRY_FLAG_VOLTAGE_AVAILABLE;
+    frame.shuntCounts = INT32_MIN;
+    frame.ads2Counts = INT32_MIN;
+    frame.chargeUah = INT32_MIN;
+    frame.energyUwh = INT32_MIN;
+    frame.statsWindow = UINT32_MAX;
+    frame.currentStats = {INT32_MIN, INT32_MIN, INT32_MIN, INT32_MIN, INT32_MIN};
+    frame.voltageStats = frame.currentStats;
+    return frame;
+}
+
+static bool sameFrame(const TelemetryFrame& a, const TelemetryFrame& b) {
+    return a.sequence == b.sequence && a.timestampMs == b.timestampMs && a.currentUa == b.currentUa &&
+           a.voltageUv == b.voltageUv && a.powerUw == b.powerUw && a.currentQuality == b.currentQuality &&
+           a.voltageQuality == b.voltageQuality && a.relays == b.relays && a.flags == b.flags &&
+           a.shuntCounts == b.shuntCounts && a.ads2Counts == b.ads2Counts && a.chargeUah == b.chargeUah &&
+           a.energyUwh == b.energyUwh && a.statsWindow == b.statsWindow &&
+           memcmp(&a.currentStats, &b.currentStats, sizeof(TelemetryStats)) == 0 &&
+           memcmp(&a.voltageStats, &b.voltageStats, sizeof(TelemetryStats)) == 0;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_layout_is_fixed_little_endian() {
+    uint8_t packet[TELEMETRY_FRAME_SIZE + 8];
+    memset(packet, 0xEE, sizeof(packet));
+    TEST_ASSERT_EQUAL_UINT32(TELEMETRY_FRAME_SIZE, encodeTelemetryFrame(sampleFrame(), packet, sizeof(packet)));
+    TEST_ASSERT_EQUAL_HEX8(TELEMETRY_FRAME_MAGIC, packet[0]);
+    TEST_ASSERT_EQUAL_HEX8(TELEMETRY_FRAME_VERSION, packet[1]);
+    const uint8_t sequence[] = {0x34, 0x12};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(sequence, packet + 2, 2);
+    const uint8_t timestamp[] = {0xEF, 0xCD, 0xAB, 0x89};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(timestamp, packet + 4, 4);
+    // -1500000 = 0xFFE91CA0
+    const uint8_t current[] = {0xA0, 0x1C, 0xE9, 0xFF};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(current, packet + 8, 4);
+    const uint8_t bytes[] = {0x01, 0x10, 0x05, TELEMETRY_FLAG_VOLTAGE_AVAILABLE};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(bytes, packet + 20, 4);
+    const uint8_t window[] = {100, 0, 0, 0};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(window, packet + 40, 4);
+    // 5000 = 0x1388, the last field
+    const uint8_t voltageStd[] = {0x88, 0x13, 0x00, 0x00};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(voltageStd, packet + TELEMETRY_FRAME_SIZE - 4, 4);
+    TEST_ASSERT_EQUAL_HEX8(0xEE, packet[TELEMETRY_FRAME_SIZE]);
+}
+
+void test_round_trip() {
+    const TelemetryFrame frames[] = {sampleFrame(), widestFrame()};
+    for (const TelemetryFrame& frame : frames) {
+        uint8_t packet[TELEMETRY_FRAME_SIZE];
+        TEST_ASSERT_EQUAL_UINT32(TELEMETRY_FRAME_SIZE, encodeTelemetryFrame(frame, packet, sizeof(packet)));
+        TelemetryFrame decoded;
+        TEST_ASSERT_TRUE(decodeTelemetryFrame(packet, sizeof(packet), decoded));
+        TEST_ASSERT_TRUE(sameFrame(frame, decoded));
+    }
+}
+
+void test_rejects_short_foreign_and_unknown_frames() {
+    uint8_t packet[TELEMETRY_FRAME_SIZE];
+    TelemetryFrame decoded;
+    TEST_ASSERT_EQUAL_UINT32(0, encodeTelemetryFrame(sampleFrame(), packet, sizeof(packet) - 1));
+    encodeTelemetryFrame(sampleFrame(), packet, sizeof(packet));
+    TEST_ASSERT_FALSE(decodeTelemetryFrame(packet, sizeof(packet) - 1, decoded));
+
+    // A JSON notification on the same characteristic
+    char json[TELEMETRY_JSON_CAPACITY];
+    size_t length = formatTelemetryJson(sampleFrame(), "1.3.0", json, sizeof(json));
+    TEST_ASSERT_FALSE(decodeTelemetryFrame(reinterpret_cast<const uint8_t*>(json), length, decoded));
+
+    packet[1] = TELEMETRY_FRAME_VERSION + 1;
+    TEST_ASSERT_FALSE(decodeTelemetryFrame(packet, sizeof(packet), decoded));
+}
+
+void test_json_keeps_the_original_keys() {
+    char json[TELEMETRY_JSON_CAPACITY];
+    size_t length = formatTelemetryJson(sampleFrame(), "1.3.0", json, sizeof(json));
+    TEST_ASSERT_EQUAL_UINT32(strlen(json), length);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"protocol_version\":\"1.3.0\",\"timestamp\":2309737967,"
+        "\"measurements\":{\"shunt_diff\":-1.5,\"ads2_a0\":26400,\"current_ua\":-1500000,"
+        "\"voltage_uv\":3300123,\"power_uw\":-4950184},"
+        "\"relays\":{\"relay1\":1,\"relay2\":0,\"relay3\":1,\"relay4\":0}}",
+        json);
+
+    // Every field at the end of its range still fits one notification
+    char wide[TELEMETRY_JSON_CAPACITY + 1];
+    size_t widest = formatTelemetryJson(widestFrame(), "1.3.0", wide, sizeof(wide));
+    TEST_ASSERT_GREATER_THAN_UINT32(0, widest);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(TELEMETRY_JSON_CAPACITY, widest);
+    printf("JSON frame: %u bytes typical, %u widest; binary frame: %u bytes\n", (unsigned)length,
+           (unsigned)widest, (unsigned)TELEMETRY_FRAME_SIZE);
+}
+
+void test_json_fits_one_notification_with_realistic_values() {
+    // 1.23 A at 3.3 V after days of uptime, 1.2 Ah integrated, every relay on
+    TelemetryFrame frame = sampleFrame();
+    frame.timestampMs = 1234567890;
+    frame.currentUa = 1230456;
+    frame.voltageUv = 3300789;
+    frame.powerUw = 4061476;
+    frame.shuntCounts = 1537 * Q31_ONE_COUNT + Q31_ONE_COUNT / 8;
+    frame.ads2Counts = 26406 * Q31_ONE_COUNT + Q31_ONE_COUNT / 8;
+    frame.chargeUah = 1200000;
+    frame.energyUwh = 3960000;
+    frame.relays = 0x0F;
+    char json[TELEMETRY_JSON_CAPACITY + 1];
+    size_t length = formatTelemetryJson(frame, "1.5.0", json, sizeof(json));
+    TEST_ASSERT_GREATER_THAN_UINT32(0, length);
+    // The notification payload of the 256-byte MTU setupBLE() requests
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(253, length);
+
+    // A smaller negotiated MTU gets no frame rather than a truncated one
+    TEST_ASSERT_EQUAL_UINT32(0, formatTelemetryJson(frame, "1.5.0", json, length));
+}
+
+void test_benchmark_encode_decode() {
+    const int iterations = 200000;
+    TelemetryFrame frame = sampleFrame();
+    uint8_t packet[TELEMETRY_FRAME_SIZE];
+    char json[TELEMETRY_JSON_CAPACITY];
+    uint32_t check = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        frame.sequence = static_cast<uint16_t>(i);
+        check += encodeTelemetryFrame(frame, packet, sizeof(packet));
+        check += packet[2];
+    }
+    auto encoded = std::chrono::steady_clock::now();
+    TelemetryFrame decoded;
+    for (int i = 0; i < iterations; i++) {
+        packet[2] = static_cast<uint8_t>(i);
+        check += decodeTelemetryFrame(packet, sizeof(packet), decoded) ? decoded.sequence : 0;
+    }
+    auto decodedEnd = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations / 10; i++) {
+        frame.sequence = static_cast<uint16_t>(i);
+        check += formatTelemetryJson(frame, "1.3.0", json, sizeof(json));
+    }
+    auto formatted = std::chrono::steady_clock::now();
+
+    double encodeNs = std::chrono::duration<double, std::nano>(encoded - start).count() / iterations;
+    double decodeNs = std::chrono::duration<double, std::nano>(decodedEnd - encoded).count() / iterations;
+    double jsonNs = std::chrono::duration<double, std::nano>(formatted - decodedEnd).count() / (iterations / 10);
+    printf("binary encode %.1f ns, decode %.1f ns per frame; JSON format %.1f ns per frame (check %u)\n",
+           encodeNs, decodeNs, jsonNs, check);
+    TEST_ASSERT_TRUE(check != 0);
+    TEST_ASSERT_TRUE(encodeNs < jsonNs);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_layout_is_fixed_little_endian);
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_rejects_short_foreign_and_unknown_frames);
+    RUN_TEST(test_json_keeps_the_original_keys);
+    RUN_TEST(test_json_fits_one_notification_with_realistic_values);
+    RUN_TEST(test_benchmark_encode_decode);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
@@ -0,0 +1,212 @@
+// Host tests for the swinging-door trend compressor: the reconstruction error bound,
+// exact timestamps, breaks in the trend, the point interval limits and a throughput
+// benchmark
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "swinging_door.h"
+#include "sim_noise.h"
+
+// 860 SPS conversion period
+static const int64_t PERIOD_US = 1163;
+
+struct Input {
+    int64_t timeUs;
+    q31_t value;
+};
+
+static void drain(SwingingDoor& door, std::vector<TrendPoint>& points) {
+    TrendPoint point;
+    while (door.read(point)) {
+        points.push_back(point);
+    }
+}
+
+// Largest distance of an input from the straight lines between the points around it;
+// INT64_MAX when an input is not covered by a joined segment
+static int64_t worstError(const std::vector<Input>& inputs, const std::vector<TrendPoint>& points) {
+    int64_t worst = 0;
+    size_t segment = 0;
+    for (const Input& input : inputs) {
+        while (segment + 1 < points.size() && points[segment + 1].timeUs < input.timeUs) {
+            segment++;
+        }
+        const TrendPoint& from = points[segment];
+        double reconstructed = from.value;
+        if (input.timeUs != from.timeUs) {
+            if (segment + 1 == points.size() || points[segment + 1].start) {
+                return INT64_MAX;
+            }
+            const TrendPoint& to = points[segment + 1];
+            reconstructed += static_cast<double>(to.value - from.value) * (input.timeUs - from.timeUs) /
+                             (to.timeUs - from.timeUs);
+        }
+        int64_t error = llround(fabs(reconstructed - input.value));
+        worst = error > worst ? error : worst;
+    }
+    return worst;
+}
+
+void setUp(void) {
+    sim::resetNoise();
+}
+
+void tearDown(void) {
+}
+
+void test_reconstruction_stays_within_the_deviation() {
+    const q31_t deviation = 40000;
+    SwingingDoor door(1, deviation);
+    std::vector<Input> inputs;
+    std::vector<TrendPoint> points;
+    // Ramps, a sine, steps and noise larger than the deviation
+    for (int n = 0; n < 20000; n++) {
+        int64_t t = n * PERIOD_US;
+        double wave = 3e6 * sin(n * 0.01) + (n % 5000 < 2500 ? 5e6 : -5e6) + n * 200.0;
+        Input input = {t, static_cast<q31_t>(wave) + sim::noise(60000)};
+        inputs.push_back(input);
+        door.add(input.timeUs, input.value, SAMPLE_QUALITY_FRESH);
+        drain(door, points);
+    }
+    door.flush();
+    drain(door, points);
+
+    TEST_ASSERT_TRUE(points.front().start);
+    TEST_ASSERT_EQUAL_INT64(inputs.front().timeUs, points.front().timeUs);
+    TEST_ASSERT_EQUAL_INT64(inputs.back().timeUs, points.back().timeUs);
+    TEST_ASSERT_EQUAL_UINT32(points.size(), door.getArchived());
+    TEST_ASSERT_EQUAL_UINT32(inputs.size(), door.getInputs());
+    // Rounding the point onto the line costs at most half a count
+    TEST_ASSERT_TRUE(worstError(inputs, points) <= deviation + 1);
+    for (const TrendPoint& point : points) {
+        // Points sit on conversion instants
+        TEST_ASSERT_EQUAL_INT64(0, point.timeUs % PERIOD_US);
+        TEST_ASSERT_EQUAL_UINT8(1, point.channel);
+    }
+    TEST_ASSERT_TRUE(points.size() < inputs.size() / 2);
+}
+
+void test_steady_signal_compresses_by_orders_of_magnitude() {
+    const q31_t deviation = 50000;
+    SwingingDoor door(0, deviation);
+    std::vector<Input> inputs;
+    std::vector<TrendPoint> points;
+    // 60 s at 860 SPS of a level with noise well inside the deviation
+    for (int n = 0; n < 51600; n++) {
+        Input input = {n * PERIOD_US, 100000000 + sim::noise(20000)};
+        inputs.push_back(input);
+        door.add(input.timeUs, input.value, SAMPLE_QUALITY_FRESH);
+        drain(door, points);
+    }
+    door.flush();
+    drain(door, points);
+    printf("steady signal: %u conversions in %u points\n", door.getInputs(), door.getArchived());
+    TEST_ASSERT_TRUE(worstError(inputs, points) <= deviation + 1);
+    // Only the interval limit archives: one point per 5 s
+    TEST_ASSERT_TRUE(points.size() <= 60000000 / SWINGING_DOOR_DEFAULT_MAX_INTERVAL_US + 2);
+    for (size_t i = 1; i < points.size(); i++) {
+        TEST_ASSERT_TRUE(points[i].timeUs - points[i - 1].timeUs <= SWINGING_DOOR_DEFAULT_MAX_INTERVAL_US);
+    }
+}
+
+void test_zero_deviation_keeps_every_corner() {
+    SwingingDoor door;
+    std::vector<TrendPoint> points;
+    // Triangle: up for 10 conversions, down for 10; the turning points must survive exactly
+    for (int n = 0; n <= 40; n++) {
+        int phase = n % 20;
+        q31_t value = (phase <= 10 ? phase : 20 - phase) * 1000;
+        door.add(n * 1000, value, SAMPLE_QUALITY_FRESH);
+        drain(door, points);
+    }
+    door.flush();
+    drain(door, points);
+    TEST_ASSERT_EQUAL_UINT32(5, points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        TEST_ASSERT_EQUAL_INT64(i * 10000, points[i].timeUs);
+        TEST_ASSERT_EQUAL_INT32(i % 2 ? 10000 : 0, points[i].value);
+    }
+}
+
+void test_breaks_and_quality_flags() {
+    SwingingDoor door(0, 1000);
+    std::vector<TrendPoint> points;
+    door.add(0, 0, SAMPLE_QUALITY_FRESH);
+    door.add(1000, 0, SAMPLE_QUALITY_CLIPPED);
+    // Repeats are not conversions
+    door.add(2000, 500000, SAMPLE_QUALITY_HELD);
+    door.add(3000, 0, SAMPLE_QUALITY_FRESH);
+    TEST_ASSERT_EQUAL_UINT32(3, door.getInputs());
+    // The outage ends the trend at the last good conversion
+    door.add(4000, 0, SAMPLE_QUALITY_HELD | SAMPLE_QUALITY_RECOVERING);
+    door.add(9000, 7000, SAMPLE_QUALITY_GAIN_CHANGED);
+    drain(door, points);
+
+    TEST_ASSERT_EQUAL_UINT32(3, points.size());
+    TEST_ASSERT_TRUE(points[0].start);
+    TEST_ASSERT_EQUAL_INT64(3000, points[1].timeUs);
+    TEST_ASSERT_FALSE(points[1].start);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_CLIPPED, points[1].quality);
+    TEST_ASSERT_EQUAL_INT64(9000, points[2].timeUs);
+    TEST_ASSERT_EQUAL_INT32(7000, points[2].value);
+    TEST_ASSERT_TRUE(points[2].start);
+    TEST_ASSERT_EQUAL_HEX8(SAMPLE_QUALITY_GAIN_CHANGED, points[2].quality);
+}
+
+void test_slow_sampling_and_paused_acquisition() {
+    SwingingDoor door(0, 1000, 2000000);
+    std::vector<TrendPoint> points;
+    // Sampled every 3 s against a 2 s interval: every conversion is a joined point
+    for (int n = 0; n < 4; n++) {
+        door.add(n * 3000000LL, 0, SAMPLE_QUALITY_FRESH);
+    }
+    drain(door, points);
+    TEST_ASSERT_EQUAL_UINT32(4, points.size());
+    TEST_ASSERT_FALSE(points[3].start);
+
+    // A pause beyond the limit is not bridged
+    door.add(9000000LL + SWINGING_DOOR_MAX_INTERVAL_LIMIT_US + 1, 0, SAMPLE_QUALITY_FRESH);
+    drain(door, points);
+    TEST_ASSERT_EQUAL_UINT32(5, points.size());
+    TEST_ASSERT_TRUE(points[4].start);
+
+    // Out-of-range intervals are refused
+    door.setMaxInterval(SWINGING_DOOR_MAX_INTERVAL_LIMIT_US + 1);
+    TEST_ASSERT_EQUAL_INT64(2000000, door.getMaxInterval());
+}
+
+void test_benchmark_compression() {
+    static const int SAMPLES = 2000000;
+    SwingingDoor door(0, 50000);
+    TrendPoint point;
+    uint32_t points = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (int n = 0; n < SAMPLES; n++) {
+        q31_t value = static_cast<q31_t>((n % 4000 < 2000 ? 1000000 : 3000000) + sim::noise(60000));
+        door.add(static_cast<int64_t>(n) * PERIOD_US, value, SAMPLE_QUALITY_FRESH);
+        while (door.read(point)) {
+            points++;
+        }
+    }
+    double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+    printf("swinging door: %.1f ns per conversion, %u points from %d conversions\n", elapsedNs / SAMPLES,
+           points, SAMPLES);
+    TEST_ASSERT_TRUE(points > 0);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_reconstruction_stays_within_the_deviation);
+    RUN_TEST(test_steady_signal_compresses_by_orders_of_magnitude);
+    RUN_TEST(test_zero_deviation_keeps_every_corner);
+    RUN_TEST(test_breaks_and_quality_flags);
+    RUN_TEST(test_slow_sampling_and_paused_acquisition);
+    RUN_TEST(test_benchmark_compression);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}
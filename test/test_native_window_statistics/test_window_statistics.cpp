@@ -0,0 +1,149 @@
+// Host tests for the sliding-window statistics engine, checked against brute force
+#include <unity.h>
+#include <math.h>
+#include <stdlib.h>
+#include "window_statistics.h"
+
+static const size_t CAPACITY = 64;
+
+struct Reference {
+    q31_t min, max;
+    double mean, rms, stddev;
+};
+
+static Reference bruteForce(const q31_t* values, size_t end, uint32_t length) {
+    size_t start = end > length ? end - length : 0;
+    Reference r = {values[start], values[start], 0, 0, 0};
+    double sum = 0, sumSquares = 0;
+    for (size_t i = start; i < end; i++) {
+        if (values[i] < r.min) r.min = values[i];
+        if (values[i] > r.max) r.max = values[i];
+        sum += values[i];
+        sumSquares += static_cast<double>(values[i]) * values[i];
+    }
+    double n = static_cast<double>(end - start);
+    r.mean = sum / n;
+    r.rms = sqrt(sumSquares / n);
+    double variance = sumSquares / n - r.mean * r.mean;
+    r.stddev = variance > 0 ? sqrt(variance) : 0;
+    return r;
+}
+
+static void checkWindow(const WindowedStatistics<CAPACITY>& stats, int window, const q31_t* values, size_t end) {
+    uint32_t length = stats.getWindowLength(window);
+    Reference expected = bruteForce(values, end, length);
+    WindowSummary actual = stats.summary(window);
+    TEST_ASSERT_EQUAL_UINT32(end < length ? end : length, actual.count);
+    TEST_ASSERT_EQUAL_INT32(expected.min, actual.min);
+    TEST_ASSERT_EQUAL_INT32(expected.max, actual.max);
+    // Moments are summed at Q23, so they match to within a few Q31 LSBs of that resolution
+    TEST_ASSERT_INT32_WITHIN(256, static_cast<int32_t>(lround(expected.mean)), actual.mean);
+    TEST_ASSERT_INT32_WITHIN(256, static_cast<int32_t>(lround(expected.rms)), actual.rms);
+    TEST_ASSERT_INT32_WITHIN(512, static_cast<int32_t>(lround(expected.stddev)), actual.stddev);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_matches_brute_force_on_random_stream() {
+    static q31_t values[2000];
+    WindowedStatistics<CAPACITY> stats;
+    stats.setWindowLength(0, 5);
+    stats.setWindowLength(1, 17);
+    stats.setWindowLength(2, CAPACITY);
+    srand(1234);
+    for (size_t i = 0; i < 2000; i++) {
+        values[i] = static_cast<q31_t>((rand() % 2000001 - 1000000) * 1024);
+        stats.add(values[i]);
+        for (int w = 0; w < STATS_WINDOW_COUNT; w++) {
+            checkWindow(stats, w, values, i + 1);
+        }
+    }
+}
+
+void test_monotonic_runs_keep_extremes() {
+    static q31_t values[300];
+    WindowedStatistics<CAPACITY> stats;
+    stats.setWindowLength(0, 10);
+    // Rising then falling ramps exercise both deques emptying from the back and the front
+    for (size_t i = 0; i < 300; i++) {
+        int32_t phase = static_cast<int32_t>(i % 100);
+        values[i] = (phase < 50 ? phase : 100 - phase) * 1000000;
+        stats.add(values[i]);
+        checkWindow(stats, 0, values, i + 1);
+    }
+}
+
+void test_peak_is_largest_magnitude() {
+    WindowedStatistics<CAPACITY> stats;
+    stats.add(1000);
+    stats.add(-5000);
+    stats.add(3000);
+    WindowSummary summary = stats.summary(0);
+    TEST_ASSERT_EQUAL_INT32(-5000, summary.min);
+    TEST_ASSERT_EQUAL_INT32(3000, summary.max);
+    TEST_ASSERT_EQUAL_INT32(5000, summary.peak);
+
+    // Full negative scale saturates instead of overflowing
+    stats.add(INT32_MIN);
+    TEST_ASSERT_EQUAL_INT32(INT32_MAX, stats.summary(0).peak);
+}
+
+void test_constant_signal_has_no_noise() {
+    WindowedStatistics<CAPACITY> stats;
+    for (int i = 0; i < 1000; i++) {
+        stats.add(-123456789);
+    }
+    WindowSummary summary = stats.summary(2);
+    TEST_ASSERT_INT32_WITHIN(256, -123456789, summary.mean);
+    TEST_ASSERT_INT32_WITHIN(256, 123456789, summary.rms);
+    TEST_ASSERT_EQUAL_INT32(0, summary.stddev);
+}
+
+void test_resize_refills_from_history() {
+    static q31_t values[100];
+    WindowedStatistics<CAPACITY> stats;
+    for (size_t i = 0; i < 100; i++) {
+        values[i] = static_cast<q31_t>(i * 7919 % 1000) << 16;
+        stats.add(values[i]);
+    }
+    stats.setWindowLength(0, 48);
+    checkWindow(stats, 0, values, 100);
+
+    // Lengths are clamped to the shared history
+    stats.setWindowLength(1, 10 * CAPACITY);
+    TEST_ASSERT_EQUAL_UINT32(CAPACITY, stats.getWindowLength(1));
+    checkWindow(stats, 1, values, 100);
+    stats.setWindowLength(1, 0);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.getWindowLength(1));
+    checkWindow(stats, 1, values, 100);
+}
+
+void test_reset_empties_every_window() {
+    WindowedStatistics<CAPACITY> stats;
+    stats.add(42);
+    stats.reset();
+    for (int w = 0; w < STATS_WINDOW_COUNT; w++) {
+        TEST_ASSERT_EQUAL_UINT32(0, stats.summary(w).count);
+    }
+    stats.add(-1792);
+    TEST_ASSERT_EQUAL_INT32(-1792, stats.summary(0).mean);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_brute_force_on_random_stream);
+    RUN_TEST(test_monotonic_runs_keep_extremes);
+    RUN_TEST(test_peak_is_largest_magnitude);
+    RUN_TEST(test_constant_signal_has_no_noise);
+    RUN_TEST(test_resize_refills_from_history);
+    RUN_TEST(test_reset_empties_every_window);
+    return UNITY_END();
+}
+
+int main() {
+    return runUnityTests();
+}